@@ -112,6 +112,7 @@ LIB_VOODOO_SOURCES = \
 # libdirect object files
 LIB_DIRECT_SOURCES = \
 	$(DFB_SOURCE)/lib/direct/String.cpp			\
+	$(DFB_SOURCE)/lib/direct/arena.c				\
 	$(DFB_SOURCE)/lib/direct/clock.c				\
 	$(DFB_SOURCE)/lib/direct/conf.c				\
 	$(DFB_SOURCE)/lib/direct/debug.c				\
@@ -178,7 +179,8 @@ LIB_FUSION_SOURCES_SINGLE = \
 LIB_FUSION_SOURCES_MULTI = \
 	$(DFB_SOURCE)/lib/fusion/shm/heap.c			\
 	$(DFB_SOURCE)/lib/fusion/shm/pool.c			\
-	$(DFB_SOURCE)/lib/fusion/shm/shm.c
+	$(DFB_SOURCE)/lib/fusion/shm/shm.c			\
+	$(DFB_SOURCE)/lib/fusion/shm/slab.c
 
 #
 # New surface core object files
@@ -262,6 +264,7 @@ DIRECTFB_SOURCES = \
 	$(DFB_SOURCE)/src/media/ImageProvider_real.cpp		\
 	$(DFB_SOURCE)/src/misc/conf.c				\
 	$(DFB_SOURCE)/src/misc/gfx_util.c				\
+	$(DFB_SOURCE)/src/misc/region_index.c			\
 	$(DFB_SOURCE)/src/misc/util.c				\
 	$(DFB_SOURCE)/src/windows/idirectfbwindow.c		\
 	$(DFB_SOURCE)/src/core/CoreDFB.cpp				\
@@ -295,6 +298,7 @@ DIRECTFB_SOURCES = \
 	$(DFB_SOURCE)/src/core/Renderer.cpp			\
 	$(DFB_SOURCE)/src/core/Task.cpp				\
 	$(DFB_SOURCE)/src/core/TaskThreadsQ.cpp			\
+	$(DFB_SOURCE)/src/core/TaskTrace.cpp			\
 	$(DFB_SOURCE)/src/core/Util.cpp
 
 #
@@ -0,0 +1,355 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+#include <config.h>
+
+#include <direct/arena.h>
+#include <direct/atomic.h>
+#include <direct/debug.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/thread.h>
+
+
+D_DEBUG_DOMAIN( Direct_Arena, "Direct/Arena", "Direct Arena" );
+D_DEBUG_DOMAIN( Direct_Pool,  "Direct/Pool",  "Direct Pool" );
+
+/**********************************************************************************************************************/
+
+static DirectOnce arena_once = DIRECT_ONCE_INIT;
+static DirectTLS  arena_tls;
+
+static D_COUNTER( Direct_Arena_Thread, "Direct/Arena/Thread" );
+
+/**********************************************************************************************************************/
+
+void
+direct_arena_init( DirectArena   *arena,
+                   size_t         chunk_size,
+                   DirectCounter *counter )
+{
+     D_DEBUG_AT( Direct_Arena, "%s( %p, chunk size %zu )\n", __FUNCTION__, arena, chunk_size );
+
+     D_ASSERT( arena != NULL );
+
+     memset( arena, 0, sizeof(DirectArena) );
+
+     arena->chunk_size = chunk_size ? chunk_size : DIRECT_ARENA_CHUNK_SIZE;
+     arena->counter    = counter;
+
+     D_MAGIC_SET( arena, DirectArena );
+}
+
+void
+direct_arena_deinit( DirectArena *arena )
+{
+     DirectArenaChunk *chunk;
+
+     D_DEBUG_AT( Direct_Arena, "%s( %p )\n", __FUNCTION__, arena );
+
+     D_MAGIC_ASSERT( arena, DirectArena );
+
+     while (arena->chunks) {
+          chunk = arena->chunks;
+
+          arena->chunks = chunk->next;
+
+          direct_free( chunk );
+     }
+
+     D_MAGIC_CLEAR( arena );
+}
+
+void *
+direct_arena_alloc_chunk( DirectArena *arena,
+                          size_t       size )
+{
+     DirectArenaChunk *chunk;
+     DirectArenaChunk *current = arena->current;
+
+     D_MAGIC_ASSERT( arena, DirectArena );
+     D_ASSERT( size % DIRECT_ARENA_ALIGN == 0 );
+
+     /* Use the next unused chunk if it is big enough. */
+     if (current && current->next && current->next->size >= size) {
+          chunk = current->next;
+     }
+     else if (!current && arena->chunks && arena->chunks->size >= size) {
+          chunk = arena->chunks;
+     }
+     else {
+          size_t chunk_size = MAX( size, arena->chunk_size );
+
+          D_DEBUG_AT( Direct_Arena, "%s( %p, %zu ) -> new chunk of %zu bytes\n", __FUNCTION__, arena, size, chunk_size );
+
+          chunk = direct_malloc( DIRECT_ARENA_CHUNK_HEADER + chunk_size );
+          if (!chunk) {
+               D_OOM();
+               return NULL;
+          }
+
+          chunk->size = chunk_size;
+
+          if (current) {
+               chunk->next   = current->next;
+               current->next = chunk;
+          }
+          else {
+               chunk->next   = arena->chunks;
+               arena->chunks = chunk;
+          }
+     }
+
+     D_ASSERT( chunk->size >= size );
+
+     chunk->used = size;
+
+     arena->current = chunk;
+
+     if (arena->counter)
+          direct_counter_add( arena->counter, 1 );
+
+     return (u8*) chunk + DIRECT_ARENA_CHUNK_HEADER;
+}
+
+void
+direct_arena_release( DirectArena           *arena,
+                      const DirectArenaMark *mark )
+{
+     DirectArenaChunk *prev;
+     DirectArenaChunk *chunk;
+
+     D_MAGIC_ASSERT( arena, DirectArena );
+     D_ASSERT( mark != NULL );
+
+     prev  = mark->chunk;
+     chunk = prev ? prev->next : arena->chunks;
+
+     if (prev) {
+          D_ASSERT( mark->used <= prev->used );
+
+          prev->used = mark->used;
+     }
+
+     /* Keep chunks of the usual size for reuse. */
+     while (chunk) {
+          DirectArenaChunk *next = chunk->next;
+
+          if (chunk->size > arena->chunk_size) {
+               if (prev)
+                    prev->next = next;
+               else
+                    arena->chunks = next;
+
+               direct_free( chunk );
+          }
+          else {
+               chunk->used = 0;
+
+               prev = chunk;
+          }
+
+          chunk = next;
+     }
+
+     arena->current = mark->chunk;
+}
+
+/**********************************************************************************************************************/
+
+static void
+arena_thread_destroy( void *arg )
+{
+     DirectArena *arena = arg;
+
+     direct_arena_deinit( arena );
+
+     direct_free( arena );
+}
+
+static void
+arena_init_once( void )
+{
+     direct_tls_register( &arena_tls, arena_thread_destroy );
+}
+
+DirectArena *
+direct_arena_thread()
+{
+     DirectArena *arena;
+
+     direct_once( &arena_once, arena_init_once );
+
+     arena = direct_tls_get( arena_tls );
+     if (!arena) {
+          arena = direct_malloc( sizeof(DirectArena) );
+          if (!arena) {
+               D_OOM();
+               return NULL;
+          }
+
+          direct_arena_init( arena, 0, &Direct_Arena_Thread );
+
+          direct_tls_set( arena_tls, arena );
+     }
+
+     return arena;
+}
+
+/**********************************************************************************************************************/
+
+void
+direct_pool_init( DirectPool    *pool,
+                  size_t         size,
+                  unsigned int   chunk_objects,
+                  DirectCounter *counter )
+{
+     D_DEBUG_AT( Direct_Pool, "%s( %p, size %zu, %u per chunk )\n", __FUNCTION__, pool, size, chunk_objects );
+
+     D_ASSERT( pool != NULL );
+     D_ASSERT( size > 0 );
+     D_ASSERT( chunk_objects > 0 );
+
+     memset( pool, 0, sizeof(DirectPool) );
+
+     pool->size          = (size + DIRECT_ARENA_ALIGN - 1) & ~(DIRECT_ARENA_ALIGN - 1);
+     pool->chunk_objects = chunk_objects;
+     pool->counter       = counter;
+
+     direct_mutex_init( &pool->lock );
+
+     D_MAGIC_SET( pool, DirectPool );
+}
+
+void
+direct_pool_deinit( DirectPool *pool )
+{
+     D_DEBUG_AT( Direct_Pool, "%s( %p )\n", __FUNCTION__, pool );
+
+     D_MAGIC_ASSERT( pool, DirectPool );
+
+     while (pool->chunks) {
+          void *chunk = pool->chunks;
+
+          pool->chunks = *(void**) chunk;
+
+          direct_free( chunk );
+     }
+
+     direct_mutex_deinit( &pool->lock );
+
+     D_MAGIC_CLEAR( pool );
+}
+
+static bool
+pool_add_chunk( DirectPool *pool )
+{
+     unsigned int  i;
+     u8           *chunk;
+     u8           *objects;
+
+     D_DEBUG_AT( Direct_Pool, "%s( %p ) -> %u objects of %zu bytes\n", __FUNCTION__, pool, pool->chunk_objects, pool->size );
+
+     /* Chunks are linked via their first word, objects follow aligned. */
+     chunk = direct_malloc( DIRECT_ARENA_ALIGN + pool->chunk_objects * pool->size );
+     if (!chunk) {
+          D_OOM();
+          return false;
+     }
+
+     *(void**) chunk = pool->chunks;
+
+     pool->chunks = chunk;
+
+     objects = chunk + DIRECT_ARENA_ALIGN;
+
+     for (i=0; i<pool->chunk_objects; i++) {
+          void **object = (void**) (objects + i * pool->size);
+
+          *object = pool->free;
+
+          pool->free = object;
+     }
+
+     return true;
+}
+
+void *
+direct_pool_get( DirectPool *pool )
+{
+     void **object;
+
+     D_MAGIC_ASSERT( pool, DirectPool );
+
+     direct_mutex_lock( &pool->lock );
+
+     if (!pool->free) {
+          void *returned;
+
+          /* Take all objects put back so far. */
+          do {
+               returned = pool->returned;
+          } while (!D_SYNC_BOOL_COMPARE_AND_SWAP( &pool->returned, returned, NULL ));
+
+          pool->free = returned;
+     }
+
+     if (pool->free) {
+          if (pool->counter)
+               direct_counter_add( pool->counter, 1 );
+     }
+     else if (!pool_add_chunk( pool )) {
+          direct_mutex_unlock( &pool->lock );
+          return NULL;
+     }
+
+     object = pool->free;
+
+     pool->free = *object;
+
+     direct_mutex_unlock( &pool->lock );
+
+     return object;
+}
+
+void
+direct_pool_put( DirectPool *pool,
+                 void       *object )
+{
+     void *returned;
+
+     D_MAGIC_ASSERT( pool, DirectPool );
+     D_ASSERT( object != NULL );
+
+     do {
+          returned = pool->returned;
+
+          *(void**) object = returned;
+     } while (!D_SYNC_BOOL_COMPARE_AND_SWAP( &pool->returned, returned, object ));
+}
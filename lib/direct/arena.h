@@ -0,0 +1,171 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+#ifndef __DIRECT__ARENA_H__
+#define __DIRECT__ARENA_H__
+
+#include <direct/debug.h>
+#include <direct/perf.h>
+#include <direct/thread.h>
+
+
+/*
+ * Arena
+ *
+ * Bump allocator for short-lived allocations, e.g. during a frame. Memory is given back in stack
+ * order by releasing the arena to a mark taken before, keeping its chunks for reuse.
+ */
+
+#define DIRECT_ARENA_ALIGN              16
+#define DIRECT_ARENA_CHUNK_SIZE      16384
+
+typedef struct __D_DirectArenaChunk DirectArenaChunk;
+
+struct __D_DirectArenaChunk {
+     DirectArenaChunk   *next;         /* Next chunk, all following the current one are unused. */
+
+     size_t              size;         /* Bytes available for allocations. */
+     size_t              used;
+};
+
+#define DIRECT_ARENA_CHUNK_HEADER    ((sizeof(DirectArenaChunk) + DIRECT_ARENA_ALIGN - 1) & ~(DIRECT_ARENA_ALIGN - 1))
+
+struct __D_DirectArena {
+     int                 magic;
+
+     DirectArenaChunk   *chunks;
+     DirectArenaChunk   *current;      /* Chunk to allocate from, NULL if none yet. */
+
+     size_t              chunk_size;
+
+     DirectCounter      *counter;      /* Optional, counts allocations. */
+};
+
+typedef struct {
+     DirectArenaChunk   *chunk;
+     size_t              used;
+} DirectArenaMark;
+
+/**********************************************************************************************************************/
+
+void DIRECT_API  direct_arena_init   ( DirectArena     *arena,
+                                       size_t           chunk_size,
+                                       DirectCounter   *counter );
+
+void DIRECT_API  direct_arena_deinit ( DirectArena     *arena );
+
+void DIRECT_API *direct_arena_alloc_chunk( DirectArena *arena,
+                                           size_t       size );
+
+/*
+ * Gives back everything allocated since the mark has been taken.
+ */
+void DIRECT_API  direct_arena_release( DirectArena           *arena,
+                                       const DirectArenaMark *mark );
+
+/*
+ * Returns the arena of the calling thread.
+ */
+DirectArena DIRECT_API *direct_arena_thread( void );
+
+/**********************************************************************************************************************/
+
+static __inline__ void *
+direct_arena_alloc( DirectArena *arena,
+                    size_t       size )
+{
+     DirectArenaChunk *chunk = arena->current;
+
+     D_MAGIC_ASSERT( arena, DirectArena );
+
+     size = (size + DIRECT_ARENA_ALIGN - 1) & ~(DIRECT_ARENA_ALIGN - 1);
+
+     if (chunk && chunk->used + size <= chunk->size) {
+          void *ptr = (u8*) chunk + DIRECT_ARENA_CHUNK_HEADER + chunk->used;
+
+          chunk->used += size;
+
+          if (arena->counter)
+               direct_counter_add( arena->counter, 1 );
+
+          return ptr;
+     }
+
+     return direct_arena_alloc_chunk( arena, size );
+}
+
+static __inline__ void
+direct_arena_mark( const DirectArena *arena,
+                   DirectArenaMark   *ret_mark )
+{
+     D_MAGIC_ASSERT( arena, DirectArena );
+
+     ret_mark->chunk = arena->current;
+     ret_mark->used  = arena->current ? arena->current->used : 0;
+}
+
+
+/*
+ * Pool
+ *
+ * Objects of a fixed size, allocated in chunks which are kept until the pool is deinitialized.
+ * Objects may be put back by any thread.
+ */
+
+struct __D_DirectPool {
+     int                 magic;
+
+     size_t              size;         /* Size of objects, aligned like arena allocations. */
+     unsigned int        chunk_objects;
+
+     DirectMutex         lock;         /* Lock for taking objects. */
+
+     void               *free;         /* Objects to take, linked via their first word. */
+     void               *returned;     /* Objects put back without locking. */
+     void               *chunks;
+
+     DirectCounter      *counter;      /* Optional, counts objects taken without allocating a chunk. */
+};
+
+/**********************************************************************************************************************/
+
+void DIRECT_API  direct_pool_init  ( DirectPool      *pool,
+                                     size_t           size,
+                                     unsigned int     chunk_objects,
+                                     DirectCounter   *counter );
+
+void DIRECT_API  direct_pool_deinit( DirectPool      *pool );
+
+void DIRECT_API *direct_pool_get   ( DirectPool      *pool );
+
+void DIRECT_API  direct_pool_put   ( DirectPool      *pool,
+                                     void            *object );
+
+
+#endif
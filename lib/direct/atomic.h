@@ -353,6 +353,11 @@ static inline int _D__atomic_add_return(int i, volatile int *v)
 	 0
 #endif
 
+#ifndef D_SYNC_SYNCHRONIZE
+#define D_SYNC_SYNCHRONIZE()                                          \
+     do { } while (0)
+#endif
+
 #else //WIN32
 
 #ifndef D_SYNC_BOOL_COMPARE_AND_SWAP
@@ -387,6 +392,14 @@ static inline int _D__atomic_add_return(int i, volatile int *v)
      do { (void) D_SYNC_ADD_AND_FETCH( ptr, value ); } while (0)
 #endif
 
+/*
+ * Full memory barrier, orders plain loads and stores around publishing via shared memory
+ */
+#ifndef D_SYNC_SYNCHRONIZE
+#define D_SYNC_SYNCHRONIZE()                                          \
+     __sync_synchronize()
+#endif
+
 #endif //!WIN32
 
 /*
@@ -32,6 +32,8 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include <direct/debug.h>
 #include <direct/hash.h>
 #include <direct/mem.h>
@@ -42,86 +44,151 @@ D_LOG_DOMAIN( Direct_Hash, "Direct/Hash", "Hash table implementation" );
 
 /**********************************************************************************************************************/
 
-static const unsigned int primes[] =
+#define DIRECT_HASH_MIN_SIZE   DIRECT_HASH_GROUP_SIZE
+#define DIRECT_HASH_MAX_SIZE   (1 << 30)
+
+/* Resize when more than 7/8 of the slots are used or deleted. */
+#define DIRECT_HASH_MAX_LOAD(size)   ((size) - (size) / 8)
+
+#define CONTROL(hash)          ((u8*) ((hash)->Elements + (hash)->size))
+
+/**********************************************************************************************************************/
+
+static int
+round_size( int size )
 {
-     11,
-     19,
-     37,
-     73,
-     109,
-     163,
-     251,
-     367,
-     557,
-     823,
-     1237,
-     1861,
-     2777,
-     4177,
-     6247,
-     9371,
-     14057,
-     21089,
-     31627,
-     47431,
-     71143,
-     106721,
-     160073,
-     240101,
-     360163,
-     540217,
-     810343,
-     1215497,
-     1823231,
-     2734867,
-     4102283,
-     6153409,
-     9230113,
-     13845163,
-};
-
-static const unsigned int nprimes = D_ARRAY_SIZE( primes );
-
-static unsigned int
-spaced_primes_closest (unsigned int num)
+     int result = DIRECT_HASH_MIN_SIZE;
+
+     while (result < size && result < DIRECT_HASH_MAX_SIZE)
+          result <<= 1;
+
+     return result;
+}
+
+static DirectHashElement *
+alloc_elements( const DirectHash *hash, int size )
 {
-     unsigned int i;
-     for (i = 0; i < nprimes; i++)
-          if (primes[i] > num)
-               return primes[i];
-     return primes[nprimes - 1];
+     DirectHashElement *elements;
+
+     if (hash->disable_debugging_alloc)
+          elements = direct_calloc( 1, size * sizeof(DirectHashElement) + size );
+     else
+          elements = D_CALLOC( 1, size * sizeof(DirectHashElement) + size );
+
+     if (elements)
+          memset( elements + size, DIRECT_HASH_CONTROL_EMPTY, size );
+
+     return elements;
 }
 
-#define DIRECT_HASH_MIN_SIZE 11
-#define DIRECT_HASH_MAX_SIZE 13845163
+static void
+free_elements( const DirectHash *hash, DirectHashElement *elements )
+{
+     if (hash->disable_debugging_alloc)
+          direct_free( elements );
+     else
+          D_FREE( elements );
+}
 
-/**********************************************************************************************************************/
+/*
+ * Returns the first unused or deleted slot in the probe sequence of the hashed key.
+ */
+static __inline__ int
+locate_free( const u8 *control, int size, unsigned long h )
+{
+     int            mask = size / DIRECT_HASH_GROUP_SIZE - 1;
+     int            group;
+     int            step = 0;
+     DirectHashMask match;
+
+     group = (h >> 7) & mask;
+
+     while (!(match = direct_hash_group_match_free( control + group * DIRECT_HASH_GROUP_SIZE )))
+          group = (group + ++step) & mask;
+
+     return group * DIRECT_HASH_GROUP_SIZE + DIRECT_HASH_MASK_NEXT( match );
+}
 
 static __inline__ int
 locate_key( const DirectHash *hash, unsigned long key )
 {
-     int                      pos;
-     const DirectHashElement *element;
+     unsigned long  h;
+     int            mask;
+     int            group;
+     int            step = 0;
+     const u8      *control;
 
      D_MAGIC_ASSERT( hash, DirectHash );
      D_ASSERT( hash->size > 0 );
      D_ASSERT( hash->Elements != NULL );
 
-     pos = key % hash->size;
+     h       = direct_hash_mix( key );
+     mask    = hash->size / DIRECT_HASH_GROUP_SIZE - 1;
+     group   = (h >> 7) & mask;
+     control = CONTROL( hash );
+
+     while (true) {
+          const u8       *group_control = control + group * DIRECT_HASH_GROUP_SIZE;
+          DirectHashMask  match         = direct_hash_group_match( group_control, h & 0x7f );
+
+          while (match) {
+               int pos = group * DIRECT_HASH_GROUP_SIZE + DIRECT_HASH_MASK_NEXT( match );
+
+               if (hash->Elements[pos].key == key)
+                    return pos;
+
+               match = DIRECT_HASH_MASK_DROP( match );
+          }
+
+          /* Keys are never placed beyond a group that has empty slots. */
+          if (direct_hash_group_match( group_control, DIRECT_HASH_CONTROL_EMPTY ))
+               return -1;
+
+          group = (group + ++step) & mask;
+     }
+}
+
+static DirectResult
+resize_hash( DirectHash *hash,
+             int         size )
+{
+     int                i;
+     DirectHashElement *elements;
+     u8                *control;
+     const u8          *old_control = CONTROL( hash );
+
+     D_DEBUG_AT( Direct_Hash, "Resizing from %d to %d... (count %d, removed %d)\n",
+                 hash->size, size, hash->count, hash->removed );
+
+     elements = alloc_elements( hash, size );
+     if (!elements) {
+          D_WARN( "out of memory" );
+          return DR_NOLOCALMEMORY;
+     }
+
+     control = (u8*) (elements + size);
 
-     element = &hash->Elements[pos];
+     for (i=0; i<hash->size; i++) {
+          unsigned long h;
+          int           pos;
 
-     while (element->value) {
-          if (element->value != DIRECT_HASH_ELEMENT_REMOVED && element->key == key)
-               return pos;
+          if (old_control[i] & 0x80)
+               continue;
 
-          if (++pos == hash->size)
-               pos = 0;
+          h   = direct_hash_mix( hash->Elements[i].key );
+          pos = locate_free( control, size, h );
 
-          element = &hash->Elements[pos];
+          control[pos]  = h & 0x7f;
+          elements[pos] = hash->Elements[i];
      }
 
-     return -1;
+     free_elements( hash, hash->Elements );
+
+     hash->size     = size;
+     hash->Elements = elements;
+     hash->removed  = 0;
+
+     return DR_OK;
 }
 
 /**********************************************************************************************************************/
@@ -178,10 +245,7 @@ direct_hash_deinit( DirectHash *hash )
      D_MAGIC_CLEAR( hash );
 
      if (hash->Elements) {
-          if (hash->disable_debugging_alloc)
-               direct_free( hash->Elements );
-          else
-               D_FREE( hash->Elements );
+          free_elements( hash, hash->Elements );
 
           hash->Elements = NULL;
      }
@@ -202,97 +266,56 @@ direct_hash_insert( DirectHash    *hash,
                     unsigned long  key,
                     void          *value )
 {
-     int                pos;
-     DirectHashElement *element;
+     DirectResult   ret;
+     unsigned long  h;
+     int            pos;
+     u8            *control;
 
      D_MAGIC_ASSERT( hash, DirectHash );
      D_ASSERT( hash->size > 0 );
      D_ASSERT( value != NULL );
 
      if (!hash->Elements) {
-          if (hash->disable_debugging_alloc)
-               hash->Elements = direct_calloc( hash->size, sizeof(DirectHashElement) );
-          else
-               hash->Elements = D_CALLOC( hash->size, sizeof(DirectHashElement) );
+          int size = round_size( hash->size );
 
+          hash->Elements = alloc_elements( hash, size );
           if (!hash->Elements)
                return D_OOM();
-     }
-
-     /* Need to resize the hash table? */
-     if ((hash->count + hash->removed) > hash->size / 2) {
-          int                i, size;
-          DirectHashElement *elements;
-
-          size = spaced_primes_closest( hash->size );
-          if (size > DIRECT_HASH_MAX_SIZE)
-               size = DIRECT_HASH_MAX_SIZE;
-          if (size < DIRECT_HASH_MIN_SIZE)
-               size = DIRECT_HASH_MIN_SIZE;
-
-          D_DEBUG_AT( Direct_Hash, "Resizing from %d to %d... (count %d, removed %d)\n",
-                      hash->size, size, hash->count, hash->removed );
-
-          if (hash->disable_debugging_alloc)
-               elements = direct_calloc( size, sizeof(DirectHashElement) );
-          else
-               elements = D_CALLOC( size, sizeof(DirectHashElement) );
-          if (!elements) {
-               D_WARN( "out of memory" );
-               return DR_NOLOCALMEMORY;
-          }
-
-          for (i=0; i<hash->size; i++) {
-               DirectHashElement *element = &hash->Elements[i];
-               DirectHashElement *insertElement;
-
-               if (element->value && element->value != DIRECT_HASH_ELEMENT_REMOVED) {
-                    pos = element->key % size;
 
-                    insertElement = &elements[pos];
-                    while (insertElement->value && insertElement->value != DIRECT_HASH_ELEMENT_REMOVED) {
-                        if (++pos == size)
-                            pos = 0;
-                        insertElement = &elements[pos];
-                    }
-
-                    elements[pos] = *element;
-               }
-          }
-
-          if (hash->disable_debugging_alloc)
-               direct_free( hash->Elements );
-          else
-               D_FREE( hash->Elements );
-
-          hash->size     = size;
-          hash->Elements = elements;
-          hash->removed  = 0;
+          hash->size = size;
+     }
+     else if (locate_key( hash, key ) != -1) {
+          D_BUG( "key already exists" );
+          return DR_BUG;
      }
 
-     pos = key % hash->size;
+     h       = direct_hash_mix( key );
+     pos     = locate_free( CONTROL( hash ), hash->size, h );
+     control = CONTROL( hash );
 
      D_DEBUG_AT( Direct_Hash, "Attempting to insert key 0x%08lx at position %d...\n", key, pos );
 
-     element = &hash->Elements[pos];
+     if (control[pos] == DIRECT_HASH_CONTROL_DELETED)
+          hash->removed--;
+     else if (hash->count + hash->removed >= DIRECT_HASH_MAX_LOAD( hash->size )) {
+          /* Grow if needed, otherwise just get rid of the tombstones. */
+          int size = hash->size;
 
-     while (element->value && element->value != DIRECT_HASH_ELEMENT_REMOVED) {
-          if (element->key == key) {
-               D_BUG( "key already exists" );
-               return DR_BUG;
-          }
+          if (hash->count >= DIRECT_HASH_MAX_LOAD( size ) / 2 && size < DIRECT_HASH_MAX_SIZE)
+               size <<= 1;
 
-          if (++pos == hash->size)
-               pos = 0;
+          ret = resize_hash( hash, size );
+          if (ret)
+               return ret;
 
-          element = &hash->Elements[pos];
+          pos     = locate_free( CONTROL( hash ), hash->size, h );
+          control = CONTROL( hash );
      }
 
-     if (element->value == DIRECT_HASH_ELEMENT_REMOVED)
-          hash->removed--;
+     control[pos] = h & 0x7f;
 
-     element->key   = key;
-     element->value = value;
+     hash->Elements[pos].key   = key;
+     hash->Elements[pos].value = value;
 
      hash->count++;
 
@@ -306,7 +329,8 @@ DirectResult
 direct_hash_remove( DirectHash    *hash,
                     unsigned long  key )
 {
-     int pos;
+     int  pos;
+     u8  *control;
 
      D_MAGIC_ASSERT( hash, DirectHash );
 
@@ -319,10 +343,20 @@ direct_hash_remove( DirectHash    *hash,
           return DR_ITEMNOTFOUND;
      }
 
-     hash->Elements[pos].value = DIRECT_HASH_ELEMENT_REMOVED;
+     control = CONTROL( hash );
+
+     /* No probe sequence continues beyond a group with empty slots, no tombstone needed then. */
+     if (direct_hash_group_match( control + (pos & ~(DIRECT_HASH_GROUP_SIZE - 1)), DIRECT_HASH_CONTROL_EMPTY ))
+          control[pos] = DIRECT_HASH_CONTROL_EMPTY;
+     else {
+          control[pos] = DIRECT_HASH_CONTROL_DELETED;
+
+          hash->removed++;
+     }
+
+     hash->Elements[pos].value = NULL;
 
      hash->count--;
-     hash->removed++;
 
      D_DEBUG_AT( Direct_Hash, "Removed key 0x%08lx at %d, new count = %d, removed = %d, size = %d.\n",
                  key, pos, hash->count, hash->removed, hash->size );
@@ -353,21 +387,24 @@ direct_hash_iterate( DirectHash             *hash,
                      DirectHashIteratorFunc  func,
                      void                   *ctx )
 {
-     int i;
+     int       i;
+     const u8 *control;
 
      D_MAGIC_ASSERT( hash, DirectHash );
 
      if (!hash->Elements)
           return;
 
+     control = CONTROL( hash );
+
+     /* Removing the current element from the callback is fine, slots never move outside of insert. */
      for (i=0; i<hash->size; i++) {
           DirectHashElement *element = &hash->Elements[i];
 
-          if (!element->value || element->value == DIRECT_HASH_ELEMENT_REMOVED)
+          if (control[i] & 0x80)
                continue;
 
           if (!func( hash, element->key, element->value, ctx ) )
                return;
      }
 }
-
@@ -42,18 +42,28 @@ typedef struct {
      void          *value;
 } DirectHashElement;
 
-#define DIRECT_HASH_ELEMENT_REMOVED  ((void *) -1)
+/*
+ * Open addressing in groups of slots with one control byte per slot, probed all at once via SSE2 or NEON.
+ *
+ * Full slots store the lower seven bits of the hashed key, so that most key compares are avoided.
+ * Probing visits whole groups at aligned positions and stops at the first group containing an empty slot,
+ * therefore a removed slot only needs a tombstone if its group is completely used.
+ */
+#define DIRECT_HASH_GROUP_SIZE       16
+
+#define DIRECT_HASH_CONTROL_EMPTY    0x80
+#define DIRECT_HASH_CONTROL_DELETED  0xfe
 
 
 struct __D_DirectHash {
      int                 magic;
 
-     int                 size;
+     int                 size;          /* Number of slots, rounded up to a power of two on first insert. */
 
      int                 count;
-     int                 removed;
+     int                 removed;       /* Slots with tombstones. */
 
-     DirectHashElement  *Elements;
+     DirectHashElement  *Elements;      /* Control bytes follow the elements. */
 
      bool                disable_debugging_alloc;
 };
@@ -63,7 +73,7 @@ struct __D_DirectHash {
 #define DIRECT_HASH_INIT( __size, __disable_debugging_alloc )    \
      {                                                           \
           0x0b161321,                                            \
-          (__size < 17 ? 17 : __size),                           \
+          (__size < 16 ? 16 : __size),                           \
           0,                                                     \
           0,                                                     \
           NULL,                                                  \
@@ -85,6 +95,86 @@ struct __D_DirectHash {
 
 /**********************************************************************************************************************/
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#define DIRECT_HASH_GROUP_NEON
+#endif
+
+/*
+ * Bit mask of matching slots within a group, use DIRECT_HASH_MASK_NEXT() to get the index of the lowest one.
+ */
+typedef u64 DirectHashMask;
+
+#ifdef DIRECT_HASH_GROUP_NEON
+/* four bits per slot */
+#define DIRECT_HASH_MASK_NEXT( mask )  (__builtin_ctzll( mask ) >> 2)
+#define DIRECT_HASH_MASK_DROP( mask )  ((mask) & ~(0xfULL << (__builtin_ctzll( mask ) & ~3)))
+#else
+#define DIRECT_HASH_MASK_NEXT( mask )  __builtin_ctzll( mask )
+#define DIRECT_HASH_MASK_DROP( mask )  ((mask) & ((mask) - 1))
+#endif
+
+/*
+ * Mix the key, lower seven bits are stored in the control byte, the rest selects the group.
+ */
+static __inline__ unsigned long
+direct_hash_mix( unsigned long key )
+{
+     u64 h = (u64) key * 0x9e3779b97f4a7c15ULL;
+
+     return (unsigned long) (h ^ (h >> 32));
+}
+
+static __inline__ DirectHashMask
+direct_hash_group_match( const u8 *control, u8 value )
+{
+#if defined(__SSE2__)
+     __m128i group = _mm_loadu_si128( (const __m128i*) control );
+
+     return (unsigned int) _mm_movemask_epi8( _mm_cmpeq_epi8( group, _mm_set1_epi8( (char) value ) ) );
+#elif defined(DIRECT_HASH_GROUP_NEON)
+     uint8x16_t eq = vceqq_u8( vld1q_u8( control ), vdupq_n_u8( value ) );
+
+     return vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8( eq ), 4 ) ), 0 );
+#else
+     int            i;
+     DirectHashMask mask = 0;
+
+     for (i=0; i<DIRECT_HASH_GROUP_SIZE; i++) {
+          if (control[i] == value)
+               mask |= 1 << i;
+     }
+
+     return mask;
+#endif
+}
+
+static __inline__ DirectHashMask
+direct_hash_group_match_free( const u8 *control )
+{
+#if defined(__SSE2__)
+     return (unsigned int) _mm_movemask_epi8( _mm_loadu_si128( (const __m128i*) control ) );
+#elif defined(DIRECT_HASH_GROUP_NEON)
+     uint8x16_t neg = vcltq_s8( vreinterpretq_s8_u8( vld1q_u8( control ) ), vdupq_n_s8( 0 ) );
+
+     return vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8( neg ), 4 ) ), 0 );
+#else
+     int            i;
+     DirectHashMask mask = 0;
+
+     for (i=0; i<DIRECT_HASH_GROUP_SIZE; i++) {
+          if (control[i] & 0x80)
+               mask |= 1 << i;
+     }
+
+     return mask;
+#endif
+}
+
+/**********************************************************************************************************************/
+
 /*
  * Hash iteration callback, return false to abort iteration.
  */
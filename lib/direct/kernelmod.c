@@ -188,6 +188,7 @@ EXPORT_SYMBOL_GPL( direct_futex_wake );
 EXPORT_SYMBOL_GPL( direct_getpid );
 EXPORT_SYMBOL_GPL( direct_gettid );
 EXPORT_SYMBOL_GPL( direct_sigaction );
+EXPORT_SYMBOL_GPL( direct_cachesize );
 EXPORT_SYMBOL_GPL( direct_page_align );
 EXPORT_SYMBOL_GPL( direct_pagesize );
 EXPORT_SYMBOL_GPL( direct_tgkill );
@@ -229,6 +230,7 @@ EXPORT_SYMBOL_GPL( direct_log_set_default );
 EXPORT_SYMBOL_GPL( direct_log_unlock );
 
 EXPORT_SYMBOL_GPL( direct_memcpy );
+EXPORT_SYMBOL_GPL( direct_memcpy_2d );
 
 EXPORT_SYMBOL_GPL( direct_messages_bug );
 EXPORT_SYMBOL_GPL( direct_messages_derror );
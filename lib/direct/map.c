@@ -33,8 +33,10 @@
 #include <config.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <direct/debug.h>
+#include <direct/hash.h>
 #include <direct/map.h>
 #include <direct/mem.h>
 #include <direct/messages.h>
@@ -44,13 +46,14 @@ D_DEBUG_DOMAIN( Direct_Map, "Direct/Map", "Map implementation" );
 
 /**********************************************************************************************************************/
 
-#define REMOVED  ((void *) -1)
-
 typedef struct {
      unsigned int           hash;
      void                  *object;
 } MapEntry;
 
+/*
+ * Same layout and probing as DirectHash, see direct/hash.h.
+ */
 struct __D_DirectMap {
      int                    magic;
 
@@ -59,7 +62,7 @@ struct __D_DirectMap {
      unsigned int           count;
      unsigned int           removed;
 
-     MapEntry              *entries;
+     MapEntry              *entries;        /* Control bytes follow the entries. */
 
      DirectMapCompareFunc   compare;
      DirectMapHashFunc      hash;
@@ -71,68 +74,131 @@ struct __D_DirectMap {
           D_MAGIC_ASSERT( map, DirectMap );  \
      } while (0)
 
+/* Resize when more than 7/8 of the slots are used or deleted. */
+#define DIRECT_MAP_MAX_LOAD(size)   ((size) - (size) / 8)
+
+#define CONTROL(map)                ((u8*) ((map)->entries + (map)->size))
+
 /**********************************************************************************************************************/
 
+static MapEntry *
+alloc_entries( unsigned int size )
+{
+     MapEntry *entries;
+
+     entries = D_CALLOC( 1, size * sizeof(MapEntry) + size );
+     if (entries)
+          memset( entries + size, DIRECT_HASH_CONTROL_EMPTY, size );
+
+     return entries;
+}
+
+static __inline__ int
+locate_free( const u8 *control, unsigned int size, unsigned long h )
+{
+     unsigned int   mask = size / DIRECT_HASH_GROUP_SIZE - 1;
+     unsigned int   group;
+     unsigned int   step = 0;
+     DirectHashMask match;
+
+     group = (h >> 7) & mask;
+
+     while (!(match = direct_hash_group_match_free( control + group * DIRECT_HASH_GROUP_SIZE )))
+          group = (group + ++step) & mask;
+
+     return group * DIRECT_HASH_GROUP_SIZE + DIRECT_HASH_MASK_NEXT( match );
+}
+
 static int
 locate_entry( DirectMap *map, unsigned int hash, const void *key )
 {
-     int             pos;
-     const MapEntry *entry;
+     unsigned long  h;
+     unsigned int   mask;
+     unsigned int   group;
+     unsigned int   step = 0;
+     const u8      *control;
 
      D_DEBUG_AT( Direct_Map, "%s( hash %u )\n", __func__, hash );
 
      DIRECT_MAP_ASSERT( map );
      D_ASSERT( key != NULL );
 
-     pos = hash % map->size;
+     h       = direct_hash_mix( hash );
+     mask    = map->size / DIRECT_HASH_GROUP_SIZE - 1;
+     group   = (h >> 7) & mask;
+     control = CONTROL( map );
+
+     while (true) {
+          const u8       *group_control = control + group * DIRECT_HASH_GROUP_SIZE;
+          DirectHashMask  match         = direct_hash_group_match( group_control, h & 0x7f );
+
+          while (match) {
+               int             pos   = group * DIRECT_HASH_GROUP_SIZE + DIRECT_HASH_MASK_NEXT( match );
+               const MapEntry *entry = &map->entries[pos];
+
+               if (entry->hash == hash && map->compare( map, key, entry->object, map->ctx ))
+                    return pos;
 
-     entry = &map->entries[pos];
+               match = DIRECT_HASH_MASK_DROP( match );
+          }
+
+          if (direct_hash_group_match( group_control, DIRECT_HASH_CONTROL_EMPTY ))
+               return -1;
+
+          group = (group + ++step) & mask;
+     }
+}
 
-     while (entry->object) {
-          if (entry->object != REMOVED && entry->hash == hash && map->compare( map, key, entry->object, map->ctx ))
-               return pos;
+static void
+remove_entry( DirectMap *map, int pos )
+{
+     u8 *control = CONTROL( map );
 
-          if (++pos == map->size)
-               pos = 0;
+     if (direct_hash_group_match( control + (pos & ~(DIRECT_HASH_GROUP_SIZE - 1)), DIRECT_HASH_CONTROL_EMPTY ))
+          control[pos] = DIRECT_HASH_CONTROL_EMPTY;
+     else {
+          control[pos] = DIRECT_HASH_CONTROL_DELETED;
 
-          entry = &map->entries[pos];
+          map->removed++;
      }
 
-     return -1;
+     map->entries[pos].object = NULL;
+
+     map->count--;
 }
 
 static DirectResult
 resize_map( DirectMap    *map,
             unsigned int  size )
 {
-     unsigned int  i, pos;
+     unsigned int  i;
      MapEntry     *entries;
+     u8           *control;
+     const u8     *old_control = CONTROL( map );
 
      D_DEBUG_AT( Direct_Map, "%s( size %u )\n", __func__, size );
 
      DIRECT_MAP_ASSERT( map );
-     D_ASSERT( size > 3 );
+     D_ASSERT( size >= DIRECT_HASH_GROUP_SIZE );
 
-     entries = D_CALLOC( size, sizeof(MapEntry) );
+     entries = alloc_entries( size );
      if (!entries)
           return D_OOM();
 
+     control = (u8*) (entries + size);
+
      for (i=0; i<map->size; i++) {
-          MapEntry *entry = &map->entries[i];
-          MapEntry *insertElement;
+          unsigned long h;
+          int           pos;
 
-          if (entry->object && entry->object != REMOVED) {
-               pos = entry->hash % size;
+          if (old_control[i] & 0x80)
+               continue;
 
-               insertElement = &entries[pos];
-               while (insertElement->object && insertElement->object != REMOVED) {
-                   if (++pos == size)
-                       pos = 0;
-                   insertElement = &entries[pos];
-               }
+          h   = direct_hash_mix( map->entries[i].hash );
+          pos = locate_free( control, size, h );
 
-               entries[pos] = *entry;
-          }
+          control[pos] = h & 0x7f;
+          entries[pos] = map->entries[i];
      }
 
      D_FREE( map->entries );
@@ -153,7 +219,8 @@ direct_map_create( unsigned int           initial_size,
                    void                  *ctx,
                    DirectMap            **ret_map )
 {
-     DirectMap *map;
+     DirectMap    *map;
+     unsigned int  size = DIRECT_HASH_GROUP_SIZE;
 
      D_DEBUG_AT( Direct_Map, "%s( size %u, compare %p, hash %p )\n", __func__, initial_size, compare_func, hash_func );
 
@@ -161,20 +228,20 @@ direct_map_create( unsigned int           initial_size,
      D_ASSERT( hash_func != NULL );
      D_ASSERT( ret_map != NULL );
 
-     if (initial_size < 3)
-          initial_size = 3;
+     while (size < initial_size)
+          size <<= 1;
 
      map = D_CALLOC( 1, sizeof (DirectMap) );
      if (!map)
           return D_OOM();
 
-     map->entries = D_CALLOC( initial_size, sizeof(MapEntry) );
+     map->entries = alloc_entries( size );
      if (!map->entries) {
           D_FREE( map );
           return D_OOM();
      }
 
-     map->size    = initial_size;
+     map->size    = size;
      map->compare = compare_func;
      map->hash    = hash_func;
      map->ctx     = ctx;
@@ -204,9 +271,11 @@ direct_map_insert( DirectMap  *map,
                    const void *key,
                    void       *object )
 {
-     unsigned int hash;
-     int          pos;
-     MapEntry    *entry;
+     DirectResult   ret;
+     unsigned int   hash;
+     unsigned long  h;
+     int            pos;
+     u8            *control;
 
      D_DEBUG_AT( Direct_Map, "%s( key %p, object %p )\n", __func__, key, object );
 
@@ -214,41 +283,48 @@ direct_map_insert( DirectMap  *map,
      D_ASSERT( key != NULL );
      D_ASSERT( object != NULL );
 
-     /* Need to resize the map? */
-     if ((map->count + map->removed) > map->size / 4)
-          resize_map( map, map->size * 3 );
+     hash = map->hash( map, key, map->ctx );
 
-	 hash = map->hash( map, key, map->ctx );
-	 pos  = hash % map->size;
+     pos = locate_entry( map, hash, key );
+     if (pos != -1) {
+          if (map->entries[pos].object == object) {
+               D_DEBUG_AT( Direct_Map, "  -> same object with matching key already exists\n" );
+               return DR_BUSY;
+          }
+          else {
+               D_DEBUG_AT( Direct_Map, "  -> different object with matching key already exists\n" );
+               D_BUG( "different object with matching key already exists" );
+               return DR_BUG;
+          }
+     }
+
+     h       = direct_hash_mix( hash );
+     pos     = locate_free( CONTROL( map ), map->size, h );
+     control = CONTROL( map );
 
      D_DEBUG_AT( Direct_Map, "  -> hash %u, pos %d\n", hash, pos );
 
-     entry = &map->entries[pos];
+     if (control[pos] == DIRECT_HASH_CONTROL_DELETED)
+          map->removed--;
+     else if (map->count + map->removed >= DIRECT_MAP_MAX_LOAD( map->size )) {
+          /* Grow if needed, otherwise just get rid of the tombstones. */
+          unsigned int size = map->size;
 
-     while (entry->object && entry->object != REMOVED) {
-          if (entry->hash == hash && map->compare( map, key, entry->object, map->ctx )) {
-               if (entry->object == object) {
-                    D_DEBUG_AT( Direct_Map, "  -> same object with matching key already exists\n" );
-                    return DR_BUSY;
-               }
-               else {
-                    D_DEBUG_AT( Direct_Map, "  -> different object with matching key already exists\n" );
-                    D_BUG( "different object with matching key already exists" );
-                    return DR_BUG;
-               }
-          }
+          if (map->count >= DIRECT_MAP_MAX_LOAD( size ) / 2)
+               size <<= 1;
 
-          if (++pos == map->size)
-               pos = 0;
+          ret = resize_map( map, size );
+          if (ret)
+               return ret;
 
-          entry = &map->entries[pos];
+          pos     = locate_free( CONTROL( map ), map->size, h );
+          control = CONTROL( map );
      }
 
-     if (entry->object == REMOVED)
-          map->removed--;
+     control[pos] = h & 0x7f;
 
-     entry->hash   = hash;
-     entry->object = object;
+     map->entries[pos].hash   = hash;
+     map->entries[pos].object = object;
 
      map->count++;
 
@@ -277,10 +353,7 @@ direct_map_remove( DirectMap  *map,
           return DR_ITEMNOTFOUND;
      }
 
-     map->entries[pos].object = REMOVED;
-
-     map->count--;
-     map->removed++;
+     remove_entry( map, pos );
 
      D_DEBUG_AT( Direct_Map, "  -> new count = %d, removed = %d, size = %d\n", map->count, map->removed, map->size );
 
@@ -321,7 +394,7 @@ direct_map_iterate( DirectMap             *map,
      for (i=0; i<map->size; i++) {
           MapEntry *entry = &map->entries[i];
 
-          if (entry->object && entry->object != REMOVED) {
+          if (!(CONTROL( map )[i] & 0x80)) {
                switch (func( map, entry->object, ctx )) {
                     case DENUM_OK:
                          break;
@@ -330,10 +403,7 @@ direct_map_iterate( DirectMap             *map,
                          return;
 
                     case DENUM_REMOVE:
-                         entry->object = REMOVED;
-
-                         map->count--;
-                         map->removed++;
+                         remove_entry( map, i );
                }
           }
      }
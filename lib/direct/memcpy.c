@@ -43,7 +43,12 @@
 #include <direct/memcpy.h>
 #include <direct/messages.h>
 
-#if defined (ARCH_PPC) || defined (ARCH_ARM) || (SIZEOF_LONG == 8)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+# define HAVE_SSE2_MEMCPY
+#endif
+
+#if defined (ARCH_PPC) || defined (ARCH_ARM) || (SIZEOF_LONG == 8) || defined (HAVE_SSE2_MEMCPY)
 # define RUN_BENCHMARK  1
 #else
 # define RUN_BENCHMARK  0
@@ -134,8 +139,129 @@ static void * generic64_memcpy( void * to, const void * from, size_t len )
 #endif /* SIZEOF_LONG == 8 */
 
 
+#ifdef HAVE_SSE2_MEMCPY
+
+/*
+ * Unaligned loads, aligned stores, the unaligned head and tail are done by overlapping stores.
+ */
+static void * sse2_memcpy( void * to, const void * from, size_t len )
+{
+     u8       *d = (u8*)to;
+     const u8 *s = (const u8*)from;
+     size_t    delta;
+
+     if (len < 64)
+          return memcpy( to, from, len );
+
+     delta = -(unsigned long)d & 15;
+
+     _mm_storeu_si128( (__m128i*) d, _mm_loadu_si128( (const __m128i*) s ) );
+
+     d   += delta;
+     s   += delta;
+     len -= delta;
+
+     for (; len >= 64; len -= 64) {
+          __m128i x0 = _mm_loadu_si128( (const __m128i*) s + 0 );
+          __m128i x1 = _mm_loadu_si128( (const __m128i*) s + 1 );
+          __m128i x2 = _mm_loadu_si128( (const __m128i*) s + 2 );
+          __m128i x3 = _mm_loadu_si128( (const __m128i*) s + 3 );
+
+          _mm_store_si128( (__m128i*) d + 0, x0 );
+          _mm_store_si128( (__m128i*) d + 1, x1 );
+          _mm_store_si128( (__m128i*) d + 2, x2 );
+          _mm_store_si128( (__m128i*) d + 3, x3 );
+
+          d += 64; s += 64;
+     }
+
+     for (; len >= 16; len -= 16) {
+          _mm_store_si128( (__m128i*) d, _mm_loadu_si128( (const __m128i*) s ) );
+
+          d += 16; s += 16;
+     }
+
+     if (len)
+          _mm_storeu_si128( (__m128i*) (d + len - 16), _mm_loadu_si128( (const __m128i*) (s + len - 16) ) );
+
+     return to;
+}
+
+/*
+ * Non-temporal stores bypassing the caches, for copies that would evict everything else anyway.
+ */
+static void * sse2_stream_memcpy( void * to, const void * from, size_t len )
+{
+     u8       *d = (u8*)to;
+     const u8 *s = (const u8*)from;
+     size_t    delta;
+
+     if (len < 256)
+          return memcpy( to, from, len );
+
+     delta = -(unsigned long)d & 15;
+
+     _mm_storeu_si128( (__m128i*) d, _mm_loadu_si128( (const __m128i*) s ) );
+
+     d   += delta;
+     s   += delta;
+     len -= delta;
+
+     for (; len >= 64; len -= 64) {
+          __m128i x0, x1, x2, x3;
+
+          _mm_prefetch( (const char*) s + 512, _MM_HINT_NTA );
+
+          x0 = _mm_loadu_si128( (const __m128i*) s + 0 );
+          x1 = _mm_loadu_si128( (const __m128i*) s + 1 );
+          x2 = _mm_loadu_si128( (const __m128i*) s + 2 );
+          x3 = _mm_loadu_si128( (const __m128i*) s + 3 );
+
+          _mm_stream_si128( (__m128i*) d + 0, x0 );
+          _mm_stream_si128( (__m128i*) d + 1, x1 );
+          _mm_stream_si128( (__m128i*) d + 2, x2 );
+          _mm_stream_si128( (__m128i*) d + 3, x3 );
+
+          d += 64; s += 64;
+     }
+
+     for (; len >= 16; len -= 16) {
+          _mm_stream_si128( (__m128i*) d, _mm_loadu_si128( (const __m128i*) s ) );
+
+          d += 16; s += 16;
+     }
+
+     /* Order the streaming stores before anything else, e.g. an accelerator reading the data. */
+     _mm_sfence();
+
+     if (len)
+          _mm_storeu_si128( (__m128i*) (d + len - 16), _mm_loadu_si128( (const __m128i*) (s + len - 16) ) );
+
+     return to;
+}
+
+#endif /* HAVE_SSE2_MEMCPY */
+
+
 typedef void* (*memcpy_func)(void *to, const void *from, size_t len);
 
+/*
+ * Copies are split into three tiers by size, each using the fastest routine measured for it.
+ */
+#define MEMCPY_SMALL   0x01
+#define MEMCPY_MEDIUM  0x02
+#define MEMCPY_LARGE   0x04
+#define MEMCPY_ALL     (MEMCPY_SMALL | MEMCPY_MEDIUM | MEMCPY_LARGE)
+
+/* Copies from this size use the medium routine... */
+#define MEMCPY_MEDIUM_SIZE     4096
+
+/* ...and the large one from the size of the last level cache, or this size if it's unknown. */
+#define MEMCPY_LARGE_DEFAULT   (4 * 1024 * 1024)
+
+/* Limit for the buffers used to measure large copies. */
+#define MEMCPY_LARGE_BENCH     (8 * 1024 * 1024)
+
 
 static void *
 std_memcpy( void *to, const void *from, size_t len )
@@ -150,40 +276,101 @@ static struct {
      memcpy_func           function;
      unsigned long long    time;
      u32                   cpu_require;
+     unsigned int          tiers;
 } memcpy_method[] =
 {
-     { NULL, NULL, NULL, 0, 0},
-     { "libc",     "libc memcpy()",             std_memcpy, 0, 0},
+     { NULL, NULL, NULL, 0, 0, 0},
+     { "libc",     "libc memcpy()",             std_memcpy, 0, 0, MEMCPY_ALL},
 #if SIZEOF_LONG == 8
-     { "generic64","Generic 64bit memcpy()",    generic64_memcpy, 0, 0},
+     { "generic64","Generic 64bit memcpy()",    generic64_memcpy, 0, 0, MEMCPY_ALL},
 #endif /* SIZEOF_LONG == 8 */
+#ifdef HAVE_SSE2_MEMCPY
+     { "sse2",     "SSE2 memcpy()",             sse2_memcpy, 0, 0, MEMCPY_MEDIUM | MEMCPY_LARGE},
+     { "sse2nt",   "SSE2 non-temporal memcpy()", sse2_stream_memcpy, 0, 0, MEMCPY_LARGE},
+#endif /* HAVE_SSE2_MEMCPY */
 #ifdef USE_PPCASM
-     { "ppc",      "ppcasm_memcpy()",            direct_ppcasm_memcpy, 0, 0},
+     { "ppc",      "ppcasm_memcpy()",            direct_ppcasm_memcpy, 0, 0, MEMCPY_ALL},
 #ifdef __LINUX__
-     { "ppccache", "ppcasm_cacheable_memcpy()",  direct_ppcasm_cacheable_memcpy, 0, 0},
+     { "ppccache", "ppcasm_cacheable_memcpy()",  direct_ppcasm_cacheable_memcpy, 0, 0, MEMCPY_ALL},
 #endif /* __LINUX__ */
 #endif /* USE_PPCASM */
 #if defined(USE_ARMASM) && !defined(WORDS_BIGENDIAN)
-     { "arm",      "armasm_memcpy()",            direct_armasm_memcpy, 0, 0},
+     { "arm",      "armasm_memcpy()",            direct_armasm_memcpy, 0, 0, MEMCPY_ALL},
 #endif
-     { NULL, NULL, NULL, 0, 0}
+     { NULL, NULL, NULL, 0, 0, 0}
 };
 
 
 
 memcpy_func direct_memcpy = std_memcpy;
 
+static memcpy_func memcpy_small      = std_memcpy;
+static memcpy_func memcpy_medium     = std_memcpy;
+static memcpy_func memcpy_large      = std_memcpy;
+static size_t      memcpy_large_size = ~(size_t) 0;
+
+#if RUN_BENCHMARK
+static void *
+tiered_memcpy( void *to, const void *from, size_t len )
+{
+     if (len < MEMCPY_MEDIUM_SIZE)
+          return memcpy_small( to, from, len );
+
+     if (len < memcpy_large_size)
+          return memcpy_medium( to, from, len );
+
+     return memcpy_large( to, from, len );
+}
+#endif
+
 #define BUFSIZE 1024
 
+#if RUN_BENCHMARK
+/*
+ * Returns the index of the fastest method for the tier, copying num blocks of the given size.
+ */
+static int
+bench_tier( unsigned int tier, char *buf1, char *buf2, size_t size, int num )
+{
+     unsigned long long t;
+     int i, j, best = 0;
+     u32 config_flags = 0;
+
+     for (i=1; memcpy_method[i].name; i++) {
+          if (memcpy_method[i].cpu_require & ~config_flags)
+               continue;
+
+          if (!(memcpy_method[i].tiers & tier))
+               continue;
+
+          t = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+          for (j=0; j<num; j++)
+               memcpy_method[i].function( buf1 + j*size, buf2 + j*size, size );
+
+          t = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) - t;
+          memcpy_method[i].time = t;
+
+          D_DEBUG_AT( Direct_Memcpy, "\t%-10s  %20lld\n", memcpy_method[i].name, t );
+
+          if (best == 0 || t < memcpy_method[best].time)
+               best = i;
+     }
+
+     return best;
+}
+#endif
+
 void
 direct_find_best_memcpy( void )
 {
      /* Save library size and startup time
         on platforms without a special memcpy() implementation. */
 #if RUN_BENCHMARK
-     unsigned long long t;
      char *buf1, *buf2;
-     int i, j, best = 0;
+     int i, small, medium, large = 0;
+     long cachesize;
+     size_t large_size;
      u32 config_flags = 0;
 
      if (direct_config->memcpy) {
@@ -194,6 +381,10 @@ direct_find_best_memcpy( void )
 
                     direct_memcpy = memcpy_method[i].function;
 
+                    memcpy_small  = direct_memcpy;
+                    memcpy_medium = direct_memcpy;
+                    memcpy_large  = direct_memcpy;
+
                     D_INFO( "Direct/Memcpy: Forced to use %s\n", memcpy_method[i].desc );
 
                     return;
@@ -201,10 +392,10 @@ direct_find_best_memcpy( void )
           }
      }
 
-     if (!(buf1 = D_MALLOC( BUFSIZE * 500 )))
+     if (!(buf1 = D_MALLOC( BUFSIZE * 512 )))
           return;
 
-     if (!(buf2 = D_MALLOC( BUFSIZE * 500 ))) {
+     if (!(buf2 = D_MALLOC( BUFSIZE * 512 ))) {
           D_FREE( buf1 );
           return;
      }
@@ -212,38 +403,122 @@ direct_find_best_memcpy( void )
      D_DEBUG_AT( Direct_Memcpy, "Benchmarking memcpy methods (smaller is better):\n");
 
      /* make sure buffers are present on physical memory */
-     memcpy( buf1, buf2, BUFSIZE * 500 );
-     memcpy( buf2, buf1, BUFSIZE * 500 );
+     memcpy( buf1, buf2, BUFSIZE * 512 );
+     memcpy( buf2, buf1, BUFSIZE * 512 );
 
-     for (i=1; memcpy_method[i].name; i++) {
-          if (memcpy_method[i].cpu_require & ~config_flags)
-               continue;
+     D_DEBUG_AT( Direct_Memcpy, "  -> %d bytes\n", BUFSIZE );
 
-          t = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+     small = bench_tier( MEMCPY_SMALL, buf1, buf2, BUFSIZE, 500 );
 
-          for (j=0; j<500; j++)
-               memcpy_method[i].function( buf1 + j*BUFSIZE, buf2 + j*BUFSIZE, BUFSIZE );
+     D_DEBUG_AT( Direct_Memcpy, "  -> %d bytes\n", BUFSIZE * 64 );
 
-          t = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) - t;
-          memcpy_method[i].time = t;
+     medium = bench_tier( MEMCPY_MEDIUM, buf1, buf2, BUFSIZE * 64, 8 );
 
-          D_DEBUG_AT( Direct_Memcpy, "\t%-10s  %20lld\n", memcpy_method[i].name, t );
+     D_FREE( buf1 );
+     D_FREE( buf2 );
 
-          if (best == 0 || t < memcpy_method[best].time)
-               best = i;
+     /* Large copies only differ when they don't fit into the cache. */
+     cachesize  = direct_cachesize();
+     large_size = cachesize ? cachesize : MEMCPY_LARGE_DEFAULT;
+
+     if (large_size < MEMCPY_LARGE_BENCH && (buf1 = D_MALLOC( large_size * 2 ))) {
+          memset( buf1, 0, large_size * 2 );
+
+          D_DEBUG_AT( Direct_Memcpy, "  -> %zu bytes\n", large_size );
+
+          large = bench_tier( MEMCPY_LARGE, buf1, buf1 + large_size, large_size, 1 );
+
+          D_FREE( buf1 );
      }
+     else if ((buf1 = D_MALLOC( MEMCPY_LARGE_BENCH )) && (buf2 = D_MALLOC( MEMCPY_LARGE_BENCH ))) {
+          memset( buf1, 0, MEMCPY_LARGE_BENCH );
+          memset( buf2, 0, MEMCPY_LARGE_BENCH );
 
-     if (best) {
-          direct_memcpy = memcpy_method[best].function;
+          D_DEBUG_AT( Direct_Memcpy, "  -> %d bytes\n", MEMCPY_LARGE_BENCH );
 
-          D_INFO( "Direct/Memcpy: Using %s\n", memcpy_method[best].desc );
+          large = bench_tier( MEMCPY_LARGE, buf1, buf2, MEMCPY_LARGE_BENCH, 1 );
+
+          D_FREE( buf1 );
+          D_FREE( buf2 );
      }
+     else if (buf1)
+          D_FREE( buf1 );
 
-     D_FREE( buf1 );
-     D_FREE( buf2 );
+     if (!small)
+          return;
+
+     if (!medium)
+          medium = small;
+
+     if (!large)
+          large = medium;
+
+     memcpy_small      = memcpy_method[small].function;
+     memcpy_medium     = memcpy_method[medium].function;
+     memcpy_large      = memcpy_method[large].function;
+     memcpy_large_size = large_size;
+
+     if (small == medium && medium == large) {
+          direct_memcpy = memcpy_small;
+
+          D_INFO( "Direct/Memcpy: Using %s\n", memcpy_method[small].desc );
+     }
+     else {
+          direct_memcpy = tiered_memcpy;
+
+          D_INFO( "Direct/Memcpy: Using %s, %s from %d bytes, %s from %zu bytes\n", memcpy_method[small].desc,
+                  memcpy_method[medium].desc, MEMCPY_MEDIUM_SIZE, memcpy_method[large].desc, large_size );
+     }
 #endif
 }
 
+void
+direct_memcpy_2d( void       *to,
+                  int         to_pitch,
+                  const void *from,
+                  int         from_pitch,
+                  size_t      bytes,
+                  int         height )
+{
+     u8          *d = to;
+     const u8    *s = from;
+     size_t       total;
+     memcpy_func  func;
+
+     D_ASSERT( to != NULL );
+     D_ASSERT( from != NULL );
+     D_ASSERT( height >= 0 );
+
+     if (!bytes || height <= 0)
+          return;
+
+     D_ASSERT( to_pitch >= bytes || height == 1 );
+     D_ASSERT( from_pitch >= bytes || height == 1 );
+
+     total = bytes * height;
+
+     /* Without padding it's a single copy. */
+     if (to_pitch == from_pitch && to_pitch == bytes) {
+          direct_memcpy( to, from, total );
+          return;
+     }
+
+     /* Choose by the total size, streaming copies of short rows are not worth it though. */
+     if (total >= memcpy_large_size && bytes >= 1024)
+          func = memcpy_large;
+     else if (bytes >= MEMCPY_MEDIUM_SIZE)
+          func = memcpy_medium;
+     else
+          func = memcpy_small;
+
+     while (height--) {
+          func( d, s, bytes );
+
+          d += to_pitch;
+          s += from_pitch;
+     }
+}
+
 void
 direct_print_memcpy_routines( void )
 {
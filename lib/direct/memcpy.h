@@ -41,6 +41,18 @@ void DIRECT_API direct_print_memcpy_routines( void );
 
 extern void DIRECT_API *(*direct_memcpy)( void *to, const void *from, size_t len );
 
+/*
+ * Copies height rows of bytes each, e.g. for surface uploads or readbacks.
+ *
+ * The routine is chosen by the total size, so that large transfers bypass the caches.
+ */
+void DIRECT_API direct_memcpy_2d( void       *to,
+                                  int         to_pitch,
+                                  const void *from,
+                                  int         from_pitch,
+                                  size_t      bytes,
+                                  int         height );
+
 static __inline__ void *direct_memmove( void *to, const void *from, size_t len )
 {
      if ((from < to && ((const char*) from + len) < ((char*) to)) ||
@@ -71,6 +71,22 @@ direct_page_align( unsigned long value )
      return (value + mask) & ~mask;
 }
 
+long
+direct_cachesize( void )
+{
+     long size = 0;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+     size = sysconf( _SC_LEVEL3_CACHE_SIZE );
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+     if (size <= 0)
+          size = sysconf( _SC_LEVEL2_CACHE_SIZE );
+#endif
+
+     return (size > 0) ? size : 0;
+}
+
 /**********************************************************************************************************************/
 
 pid_t
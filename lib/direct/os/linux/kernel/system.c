@@ -63,6 +63,12 @@ direct_page_align( unsigned long value )
      return (value + mask) & ~mask;
 }
 
+long
+direct_cachesize( void )
+{
+     return 0;
+}
+
 /**********************************************************************************************************************/
 
 pid_t
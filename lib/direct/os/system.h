@@ -45,6 +45,9 @@ long          DIRECT_API  direct_pagesize( void );
 
 unsigned long DIRECT_API  direct_page_align( unsigned long value );
 
+/* Size of the last level cache in bytes, zero if unknown. */
+long          DIRECT_API  direct_cachesize( void );
+
 pid_t         DIRECT_API  direct_getpid( void );
 pid_t         DIRECT_API  direct_gettid( void );
 
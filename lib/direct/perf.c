@@ -31,12 +31,15 @@
 
 #include <config.h>
 
+#include <direct/atomic.h>
 #include <direct/clock.h>
 #include <direct/debug.h>
 #include <direct/hash.h>
 #include <direct/mem.h>
 #include <direct/messages.h>
 #include <direct/perf.h>
+#include <direct/thread.h>
+#include <direct/util.h>
 
 
 
@@ -51,6 +54,10 @@ static DirectMutex    counter_lock;
 static unsigned long  counter_ids;
 static DirectThread  *counter_dump_thread;
 
+static DirectCounter *counters;           /* Registered counters, locked by counter_lock. */
+static DirectTLS      counter_shard_key;  /* Shard of the calling thread plus one. */
+static unsigned int   counter_shards;     /* Used for round robin assignment of shards to threads. */
+
 /**********************************************************************************************************************/
 
 void
@@ -59,8 +66,10 @@ __D_perf_init()
      direct_hash_init( &counter_hash, 7 );
      direct_mutex_init( &counter_lock );
 
+     direct_tls_register( &counter_shard_key, NULL );
+
      if (direct_config->perf_dump_interval)
-          direct_thread_create( DTT_DEFAULT, direct_perf_dump_thread, NULL, "Perf Dump" );
+          counter_dump_thread = direct_thread_create( DTT_DEFAULT, direct_perf_dump_thread, NULL, "Perf Dump" );
 }
 
 void
@@ -80,6 +89,27 @@ __D_perf_deinit()
 
      //direct_perf_dump_all();
 
+     direct_mutex_lock( &counter_lock );
+
+     while (counters) {
+          DirectCounter *counter = counters;
+
+          counters = counter->next;
+
+          if (counter->bins)
+               D_FREE( counter->bins );
+
+          memset( counter->shards, 0, sizeof(counter->shards) );
+
+          counter->bins       = NULL;
+          counter->next       = NULL;
+          counter->registered = false;
+     }
+
+     direct_mutex_unlock( &counter_lock );
+
+     direct_tls_unregister( &counter_shard_key );
+
      direct_hash_deinit( &counter_hash );
      direct_mutex_deinit( &counter_lock );
 }
@@ -153,6 +183,30 @@ perf_iterate( DirectHash    *hash,
      return true;
 }
 
+static bool
+counter_iterate( const DirectCounterValue *value,
+                 void                     *ctx )
+{
+     double rate = 0.0;
+
+     if (!value->count)
+          return true;
+
+     if (value->stop > value->start)
+          rate = value->count * 1000000.0 / (double)(value->stop - value->start);
+
+     if (value->type == DCT_HISTOGRAM)
+          direct_log_printf( NULL, "  %-60s  %12llu  (%7.3f/sec)  avg %llu, 50%% <= %llu, 90%% <= %llu, 99%% <= %llu\n",
+                             value->name, value->count, rate, value->sum / value->count,
+                             direct_counter_percentile( value, 50 ),
+                             direct_counter_percentile( value, 90 ),
+                             direct_counter_percentile( value, 99 ) );
+     else
+          direct_log_printf( NULL, "  %-60s  %12llu  (%7.3f/sec)\n", value->name, value->count, rate );
+
+     return true;
+}
+
 void
 direct_perf_dump_all()
 {
@@ -165,8 +219,177 @@ direct_perf_dump_all()
      }
 
      direct_mutex_unlock( &counter_lock );
+
+     if (counters) {
+          direct_log_printf( NULL, "Counters                                                           Total count    rate\n" );
+
+          direct_counters_enum( counter_iterate, NULL );
+     }
+}
+
+/**********************************************************************************************************************/
+
+static void
+counter_register( DirectCounter *counter )
+{
+     direct_mutex_lock( &counter_lock );
+
+     if (!counter->registered) {
+          D_ASSERT( counter->name != NULL );
+
+          if (counter->type == DCT_HISTOGRAM) {
+               counter->bins = D_CALLOC( DIRECT_COUNTER_SHARDS * DIRECT_COUNTER_BINS, sizeof(unsigned int) );
+               if (!counter->bins)
+                    D_OOM();
+          }
+
+          counter->start = direct_clock_get_time( DIRECT_CLOCK_SESSION );
+          counter->next  = counters;
+
+          counters = counter;
+
+          counter->registered = true;
+     }
+
+     direct_mutex_unlock( &counter_lock );
+}
+
+static __inline__ unsigned int
+counter_shard( void )
+{
+     unsigned long shard = (unsigned long) direct_tls_get( counter_shard_key );
+
+     if (!shard) {
+          shard = D_SYNC_ADD_AND_FETCH( &counter_shards, 1 ) % DIRECT_COUNTER_SHARDS + 1;
+
+          direct_tls_set( counter_shard_key, (void*) shard );
+     }
+
+     return shard - 1;
+}
+
+static __inline__ int
+counter_bin( unsigned long value )
+{
+     if (value <= 1)
+          return 0;
+
+     if (value > 1UL << (DIRECT_COUNTER_BINS - 2))
+          return DIRECT_COUNTER_BINS - 1;
+
+     return direct_log2( value );
+}
+
+void
+direct_counter_add( DirectCounter *counter,
+                    unsigned long  value )
+{
+     unsigned int        index;
+     DirectCounterShard *shard;
+
+     D_ASSERT( counter != NULL );
+
+     if (!counter->registered)
+          counter_register( counter );
+
+     index = counter_shard();
+     shard = &counter->shards[index];
+
+     if (counter->type == DCT_EVENTS) {
+          D_SYNC_ADD( &shard->count, value );
+          return;
+     }
+
+     D_SYNC_ADD( &shard->count, 1 );
+     D_SYNC_ADD( &shard->sum, value );
+
+     if (counter->bins)
+          D_SYNC_ADD( &counter->bins[index * DIRECT_COUNTER_BINS + counter_bin( value )], 1 );
+}
+
+void
+direct_counter_get( DirectCounter      *counter,
+                    DirectCounterValue *ret_value )
+{
+     int i, n;
+
+     D_ASSERT( counter != NULL );
+     D_ASSERT( ret_value != NULL );
+
+     memset( ret_value, 0, sizeof(DirectCounterValue) );
+
+     ret_value->name = counter->name;
+     ret_value->type = counter->type;
+
+     if (!counter->registered)
+          return;
+
+     ret_value->start = counter->start;
+     ret_value->stop  = direct_clock_get_time( DIRECT_CLOCK_SESSION );
+
+     for (i=0; i<DIRECT_COUNTER_SHARDS; i++) {
+          ret_value->count += counter->shards[i].count;
+          ret_value->sum   += counter->shards[i].sum;
+
+          if (counter->bins) {
+               for (n=0; n<DIRECT_COUNTER_BINS; n++)
+                    ret_value->bins[n] += counter->bins[i * DIRECT_COUNTER_BINS + n];
+          }
+     }
+}
+
+unsigned long long
+direct_counter_percentile( const DirectCounterValue *value,
+                           int                       percent )
+{
+     int                i;
+     unsigned long long total = 0;
+     unsigned long long threshold;
+
+     D_ASSERT( value != NULL );
+     D_ASSERT( percent >= 0 && percent <= 100 );
+
+     for (i=0; i<DIRECT_COUNTER_BINS; i++)
+          total += value->bins[i];
+
+     if (!total)
+          return 0;
+
+     threshold = (total * percent + 99) / 100;
+
+     for (i=0, total=0; i<DIRECT_COUNTER_BINS - 1; i++) {
+          total += value->bins[i];
+
+          if (total >= threshold)
+               break;
+     }
+
+     return 1ULL << i;
+}
+
+void
+direct_counters_enum( DirectCounterCallback  callback,
+                      void                  *ctx )
+{
+     DirectCounter      *counter;
+     DirectCounterValue  value;
+
+     D_ASSERT( callback != NULL );
+
+     direct_mutex_lock( &counter_lock );
+
+     for (counter = counters; counter; counter = counter->next) {
+          direct_counter_get( counter, &value );
+
+          if (!callback( &value, ctx ))
+               break;
+     }
+
+     direct_mutex_unlock( &counter_lock );
 }
 
+/**********************************************************************************************************************/
+
 static void *
 direct_perf_dump_thread( DirectThread *thread,
                          void         *arg )
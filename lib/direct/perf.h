@@ -91,6 +91,100 @@ typedef struct {
 void direct_perf_count( DirectPerfCounterInstallation *installation, int index );
 
 
+/**********************************************************************************************************************/
+
+/*
+ * Counters available in all builds
+ *
+ * Each thread counts in one of a few shards of a counter, each on its own cache line,
+ * so counting is a single atomic add rarely contending with other threads. Shards are
+ * summed up when the counter is read.
+ *
+ * Histograms count values like latencies in micro seconds in power of two bins.
+ */
+
+#define DIRECT_COUNTER_SHARDS      8
+#define DIRECT_COUNTER_BINS       32
+
+typedef enum {
+     DCT_EVENTS     = 0x00000000,  /* Number of events. */
+     DCT_HISTOGRAM  = 0x00000001   /* Distribution of values. */
+} DirectCounterType;
+
+typedef struct {
+     unsigned long       count;
+     unsigned long       sum;
+
+     unsigned long       pad[64 / sizeof(long) - 2];    /* Own cache line for each shard. */
+} DirectCounterShard;
+
+typedef struct __D_DirectCounter DirectCounter;
+
+struct __D_DirectCounter {
+     const char         *name;
+     DirectCounterType   type;
+
+     bool                registered;
+     DirectCounter      *next;
+
+     unsigned int       *bins;         /* Bins of all shards for histograms. */
+     long long           start;        /* Time of registration. */
+
+     DirectCounterShard  shards[DIRECT_COUNTER_SHARDS];
+};
+
+typedef struct {
+     const char         *name;
+     DirectCounterType   type;
+
+     unsigned long long  count;
+     unsigned long long  sum;
+     unsigned long long  bins[DIRECT_COUNTER_BINS];   /* Bin i counts values up to 2^i. */
+
+     long long           start;
+     long long           stop;
+} DirectCounterValue;
+
+
+#define D_COUNTER( _identifier, _name )                \
+     DirectCounter _identifier = { (_name), DCT_EVENTS }
+
+#define D_HISTOGRAM( _identifier, _name )              \
+     DirectCounter _identifier = { (_name), DCT_HISTOGRAM }
+
+
+#define D_COUNT( _identifier )                         \
+     direct_counter_add( &_identifier, 1 )
+
+#define D_COUNT_N( _identifier, _num )                 \
+     direct_counter_add( &_identifier, _num )
+
+#define D_COUNT_VALUE( _identifier, _value )           \
+     direct_counter_add( &_identifier, _value )
+
+
+/*
+ * Adds events to a counter or a value to a histogram, registering it on first use.
+ */
+void         direct_counter_add    ( DirectCounter            *counter,
+                                     unsigned long             value );
+
+void         direct_counter_get    ( DirectCounter            *counter,
+                                     DirectCounterValue       *ret_value );
+
+/*
+ * Returns the upper bound of the bin containing the given percentile of a histogram.
+ */
+unsigned long long direct_counter_percentile( const DirectCounterValue *value,
+                                              int                       percent );
+
+typedef bool (*DirectCounterCallback)( const DirectCounterValue *value,
+                                       void                     *ctx );
+
+void         direct_counters_enum  ( DirectCounterCallback     callback,
+                                     void                     *ctx );
+
+
 void direct_perf_dump_all( void );
 
 
@@ -39,6 +39,7 @@
 #include <direct/list.h>
 #include <direct/mem.h>
 #include <direct/messages.h>
+#include <direct/perf.h>
 #include <direct/signals.h>
 #include <direct/system.h>
 #include <direct/thread.h>
@@ -562,6 +563,8 @@ handle_signals( DirectThread *thread,
 
                     direct_evlog_dump_all();
 
+                    direct_perf_dump_all();
+
                     call_handlers( info.si_signo, NULL );
                }
                else {
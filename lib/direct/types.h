@@ -67,6 +67,7 @@ typedef enum {
 } DirectEnumerationResult;
 
 
+typedef struct __D_DirectArena               DirectArena;
 typedef struct __D_DirectCleanupHandler      DirectCleanupHandler;
 typedef struct __D_DirectConfig              DirectConfig;
 typedef struct __D_DirectFifo                DirectFifo;
@@ -80,6 +81,7 @@ typedef struct __D_DirectMap                 DirectMap;
 typedef struct __D_DirectModuleDir           DirectModuleDir;
 typedef struct __D_DirectModuleEntry         DirectModuleEntry;
 typedef struct __D_DirectMutex               DirectMutex;
+typedef struct __D_DirectPool                DirectPool;
 typedef struct __D_DirectProcessor           DirectProcessor;
 typedef struct __D_DirectSerial              DirectSerial;
 typedef struct __D_DirectSignalHandler       DirectSignalHandler;
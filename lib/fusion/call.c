@@ -44,6 +44,7 @@
 #include <direct/mem.h>
 #include <direct/memcpy.h>
 #include <direct/messages.h>
+#include <direct/perf.h>
 
 #include <fusion/call.h>
 #include <fusion/conf.h>
@@ -55,6 +56,33 @@
 
 D_DEBUG_DOMAIN( Fusion_Call, "Fusion/Call", "Fusion Call" );
 
+static D_COUNTER( Fusion_Call_Execute, "Fusion/Call/Execute" );
+
+/*
+ * Handle of a call executed via fusion_call_execute_async().
+ */
+struct __Fusion_FusionCallCompletion {
+     int                  magic;
+
+     FusionWorldShared   *shared;
+
+     void                *reply;       /* Pending reply slot (user space transport only). */
+
+     unsigned int         ret_length;  /* Length of the return data following, if completed. */
+};
+
+static void
+fusion_call_completion_copy( const FusionCallCompletion *completion,
+                             void                       *ret_ptr,
+                             unsigned int               *ret_length )
+{
+     if (completion->ret_length && ret_ptr)
+          direct_memcpy( ret_ptr, completion + 1, completion->ret_length );
+
+     if (ret_length)
+          *ret_length = completion->ret_length;
+}
+
 
 #if FUSION_BUILD_MULTI
 
@@ -322,6 +350,8 @@ fusion_call_execute (FusionCall          *call,
 
      D_ASSERT( call != NULL );
 
+     D_COUNT( Fusion_Call_Execute );
+
      if (!call->handler)
           return DR_DESTROYED;
 
@@ -400,6 +430,8 @@ fusion_call_execute2(FusionCall          *call,
 
      D_ASSERT( call != NULL );
 
+     D_COUNT( Fusion_Call_Execute );
+
 //     if (!call->handler)
 //          return DR_DESTROYED;
 
@@ -482,6 +514,8 @@ fusion_call_execute3(FusionCall          *call,
 
      D_ASSERT( call != NULL );
 
+     D_COUNT( Fusion_Call_Execute );
+
 //     if (!call->handler)
 //          return DR_DESTROYED;
 
@@ -1011,8 +1045,8 @@ out:
 
 #else /* FUSION_BUILD_KERNEL */
 
-#include <fcntl.h>
-#include <unistd.h>
+#include <direct/atomic.h>
+#include <direct/system.h>
 
 
 typedef struct {
@@ -1024,6 +1058,45 @@ typedef struct {
      void     *ctx;
 } CallInfo;
 
+/*
+ * Reply slot of a synchronous call, allocated by the caller in the message pool.
+ *
+ * The call serial is the distance of the slot to the end of the world's shared memory range,
+ * so the return can be stored directly without any lookup. The caller only sleeps if the
+ * return is not there yet, in which case the returning side wakes it up.
+ */
+typedef struct {
+     int           state;    /* 0 pending, 1 caller sleeping, 2 returned */
+     unsigned int  size;
+     unsigned int  length;
+     unsigned int  reserved; /* Keeps the return data aligned. */
+} CallReply;
+
+static __inline__ CallReply *
+call_reply( const FusionWorldShared *shared, unsigned int serial )
+{
+     return (CallReply*) ((u8*) shared->pool_max - serial);
+}
+
+static void
+call_reply_publish( CallReply *reply, unsigned int length )
+{
+     D_ASSERT( length <= reply->size );
+
+     reply->length = length;
+
+     if (!D_SYNC_BOOL_COMPARE_AND_SWAP( &reply->state, 0, 2 )) {
+          D_ASSERT( reply->state == 1 );
+
+          /* Release the return data before the plain store of the state. */
+          D_SYNC_SYNCHRONIZE();
+
+          reply->state = 2;
+
+          direct_futex_wake( &reply->state, 1 );
+     }
+}
+
 DirectResult
 fusion_call_init (FusionCall        *call,
                   FusionCallHandler  handler,
@@ -1158,6 +1231,112 @@ fusion_call_set_name( FusionCall *call,
      return DR_OK;
 }
 
+static __inline__ bool
+call_is_direct( const FusionCall *call, const FusionWorld *world, FusionCallExecFlags flags )
+{
+     return call->fusion_id == fusion_id( world ) &&
+            (!(flags & FCEF_NODIRECT) || (call->handler3 && (direct_thread_self() == world->dispatch_loop)));
+}
+
+/*
+ * Posts the call message, for a return a reply slot is allocated and returned.
+ */
+static DirectResult
+call_post( FusionCall           *call,
+           FusionCallExecFlags   flags,
+           int                   call_arg,
+           void                 *call_ptr,
+           unsigned int          length,
+           unsigned int          ret_size,
+           CallReply           **ret_reply )
+{
+     DirectResult       ret;
+     FusionWorld       *world;
+     FusionWorldShared *shared;
+     CallReply         *reply = NULL;
+
+     char               msg_buf[sizeof(FusionCallMessage) + length];
+     FusionCallMessage *msg = (FusionCallMessage *) msg_buf;
+
+     world  = _fusion_world( call->shared );
+     shared = world->shared;
+
+     msg->type        = FMT_CALL;
+     msg->caller      = world->fusion_id;
+     msg->call_id     = call->call_id;
+     msg->call_arg    = call_arg;
+     msg->call_length = length;
+     msg->ret_length  = ret_size;
+     msg->handler     = call->handler;
+     msg->handler3    = call->handler3;
+     msg->ctx         = call->ctx;
+     msg->flags       = flags;
+
+     direct_memcpy( msg + 1, call_ptr, length );
+     
+     if (flags & FCEF_ONEWAY) {
+          D_ASSERT( ret_reply == NULL );
+
+          /* Invalidate serial. */
+          msg->serial = -1;
+     }
+     else {
+          D_ASSERT( ret_reply != NULL );
+
+          reply = SHMALLOC( shared->message_pool, sizeof(CallReply) + ret_size );
+          if (!reply)
+               return D_OOSHM();
+
+          reply->state  = 0;
+          reply->size   = ret_size;
+          reply->length = 0;
+
+          msg->serial = (u8*) shared->pool_max - (u8*) reply;
+     }
+
+     /* Send message. */
+     ret = _fusion_post_message( world, call->fusion_id, msg, sizeof(FusionCallMessage) + length );
+     if (ret) {
+          if (reply)
+               SHFREE( shared->message_pool, reply );
+
+          return ret;
+     }
+
+     if (ret_reply)
+          *ret_reply = reply;
+
+     return DR_OK;
+}
+
+/*
+ * Waits for the return unless it's already there, copies it and frees the reply slot.
+ */
+static void
+call_reply_wait( FusionWorldShared *shared,
+                 CallReply         *reply,
+                 void              *ret_ptr,
+                 unsigned int      *ret_length )
+{
+     if (D_SYNC_BOOL_COMPARE_AND_SWAP( &reply->state, 0, 1 )) {
+          while (reply->state == 1)
+               direct_futex_wait( &reply->state, 1 );
+     }
+
+     /* Acquire the return data published along with the state. */
+     D_SYNC_SYNCHRONIZE();
+
+     D_ASSERT( reply->length <= reply->size );
+
+     if (reply->length && ret_ptr)
+          direct_memcpy( ret_ptr, reply + 1, reply->length );
+
+     if (ret_length)
+          *ret_length = reply->length;
+
+     SHFREE( shared->message_pool, reply );
+}
+
 static DirectResult
 fusion_call_execute_internal (FusionCall          *call,
                               FusionCallExecFlags  flags,
@@ -1168,26 +1347,21 @@ fusion_call_execute_internal (FusionCall          *call,
                               unsigned int         ret_size,
                               unsigned int        *ret_length)
 {
-     DirectResult        ret = DR_OK;
-     FusionWorld        *world;
-     struct sockaddr_un  addr;
-     
-
-     char               msg_buf[sizeof(FusionCallMessage) + length];
-     FusionCallMessage *msg = (FusionCallMessage *) msg_buf;
-
+     DirectResult  ret;
+     FusionWorld  *world;
+     CallReply    *reply;
 
      D_ASSERT( call != NULL );
 
+     D_COUNT( Fusion_Call_Execute );
+
      if (!call->handler && !call->handler3)
           return DR_DESTROYED;
 
      world = _fusion_world( call->shared );
 
      //D_INFO_LINE_MSG("call execute %d owner %lu, me %lu\n",call->call_id,call->fusion_id, _fusion_id( call->shared ));
-     if (call->fusion_id == fusion_id( world ) &&
-         (!(flags & FCEF_NODIRECT) || (call->handler3 && (direct_thread_self() == world->dispatch_loop))))
-     {
+     if (call_is_direct( call, world, flags )) {
           FusionCallHandlerResult result;
 
           if (call->handler) {
@@ -1205,100 +1379,17 @@ fusion_call_execute_internal (FusionCall          *call,
                
           return DR_OK;
      }
-     
-     msg->type        = FMT_CALL;
-     msg->caller      = world->fusion_id;
-     msg->call_id     = call->call_id;
-     msg->call_arg    = call_arg;
-     msg->call_length = length;
-     msg->ret_length  = ret_size;
-     msg->handler     = call->handler;
-     msg->handler3    = call->handler3;
-     msg->ctx         = call->ctx;
-     msg->flags       = flags;
-
-     direct_memcpy( msg + 1, call_ptr, length );
-     
-     if (flags & FCEF_ONEWAY) {
-          /* Invalidate serial. */
-          msg->serial = -1;
-          
-          /* Send message. */
-          addr.sun_family = AF_UNIX;
-          snprintf( addr.sun_path, sizeof(addr.sun_path), 
-                    "/tmp/.fusion-%d/%lx", call->shared->world_index, call->fusion_id );
 
-          ret = _fusion_send_message( world->fusion_fd, msg, sizeof(FusionCallMessage) + length, &addr );
-     }
-     else {
-          int       fd;
-          socklen_t len;
-          int       err;
-
-          fd = socket( PF_LOCAL, SOCK_RAW, 0 );
-          if (fd < 0) {
-               D_PERROR( "Fusion/Call: Error creating local socket!\n" ) ;
-               return DR_IO;
-          }
+     if (flags & FCEF_ONEWAY)
+          return call_post( call, flags, call_arg, call_ptr, length, ret_size, NULL );
 
-          /* Set close-on-exec flag. */
-          fcntl( fd, F_SETFD, FD_CLOEXEC );
-          
-          addr.sun_family = AF_UNIX;
-          len = snprintf( addr.sun_path, sizeof(addr.sun_path), 
-                          "/tmp/.fusion-%d/call.%x.", fusion_world_index( world ), call->call_id ); 
-          
-          /* Generate call serial (socket address is based on it). */
-          for (msg->serial = 0; msg->serial <= 0xffffff; msg->serial++) {
-               snprintf( addr.sun_path+len, sizeof(addr.sun_path)-len, "%x", msg->serial );
-               err = bind( fd, (struct sockaddr*)&addr, sizeof(addr) );
-               if (err == 0) {
-                    chmod( addr.sun_path, 0660 );
-                    /* Change group, if requested. */
-                    if (fusion_config->shmfile_gid != (gid_t)-1)
-                         chown( addr.sun_path, -1, fusion_config->shmfile_gid );
-                    break;
-               }
-          }
-          
-          if (err < 0) {
-               D_PERROR( "Fusion/Call: Error binding local socket!\n" );
-               close( fd );
-               return DR_IO;
-          }
-
-          /* Send message. */
-          snprintf( addr.sun_path, sizeof(addr.sun_path), 
-                    "/tmp/.fusion-%d/%lx", call->shared->world_index, call->fusion_id );
-
-          ret = _fusion_send_message( fd, msg, sizeof(FusionCallMessage) + length, &addr );
-          if (ret == DR_OK) {
-               char              buf[sizeof(FusionCallReturn) + ret_size];
-               FusionCallReturn *callret = (FusionCallReturn *) buf;
-
-               /* Wait for reply. */
-               ret = _fusion_recv_message( fd, buf, sizeof(FusionCallReturn) + ret_size, NULL );
-               if (ret == DR_OK) {
-                    D_ASSERT( callret->length <= ret_size );
-
-                    if (callret->length) {
-                         D_ASSERT( ret_ptr != NULL );
+     ret = call_post( call, flags, call_arg, call_ptr, length, ret_size, &reply );
+     if (ret)
+          return ret;
 
-                         direct_memcpy( ret_ptr, callret + 1, callret->length );
-                    }
+     call_reply_wait( world->shared, reply, ret_ptr, ret_length );
 
-                    if (ret_length)
-                         *ret_length = callret->length;
-               } 
-          }
-          
-          len = sizeof(addr);
-          if (getsockname( fd, (struct sockaddr*)&addr, &len ) == 0)
-               unlink( addr.sun_path );
-          close( fd );
-     }
-
-     return ret;
+     return DR_OK;
 }
 
 DirectResult
@@ -1335,33 +1426,105 @@ fusion_call_execute3(FusionCall          *call,
      return fusion_call_execute_internal( call, flags, call_arg, call_ptr, length, ret_ptr, ret_size, ret_length );
 }
 
+DirectResult
+fusion_call_execute_async( FusionCall            *call,
+                           FusionCallExecFlags    flags,
+                           int                    call_arg,
+                           void                  *ptr,
+                           unsigned int           length,
+                           unsigned int           ret_size,
+                           FusionCallCompletion **ret_completion )
+{
+     DirectResult          ret;
+     FusionWorld          *world;
+     FusionCallCompletion *completion;
+
+     D_DEBUG_AT( Fusion_Call, "%s( %p, flags 0x%x, arg %d, ptr %p, length %u, ret_size %u )\n",
+                 __FUNCTION__, call, flags, call_arg, ptr, length, ret_size );
+
+     D_ASSERT( call != NULL );
+     D_ASSERT( ret_completion != NULL );
+
+     if (!call->handler && !call->handler3)
+          return DR_DESTROYED;
+
+     flags &= ~(FCEF_ONEWAY | FCEF_QUEUE);
+
+     world = _fusion_world( call->shared );
+
+     completion = D_CALLOC( 1, sizeof(FusionCallCompletion) + ret_size );
+     if (!completion)
+          return D_OOM();
+
+     completion->shared = call->shared;
+
+     if (call_is_direct( call, world, flags )) {
+          completion->ret_length = call->handler ? sizeof(int) : 0;
+
+          ret = fusion_call_execute_internal( call, flags, call_arg, ptr, length, completion + 1, ret_size, &completion->ret_length );
+     }
+     else
+          ret = call_post( call, flags, call_arg, ptr, length, ret_size, (CallReply**) &completion->reply );
+
+     if (ret) {
+          D_FREE( completion );
+          return ret;
+     }
+
+     D_MAGIC_SET( completion, FusionCallCompletion );
+
+     *ret_completion = completion;
+
+     return DR_OK;
+}
+
+DirectResult
+fusion_call_completion_wait( FusionCallCompletion *completion,
+                             void                 *ret_ptr,
+                             unsigned int         *ret_length )
+{
+     D_MAGIC_ASSERT( completion, FusionCallCompletion );
+
+     D_DEBUG_AT( Fusion_Call, "%s( %p )\n", __FUNCTION__, completion );
+
+     if (completion->reply)
+          call_reply_wait( completion->shared, completion->reply, ret_ptr, ret_length );
+     else
+          fusion_call_completion_copy( completion, ret_ptr, ret_length );
+
+     D_MAGIC_CLEAR( completion );
+
+     D_FREE( completion );
+
+     return DR_OK;
+}
+
 static DirectResult
 fusion_call_return_internal( FusionCall   *call,
                              unsigned int  serial,
                              const void   *ptr,
                              unsigned int  length )
 {
-     struct sockaddr_un addr;
-
-     char              buf[sizeof(FusionCallReturn) + length];
-     FusionCallReturn *callret = (FusionCallReturn *) buf;
+     CallReply *reply;
 
      D_ASSERT( call != NULL );
 
-     addr.sun_family = AF_UNIX;
-     snprintf( addr.sun_path, sizeof(addr.sun_path), 
-               "/tmp/.fusion-%d/call.%x.%x", call->shared->world_index, call->call_id, serial );
+     reply = call_reply( call->shared, serial );
 
-     callret->type   = FMT_CALLRET;
-     callret->length = length;
+     if (length > reply->size) {
+          D_WARN( "return of %u bytes exceeds %u", length, reply->size );
+          length = reply->size;
+     }
 
      if (length) {
           D_ASSERT( ptr != NULL );
 
-          direct_memcpy( callret + 1, ptr, length );
+          direct_memcpy( reply + 1, ptr, length );
      }
 
-     return _fusion_send_message( _fusion_fd( call->shared ), callret, sizeof(FusionCallReturn) + length, &addr );
+     call_reply_publish( reply, length );
+
+     return DR_OK;
 }
 
 DirectResult
@@ -1448,77 +1611,60 @@ fusion_world_flush_calls( FusionWorld *world, int lock )
 void
 _fusion_call_process( FusionWorld *world, int call_id, FusionCallMessage *msg, void *ptr )
 {
-     FusionCallHandlerResult result;
+     FusionCallHandlerResult  result;
+     CallReply               *reply = NULL;
+     void                    *ret_ptr;
+     unsigned int             ret_length;
 
      D_MAGIC_ASSERT( world, FusionWorld );
      D_ASSERT( msg != NULL );
 
-     char              buf[sizeof(FusionCallReturn) + msg->ret_length];
-     FusionCallReturn *callret = (FusionCallReturn *) buf;
+     char buf[sizeof(int) + msg->ret_length];
+
+     /* Let the handler write into the reply slot of the caller directly. */
+     if (msg->flags & FCEF_ONEWAY) {
+          ret_ptr = buf;
+     }
+     else {
+          reply   = call_reply( world->shared, msg->serial );
+          ret_ptr = reply + 1;
+
+          D_ASSERT( reply->size == msg->ret_length );
+     }
 
      if (msg->handler) {
           FusionCallHandler call_handler = msg->handler;
 
           D_ASSERT( call_handler != NULL );
 
-          callret->type   = FMT_CALLRET;
-          callret->length = sizeof(int);
-
           D_ASSERT( msg->call_length == sizeof(void*) );
 
-          result = call_handler( msg->caller, msg->call_arg, ptr, msg->ctx, msg->serial, (int*)(callret + 1) );
-          switch (result) {
-               case FCHR_RETURN:
-                    if (!(msg->flags & FCEF_ONEWAY)) {
-                         struct sockaddr_un addr;
-
-                         addr.sun_family = AF_UNIX;
-                         snprintf( addr.sun_path, sizeof(addr.sun_path),
-                                   "/tmp/.fusion-%d/call.%x.%x", fusion_world_index( world ), call_id, msg->serial );
+          ret_length = sizeof(int);
 
-                         if (_fusion_send_message( world->fusion_fd, callret, sizeof(FusionCallMessage) + callret->length, &addr ))
-                              D_ERROR( "Fusion/Call: Couldn't send call return (serial: 0x%08x)!\n", msg->serial );
-                    }
-                    break;
-
-               case FCHR_RETAIN:
-                    break;
-
-               default:
-                    D_BUG( "unknown result %d from call handler", result );
-                    break;
-          }
+          result = call_handler( msg->caller, msg->call_arg, ptr, msg->ctx, msg->serial, ret_ptr );
      }
      else {
           FusionCallHandler3 call_handler3 = msg->handler3;
 
           D_ASSERT( call_handler3 != NULL );
 
-          callret->type   = FMT_CALLRET;
-          callret->length = 0;
-
-          result = call_handler3( msg->caller, msg->call_arg, ptr, msg->call_length, msg->ctx, msg->serial, callret + 1, msg->ret_length, &callret->length );
-          switch (result) {
-               case FCHR_RETURN:
-                    if (!(msg->flags & FCEF_ONEWAY)) {
-                         struct sockaddr_un addr;
+          ret_length = 0;
 
-                         addr.sun_family = AF_UNIX;
-                         snprintf( addr.sun_path, sizeof(addr.sun_path),
-                                   "/tmp/.fusion-%d/call.%x.%x", fusion_world_index( world ), call_id, msg->serial );
+          result = call_handler3( msg->caller, msg->call_arg, ptr, msg->call_length, msg->ctx, msg->serial, ret_ptr, msg->ret_length, &ret_length );
+     }
 
-                         if (_fusion_send_message( world->fusion_fd, callret, sizeof(FusionCallMessage) + callret->length, &addr ))
-                              D_ERROR( "Fusion/Call: Couldn't send call return (serial: 0x%08x)!\n", msg->serial );
-                    }
-                    break;
+     switch (result) {
+          case FCHR_RETURN:
+               if (reply)
+                    call_reply_publish( reply, ret_length );
+               break;
 
-               case FCHR_RETAIN:
-                    break;
+          case FCHR_RETAIN:
+               break;
 
-               default:
-                    D_BUG( "unknown result %d from call handler", result );
-                    break;
-          }
+          default:
+               D_BUG( "unknown result %d from call handler", result );
+               break;
      }
 }
 
@@ -1620,6 +1766,8 @@ fusion_call_execute (FusionCall          *call,
 
      D_ASSERT( call != NULL );
 
+     D_COUNT( Fusion_Call_Execute );
+
      if (!call->handler)
           return DR_DESTROYED;
 
@@ -1662,6 +1810,8 @@ fusion_call_execute2(FusionCall          *call,
 
      D_ASSERT( call != NULL );
 
+     D_COUNT( Fusion_Call_Execute );
+
      if (!call->handler)
           return DR_DESTROYED;
 
@@ -1705,6 +1855,8 @@ fusion_call_execute3(FusionCall          *call,
 
      D_ASSERT( call != NULL );
 
+     D_COUNT( Fusion_Call_Execute );
+
      if (!call->handler3)
           return DR_DESTROYED;
 
@@ -1804,3 +1956,66 @@ __Fusion_call_deinit( void )
 
 #endif
 
+/*********************************************************************************************************************/
+
+#if !FUSION_BUILD_MULTI || FUSION_BUILD_KERNEL
+
+/*
+ * No asynchronous transport, execute the call right away and keep the return.
+ */
+DirectResult
+fusion_call_execute_async( FusionCall            *call,
+                           FusionCallExecFlags    flags,
+                           int                    call_arg,
+                           void                  *ptr,
+                           unsigned int           length,
+                           unsigned int           ret_size,
+                           FusionCallCompletion **ret_completion )
+{
+     DirectResult          ret;
+     FusionCallCompletion *completion;
+
+     D_DEBUG_AT( Fusion_Call, "%s( %p, flags 0x%x, arg %d, ptr %p, length %u, ret_size %u )\n",
+                 __FUNCTION__, call, flags, call_arg, ptr, length, ret_size );
+
+     D_ASSERT( call != NULL );
+     D_ASSERT( ret_completion != NULL );
+
+     completion = D_CALLOC( 1, sizeof(FusionCallCompletion) + ret_size );
+     if (!completion)
+          return D_OOM();
+
+     ret = fusion_call_execute3( call, flags & ~(FCEF_ONEWAY | FCEF_QUEUE), call_arg, ptr, length,
+                                 completion + 1, ret_size, &completion->ret_length );
+     if (ret) {
+          D_FREE( completion );
+          return ret;
+     }
+
+     D_MAGIC_SET( completion, FusionCallCompletion );
+
+     *ret_completion = completion;
+
+     return DR_OK;
+}
+
+DirectResult
+fusion_call_completion_wait( FusionCallCompletion *completion,
+                             void                 *ret_ptr,
+                             unsigned int         *ret_length )
+{
+     D_MAGIC_ASSERT( completion, FusionCallCompletion );
+
+     D_DEBUG_AT( Fusion_Call, "%s( %p )\n", __FUNCTION__, completion );
+
+     fusion_call_completion_copy( completion, ret_ptr, ret_length );
+
+     D_MAGIC_CLEAR( completion );
+
+     D_FREE( completion );
+
+     return DR_OK;
+}
+
+#endif
+
@@ -106,6 +106,35 @@ DirectResult FUSION_API fusion_call_execute3( FusionCall          *call,
                                               unsigned int         ret_size,
                                               unsigned int        *ret_length );
 
+/*
+ * Handle for collecting the return of an asynchronous call.
+ */
+typedef struct __Fusion_FusionCallCompletion FusionCallCompletion;
+
+/*
+ * Executes the call like fusion_call_execute3() without waiting for the return.
+ *
+ * Calls to the same fusionee are processed in order, so many requests can be issued
+ * in a row with their returns collected afterwards, instead of one round trip each.
+ *
+ * Each completion has to be passed to fusion_call_completion_wait() exactly once.
+ * Without an asynchronous transport the call is executed before returning.
+ */
+DirectResult FUSION_API fusion_call_execute_async( FusionCall            *call,
+                                                   FusionCallExecFlags    flags,
+                                                   int                    call_arg,
+                                                   void                  *ptr,
+                                                   unsigned int           length,
+                                                   unsigned int           ret_size,
+                                                   FusionCallCompletion **ret_completion );
+
+/*
+ * Waits for the return of an asynchronous call and releases the completion.
+ */
+DirectResult FUSION_API fusion_call_completion_wait( FusionCallCompletion  *completion,
+                                                     void                  *ret_ptr,
+                                                     unsigned int          *ret_length );
+
 DirectResult FUSION_API fusion_call_return ( FusionCall          *call,
                                              unsigned int         serial,
                                              int                  val );
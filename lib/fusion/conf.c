@@ -58,6 +58,9 @@ const char   *fusion_config_usage =
      "  shmfile-group=<groupname>      Group that owns shared memory files\n"
 #endif
      "  [no-]debugshm                  Enable shared memory allocation tracking\n"
+#if FUSION_BUILD_MULTI
+     "  [no-]shm-slabs                 Serve small shared memory allocations from slabs (default=yes)\n"
+#endif
      "  [no-]madv-remove               Enable usage of MADV_REMOVE (default = auto)\n"
      "  [no-]secure-fusion             Use secure fusion, e.g. read-only shm (default=yes)\n"
      "  [no-]defer-destructors         Handle destructor calls in separate thread\n"
@@ -72,6 +75,7 @@ void
 __Fusion_conf_init()
 {
      fusion_config->secure_fusion     = true;
+     fusion_config->shm_slabs         = true;
      fusion_config->shmfile_gid       = -1;
      fusion_config->call_bin_max_num  = 512;
      fusion_config->call_bin_max_data = 65536;
@@ -133,6 +137,12 @@ fusion_config_set( const char *name, const char *value )
      if (strcmp (name, "no-debugshm" ) == 0) {
           fusion_config->debugshm = false;
      } else
+     if (strcmp (name, "shm-slabs" ) == 0) {
+          fusion_config->shm_slabs = true;
+     } else
+     if (strcmp (name, "no-shm-slabs" ) == 0) {
+          fusion_config->shm_slabs = false;
+     } else
      if (strcmp (name, "madv-remove" ) == 0) {
           fusion_config->madv_remove       = true;
           fusion_config->madv_remove_force = true;
@@ -40,6 +40,7 @@ struct __Fusion_FusionConfig {
      char *tmpfs;             /* location of shm file */
 
      bool  debugshm;
+     bool  shm_slabs;         /* serve small allocations from slabs */
      bool  madv_remove;
      bool  madv_remove_force;
      bool  force_slave;
@@ -1767,7 +1767,9 @@ fusion_sync( const FusionWorld *world )
 #else /* FUSION_BUILD_KERNEL */
 
 #include <dirent.h>
+#include <limits.h>
 
+#include <direct/atomic.h>
 #include <direct/system.h>
 
 typedef struct {
@@ -1778,6 +1780,40 @@ typedef struct {
      int          count;
 } __FusioneeRef;
 
+/*
+ * Message ring of a fusionee
+ *
+ * Every fusionee owns a ring in the message pool which is drained by its dispatcher thread.
+ * Producers (any thread of any fusionee) serialize on a futex based lock, so the data area
+ * itself is accessed by one producer and one consumer at a time. The lock word is the process
+ * holding it, waiters break it if that process died before unlocking. As 'head' is advanced
+ * only after the record is complete, a dead producer never leaves a partial record behind.
+ *
+ * Records are a length word followed by the message, aligned to eight bytes. A zero length
+ * word marks the unused remainder of the data area before wrapping around.
+ *
+ * The consumer announces sleeping via 'idle' before waiting on 'head', producers announce
+ * waiting for space via 'full' before waiting on 'tail'. Futex wake ups are only issued
+ * for these cases, a busy dispatcher gets new messages without any system call.
+ */
+typedef struct {
+     int                 magic;
+
+     unsigned int        size;      /* Size of data area, a power of two. */
+
+     unsigned int        head;      /* Advanced by producers. */
+     unsigned int        tail;      /* Advanced by the consumer. */
+
+     int                 lock;      /* Producer lock: 0 unlocked, else pid of holder plus waiters flag. */
+     int                 idle;      /* Consumer is waiting for 'head' to change. */
+     int                 full;      /* Producer is waiting for 'tail' to change. */
+
+     int                 users;     /* Producers having looked up the ring. */
+     bool                destroyed;
+
+     pid_t               pid;       /* Process of the consumer. */
+} FusionRing;
+
 typedef struct {
      DirectLink   link;
      
@@ -1785,9 +1821,280 @@ typedef struct {
      pid_t        pid;
 
      DirectLink  *refs;
+
+     FusionRing  *ring;
 } __Fusionee;
 
 
+/**********************************************************************************************************************/
+
+#define FUSION_RING_HEADER    8
+#define FUSION_RING_ALIGN(n)  (((n) + 7) & ~7)
+#define FUSION_RING_DATA(r)   ((u8*)((r) + 1))
+
+static DirectResult
+fusion_ring_create( FusionWorldShared  *shared,
+                    FusionRing        **ret_ring )
+{
+     FusionRing   *ring;
+     unsigned int  size = 4096;
+
+     D_MAGIC_ASSERT( shared, FusionWorldShared );
+     D_ASSERT( ret_ring != NULL );
+
+     while (size < FUSION_MESSAGE_SIZE * 4)
+          size <<= 1;
+
+     ring = SHCALLOC( shared->message_pool, 1, sizeof(FusionRing) + size );
+     if (!ring)
+          return D_OOSHM();
+
+     ring->size = size;
+     ring->pid  = getpid();
+
+     D_MAGIC_SET( ring, FusionRing );
+
+     *ret_ring = ring;
+
+     return DR_OK;
+}
+
+static void
+fusion_ring_destroy( FusionWorldShared *shared,
+                     FusionRing        *ring )
+{
+     int i;
+
+     D_MAGIC_ASSERT( shared, FusionWorldShared );
+     D_MAGIC_ASSERT( ring, FusionRing );
+
+     /* Let producers waiting for space fail, new ones can no longer look up the ring. */
+     ring->destroyed = true;
+
+     direct_futex_wake( (int*) &ring->tail, INT_MAX );
+
+     /* A producer that died between lookup and write never leaves, so don't wait forever. */
+     for (i=0; ring->users; i++) {
+          if (i == 1000) {
+               D_WARN( "%d producer(s) still using ring of %d, leaking it", ring->users, ring->pid );
+               return;
+          }
+
+          direct_thread_sleep( 1000 );
+     }
+
+     D_MAGIC_CLEAR( ring );
+
+     SHFREE( shared->message_pool, ring );
+}
+
+#define FUSION_RING_LOCK_WAITERS   0x40000000   /* Above any pid, see PID_MAX_LIMIT. */
+
+/*
+ * Breaks the producer lock if its holder is gone, the exchange fails if the lock changed meanwhile.
+ */
+static void
+fusion_ring_recover( FusionRing *ring,
+                     int         lock )
+{
+     pid_t owner = lock & ~FUSION_RING_LOCK_WAITERS;
+
+     if (kill( owner, 0 ) == 0 || errno != ESRCH)
+          return;
+
+     if (!D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->lock, lock, 0 ))
+          return;
+
+     D_WARN( "producer %d died holding the lock of ring %p", owner, ring );
+
+     direct_futex_wake( &ring->lock, INT_MAX );
+}
+
+/*
+ * The holder is set along with taking the lock, so there's no window leaving a locked ring without owner.
+ */
+static void
+fusion_ring_lock( FusionRing *ring )
+{
+     int self  = getpid();
+     int flags = 0;
+
+     D_ASSERT( self > 0 && self < FUSION_RING_LOCK_WAITERS );
+
+     while (!D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->lock, 0, self | flags )) {
+          int lock = ring->lock;
+
+          if (!lock)
+               continue;
+
+          if (!(lock & FUSION_RING_LOCK_WAITERS)) {
+               if (!D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->lock, lock, lock | FUSION_RING_LOCK_WAITERS ))
+                    continue;
+
+               lock |= FUSION_RING_LOCK_WAITERS;
+          }
+
+          /* Others may still be waiting when we got the lock, so keep the flag from now on. */
+          flags = FUSION_RING_LOCK_WAITERS;
+
+          if (direct_futex_wait_timed( &ring->lock, lock, 500 ) == DR_TIMEOUT)
+               fusion_ring_recover( ring, lock );
+     }
+}
+
+static void
+fusion_ring_unlock( FusionRing *ring )
+{
+     if (D_SYNC_FETCH_AND_CLEAR( &ring->lock ) & FUSION_RING_LOCK_WAITERS)
+          direct_futex_wake( &ring->lock, 1 );
+}
+
+static DirectResult
+fusion_ring_write( FusionRing *ring,
+                   const void *msg,
+                   size_t      msg_size )
+{
+     DirectResult  ret  = DR_OK;
+     unsigned int  need = FUSION_RING_ALIGN( FUSION_RING_HEADER + msg_size );
+     unsigned int  head, tail, offset, pad;
+
+     D_MAGIC_ASSERT( ring, FusionRing );
+     D_ASSERT( msg != NULL );
+     D_ASSERT( msg_size > 0 );
+
+     if (need > ring->size / 2)
+          return DR_LIMITEXCEEDED;
+
+     fusion_ring_lock( ring );
+
+     while (true) {
+          head   = ring->head;
+          tail   = ring->tail;
+          offset = head & (ring->size - 1);
+          pad    = (ring->size - offset < need) ? ring->size - offset : 0;
+
+          if (ring->size - (head - tail) >= pad + need)
+               break;
+
+          if (ring->destroyed) {
+               ret = DR_DESTROYED;
+               goto out;
+          }
+
+          D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->full, 0, 1 );
+
+          if (ring->tail == tail &&
+              direct_futex_wait_timed( (int*) &ring->tail, tail, 500 ) == DR_TIMEOUT &&
+              kill( ring->pid, 0 ) < 0 && errno == ESRCH)
+          {
+               D_DEBUG_AT( Fusion_Main, "  -> consumer %d of full ring %p is gone\n", ring->pid, ring );
+               ret = DR_DESTROYED;
+               goto out;
+          }
+     }
+
+     if (pad) {
+          *(unsigned int*) (FUSION_RING_DATA( ring ) + offset) = 0;
+
+          offset = 0;
+     }
+
+     *(unsigned int*) (FUSION_RING_DATA( ring ) + offset) = msg_size;
+
+     direct_memcpy( FUSION_RING_DATA( ring ) + offset + FUSION_RING_HEADER, msg, msg_size );
+
+     /* Release the record before publishing it via 'head'. */
+     D_SYNC_SYNCHRONIZE();
+
+     D_SYNC_ADD( &ring->head, pad + need );
+
+out:
+     fusion_ring_unlock( ring );
+
+     if (ret == DR_OK && ring->idle)
+          direct_futex_wake( (int*) &ring->head, 1 );
+
+     return ret;
+}
+
+static void
+fusion_ring_advance( FusionRing   *ring,
+                     unsigned int  bytes )
+{
+     /* Finish reading the record before handing its space back. */
+     D_SYNC_SYNCHRONIZE();
+
+     D_SYNC_ADD( &ring->tail, bytes );
+
+     if (ring->full && D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->full, 1, 0 ))
+          direct_futex_wake( (int*) &ring->tail, INT_MAX );
+}
+
+static bool
+fusion_ring_read( FusionRing *ring,
+                  void       *buf,
+                  size_t      buf_size,
+                  size_t     *ret_size )
+{
+     D_MAGIC_ASSERT( ring, FusionRing );
+     D_ASSERT( buf != NULL );
+     D_ASSERT( ret_size != NULL );
+
+     while (ring->tail != ring->head) {
+          unsigned int offset;
+          unsigned int length;
+
+          /* Acquire the records published by the producer's release of 'head'. */
+          D_SYNC_SYNCHRONIZE();
+
+          offset = ring->tail & (ring->size - 1);
+          length = *(unsigned int*) (FUSION_RING_DATA( ring ) + offset);
+
+          if (!length) {
+               fusion_ring_advance( ring, ring->size - offset );
+               continue;
+          }
+
+          if (length > buf_size) {
+               D_BUG( "message of %u bytes exceeds %zu", length, buf_size );
+               *ret_size = buf_size;
+          }
+          else
+               *ret_size = length;
+
+          direct_memcpy( buf, FUSION_RING_DATA( ring ) + offset + FUSION_RING_HEADER, *ret_size );
+
+          fusion_ring_advance( ring, FUSION_RING_ALIGN( FUSION_RING_HEADER + length ) );
+
+          return true;
+     }
+
+     return false;
+}
+
+static void
+fusion_ring_wait( FusionRing *ring )
+{
+     unsigned int tail = ring->tail;
+
+     D_MAGIC_ASSERT( ring, FusionRing );
+
+     D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->idle, 0, 1 );
+
+     if (ring->head == tail)
+          direct_futex_wait( (int*) &ring->head, tail );
+
+     ring->idle = 0;
+}
+
+static void
+fusion_ring_wakeup( FusionRing *ring )
+{
+     D_MAGIC_ASSERT( ring, FusionRing );
+
+     direct_futex_wake( (int*) &ring->head, 1 );
+}
+
 /**********************************************************************************************************************/
 
 static DirectResult
@@ -1811,9 +2118,16 @@ _fusion_add_fusionee( FusionWorld *world, FusionID fusion_id )
      
      fusionee->id  = fusion_id;
      fusionee->pid = direct_gettid();
+
+     ret = fusion_ring_create( shared, &fusionee->ring );
+     if (ret) {
+          SHFREE( shared->main_pool, fusionee );
+          return ret;
+     }
      
      ret = fusion_skirmish_prevail( &shared->fusionees_lock );
      if (ret) {
+          fusion_ring_destroy( shared, fusionee->ring );
           SHFREE( shared->main_pool, fusionee );
           return ret;
      }
@@ -2004,6 +2318,8 @@ _fusion_remove_fusionee( FusionWorld *world, FusionID fusion_id )
           SHFREE( shared->main_pool, fusionee_ref );
      }
 
+     fusion_ring_destroy( shared, fusionee->ring );
+
      SHFREE( shared->main_pool, fusionee );
 }
 
@@ -2070,6 +2386,112 @@ _fusion_recv_message( int                 fd,
      return DR_OK;
 }
 
+DirectResult
+_fusion_post_message( FusionWorld *world,
+                      FusionID     fusion_id,
+                      const void  *msg,
+                      size_t       msg_size )
+{
+     DirectResult       ret;
+     FusionWorldShared *shared;
+     __Fusionee        *fusionee;
+     FusionRing        *ring = NULL;
+
+     D_MAGIC_ASSERT( world, FusionWorld );
+     D_ASSERT( msg != NULL );
+
+     shared = world->shared;
+
+     D_MAGIC_ASSERT( shared, FusionWorldShared );
+
+     ret = fusion_skirmish_prevail( &shared->fusionees_lock );
+     if (ret)
+          return ret;
+
+     /* Last one wins, a forked child takes over the fusion id of its parent. */
+     direct_list_foreach (fusionee, shared->fusionees) {
+          if (fusionee->id == fusion_id)
+               ring = fusionee->ring;
+     }
+
+     if (ring)
+          D_SYNC_ADD( &ring->users, 1 );
+
+     fusion_skirmish_dismiss( &shared->fusionees_lock );
+
+     if (!ring) {
+          D_DEBUG_AT( Fusion_Main, "  -> fusionee %lu not found\n", fusion_id );
+          return DR_DESTROYED;
+     }
+
+     ret = fusion_ring_write( ring, msg, msg_size );
+
+     D_SYNC_ADD( &ring->users, -1 );
+
+     return ret;
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Services the master's socket for fusionees entering or leaving the world,
+ * all other messages are passed via the message rings.
+ */
+static void *
+fusion_socket_loop( DirectThread *self, void *arg )
+{
+     FusionWorld        *world = arg;
+     struct sockaddr_un  addr;
+     socklen_t           addr_len;
+     FusionMessage       msg;
+
+     D_DEBUG_AT( Fusion_Main_Dispatch, "%s() running...\n", __FUNCTION__ );
+
+     while (true) {
+          addr_len = sizeof(addr);
+
+          if (recvfrom( world->fusion_fd, &msg, sizeof(msg), 0, (struct sockaddr*)&addr, &addr_len ) < 0) {
+               if (errno == EINTR)
+                    continue;
+
+               D_PERROR( "Fusion/Socket: recvfrom() failed!\n" );
+               return NULL;
+          }
+
+          D_MAGIC_ASSERT( world, FusionWorld );
+
+          D_DEBUG_AT( Fusion_Main_Dispatch, " -> message from '%s'...\n", addr.sun_path );
+
+          switch (msg.type) {
+               case FMT_SEND:
+                    D_DEBUG_AT( Fusion_Main_Dispatch, "  -> FMT_SEND, good bye!\n" );
+                    return NULL;
+
+               case FMT_ENTER:
+                    D_DEBUG_AT( Fusion_Main_Dispatch, "  -> FMT_ENTER...\n" ); 
+                    if (msg.enter.fusion_id == world->fusion_id) {
+                         D_ERROR( "Fusion/Socket: Received ENTER request from myself!\n" );
+                         break;
+                    }
+                    /* Nothing to do here. Send back message. */
+                    _fusion_send_message( world->fusion_fd, &msg, sizeof(FusionEnter), &addr );
+                    break;
+
+               case FMT_LEAVE:
+                    D_DEBUG_AT( Fusion_Main_Dispatch, "  -> FMT_LEAVE...\n" );
+                    /* Cleanup has to happen in the dispatcher. */
+                    _fusion_post_message( world, world->fusion_id, &msg, sizeof(FusionLeave) );
+                    break;
+
+               default:
+                    D_BUG( "unexpected message type (%d)", msg.type );
+                    break;
+          }
+     }
+
+     return NULL;
+}
+
 /**********************************************************************************************************************/
 
 static void
@@ -2122,6 +2544,8 @@ fusion_fork_handler_parent( void )
                
                /* Cancel the dispatcher to prevent conflicts. */
                direct_thread_cancel( world->dispatch_loop );
+
+               fusion_ring_wakeup( ((__Fusionee*) world->fusionee)->ring );
           }
      }
 }
@@ -2210,6 +2634,9 @@ fusion_fork_handler_child( void )
 
                     fusion_skirmish_dismiss( &shared->fusionees_lock );
 
+                    /* Enter and leave requests are still handled by the parent. */
+                    world->socket_loop = NULL;
+
                     D_DEBUG_AT( Fusion_Main, "  -> restarting dispatcher loop...\n" );
                     
                     /* Restart the dispatcher thread. FIXME: free old struct */
@@ -2632,6 +3059,8 @@ retry:
      world->fusion_fd = fd;
      world->fusion_id = id;
 
+     direct_mutex_init( &world->reactor_nodes_lock );
+
      D_MAGIC_SET( world, FusionWorld );
 
      fusion_worlds[world_index] = world;
@@ -2657,6 +3086,14 @@ retry:
           if (ret)
                goto error3;
 
+          /* Create the pool for message rings and call replies. */
+          ret = fusion_shm_pool_create( world, "Fusion Message Pool", 0x800000,
+                                        fusion_config->debugshm, &shared->message_pool );
+          if (ret) {
+               fusion_shm_pool_destroy( world, shared->main_pool );
+               goto error3;
+          }
+
           fusion_hash_create( shared->main_pool, HASH_INT, HASH_PTR, 109, &shared->call_hash );
 
           fusion_call_init( &shared->refs_call, world_refs_call, world, world );
@@ -2687,6 +3124,17 @@ retry:
           goto error5;
      }
 
+     /* Start the thread answering enter and leave requests. */
+     if (world->fusion_id == FUSION_ID_MASTER) {
+          world->socket_loop = direct_thread_create( DTT_MESSAGING,
+                                                     fusion_socket_loop,
+                                                     world, "Fusion Socket" );
+          if (!world->socket_loop) {
+               ret = DR_FAILURE;
+               goto error5;
+          }
+     }
+
      D_DEBUG_AT( Fusion_Main, "  -> done. (%p)\n", world );
 
      pthread_mutex_unlock( &fusion_worlds_lock );
@@ -2698,14 +3146,25 @@ retry:
 
 
 error5:
-     if (world->dispatch_loop)
+     if (world->dispatch_loop) {
+          FusionMessageType msg = FMT_SEND;
+
+          /* Wakeup dispatcher, it terminates as there are no references. */
+          world->refs = 0;
+
+          if (fusion_ring_write( ((__Fusionee*) world->fusionee)->ring, &msg, sizeof(msg) ) == DR_OK)
+               direct_thread_join( world->dispatch_loop );
+
           direct_thread_destroy( world->dispatch_loop );
+     }
      
      _fusion_remove_fusionee( world, id );
      
 error4:
-     if (world->fusion_id == FUSION_ID_MASTER)
+     if (world->fusion_id == FUSION_ID_MASTER) {
+          fusion_shm_pool_destroy( world, shared->message_pool );
           fusion_shm_pool_destroy( world, shared->main_pool );
+     }
 
 error3:
      if (world->fusion_id == FUSION_ID_MASTER) {
@@ -2805,18 +3264,33 @@ fusion_exit( FusionWorld *world,
      }
  
      if (!emergency) {
-          FusionMessageType msg = FMT_SEND;
+          FusionMessageType  msg  = FMT_SEND;
+          FusionRing        *ring = ((__Fusionee*) world->fusionee)->ring;
 
           /* Wakeup dispatcher. */
-          if (_fusion_send_message( world->fusion_fd, &msg, sizeof(msg), NULL ))
+          if (fusion_ring_write( ring, &msg, sizeof(msg) )) {
                direct_thread_cancel( world->dispatch_loop );
 
+               fusion_ring_wakeup( ring );
+          }
+
           /* Wait for its termination. */
           direct_thread_join( world->dispatch_loop );
+
+          if (world->socket_loop) {
+               /* Wakeup socket thread. */
+               if (_fusion_send_message( world->fusion_fd, &msg, sizeof(msg), NULL ))
+                    direct_thread_cancel( world->socket_loop );
+
+               direct_thread_join( world->socket_loop );
+          }
      }
 
      direct_thread_destroy( world->dispatch_loop );
 
+     if (world->socket_loop)
+          direct_thread_destroy( world->socket_loop );
+
      /* Remove ourselves from list. */
      if (!emergency || fusion_master( world )) {
           _fusion_remove_fusionee( world, world->fusion_id );
@@ -2850,6 +3324,7 @@ fusion_exit( FusionWorld *world,
                fusion_skirmish_destroy( &shared->arenas_lock );
                fusion_skirmish_destroy( &shared->fusionees_lock );
 
+               fusion_shm_pool_destroy( world, shared->message_pool );
                fusion_shm_pool_destroy( world, shared->main_pool );
           
                /* Deinitialize shared memory. */
@@ -3087,44 +3562,28 @@ refs_iterate( DirectMap    *map,
 static void *
 fusion_dispatch_loop( DirectThread *self, void *arg )
 {
-     FusionWorld        *world = arg;
-     struct sockaddr_un  addr;
-     socklen_t           addr_len = sizeof(addr); 
-     fd_set              set;
-     char                buf[FUSION_MESSAGE_SIZE];
+     FusionWorld *world = arg;
+     FusionRing  *ring;
+     char         buf[FUSION_MESSAGE_SIZE];
 
      D_DEBUG_AT( Fusion_Main_Dispatch, "%s() running...\n", __FUNCTION__ );
 
-     while (true) {
-          int     result;
-          ssize_t msg_size;
-          
-          D_MAGIC_ASSERT( world, FusionWorld );
-
-          FD_ZERO( &set );
-          FD_SET( world->fusion_fd, &set );
-
-          result = select( world->fusion_fd + 1, &set, NULL, NULL, NULL );
-          if (result < 0) {
-               switch (errno) {
-                    case EINTR:
-                         continue;
+     D_MAGIC_ASSERT( world, FusionWorld );
+     D_ASSERT( world->fusionee != NULL );
 
-                    default:
-                         D_PERROR( "Fusion/Dispatcher: select() failed!\n" );
-                         return NULL;
-               }
-          }
+     ring = ((__Fusionee*) world->fusionee)->ring;
 
+     while (true) {
+          size_t msg_size;
+          
           D_MAGIC_ASSERT( world, FusionWorld );
 
-          if (FD_ISSET( world->fusion_fd, &set ) && 
-              (msg_size = recvfrom( world->fusion_fd, buf, sizeof(buf), 0, (struct sockaddr*)&addr, &addr_len )) > 0) {
+          if (fusion_ring_read( ring, buf, sizeof(buf), &msg_size )) {
                FusionMessage *msg = (FusionMessage*)buf;               
 
                pthread_setcancelstate( PTHREAD_CANCEL_DISABLE, NULL );
 
-               D_DEBUG_AT( Fusion_Main_Dispatch, " -> message from '%s'...\n", addr.sun_path );
+               D_DEBUG_AT( Fusion_Main_Dispatch, " -> message (%zu bytes)...\n", msg_size );
 
                direct_thread_lock( self );
 
@@ -3137,20 +3596,6 @@ fusion_dispatch_loop( DirectThread *self, void *arg )
                               D_DEBUG_AT( Fusion_Main_Dispatch, "  -> FMT_SEND...\n" );
                               break;
 
-                         case FMT_ENTER:
-                              D_DEBUG_AT( Fusion_Main_Dispatch, "  -> FMT_ENTER...\n" ); 
-                              if (!fusion_master( world )) {
-                                   D_ERROR( "Fusion/Dispatch: Got ENTER request, but I'm not master!\n" );
-                                   break;
-                              }
-                              if (msg->enter.fusion_id == world->fusion_id) {
-                                   D_ERROR( "Fusion/Dispatch: Received ENTER request from myself!\n" );
-                                   break;
-                              }
-                              /* Nothing to do here. Send back message. */
-                              _fusion_send_message( world->fusion_fd, msg, sizeof(FusionEnter), &addr );
-                              break;
-
                          case FMT_LEAVE:
                               D_DEBUG_AT( Fusion_Main_Dispatch, "  -> FMT_LEAVE...\n" );
                               if (!fusion_master( world )) {
@@ -3211,6 +3656,13 @@ fusion_dispatch_loop( DirectThread *self, void *arg )
 
                pthread_setcancelstate( PTHREAD_CANCEL_ENABLE, NULL );
           }
+          else {
+               /* Sleep until a producer finds us idle. */
+               fusion_ring_wait( ring );
+
+               /* Waiting on the futex is no cancellation point. */
+               pthread_testcancel();
+          }
      }
 
      return NULL;
@@ -83,6 +83,7 @@ struct __Fusion_FusionWorldShared {
      FusionSHMShared      shm;
 
      FusionSHMPoolShared *main_pool;
+     FusionSHMPoolShared *message_pool; /* Message rings and call replies (no kernel module). */
      
      DirectLink          *fusionees;   /* Connected fusionees. */
      FusionSkirmish       fusionees_lock;
@@ -161,11 +162,22 @@ struct __Fusion_FusionWorld {
      DirectThread        *dispatch_loop;
      bool                 dispatch_stop;
 
+     DirectThread        *socket_loop;  /* Master handling enter/leave without kernel module. */
+
      /*
-      * List of reactors with at least one local reaction attached.
+      * Reactors with at least one local reaction attached, sorted by id.
+      *
+      * Dispatch reads the published table without locking, updates are serialized by the mutex
+      * and replace the table. Replaced objects go to the limbo list of the current epoch and are
+      * freed after all readers of the previous epoch have left.
       */
-     DirectLink          *reactor_nodes;
+     struct __Fusion_ReactorNodes *reactor_nodes;
      DirectMutex          reactor_nodes_lock;
+     bool                 reactor_nodes_dirty;  /* links removed by RS_REMOVE need cleanup */
+
+     int                  reactor_epoch;
+     int                  reactor_readers[2];
+     DirectLink          *reactor_limbo[2];
 
      FusionSHM            shm;
 
@@ -335,6 +347,15 @@ DirectResult _fusion_recv_message( int                  fd,
                                    size_t               msg_size,
                                    struct sockaddr_un  *addr );
 
+/*
+ * Puts a message into the shared memory ring of the fusionee,
+ * waking up its dispatcher only if it's idle.
+ */
+DirectResult _fusion_post_message( FusionWorld         *world,
+                                   FusionID             fusion_id,
+                                   const void          *msg,
+                                   size_t               msg_size );
+
 /*
  * from ref.c
  */
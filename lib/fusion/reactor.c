@@ -43,6 +43,7 @@
 
 #include <fusion/build.h>
 
+#include <direct/atomic.h>
 #include <direct/debug.h>
 #include <direct/list.h>
 #include <direct/mem.h>
@@ -84,41 +85,77 @@ struct __Fusion_FusionReactor {
 #endif
 };
 
+/*
+ * Local reactions are dispatched without taking any lock, see the file internal functions below.
+ *
+ * The node table, the reaction arrays and the objects they point to are never modified after
+ * being published. Updates build a copy, publish it and put the old one into limbo.
+ */
 typedef struct {
-     DirectLink         link;
+     DirectLink         link;      /* limbo */
 
      int                magic;
 
-     pthread_rwlock_t   lock;
+     Reaction          *reaction;  /* NULL after detach or RS_REMOVE */
+     int                channel;
+} NodeLink;
 
-     int                reactor_id;
-     FusionReactor     *reactor;
+typedef struct {
+     DirectLink         link;      /* limbo */
 
-     DirectLink        *links; /* reactor listeners attached to node  */
-} ReactorNode;
+     int                num;
+     NodeLink         **links;     /* reactions attached to node, newest first */
+} NodeLinks;
 
 typedef struct {
-     DirectLink         link;
+     DirectLink         link;      /* limbo */
 
      int                magic;
 
-     Reaction          *reaction;
-     int                channel;
-} NodeLink;
+     int                reactor_id;
+     FusionReactor     *reactor;
+
+     NodeLinks         *links;     /* published reactions */
+
+     int                phase;     /* flipped by sync_node() to let the other one drain */
+     int                active[2];
+} ReactorNode;
+
+struct __Fusion_ReactorNodes {
+     DirectLink         link;      /* limbo */
+
+     int                num;
+     ReactorNode      **nodes;     /* sorted by reactor id */
+};
 
 /**************************************************************************************************/
 
-static ReactorNode *lock_node      ( int                 reactor_id,
-                                     bool                add_it,
-                                     bool                wlock,
-                                     FusionReactor      *reactor, /* one of reactor and world must not be NULL */
-                                     FusionWorld        *world );
+static int          nodes_read_lock  ( FusionWorld        *world );
+static void         nodes_read_unlock( FusionWorld        *world,
+                                       int                 epoch );
+
+static ReactorNode *lookup_node      ( FusionWorld        *world,
+                                       int                 reactor_id );
+
+static ReactorNode *add_node         ( FusionWorld        *world,
+                                       FusionReactor      *reactor );
+
+static DirectResult add_node_link    ( FusionWorld        *world,
+                                       ReactorNode        *node,
+                                       NodeLink           *link );
+
+static void         cleanup_node     ( FusionWorld        *world,
+                                       ReactorNode        *node );
+
+static void         sync_node        ( ReactorNode        *node );
 
-static void         unlock_node    ( ReactorNode        *node );
+static void         reaction_removed ( FusionWorld        *world,
+                                       ReactorNode        *node,
+                                       int                 channel );
 
-static void         process_globals( FusionReactor      *reactor,
-                                     const void         *msg_data,
-                                     const ReactionFunc *globals );
+static void         process_globals  ( FusionReactor      *reactor,
+                                       const void         *msg_data,
+                                       const ReactionFunc *globals );
 
 /**************************************************************************************************/
 
@@ -254,6 +291,8 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
                                void          *ctx,
                                Reaction      *reaction )
 {
+     DirectResult         ret;
+     FusionWorld         *world;
      ReactorNode         *node;
      NodeLink            *link;
      FusionReactorAttach  attach;
@@ -266,15 +305,13 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
                  "fusion_reactor_attach( %p [%d], func %p, ctx %p, reaction %p )\n",
                  reactor, reactor->id, func, ctx, reaction );
 
+     world = _fusion_world( reactor->shared );
+
      link = D_CALLOC( 1, sizeof(NodeLink) );
      if (!link)
           return D_OOM();
 
-     node = lock_node( reactor->id, true, true, reactor, NULL );
-     if (!node) {
-          D_FREE( link );
-          return DR_FUSION;
-     }
+     direct_mutex_lock( &world->reactor_nodes_lock );
 
      attach.reactor_id = reactor->id;
      attach.channel    = channel;
@@ -286,13 +323,13 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
 
                case EINVAL:
                     D_ERROR( "Fusion/Reactor: invalid reactor\n" );
-                    unlock_node( node );
+                    direct_mutex_unlock( &world->reactor_nodes_lock );
                     D_FREE( link );
                     return DR_DESTROYED;
           }
 
           D_PERROR( "FUSION_REACTOR_ATTACH" );
-          unlock_node( node );
+          direct_mutex_unlock( &world->reactor_nodes_lock );
           D_FREE( link );
           return DR_FUSION;
      }
@@ -307,36 +344,44 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
 
      D_MAGIC_SET( link, NodeLink );
 
-     /* prepend the reaction to the local reaction list */
-     direct_list_prepend( &node->links, &link->link );
+     /* publish the reaction in the local reaction list */
+     node = add_node( world, reactor );
+     if (node)
+          ret = add_node_link( world, node, link );
+     else
+          ret = DR_NOLOCALMEMORY;
 
-     unlock_node( node );
+     if (ret) {
+          FusionReactorDetach detach;
 
-     return DR_OK;
-}
+          detach.reactor_id = reactor->id;
+          detach.channel    = channel;
 
-static void
-remove_node_link( ReactorNode *node,
-                  NodeLink    *link )
-{
-     D_MAGIC_ASSERT( node, ReactorNode );
-     D_MAGIC_ASSERT( link, NodeLink );
+          while (ioctl( _fusion_fd( reactor->shared ), FUSION_REACTOR_DETACH, &detach ) && errno == EINTR);
 
-     D_ASSUME( link->reaction == NULL );
+          reaction->node_link = NULL;
 
-     direct_list_remove( &node->links, &link->link );
+          if (node)
+               cleanup_node( world, node );
 
-     D_MAGIC_CLEAR( link );
+          D_MAGIC_CLEAR( link );
+          D_FREE( link );
+     }
 
-     D_FREE( link );
+     direct_mutex_unlock( &world->reactor_nodes_lock );
+
+     return ret;
 }
 
 DirectResult
 fusion_reactor_detach( FusionReactor *reactor,
                        Reaction      *reaction )
 {
-     ReactorNode *node;
-     NodeLink    *link;
+     DirectResult  ret = DR_OK;
+     FusionWorld  *world;
+     ReactorNode  *node;
+     NodeLink     *link;
+     int           epoch;
 
      D_MAGIC_ASSERT( reactor, FusionReactor );
      D_ASSERT( reaction != NULL );
@@ -345,9 +390,18 @@ fusion_reactor_detach( FusionReactor *reactor,
                  "fusion_reactor_detach( %p [%d], reaction %p ) <- func %p, ctx %p\n",
                  reactor, reactor->id, reaction, reaction->func, reaction->ctx );
 
-     node = lock_node( reactor->id, false, true, reactor, NULL );
+     world = _fusion_world( reactor->shared );
+
+     /* Keep the node alive for sync_node() after unlocking. */
+     epoch = nodes_read_lock( world );
+
+     direct_mutex_lock( &world->reactor_nodes_lock );
+
+     node = lookup_node( world, reactor->id );
      if (!node) {
           D_BUG( "node not found" );
+          direct_mutex_unlock( &world->reactor_nodes_lock );
+          nodes_read_unlock( world, epoch );
           return DR_BUG;
      }
 
@@ -366,7 +420,7 @@ fusion_reactor_detach( FusionReactor *reactor,
 
           link->reaction = NULL;
 
-          remove_node_link( node, link );
+          cleanup_node( world, node );
 
           while (ioctl( _fusion_fd( reactor->shared ), FUSION_REACTOR_DETACH, &detach )) {
                switch (errno) {
@@ -375,19 +429,28 @@ fusion_reactor_detach( FusionReactor *reactor,
 
                     case EINVAL:
                          D_ERROR( "Fusion/Reactor: invalid reactor\n" );
-                         unlock_node( node );
-                         return DR_DESTROYED;
+                         ret = DR_DESTROYED;
+                         break;
+
+                    default:
+                         D_PERROR( "FUSION_REACTOR_DETACH" );
+                         ret = DR_FUSION;
+                         break;
                }
 
-               D_PERROR( "FUSION_REACTOR_DETACH" );
-               unlock_node( node );
-               return DR_FUSION;
+               break;
           }
      }
 
-     unlock_node( node );
+     direct_mutex_unlock( &world->reactor_nodes_lock );
 
-     return DR_OK;
+     /* Don't return while the reaction may still be running in another thread. */
+     if (link)
+          sync_node( node );
+
+     nodes_read_unlock( world, epoch );
+
+     return ret;
 }
 
 DirectResult
@@ -561,86 +624,32 @@ fusion_reactor_add_permissions( FusionReactor            *reactor,
      return DR_OK;
 }
 
-void
-_fusion_reactor_process_message( FusionWorld *world,
-                                 int          reactor_id,
-                                 int          channel,
-                                 const void  *msg_data )
+static void
+reaction_removed( FusionWorld *world,
+                  ReactorNode *node,
+                  int          channel )
 {
-     ReactorNode *node;
-     NodeLink    *link;
-
-     D_MAGIC_ASSERT( world, FusionWorld );
-     D_ASSERT( msg_data != NULL );
-
-     D_DEBUG_AT( Fusion_Reactor,
-                 "  _fusion_reactor_process_message( [%d], msg_data %p )\n", reactor_id, msg_data );
-
-     /* Find the local counter part of the reactor. */
-     node = lock_node( reactor_id, false, false, NULL, world );
-     if (!node)
-          return;
-
-     D_DEBUG_AT( Fusion_Reactor, "    -> node %p, reactor %p\n", node, node->reactor );
-
-     D_ASSUME( node->links != NULL );
-
-     if (!node->links) {
-          D_DEBUG_AT( Fusion_Reactor, "    -> no local reactions!?!\n" );
-          unlock_node( node );
-          return;
-     }
-
-     direct_list_foreach (link, node->links) {
-          Reaction *reaction;
-
-          D_MAGIC_ASSERT( link, NodeLink );
+     FusionReactorDetach detach;
 
-          if (link->channel != channel)
-               continue;
-
-          reaction = link->reaction;
-          if (!reaction)
-               continue;
-
-#if D_DEBUG_ENABLED
-          if (direct_log_domain_check( &Fusion_Reactor )) // avoid call to direct_trace_lookup_symbol_at
-               D_DEBUG_AT( Fusion_Reactor, "  =-> %s (%p)\n", direct_trace_lookup_symbol_at( reaction->func ), reaction->func );
-#endif
+     detach.reactor_id = node->reactor_id;
+     detach.channel    = channel;
 
-          if (reaction->func( msg_data, reaction->ctx ) == RS_REMOVE) {
-               FusionReactorDetach detach;
-
-               detach.reactor_id = reactor_id;
-               detach.channel    = channel;
-
-               D_DEBUG_AT( Fusion_Reactor, "    -> removing %p, func %p, ctx %p\n",
-                           reaction, reaction->func, reaction->ctx );
-
-               link->reaction = NULL;
-
-               /* We can't remove the link as we only have read lock, to avoid dead locks. */
-
-               while (ioctl( world->fusion_fd, FUSION_REACTOR_DETACH, &detach )) {
-                    switch (errno) {
-                         case EINTR:
-                              continue;
-
-                         case EINVAL:
-                              D_ERROR( "Fusion/Reactor: invalid reactor (DETACH)\n" );
-                              break;
+     while (ioctl( world->fusion_fd, FUSION_REACTOR_DETACH, &detach )) {
+          switch (errno) {
+               case EINTR:
+                    continue;
 
-                         default:
-                              D_PERROR( "FUSION_REACTOR_DETACH" );
-                              break;
-                    }
+               case EINVAL:
+                    D_ERROR( "Fusion/Reactor: invalid reactor (DETACH)\n" );
+                    break;
 
+               default:
+                    D_PERROR( "FUSION_REACTOR_DETACH" );
                     break;
-               }
           }
-     }
 
-     unlock_node( node );
+          break;
+     }
 }
 
 #else /* FUSION_BUILD_KERNEL */
@@ -762,7 +771,9 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
                                void          *ctx,
                                Reaction      *reaction )
 {
+     DirectResult       ret;
      FusionWorldShared *shared;
+     FusionWorld       *world;
      ReactorNode       *node;
      NodeLink          *link;
      FusionID           fusion_id;
@@ -780,15 +791,19 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
           return DR_DESTROYED;
                  
      shared = reactor->shared;
+     world  = _fusion_world( shared );
 
      link = D_CALLOC( 1, sizeof(NodeLink) );
      if (!link)
           return D_OOM();
 
-     node = lock_node( reactor->id, true, true, reactor, NULL );
+     direct_mutex_lock( &world->reactor_nodes_lock );
+
+     node = add_node( world, reactor );
      if (!node) {
+          direct_mutex_unlock( &world->reactor_nodes_lock );
           D_FREE( link );
-          return DR_FUSION;
+          return D_OOM();
      }
      
      fusion_id = _fusion_id( shared );
@@ -807,7 +822,8 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
           if (!listener) {
                D_OOSHM();
                fusion_skirmish_dismiss( &reactor->listeners_lock );
-               unlock_node( node );
+               cleanup_node( world, node );
+               direct_mutex_unlock( &world->reactor_nodes_lock );
                D_FREE( link );
                return DR_NOSHAREDMEMORY;
           }
@@ -831,37 +847,32 @@ fusion_reactor_attach_channel( FusionReactor *reactor,
 
      D_MAGIC_SET( link, NodeLink );
 
-     /* prepend the reaction to the local reaction list */
-     direct_list_prepend( &node->links, &link->link );
-
-     unlock_node( node );
+     /* publish the reaction in the local reaction list */
+     ret = add_node_link( world, node, link );
+     if (ret) {
+          reaction->node_link = NULL;
 
-     return DR_OK;
-}
+          reaction_removed( world, node, channel );
 
-static void
-remove_node_link( ReactorNode *node,
-                  NodeLink    *link )
-{
-     D_MAGIC_ASSERT( node, ReactorNode );
-     D_MAGIC_ASSERT( link, NodeLink );
+          cleanup_node( world, node );
 
-     D_ASSUME( link->reaction == NULL );
-
-     direct_list_remove( &node->links, &link->link );
+          D_MAGIC_CLEAR( link );
+          D_FREE( link );
+     }
 
-     D_MAGIC_CLEAR( link );
+     direct_mutex_unlock( &world->reactor_nodes_lock );
 
-     D_FREE( link );
+     return ret;
 }
 
 DirectResult
 fusion_reactor_detach( FusionReactor *reactor,
                        Reaction      *reaction )
 {
-     FusionWorldShared *shared;
+     FusionWorld       *world;
      ReactorNode       *node;
      NodeLink          *link;
+     int                epoch;
 
      D_MAGIC_ASSERT( reactor, FusionReactor );
      D_ASSERT( reaction != NULL );
@@ -873,11 +884,18 @@ fusion_reactor_detach( FusionReactor *reactor,
      if (reactor->destroyed)
           return DR_DESTROYED;
                           
-     shared = reactor->shared;
+     world = _fusion_world( reactor->shared );
+
+     /* Keep the node alive for sync_node() after unlocking. */
+     epoch = nodes_read_lock( world );
 
-     node = lock_node( reactor->id, false, true, reactor, NULL );
+     direct_mutex_lock( &world->reactor_nodes_lock );
+
+     node = lookup_node( world, reactor->id );
      if (!node) {
           D_BUG( "node not found" );
+          direct_mutex_unlock( &world->reactor_nodes_lock );
+          nodes_read_unlock( world, epoch );
           return DR_BUG;
      }
 
@@ -885,36 +903,24 @@ fusion_reactor_detach( FusionReactor *reactor,
      D_ASSUME( link != NULL );
 
      if (link) {
-          __Listener *listener;
-          FusionID    fusion_id = _fusion_id( shared );
-
           D_ASSERT( link->reaction == reaction );
 
           reaction->node_link = NULL;
 
           link->reaction = NULL;
 
-          remove_node_link( node, link );
-          
-          fusion_skirmish_prevail( &reactor->listeners_lock );
-          
-          direct_list_foreach (listener, reactor->listeners) {
-               if (listener->fusion_id == fusion_id && listener->channel == link->channel) {
-                    if (--listener->refs == 0) {
-                         direct_list_remove( &reactor->listeners, &listener->link );
-                         SHFREE( shared->main_pool, listener );
-                    }
-                    break;
-               }
-          }
-           
-          fusion_skirmish_dismiss( &reactor->listeners_lock );
-          
-          if (!listener)
-               D_ERROR( "Fusion/Reactor: Couldn't detach listener!\n" );
+          cleanup_node( world, node );
+
+          reaction_removed( world, node, link->channel );
      }
 
-     unlock_node( node );
+     direct_mutex_unlock( &world->reactor_nodes_lock );
+
+     /* Don't return while the reaction may still be running in another thread. */
+     if (link)
+          sync_node( node );
+
+     nodes_read_unlock( world, epoch );
 
      return DR_OK;
 }
@@ -931,8 +937,6 @@ fusion_reactor_dispatch_channel( FusionReactor      *reactor,
      __Listener            *listener, *temp; 
      FusionRef             *ref = NULL;
      FusionReactorMessage  *msg;
-     struct sockaddr_un     addr;
-     int                    len;
 
      D_MAGIC_ASSERT( reactor, FusionReactor );
 
@@ -986,10 +990,6 @@ fusion_reactor_dispatch_channel( FusionReactor      *reactor,
      
      memcpy( (void*)msg + sizeof(FusionReactorMessage), msg_data, msg_size );
 
-     addr.sun_family = AF_UNIX;
-     len = snprintf( addr.sun_path, sizeof(addr.sun_path), 
-                     "/tmp/.fusion-%d/", fusion_world_index( world ) );
-     
      fusion_skirmish_prevail( &reactor->listeners_lock );
      
      direct_list_foreach_safe (listener, temp, reactor->listeners) {
@@ -1002,12 +1002,10 @@ fusion_reactor_dispatch_channel( FusionReactor      *reactor,
                if (ref)
                     fusion_ref_up( ref, true );
 
-               snprintf( addr.sun_path+len, sizeof(addr.sun_path)-len, "%lx", listener->fusion_id );
-
-               D_DEBUG_AT( Fusion_Reactor, " -> sending to '%s'\n", addr.sun_path );
+               D_DEBUG_AT( Fusion_Reactor, " -> sending to %lu\n", listener->fusion_id );
                
-               ret = _fusion_send_message( world->fusion_fd, msg, sizeof(FusionReactorMessage)+msg_size, &addr );
-               if (ret == DR_FUSION) {
+               ret = _fusion_post_message( world, listener->fusion_id, msg, sizeof(FusionReactorMessage)+msg_size );
+               if (ret == DR_DESTROYED) {
                     D_DEBUG_AT( Fusion_Reactor, " -> removing dead listener %lu\n", listener->fusion_id );
                     
                     if (ref)
@@ -1077,14 +1075,47 @@ fusion_reactor_add_permissions( FusionReactor            *reactor,
      return DR_UNIMPLEMENTED;
 }
 
+static void
+reaction_removed( FusionWorld *world,
+                  ReactorNode *node,
+                  int          channel )
+{
+     FusionReactor *reactor = node->reactor;
+     __Listener    *listener;
+
+     D_MAGIC_ASSERT( reactor, FusionReactor );
+
+     fusion_skirmish_prevail( &reactor->listeners_lock );
+
+     direct_list_foreach (listener, reactor->listeners) {
+          if (listener->fusion_id == world->fusion_id && listener->channel == channel) {
+               if (--listener->refs == 0) {
+                    direct_list_remove( &reactor->listeners, &listener->link );
+                    SHFREE( world->shared->main_pool, listener );
+               }
+               break;
+          }
+     }
+
+     fusion_skirmish_dismiss( &reactor->listeners_lock );
+
+     if (!listener)
+          D_ERROR( "Fusion/Reactor: Couldn't detach listener!\n" );
+}
+
+#endif /* FUSION_BUILD_KERNEL */
+
 void
 _fusion_reactor_process_message( FusionWorld *world,
                                  int          reactor_id,
                                  int          channel,
                                  const void  *msg_data )
 {
+     int          i;
+     int          epoch;
+     int          phase;
      ReactorNode *node;
-     NodeLink    *link;
+     NodeLinks   *links;
 
      D_MAGIC_ASSERT( world, FusionWorld );
      D_ASSERT( msg_data != NULL );
@@ -1092,22 +1123,28 @@ _fusion_reactor_process_message( FusionWorld *world,
      D_DEBUG_AT( Fusion_Reactor,
                  "  _fusion_reactor_process_message( [%d], msg_data %p )\n", reactor_id, msg_data );
 
+     epoch = nodes_read_lock( world );
+
      /* Find the local counter part of the reactor. */
-     node = lock_node( reactor_id, false, false, NULL, world );
-     if (!node)
+     node = lookup_node( world, reactor_id );
+     if (!node) {
+          nodes_read_unlock( world, epoch );
           return;
+     }
 
      D_DEBUG_AT( Fusion_Reactor, "    -> node %p, reactor %p\n", node, node->reactor );
 
-     D_ASSUME( node->links != NULL );
+     /* Announce ourself to sync_node() before loading the reactions. */
+     phase = node->phase;
 
-     if (!node->links) {
-          D_DEBUG_AT( Fusion_Reactor, "    -> no local reactions!?!\n" );
-          unlock_node( node );
-          return;
-     }
+     D_SYNC_ADD( &node->active[phase], 1 );
 
-     direct_list_foreach (link, node->links) {
+     links = node->links;
+
+     D_ASSUME( links->num > 0 );
+
+     for (i=0; i<links->num; i++) {
+          NodeLink *link = links->links[i];
           Reaction *reaction;
 
           D_MAGIC_ASSERT( link, NodeLink );
@@ -1119,33 +1156,28 @@ _fusion_reactor_process_message( FusionWorld *world,
           if (!reaction)
                continue;
 
+#if D_DEBUG_ENABLED
+          if (direct_log_domain_check( &Fusion_Reactor )) // avoid call to direct_trace_lookup_symbol_at
+               D_DEBUG_AT( Fusion_Reactor, "  =-> %s (%p)\n", direct_trace_lookup_symbol_at( reaction->func ), reaction->func );
+#endif
+
           if (reaction->func( msg_data, reaction->ctx ) == RS_REMOVE) {
-               FusionReactor *reactor = node->reactor;
-               __Listener    *listener;
-               
                D_DEBUG_AT( Fusion_Reactor, "    -> removing %p, func %p, ctx %p\n",
                            reaction, reaction->func, reaction->ctx );
-               
-               fusion_skirmish_prevail( &reactor->listeners_lock );
-               
-               direct_list_foreach (listener, reactor->listeners) {
-                    if (listener->fusion_id == world->fusion_id && listener->channel == channel) {
-                         if (--listener->refs == 0) {
-                              direct_list_remove( &reactor->listeners, &listener->link );
-                              SHFREE( world->shared->main_pool, listener );
-                         }
-                         break;
-                    }
+
+               /* Only mark the link, it's removed from the list by the next update. */
+               if (D_SYNC_BOOL_COMPARE_AND_SWAP( &link->reaction, reaction, NULL )) {
+                    world->reactor_nodes_dirty = true;
+
+                    reaction_removed( world, node, channel );
                }
-               
-               fusion_skirmish_dismiss( &reactor->listeners_lock );
           }
      }
 
-     unlock_node( node );
-}
+     D_SYNC_ADD( &node->active[phase], -1 );
 
-#endif /* FUSION_BUILD_KERNEL */
+     nodes_read_unlock( world, epoch );
+}
 
 
 DirectResult
@@ -1345,7 +1377,9 @@ fusion_reactor_direct( FusionReactor *reactor, bool direct )
 void
 _fusion_reactor_free_all( FusionWorld *world )
 {
-     ReactorNode *node, *node_temp;
+     int                           i, n;
+     struct __Fusion_ReactorNodes *nodes;
+     DirectLink                   *l, *next;
 
      D_MAGIC_ASSERT( world, FusionWorld );
 
@@ -1354,30 +1388,45 @@ _fusion_reactor_free_all( FusionWorld *world )
 
      direct_mutex_lock( &world->reactor_nodes_lock );
 
-     direct_list_foreach_safe (node, node_temp, world->reactor_nodes) {
-          NodeLink *link, *link_temp;
+     nodes = world->reactor_nodes;
+     if (nodes) {
+          for (n=0; n<nodes->num; n++) {
+               ReactorNode *node = nodes->nodes[n];
 
-          D_MAGIC_ASSERT( node, ReactorNode );
+               D_MAGIC_ASSERT( node, ReactorNode );
 
-          pthread_rwlock_wrlock( &node->lock );
+               D_ASSUME( node->active[0] == 0 && node->active[1] == 0 );
 
-          direct_list_foreach_safe (link, link_temp, node->links) {
-               D_MAGIC_ASSERT( link, NodeLink );
+               for (i=0; i<node->links->num; i++) {
+                    NodeLink *link = node->links->links[i];
 
-               D_MAGIC_CLEAR( link );
+                    D_MAGIC_ASSERT( link, NodeLink );
 
-               D_FREE( link );
-          }
+                    D_MAGIC_CLEAR( link );
 
-          pthread_rwlock_unlock( &node->lock );
-          pthread_rwlock_destroy( &node->lock );
+                    D_FREE( link );
+               }
 
-          D_MAGIC_CLEAR( node );
+               D_FREE( node->links );
 
-          D_FREE( node );
+               D_MAGIC_CLEAR( node );
+
+               D_FREE( node );
+          }
+
+          D_FREE( nodes );
+
+          world->reactor_nodes = NULL;
      }
 
-     world->reactor_nodes = NULL;
+     D_ASSUME( world->reactor_readers[0] == 0 && world->reactor_readers[1] == 0 );
+
+     for (i=0; i<2; i++) {
+          direct_list_foreach_safe (l, next, world->reactor_limbo[i])
+               D_FREE( l );
+
+          world->reactor_limbo[i] = NULL;
+     }
 
      direct_mutex_unlock( &world->reactor_nodes_lock );
 }
@@ -1453,171 +1502,364 @@ process_globals( FusionReactor      *reactor,
  *  File internal functions  *
  *****************************/
 
-static ReactorNode *
-lock_node( int reactor_id, bool add_it, bool wlock, FusionReactor *reactor, FusionWorld *world )
+/*
+ * Reclamation works with two epochs. Readers count themselves in the current epoch, while updates
+ * put unpublished objects into the limbo list of the current epoch. As soon as no reader of the
+ * previous epoch is left, the previous limbo is freed and the epoch is advanced.
+ *
+ * Objects in the previous limbo have been unpublished before the current epoch began, so only
+ * readers of earlier epochs can see them, and these are gone. Readers that loaded the epoch
+ * before an advance but counted themselves after it load the pointers after the advance, too.
+ */
+static int
+nodes_read_lock( FusionWorld *world )
 {
-     DirectLink        *n;
-     ReactorNode       *node;
-     FusionWorldShared *shared;
+     int epoch = world->reactor_epoch;
 
-     D_DEBUG_AT( Fusion_Reactor, "    lock_node( [%d], add %s, reactor %p )\n",
-                 reactor_id, add_it ? "true" : "false", reactor );
+     D_SYNC_ADD( &world->reactor_readers[epoch], 1 );
 
-     D_ASSERT( reactor != NULL || (!add_it && world != NULL) );
+     return epoch;
+}
 
-     if (reactor) {
-          D_MAGIC_ASSERT( reactor, FusionReactor );
+static void
+retire_object( FusionWorld *world,
+               DirectLink  *object )
+{
+     direct_list_prepend( &world->reactor_limbo[world->reactor_epoch], object );
+}
+
+static void
+reclaim_objects( FusionWorld *world )
+{
+     int         epoch = world->reactor_epoch;
+     DirectLink *l, *next;
 
-          shared = reactor->shared;
+     if (world->reactor_readers[!epoch])
+          return;
 
-          D_MAGIC_ASSERT( shared, FusionWorldShared );
+     direct_list_foreach_safe (l, next, world->reactor_limbo[!epoch])
+          D_FREE( l );
 
-          world = _fusion_world( shared );
+     world->reactor_limbo[!epoch] = NULL;
+
+     if (world->reactor_limbo[epoch])
+          D_SYNC_BOOL_COMPARE_AND_SWAP( &world->reactor_epoch, epoch, !epoch );
+}
+
+static void
+update_nodes( FusionWorld *world )
+{
+     struct __Fusion_ReactorNodes *nodes = world->reactor_nodes;
 
-          D_MAGIC_ASSERT( world, FusionWorld );
+     /* Remove links marked by RS_REMOVE and nodes left without reactions. */
+     if (world->reactor_nodes_dirty && nodes) {
+          int i;
+
+          world->reactor_nodes_dirty = false;
+
+          /* The table may be replaced meanwhile, but isn't freed before reclaim_objects(). */
+          for (i=0; i<nodes->num; i++)
+               cleanup_node( world, nodes->nodes[i] );
      }
-     else {
-          D_MAGIC_ASSERT( world, FusionWorld );
 
-          shared = world->shared;
+     reclaim_objects( world );
+}
+
+static void
+nodes_read_unlock( FusionWorld *world,
+                   int          epoch )
+{
+     D_SYNC_ADD( &world->reactor_readers[epoch], -1 );
+
+     /* Never block here, the housekeeping is done by the next update otherwise. */
+     if ((world->reactor_nodes_dirty || world->reactor_limbo[0] || world->reactor_limbo[1]) &&
+         direct_mutex_trylock( &world->reactor_nodes_lock ) == DR_OK)
+     {
+          update_nodes( world );
 
-          D_MAGIC_ASSERT( shared, FusionWorldShared );
+          direct_mutex_unlock( &world->reactor_nodes_lock );
      }
+}
 
+static ReactorNode *
+lookup_node( FusionWorld *world,
+             int          reactor_id )
+{
+     struct __Fusion_ReactorNodes *nodes = world->reactor_nodes;
+     int                           lower = 0;
+     int                           upper;
 
-     direct_mutex_lock( &world->reactor_nodes_lock );
+     if (!nodes)
+          return NULL;
+
+     upper = nodes->num - 1;
 
-     // FIXME: there's a deadlock case where during dispatch via one node
-     //        the outer lock is given up, taken by another thread blocking
-     //        on our node. the problem occurs when we try to get the outer
-     //        lock again for attach/detach etc...
+     while (lower <= upper) {
+          int          index = (lower + upper) / 2;
+          ReactorNode *node  = nodes->nodes[index];
 
-     direct_list_foreach_safe (node, n, world->reactor_nodes) {
           D_MAGIC_ASSERT( node, ReactorNode );
 
-          if (node->reactor_id == reactor_id) {
-               if (wlock) {
-                    DirectLink *n;
-                    NodeLink   *link;
-
-                    pthread_rwlock_wrlock( &node->lock );
-
-                    /* FIXME: don't cleanup asynchronously */
-                    direct_list_foreach_safe (link, n, node->links) {
-                         D_MAGIC_ASSERT( link, NodeLink );
-
-                         if (!link->reaction) {
-                              D_DEBUG_AT( Fusion_Reactor, "    -> cleaning up %p\n", link );
-                         
-                              remove_node_link( node, link );
-                         }
-                         else
-                              D_ASSERT( link->reaction->node_link == link );
-                    }
-               }
-               else
-                    pthread_rwlock_rdlock( &node->lock );
+          if (node->reactor_id == reactor_id)
+               return node;
 
-               /* FIXME: Don't cleanup asynchronously. */
-               if (!node->links && !add_it) {
-//                    D_DEBUG_AT( Fusion_Reactor, "      -> cleaning up mine %p\n", node );
+          if (node->reactor_id < reactor_id)
+               lower = index + 1;
+          else
+               upper = index - 1;
+     }
 
-                    direct_list_remove( &world->reactor_nodes, &node->link );
+     return NULL;
+}
 
-                    pthread_rwlock_unlock( &node->lock );
-                    pthread_rwlock_destroy( &node->lock );
+static struct __Fusion_ReactorNodes *
+alloc_nodes( int num )
+{
+     struct __Fusion_ReactorNodes *nodes;
 
-                    D_MAGIC_CLEAR( node );
+     nodes = D_CALLOC( 1, sizeof(struct __Fusion_ReactorNodes) + sizeof(ReactorNode*) * num );
+     if (!nodes)
+          return NULL;
 
-                    D_FREE( node );
+     nodes->num   = num;
+     nodes->nodes = (ReactorNode**) (nodes + 1);
 
-                    node = NULL;
-               }
-               else {
-/*                    D_DEBUG_AT( Fusion_Reactor, "      -> found %p (%d reactions)\n",
-                                node, direct_list_count_elements_EXPENSIVE( node->reactions ) );*/
+     return nodes;
+}
 
-                    D_ASSERT( node->reactor == reactor || reactor == NULL );
+static void
+publish_nodes( FusionWorld                  *world,
+               struct __Fusion_ReactorNodes *nodes )
+{
+     struct __Fusion_ReactorNodes *old = world->reactor_nodes;
 
-                    direct_list_move_to_front( &world->reactor_nodes, &node->link );
-               }
+     D_SYNC_BOOL_COMPARE_AND_SWAP( &world->reactor_nodes, old, nodes );
 
-               direct_mutex_unlock( &world->reactor_nodes_lock );
+     if (old)
+          retire_object( world, &old->link );
+}
 
-               return node;
-          }
+static NodeLinks *
+alloc_links( int num )
+{
+     NodeLinks *links;
 
-          /* FIXME: Don't cleanup asynchronously. */
-          if (!pthread_rwlock_trywrlock( &node->lock )) {
-               if (!node->links) {
-//                    D_DEBUG_AT( Fusion_Reactor, "      -> cleaning up other %p\n", node );
+     links = D_CALLOC( 1, sizeof(NodeLinks) + sizeof(NodeLink*) * num );
+     if (!links)
+          return NULL;
 
-                    direct_list_remove( &world->reactor_nodes, &node->link );
+     links->num   = num;
+     links->links = (NodeLink**) (links + 1);
 
-                    pthread_rwlock_unlock( &node->lock );
-                    pthread_rwlock_destroy( &node->lock );
+     return links;
+}
 
-                    D_MAGIC_CLEAR( node );
+static void
+publish_links( FusionWorld *world,
+               ReactorNode *node,
+               NodeLinks   *links )
+{
+     NodeLinks *old = node->links;
 
-                    D_FREE( node );
-               }
-               else {
-                    /*D_DEBUG_AT( Fusion_Reactor, "      -> keeping other %p (%d reactions)\n",
-                                node, direct_list_count_elements_EXPENSIVE( node->reactions ) );*/
+     D_SYNC_BOOL_COMPARE_AND_SWAP( &node->links, old, links );
 
-                    pthread_rwlock_unlock( &node->lock );
-               }
-          }
+     retire_object( world, &old->link );
+}
+
+static ReactorNode *
+add_node( FusionWorld   *world,
+          FusionReactor *reactor )
+{
+     int                           i, n;
+     ReactorNode                  *node;
+     struct __Fusion_ReactorNodes *nodes;
+     struct __Fusion_ReactorNodes *old = world->reactor_nodes;
+
+     D_MAGIC_ASSERT( reactor, FusionReactor );
+
+     D_DEBUG_AT( Fusion_Reactor, "    add_node( [%d], reactor %p )\n", reactor->id, reactor );
+
+     node = lookup_node( world, reactor->id );
+     if (node) {
+          D_ASSERT( node->reactor == reactor );
+          return node;
+     }
+
+     node = D_CALLOC( 1, sizeof(ReactorNode) );
+     if (!node) {
+          D_OOM();
+          return NULL;
      }
 
-//     D_DEBUG_AT( Fusion_Reactor, "      -> not found%s adding\n", add_it ? ", but" : " and not" );
+     node->links = alloc_links( 0 );
+     nodes       = alloc_nodes( old ? old->num + 1 : 1 );
 
-     if (add_it) {
-          D_MAGIC_ASSERT( reactor, FusionReactor );
+     if (!node->links || !nodes) {
+          D_OOM();
 
-          node = D_CALLOC( 1, sizeof(ReactorNode) );
-          if (!node) {
-               D_OOM();
-               return NULL;
-          }
+          if (nodes)
+               D_FREE( nodes );
+
+          if (node->links)
+               D_FREE( node->links );
+
+          D_FREE( node );
+
+          return NULL;
+     }
+
+     node->reactor_id = reactor->id;
+     node->reactor    = reactor;
+
+     D_MAGIC_SET( node, ReactorNode );
+
+     /* Insert the node keeping the table sorted. */
+     for (i=0, n=0; old && i<old->num && old->nodes[i]->reactor_id < reactor->id; i++)
+          nodes->nodes[n++] = old->nodes[i];
+
+     nodes->nodes[n++] = node;
+
+     for (; old && i<old->num; i++)
+          nodes->nodes[n++] = old->nodes[i];
+
+     D_ASSERT( n == nodes->num );
+
+     publish_nodes( world, nodes );
+
+     return node;
+}
+
+static DirectResult
+add_node_link( FusionWorld *world,
+               ReactorNode *node,
+               NodeLink    *link )
+{
+     int        i, n;
+     NodeLinks *links;
+     NodeLinks *old = node->links;
+
+     D_MAGIC_ASSERT( node, ReactorNode );
+     D_MAGIC_ASSERT( link, NodeLink );
 
-          //direct_util_recursive_pthread_mutex_init( &node->lock );
-          pthread_rwlock_init( &node->lock, NULL );
+     links = alloc_links( old->num + 1 );
+     if (!links)
+          return D_OOM();
 
+     /* prepend the reaction to the local reaction list */
+     links->links[0] = link;
 
-          if (wlock)
-               pthread_rwlock_wrlock( &node->lock );
+     for (i=0, n=1; i<old->num; i++) {
+          if (old->links[i]->reaction)
+               links->links[n++] = old->links[i];
           else
-               pthread_rwlock_rdlock( &node->lock );
+               retire_object( world, &old->links[i]->link );
+     }
 
-          node->reactor_id = reactor_id;
-          node->reactor    = reactor;
+     links->num = n;
 
-          D_MAGIC_SET( node, ReactorNode );
+     publish_links( world, node, links );
 
-          direct_list_prepend( &world->reactor_nodes, &node->link );
+     return DR_OK;
+}
 
-          direct_mutex_unlock( &world->reactor_nodes_lock );
+static void
+cleanup_node( FusionWorld *world,
+              ReactorNode *node )
+{
+     int                           i, n;
+     int                           alive = 0;
+     NodeLinks                    *links;
+     NodeLinks                    *old   = node->links;
+     struct __Fusion_ReactorNodes *nodes = NULL;
 
-          return node;
+     D_MAGIC_ASSERT( node, ReactorNode );
+
+     for (i=0; i<old->num; i++) {
+          if (old->links[i]->reaction)
+               alive++;
      }
 
-     direct_mutex_unlock( &world->reactor_nodes_lock );
+     if (alive == old->num && alive > 0)
+          return;
 
-     return NULL;
+     D_DEBUG_AT( Fusion_Reactor, "    cleanup_node( [%d] ) <- %d/%d reactions alive\n",
+                 node->reactor_id, alive, old->num );
+
+     links = alloc_links( old->num );
+
+     if (!alive)
+          nodes = alloc_nodes( world->reactor_nodes->num - 1 );
+
+     if (!links || (!alive && !nodes)) {
+          /* Keep the dead links for now, dispatch skips them anyway. */
+          if (links)
+               D_FREE( links );
+
+          world->reactor_nodes_dirty = true;
+          return;
+     }
+
+     /* Dispatch may remove more reactions meanwhile, so look at each link only once. */
+     for (i=0, n=0; i<old->num; i++) {
+          NodeLink *link = old->links[i];
+
+          if (link->reaction)
+               links->links[n++] = link;
+          else
+               retire_object( world, &link->link );
+     }
+
+     links->num = n;
+
+     if (nodes) {
+          struct __Fusion_ReactorNodes *old_nodes = world->reactor_nodes;
+
+          D_ASSERT( n == 0 );
+
+          D_FREE( links );
+
+          for (i=0, n=0; i<old_nodes->num; i++) {
+               if (old_nodes->nodes[i] != node)
+                    nodes->nodes[n++] = old_nodes->nodes[i];
+          }
+
+          D_ASSERT( n == nodes->num );
+
+          publish_nodes( world, nodes );
+
+          /* Dispatchers may still use the node and its reactions until reclaimed. */
+          retire_object( world, &old->link );
+          retire_object( world, &node->link );
+     }
+     else {
+          publish_links( world, node, links );
+
+          /* Remove the node by the next update. */
+          if (!n)
+               world->reactor_nodes_dirty = true;
+     }
 }
 
 static void
-unlock_node( ReactorNode *node )
+sync_node( ReactorNode *node )
 {
-     D_ASSERT( node != NULL );
+     int i;
+     int phase = node->phase;
 
-//     D_MAGIC_ASSERT( node->reactor, FusionReactor );
+     D_MAGIC_ASSERT( node, ReactorNode );
 
-/*     D_DEBUG_AT( Fusion_Reactor, "    unlock_node( %p, reactor %p [%d] )\n",
-                 node, node->reactor, node->reactor->id );*/
+     /*
+      * Dispatchers entering from now on see the updated reactions. One that loaded the old ones
+      * stays counted in either phase until it leaves, but the phase it picked may have been flipped
+      * by a concurrent detach in between. So wait for both phases to drain, flipping before each
+      * wait to direct new dispatchers to the other one.
+      */
+     for (i=0; i<2; i++, phase = !phase) {
+          D_SYNC_BOOL_COMPARE_AND_SWAP( &node->phase, phase, !phase );
 
-     pthread_rwlock_unlock( &node->lock );
+          while (node->active[phase])
+               direct_sched_yield();
+     }
 }
 
 #else /* FUSION_BUILD_MULTI */
@@ -157,6 +157,16 @@ fusion_shm_pool_deallocate( FusionSHMPoolShared *pool,
      return DR_OK;
 }
 
+DirectResult
+fusion_shm_pool_get_stats( FusionSHMPoolShared *pool,
+                           FusionSHMPoolStats  *ret_stats )
+{
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+     D_ASSERT( ret_stats != NULL );
+
+     return DR_UNSUPPORTED;
+}
+
 DirectResult
 fusion_shm_enum_pools( FusionWorld           *world,
                        FusionSHMPoolCallback  callback,
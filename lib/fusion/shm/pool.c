@@ -35,10 +35,13 @@
 #include <unistd.h>
 #include <sys/mman.h>
 
+#include <direct/clock.h>
 #include <direct/debug.h>
 #include <direct/list.h>
 #include <direct/mem.h>
+#include <direct/memcpy.h>
 #include <direct/messages.h>
+#include <direct/perf.h>
 
 #include <fusion/conf.h>
 #include <fusion/shmalloc.h>
@@ -142,6 +145,9 @@ fusion_shm_pool_create( FusionWorld          *world,
      if (ret)
           goto error;
 
+     /* Debug pools track each allocation in the heap. */
+     shared->pools[i].slabs = fusion_config->shm_slabs && !debug;
+
      shared->num_pools++;
 
      fusion_skirmish_dismiss( &shared->lock );
@@ -182,6 +188,9 @@ fusion_shm_pool_destroy( FusionWorld         *world,
 
      D_ASSERT( shared == pool->shm );
 
+     /* Objects in thread caches are gone with the pool. */
+     _fusion_shm_slab_flush( pool, false );
+
      ret = fusion_skirmish_prevail( &shared->lock );
      if (ret)
           return ret;
@@ -265,6 +274,9 @@ fusion_shm_pool_detach( FusionSHM           *shm,
 
      D_MAGIC_ASSERT( &shm->pools[pool->index], FusionSHMPool );
 
+     /* Give back objects cached by threads of this process. */
+     _fusion_shm_slab_flush( pool, true );
+
      leave_pool( shm, &shm->pools[pool->index], pool );
 
      return DR_OK;
@@ -288,19 +300,27 @@ fusion_shm_pool_allocate( FusionSHMPoolShared  *pool,
      D_ASSERT( size > 0 );
      D_ASSERT( ret_data != NULL );
 
-     if (lock) {
-          ret = fusion_skirmish_prevail( &pool->lock );
+     if (pool->slabs && size <= FUSION_SHM_SLAB_MAX_SIZE) {
+          ret = _fusion_shm_slab_allocate( pool, size, lock, &data );
           if (ret)
                return ret;
      }
+     else {
+          if (lock) {
+               ret = _fusion_shm_pool_lock( pool );
+               if (ret)
+                    return ret;
+          }
 
-     __shmalloc_brk( pool->heap, 0 );
+          __shmalloc_brk( pool->heap, 0 );
+
+          data = _fusion_shmalloc( pool->heap, size );
 
-     data = _fusion_shmalloc( pool->heap, size );
-     if (!data) {
           if (lock)
-               fusion_skirmish_dismiss( &pool->lock );
-          return DR_NOSHAREDMEMORY;
+               _fusion_shm_pool_unlock( pool );
+
+          if (!data)
+               return DR_NOSHAREDMEMORY;
      }
 
      if (clear)
@@ -308,9 +328,6 @@ fusion_shm_pool_allocate( FusionSHMPoolShared  *pool,
 
      *ret_data = data;
 
-     if (lock)
-          fusion_skirmish_dismiss( &pool->lock );
-
      return DR_OK;
 }
 
@@ -335,8 +352,29 @@ fusion_shm_pool_reallocate( FusionSHMPoolShared  *pool,
      D_ASSERT( size > 0 );
      D_ASSERT( ret_data != NULL );
 
+     if (_fusion_shm_slab_owns( pool, data )) {
+          int old_size = _fusion_shm_slab_size( pool, data );
+
+          if (size <= old_size) {
+               *ret_data = data;
+               return DR_OK;
+          }
+
+          ret = fusion_shm_pool_allocate( pool, size, false, lock, &new_data );
+          if (ret)
+               return ret;
+
+          direct_memcpy( new_data, data, old_size );
+
+          _fusion_shm_slab_deallocate( pool, data, lock );
+
+          *ret_data = new_data;
+
+          return DR_OK;
+     }
+
      if (lock) {
-          ret = fusion_skirmish_prevail( &pool->lock );
+          ret = _fusion_shm_pool_lock( pool );
           if (ret)
                return ret;
      }
@@ -346,14 +384,14 @@ fusion_shm_pool_reallocate( FusionSHMPoolShared  *pool,
      new_data = _fusion_shrealloc( pool->heap, data, size );
      if (!new_data) {
           if (lock)
-               fusion_skirmish_dismiss( &pool->lock );
+               _fusion_shm_pool_unlock( pool );
           return DR_NOSHAREDMEMORY;
      }
 
      *ret_data = new_data;
 
      if (lock)
-          fusion_skirmish_dismiss( &pool->lock );
+          _fusion_shm_pool_unlock( pool );
 
      return DR_OK;
 }
@@ -373,8 +411,13 @@ fusion_shm_pool_deallocate( FusionSHMPoolShared *pool,
      D_ASSERT( data >= pool->addr_base );
      D_ASSERT( data < pool->addr_base + pool->max_size );
 
+     if (_fusion_shm_slab_owns( pool, data )) {
+          _fusion_shm_slab_deallocate( pool, data, lock );
+          return DR_OK;
+     }
+
      if (lock) {
-          ret = fusion_skirmish_prevail( &pool->lock );
+          ret = _fusion_shm_pool_lock( pool );
           if (ret)
                return ret;
      }
@@ -384,11 +427,96 @@ fusion_shm_pool_deallocate( FusionSHMPoolShared *pool,
      _fusion_shfree( pool->heap, data );
 
      if (lock)
-          fusion_skirmish_dismiss( &pool->lock );
+          _fusion_shm_pool_unlock( pool );
 
      return DR_OK;
 }
 
+DirectResult
+fusion_shm_pool_get_stats( FusionSHMPoolShared *pool,
+                           FusionSHMPoolStats  *ret_stats )
+{
+     int            i;
+     DirectResult   ret;
+     shmalloc_heap *heap;
+
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+     D_ASSERT( ret_stats != NULL );
+
+     ret = fusion_skirmish_prevail( &pool->lock );
+     if (ret)
+          return ret;
+
+     heap = pool->heap;
+
+     D_MAGIC_ASSERT( heap, shmalloc_heap );
+
+     memset( ret_stats, 0, sizeof(FusionSHMPoolStats) );
+
+     ret_stats->size        = heap->size;
+     ret_stats->bytes_used  = heap->bytes_used;
+     ret_stats->bytes_free  = heap->bytes_free;
+     ret_stats->chunks_used = heap->chunks_used;
+     ret_stats->chunks_free = heap->chunks_free;
+
+     for (i=0; i<FUSION_SHM_SLAB_CLASSES; i++) {
+          const FusionSHMSlabClass *slab_class = &pool->slab_classes[i];
+
+          ret_stats->slabs += slab_class->slabs;
+     }
+
+     _fusion_shm_slab_stats( pool, &ret_stats->slab_bytes, &ret_stats->slab_bytes_free );
+
+     ret_stats->locks     = pool->locks;
+     ret_stats->contended = pool->contended;
+
+     fusion_skirmish_dismiss( &pool->lock );
+
+     return DR_OK;
+}
+
+/**********************************************************************************************************************/
+
+DirectResult
+_fusion_shm_pool_lock( FusionSHMPoolShared *pool )
+{
+     DirectResult ret;
+     bool         contended = false;
+
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+
+     ret = fusion_skirmish_swoop( &pool->lock );
+     if (ret == DR_BUSY) {
+          static D_HISTOGRAM( Fusion_SHMPool_LockWait, "Fusion/SHMPool/LockWait (us)" );
+
+          long long start = direct_clock_get_micros();
+
+          contended = true;
+
+          ret = fusion_skirmish_prevail( &pool->lock );
+
+          D_COUNT_VALUE( Fusion_SHMPool_LockWait, direct_clock_get_micros() - start );
+     }
+
+     if (ret)
+          return ret;
+
+     pool->locks++;
+
+     if (contended)
+          pool->contended++;
+
+     return DR_OK;
+}
+
+void
+_fusion_shm_pool_unlock( FusionSHMPoolShared *pool )
+{
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+
+     fusion_skirmish_dismiss( &pool->lock );
+}
+
 /**********************************************************************************************************************/
 
 #if FUSION_BUILD_KERNEL
@@ -36,6 +36,23 @@
 #include <fusion/types.h>
 
 
+typedef struct {
+     unsigned int  size;             /* Current size of the heap in bytes. */
+
+     unsigned int  bytes_used;       /* Bytes allocated from the heap, including slabs. */
+     unsigned int  bytes_free;       /* Bytes in free chunks of the heap. */
+     unsigned int  chunks_used;      /* Number of allocated chunks. */
+     unsigned int  chunks_free;      /* Number of free chunks. */
+
+     unsigned int  slabs;            /* Number of slabs for small allocations. */
+     unsigned int  slab_bytes;       /* Bytes usable for objects in all slabs. */
+     unsigned int  slab_bytes_free;  /* Bytes of free objects in slabs, not counting thread caches. */
+
+     unsigned int  locks;            /* Number of times the pool lock has been taken... */
+     unsigned int  contended;        /* ...while being held by someone else. */
+} FusionSHMPoolStats;
+
+
 DirectResult fusion_shm_pool_create    ( FusionWorld          *world,
                                          const char           *name,
                                          unsigned int          max_size,
@@ -69,5 +86,11 @@ DirectResult fusion_shm_pool_deallocate( FusionSHMPoolShared  *pool,
                                          void                 *data,
                                          bool                  lock );
 
+/*
+ * Retrieve usage, fragmentation and lock contention statistics of the pool.
+ */
+DirectResult fusion_shm_pool_get_stats ( FusionSHMPoolShared  *pool,
+                                         FusionSHMPoolStats   *ret_stats );
+
 #endif
 
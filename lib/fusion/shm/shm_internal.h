@@ -45,9 +45,25 @@
 #define FUSION_SHM_TMPFS_PATH_NAME_LEN       64
 
 
+#define FUSION_SHM_SLAB_CLASSES              10    /* Number of slab size classes, see slab.c. */
+#define FUSION_SHM_SLAB_MAX_SIZE            512    /* Largest allocation served by slabs. */
+
+
 typedef struct __shmalloc_heap shmalloc_heap;
 
 
+/*
+ * Shared data of a slab size class.
+ */
+typedef struct {
+     DirectLink          *partial;      /* Slabs with free objects. */
+
+     int                  slabs;        /* Number of slabs. */
+     int                  empty;        /* Number of slabs without any object in use. */
+     unsigned int         free;         /* Free objects in all slabs, not counting thread caches. */
+} FusionSHMSlabClass;
+
+
 /*
  * Local pool data.
  */
@@ -89,6 +105,13 @@ struct __Fusion_FusionSHMPoolShared {
      char                *name;         /* Name of the pool (allocated in the pool). */
 
      DirectLink          *allocs;       /* Used for debugging. */
+
+     bool                 slabs;        /* Serve small allocations from slabs? */
+     u8                  *slab_map;     /* One bit per heap block being a slab. */
+     FusionSHMSlabClass   slab_classes[FUSION_SHM_SLAB_CLASSES];
+
+     unsigned int         locks;        /* Number of times the lock has been taken... */
+     unsigned int         contended;    /* ...while being held by someone else. */
 };
 
 
@@ -264,5 +287,45 @@ void        *__shmalloc_brk      ( shmalloc_heap *heap,
                                    int            increment );
 
 
+DirectResult _fusion_shm_pool_lock      ( FusionSHMPoolShared  *pool );
+void         _fusion_shm_pool_unlock    ( FusionSHMPoolShared  *pool );
+
+DirectResult _fusion_shm_slab_allocate  ( FusionSHMPoolShared  *pool,
+                                          int                   size,
+                                          bool                  lock,
+                                          void                **ret_data );
+
+void         _fusion_shm_slab_deallocate( FusionSHMPoolShared  *pool,
+                                          void                 *data,
+                                          bool                  lock );
+
+int          _fusion_shm_slab_size      ( FusionSHMPoolShared  *pool,
+                                          const void           *data );
+
+void         _fusion_shm_slab_flush     ( FusionSHMPoolShared  *pool,
+                                          bool                  give_back );
+
+void         _fusion_shm_slab_stats     ( FusionSHMPoolShared  *pool,
+                                          unsigned int         *ret_bytes,
+                                          unsigned int         *ret_free );
+
+/*
+ * Read without locking, the bit of a block holding a live object does not change.
+ */
+static __inline__ bool
+_fusion_shm_slab_owns( const FusionSHMPoolShared *pool,
+                       const void                *data )
+{
+     unsigned long index;
+
+     if (!pool->slab_map)
+          return false;
+
+     index = (((unsigned long) data & ~(BLOCKSIZE - 1)) - (unsigned long) pool->addr_base) / BLOCKSIZE;
+
+     return (pool->slab_map[index >> 3] & (1 << (index & 7))) != 0;
+}
+
+
 #endif
 
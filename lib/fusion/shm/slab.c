@@ -0,0 +1,686 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+#include <config.h>
+
+#include <pthread.h>
+
+#include <direct/atomic.h>
+#include <direct/debug.h>
+#include <direct/list.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/thread.h>
+#include <direct/util.h>
+
+#include <fusion/conf.h>
+#include <fusion/shmalloc.h>
+#include <fusion/fusion_internal.h>
+
+#include <fusion/shm/pool.h>
+#include <fusion/shm/shm_internal.h>
+
+
+D_DEBUG_DOMAIN( Fusion_SHMSlab, "Fusion/SHMSlab", "Fusion Shared Memory Slabs" );
+
+/**********************************************************************************************************************/
+
+/*
+ * Small allocations are served from slabs. Each slab is a single block of the heap holding objects
+ * of one size class and is marked in the pool's slab map, so deallocation tells slab objects from
+ * other allocations without looking at the heap.
+ *
+ * Each thread caches a few objects per size class and pool, taking the pool lock only for moving
+ * a batch of objects between its cache and the slabs. A flush from another thread, i.e. when the
+ * pool is left or destroyed, takes over a cache only while its owner is not using it.
+ */
+
+#define SLAB_CACHE_OBJECTS    32   /* Objects per size class in a thread cache. */
+#define SLAB_CACHE_BATCH      16   /* Objects moved between a thread cache and the slabs at once. */
+#define SLAB_THREAD_POOLS      8   /* Pools cached per thread, others use the slabs directly. */
+
+static const int slab_sizes[FUSION_SHM_SLAB_CLASSES] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512 };
+
+typedef struct {
+     DirectLink           link;         /* Link in partial list of the size class. */
+
+     int                  magic;
+
+     int                  size_class;
+     int                  num;          /* Number of objects in this slab. */
+     int                  free;         /* Number of free objects. */
+     void                *objects;      /* Free objects, linked via their first word. */
+} FusionSHMSlab;
+
+#define SLAB_OBJECTS_OFFSET   ((sizeof(FusionSHMSlab) + 15) & ~15)
+#define SLAB_OBJECTS(size)    ((int) ((BLOCKSIZE - SLAB_OBJECTS_OFFSET) / (size)))
+
+#define SLAB_OF(data)         ((FusionSHMSlab*) ((unsigned long) (data) & ~(BLOCKSIZE - 1)))
+
+typedef struct {
+     DirectLink           link;         /* Link in list of all caches of this process. */
+
+     int                  magic;
+
+     FusionSHMPoolShared *pool;         /* NULL if not in use. */
+
+     int                  busy;         /* 1 while used by the owner, 2 while being flushed. */
+
+     int                  num[FUSION_SHM_SLAB_CLASSES];
+     void                *objects[FUSION_SHM_SLAB_CLASSES][SLAB_CACHE_OBJECTS];
+} SlabCache;
+
+typedef struct {
+     int                  magic;
+
+     SlabCache           *caches[SLAB_THREAD_POOLS];
+} SlabThread;
+
+static DirectOnce   slab_once = DIRECT_ONCE_INIT;
+static DirectTLS    slab_tls;
+static DirectMutex  slab_lock;          /* Lock for list of caches. */
+static DirectLink  *slab_caches;
+
+/**********************************************************************************************************************/
+
+static int
+slab_size_class( int size )
+{
+     int i;
+
+     D_ASSERT( size > 0 );
+     D_ASSERT( size <= FUSION_SHM_SLAB_MAX_SIZE );
+
+     for (i=0; i<FUSION_SHM_SLAB_CLASSES-1; i++) {
+          if (size <= slab_sizes[i])
+               break;
+     }
+
+     return i;
+}
+
+static FusionSHMSlab *
+slab_create( FusionSHMPoolShared *pool,
+             int                  size_class )
+{
+     int                 i;
+     int                 size       = slab_sizes[size_class];
+     FusionSHMSlabClass *slab_class = &pool->slab_classes[size_class];
+     FusionSHMSlab      *slab;
+     u8                 *objects;
+     unsigned long       index;
+
+     D_DEBUG_AT( Fusion_SHMSlab, "%s( %p, %d bytes )\n", __FUNCTION__, pool, size );
+
+     if (!pool->slab_map) {
+          int bytes = (pool->max_size / BLOCKSIZE + 2 + 7) / 8;
+
+          pool->slab_map = _fusion_shmalloc( pool->heap, bytes );
+          if (!pool->slab_map)
+               return NULL;
+
+          memset( pool->slab_map, 0, bytes );
+     }
+
+     /* A whole block, i.e. aligned to the block size. */
+     slab = _fusion_shmalloc( pool->heap, BLOCKSIZE );
+     if (!slab)
+          return NULL;
+
+     D_ASSERT( ((unsigned long) slab & (BLOCKSIZE - 1)) == 0 );
+
+     memset( slab, 0, sizeof(FusionSHMSlab) );
+
+     slab->size_class = size_class;
+     slab->num        = SLAB_OBJECTS( size );
+     slab->free       = slab->num;
+
+     objects = (u8*) slab + SLAB_OBJECTS_OFFSET;
+
+     for (i=slab->num-1; i>=0; i--) {
+          void **object = (void**) (objects + i * size);
+
+          *object = slab->objects;
+
+          slab->objects = object;
+     }
+
+     D_MAGIC_SET( slab, FusionSHMSlab );
+
+     index = ((unsigned long) slab - (unsigned long) pool->addr_base) / BLOCKSIZE;
+
+     pool->slab_map[index >> 3] |= 1 << (index & 7);
+
+     direct_list_prepend( &slab_class->partial, &slab->link );
+
+     slab_class->slabs++;
+     slab_class->empty++;
+     slab_class->free += slab->num;
+
+     return slab;
+}
+
+static void
+slab_destroy( FusionSHMPoolShared *pool,
+              FusionSHMSlab       *slab )
+{
+     FusionSHMSlabClass *slab_class = &pool->slab_classes[slab->size_class];
+     unsigned long       index;
+
+     D_DEBUG_AT( Fusion_SHMSlab, "%s( %p, %d bytes )\n", __FUNCTION__, pool, slab_sizes[slab->size_class] );
+
+     D_MAGIC_ASSERT( slab, FusionSHMSlab );
+     D_ASSERT( slab->free == slab->num );
+
+     index = ((unsigned long) slab - (unsigned long) pool->addr_base) / BLOCKSIZE;
+
+     pool->slab_map[index >> 3] &= ~(1 << (index & 7));
+
+     direct_list_remove( &slab_class->partial, &slab->link );
+
+     slab_class->slabs--;
+     slab_class->free -= slab->num;
+
+     D_MAGIC_CLEAR( slab );
+
+     _fusion_shfree( pool->heap, slab );
+}
+
+/*
+ * Take a free object from the slabs, pool must be locked.
+ */
+static void *
+slab_take( FusionSHMPoolShared *pool,
+           int                  size_class )
+{
+     FusionSHMSlabClass  *slab_class = &pool->slab_classes[size_class];
+     FusionSHMSlab       *slab       = (FusionSHMSlab*) slab_class->partial;
+     void               **object;
+
+     if (!slab) {
+          slab = slab_create( pool, size_class );
+          if (!slab)
+               return NULL;
+     }
+
+     D_MAGIC_ASSERT( slab, FusionSHMSlab );
+     D_ASSERT( slab->free > 0 );
+
+     object = slab->objects;
+
+     slab->objects = *object;
+
+     if (slab->free == slab->num)
+          slab_class->empty--;
+
+     slab->free--;
+     slab_class->free--;
+
+     if (!slab->free)
+          direct_list_remove( &slab_class->partial, &slab->link );
+
+     return object;
+}
+
+/*
+ * Give an object back to its slab, pool must be locked.
+ */
+static void
+slab_give( FusionSHMPoolShared *pool,
+           void                *data )
+{
+     FusionSHMSlab       *slab   = SLAB_OF( data );
+     FusionSHMSlabClass  *slab_class;
+     void               **object = data;
+
+     D_MAGIC_ASSERT( slab, FusionSHMSlab );
+     D_ASSERT( slab->free < slab->num );
+
+     slab_class = &pool->slab_classes[slab->size_class];
+
+     *object = slab->objects;
+
+     slab->objects = object;
+
+     if (!slab->free)
+          direct_list_prepend( &slab_class->partial, &slab->link );
+
+     slab->free++;
+     slab_class->free++;
+
+     /* Keep one empty slab per size class. */
+     if (slab->free == slab->num) {
+          if (slab_class->empty)
+               slab_destroy( pool, slab );
+          else
+               slab_class->empty++;
+     }
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Give back objects cached by a thread, called with the list of caches being locked
+ * and the cache not being used by its owner.
+ */
+static void
+cache_flush( SlabCache *cache,
+             bool       give_back )
+{
+     int                  i;
+     FusionSHMPoolShared *pool = cache->pool;
+
+     D_MAGIC_ASSERT( cache, SlabCache );
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+
+     if (give_back && _fusion_shm_pool_lock( pool ) == DR_OK) {
+          __shmalloc_brk( pool->heap, 0 );
+
+          for (i=0; i<FUSION_SHM_SLAB_CLASSES; i++) {
+               while (cache->num[i])
+                    slab_give( pool, cache->objects[i][--cache->num[i]] );
+          }
+
+          _fusion_shm_pool_unlock( pool );
+     }
+
+     memset( cache->num, 0, sizeof(cache->num) );
+
+     cache->pool = NULL;
+}
+
+static DirectResult
+cache_refill( SlabCache *cache,
+              int        size_class )
+{
+     DirectResult         ret;
+     FusionSHMPoolShared *pool = cache->pool;
+
+     ret = _fusion_shm_pool_lock( pool );
+     if (ret)
+          return ret;
+
+     __shmalloc_brk( pool->heap, 0 );
+
+     while (cache->num[size_class] < SLAB_CACHE_BATCH) {
+          void *data = slab_take( pool, size_class );
+
+          if (!data)
+               break;
+
+          cache->objects[size_class][cache->num[size_class]++] = data;
+     }
+
+     _fusion_shm_pool_unlock( pool );
+
+     return cache->num[size_class] ? DR_OK : DR_NOSHAREDMEMORY;
+}
+
+static DirectResult
+cache_drain( SlabCache *cache,
+             int        size_class )
+{
+     int                  i;
+     DirectResult         ret;
+     FusionSHMPoolShared *pool = cache->pool;
+
+     ret = _fusion_shm_pool_lock( pool );
+     if (ret)
+          return ret;
+
+     __shmalloc_brk( pool->heap, 0 );
+
+     /* Give back the objects freed longest ago. */
+     for (i=0; i<SLAB_CACHE_BATCH; i++)
+          slab_give( pool, cache->objects[size_class][i] );
+
+     _fusion_shm_pool_unlock( pool );
+
+     cache->num[size_class] -= SLAB_CACHE_BATCH;
+
+     memmove( &cache->objects[size_class][0], &cache->objects[size_class][SLAB_CACHE_BATCH],
+              cache->num[size_class] * sizeof(void*) );
+
+     return DR_OK;
+}
+
+/*
+ * Start using the cache of the calling thread, fails if it has been flushed meanwhile.
+ */
+static bool
+cache_enter( SlabCache           *cache,
+             FusionSHMPoolShared *pool )
+{
+     while (!D_SYNC_BOOL_COMPARE_AND_SWAP( &cache->busy, 0, 1 ))
+          direct_sched_yield();
+
+     if (cache->pool == pool)
+          return true;
+
+     D_SYNC_SYNCHRONIZE();
+
+     cache->busy = 0;
+
+     return false;
+}
+
+static void
+cache_leave( SlabCache *cache )
+{
+     D_ASSERT( cache->busy == 1 );
+
+     D_SYNC_SYNCHRONIZE();
+
+     cache->busy = 0;
+}
+
+/**********************************************************************************************************************/
+
+static void
+slab_thread_destroy( void *arg )
+{
+     int         i;
+     SlabThread *thread = arg;
+
+     D_MAGIC_ASSERT( thread, SlabThread );
+
+     direct_mutex_lock( &slab_lock );
+
+     for (i=0; i<SLAB_THREAD_POOLS; i++) {
+          SlabCache *cache = thread->caches[i];
+
+          if (!cache)
+               continue;
+
+          if (cache->pool)
+               cache_flush( cache, true );
+
+          direct_list_remove( &slab_caches, &cache->link );
+
+          D_MAGIC_CLEAR( cache );
+
+          D_FREE( cache );
+     }
+
+     direct_mutex_unlock( &slab_lock );
+
+     D_MAGIC_CLEAR( thread );
+
+     D_FREE( thread );
+}
+
+static void
+slab_fork_child( void )
+{
+     SlabCache *cache;
+
+     direct_mutex_init( &slab_lock );
+
+     /* The cached objects are still owned by the parent. */
+     direct_list_foreach (cache, slab_caches)
+          memset( cache->num, 0, sizeof(cache->num) );
+}
+
+static void
+slab_init_once( void )
+{
+     direct_mutex_init( &slab_lock );
+
+     direct_tls_register( &slab_tls, slab_thread_destroy );
+
+     pthread_atfork( NULL, NULL, slab_fork_child );
+}
+
+static SlabCache *
+slab_cache( FusionSHMPoolShared *pool )
+{
+     int         i;
+     SlabThread *thread;
+     SlabCache  *cache;
+
+     direct_once( &slab_once, slab_init_once );
+
+     thread = direct_tls_get( slab_tls );
+     if (!thread) {
+          thread = D_CALLOC( 1, sizeof(SlabThread) );
+          if (!thread)
+               return NULL;
+
+          D_MAGIC_SET( thread, SlabThread );
+
+          direct_tls_set( slab_tls, thread );
+     }
+
+     for (i=0; i<SLAB_THREAD_POOLS; i++) {
+          cache = thread->caches[i];
+
+          if (cache && cache->pool == pool)
+               return cache;
+     }
+
+     /* Take a new cache or one left by a pool that is gone. */
+     for (i=0; i<SLAB_THREAD_POOLS; i++) {
+          cache = thread->caches[i];
+
+          if (!cache) {
+               cache = D_CALLOC( 1, sizeof(SlabCache) );
+               if (!cache)
+                    return NULL;
+
+               D_MAGIC_SET( cache, SlabCache );
+
+               thread->caches[i] = cache;
+          }
+          else if (cache->pool)
+               continue;
+
+          direct_mutex_lock( &slab_lock );
+
+          if (!cache->link.magic)
+               direct_list_append( &slab_caches, &cache->link );
+
+          cache->pool = pool;
+
+          direct_mutex_unlock( &slab_lock );
+
+          return cache;
+     }
+
+     return NULL;
+}
+
+/**********************************************************************************************************************/
+
+DirectResult
+_fusion_shm_slab_allocate( FusionSHMPoolShared  *pool,
+                           int                   size,
+                           bool                  lock,
+                           void                **ret_data )
+{
+     DirectResult  ret;
+     int           size_class;
+     SlabCache    *cache = NULL;
+     void         *data;
+
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+     D_ASSERT( pool->slabs );
+     D_ASSERT( ret_data != NULL );
+
+     size_class = slab_size_class( size );
+
+     /* Without locking, the caller holds the lock already. */
+     if (lock)
+          cache = slab_cache( pool );
+
+     if (cache && cache_enter( cache, pool )) {
+          if (!cache->num[size_class]) {
+               ret = cache_refill( cache, size_class );
+               if (ret) {
+                    cache_leave( cache );
+                    return ret;
+               }
+          }
+
+          *ret_data = cache->objects[size_class][--cache->num[size_class]];
+
+          cache_leave( cache );
+
+          return DR_OK;
+     }
+
+     if (lock) {
+          ret = _fusion_shm_pool_lock( pool );
+          if (ret)
+               return ret;
+     }
+
+     __shmalloc_brk( pool->heap, 0 );
+
+     data = slab_take( pool, size_class );
+
+     if (lock)
+          _fusion_shm_pool_unlock( pool );
+
+     if (!data)
+          return DR_NOSHAREDMEMORY;
+
+     *ret_data = data;
+
+     return DR_OK;
+}
+
+void
+_fusion_shm_slab_deallocate( FusionSHMPoolShared *pool,
+                             void                *data,
+                             bool                 lock )
+{
+     FusionSHMSlab *slab  = SLAB_OF( data );
+     SlabCache     *cache = NULL;
+
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+     D_MAGIC_ASSERT( slab, FusionSHMSlab );
+     D_ASSERT( _fusion_shm_slab_owns( pool, data ) );
+
+     if (lock)
+          cache = slab_cache( pool );
+
+     if (cache && cache_enter( cache, pool )) {
+          int size_class = slab->size_class;
+
+          if (cache->num[size_class] < SLAB_CACHE_OBJECTS || cache_drain( cache, size_class ) == DR_OK) {
+               cache->objects[size_class][cache->num[size_class]++] = data;
+               cache_leave( cache );
+               return;
+          }
+
+          cache_leave( cache );
+     }
+
+     if (lock && _fusion_shm_pool_lock( pool ))
+          return;
+
+     __shmalloc_brk( pool->heap, 0 );
+
+     slab_give( pool, data );
+
+     if (lock)
+          _fusion_shm_pool_unlock( pool );
+}
+
+int
+_fusion_shm_slab_size( FusionSHMPoolShared *pool,
+                       const void          *data )
+{
+     const FusionSHMSlab *slab = SLAB_OF( data );
+
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+     D_MAGIC_ASSERT( slab, FusionSHMSlab );
+
+     return slab_sizes[slab->size_class];
+}
+
+void
+_fusion_shm_slab_flush( FusionSHMPoolShared *pool,
+                        bool                 give_back )
+{
+     SlabCache *cache;
+
+     D_DEBUG_AT( Fusion_SHMSlab, "%s( %p, %sgive back )\n", __FUNCTION__, pool, give_back ? "" : "don't " );
+
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+
+     if (!pool->slabs)
+          return;
+
+     direct_once( &slab_once, slab_init_once );
+
+     direct_mutex_lock( &slab_lock );
+
+     direct_list_foreach (cache, slab_caches) {
+          if (cache->pool != pool)
+               continue;
+
+          /* Wait for the owning thread to be done with its cache. */
+          while (!D_SYNC_BOOL_COMPARE_AND_SWAP( &cache->busy, 0, 2 ))
+               direct_sched_yield();
+
+          cache_flush( cache, give_back );
+
+          D_SYNC_SYNCHRONIZE();
+
+          cache->busy = 0;
+     }
+
+     direct_mutex_unlock( &slab_lock );
+}
+
+void
+_fusion_shm_slab_stats( FusionSHMPoolShared *pool,
+                        unsigned int        *ret_bytes,
+                        unsigned int        *ret_free )
+{
+     int i;
+
+     D_MAGIC_ASSERT( pool, FusionSHMPoolShared );
+     D_ASSERT( ret_bytes != NULL );
+     D_ASSERT( ret_free != NULL );
+
+     *ret_bytes = 0;
+     *ret_free  = 0;
+
+     for (i=0; i<FUSION_SHM_SLAB_CLASSES; i++) {
+          const FusionSHMSlabClass *slab_class = &pool->slab_classes[i];
+
+          *ret_bytes += slab_class->slabs * SLAB_OBJECTS( slab_sizes[i] ) * slab_sizes[i];
+          *ret_free  += slab_class->free * slab_sizes[i];
+     }
+}
@@ -30,6 +30,7 @@
 
 #include <config.h>
 
+#include <direct/atomic.h>
 #include <direct/interface.h>
 #include <direct/memcpy.h>
 #include <direct/messages.h>
@@ -62,8 +63,11 @@ ISaWMan_Destruct( ISaWMan *thiz )
      for (i=0; i<data->num_tiers; i++) {
           dfb_updates_deinit( &data->tiers[i].updates );
 
-          if (data->tiers[i].attached)
+          if (data->tiers[i].attached) {
                fusion_reactor_detach( data->tiers[i].tier->reactor, &data->tiers[i].reaction );
+
+               D_SYNC_ADD( &data->tiers[i].tier->update_listeners, -1 );
+          }
      }
 
      dfb_core_destroy( data->core, false );
@@ -229,6 +233,9 @@ ISaWMan_GetUpdates( ISaWMan                *thiz,
                     fusion_reactor_attach_channel( data->tiers[i].tier->reactor,
                                                    SAWMAN_TIER_UPDATE, ISaWMan_Tier_Update, data, &data->tiers[i].reaction );
 
+                    /* Keep the tier composited, a scanned out window never reaches the tier surface. */
+                    D_SYNC_ADD( &data->tiers[i].tier->update_listeners, 1 );
+
                     data->tiers[i].attached = true;
                }
 
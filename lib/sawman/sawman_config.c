@@ -75,6 +75,7 @@ static const char *config_usage =
      "  update-region-mode=<num>           Set internal update region mode (1-3, default 2)\n"
      "  keep-implicit-key-grabs            Causes implicit key grabs to stay even when window is withdrawn\n"
      "  hide-cursor-without-window         Hides the cursor when no window has control over it\n"
+     "  [no-]bypass                        Scan out a fullscreen opaque window without compositing\n"
      "\n";
 
 
@@ -151,6 +152,8 @@ config_allocate( void )
 
      sawman_config->static_layer = true;
 
+     sawman_config->bypass = true;
+
 
      return DFB_OK;
 }
@@ -418,6 +421,12 @@ sawman_config_set( const char *name, const char *value )
      } else
      if (strcmp (name, "hide-cursor-without-window") == 0) {
           sawman_config->hide_cursor_without_window = true;
+     } else
+     if (strcmp (name, "bypass") == 0) {
+          sawman_config->bypass = true;
+     } else
+     if (strcmp (name, "no-bypass") == 0) {
+          sawman_config->bypass = false;
      } else
           return DFB_UNSUPPORTED;
 
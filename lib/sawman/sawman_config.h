@@ -68,6 +68,8 @@ typedef struct {
      DFBDimension          passive3d_mode;
 
      bool                  hide_cursor_without_window;
+
+     bool                  bypass;      /* Scan out a fullscreen opaque window directly. */
 } SaWManConfig;
 
 
@@ -238,6 +238,9 @@ sawman_initialize( SaWMan         *sawman,
      /* Initialize window layout vector. */
      fusion_vector_init( &sawman->layout, 8, sawman->shmpool );
 
+     /* Initialize index of window bounds. */
+     dfb_region_index_init( &sawman->index, sawman->shmpool );
+
      /* Default to HW Scaling if supported. */
      if (dfb_gfxcard_get_device_info( &info ), info.caps.accel & DFXL_STRETCHBLIT)
           sawman->scaling_mode = SWMSM_SMOOTH;
@@ -458,6 +461,9 @@ sawman_shutdown( SaWMan      *sawman,
      /* Destroy window layout vector. */
      fusion_vector_destroy( &sawman->layout );
 
+     /* Destroy index of window bounds. */
+     dfb_region_index_deinit( &sawman->index );
+
      /* Free grabbed keys. */
      direct_list_foreach_safe (key, next, sawman->grabbed_keys) {
           SHFREE( key->owner->shmpool, key );
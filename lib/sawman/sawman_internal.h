@@ -53,6 +53,8 @@ extern "C"
 
 #include <core/CoreGraphicsStateClient.h>
 
+#include <misc/region_index.h>
+
 #include "sawman_types.h"
 
 /**********************************************************************************************************************/
@@ -246,6 +248,9 @@ struct __SaWMan_SaWMan {
 
      FusionVector          layout;
 
+     DFBRegionIndex        index;              /* bounds of the windows in the layout at the resolution */
+     bool                  index_valid;        /* built on demand for hit testing */
+
      DirectLink           *tiers;
 
      CoreWindowStack      *stack;
@@ -388,6 +393,8 @@ struct __SaWMan_SaWManTier {
      DFBDisplayLayerOptions  single_options;
      DFBColorKey             single_key;
 
+     SaWManWindow           *bypass_window;      /* window whose surface is scanned out instead of the tier's */
+
      bool                    border_only;
      DFBDisplayLayerConfig   border_config;
 
@@ -401,6 +408,7 @@ struct __SaWMan_SaWManTier {
      int                     cursor_dy;
 
      FusionReactor          *reactor;
+     int                     update_listeners;   /* ISaWMan instances reading the tier surface upon SAWMAN_TIER_UPDATE */
 
      SaWManTierLR            left;
      SaWManTierLR            right;
@@ -34,8 +34,10 @@
 
 #include <unistd.h>
 
+#include <direct/arena.h>
 #include <direct/debug.h>
 #include <direct/list.h>
+#include <direct/perf.h>
 
 #include <fusion/conf.h>
 #include <fusion/fusion.h>
@@ -73,6 +75,10 @@ D_DEBUG_DOMAIN( SaWMan_Update,   "SaWMan/Update",   "SaWMan window manager updat
 D_DEBUG_DOMAIN( SaWMan_FlipOnce, "SaWMan/FlipOnce", "SaWMan window manager flip once" );
 D_DEBUG_DOMAIN( SaWMan_Surface,  "SaWMan/Surface",  "SaWMan window manager surface" );
 D_DEBUG_DOMAIN( SaWMan_Focus,    "SaWMan/Focus",    "SaWMan window manager focus" );
+D_DEBUG_DOMAIN( SaWMan_Bypass,   "SaWMan/Bypass",   "SaWMan window manager scan-out bypass" );
+
+static D_COUNTER( SaWMan_Bypass_Frames,   "SaWMan/Bypass/Frames" );
+static D_COUNTER( SaWMan_Bypass_Fallback, "SaWMan/Bypass/Fallback" );
 
 /**********************************************************************************************************************/
 
@@ -83,39 +89,50 @@ typedef struct {
      DFBRegion  region;
 } DFBLinkRegion;
 
+/* Link regions live in the thread's arena until the pool is deleted. */
 typedef struct {
-     DFBLinkRegion *regions;
-     DFBLinkRegion *malloc;
-     int number;
-     int free;
+     DirectArena     *arena;
+     DirectArenaMark  mark;
 } DFBLinkRegionPool;
 
 typedef struct {
-     DFBRegion     region;
-     int           cap;
-     int           size;
-     int           curr;
-     SaWManWindow *windows;
+     DirectArena     *arena;
+     DirectArenaMark  mark;        /* Arena before allocating this bin, bins are freed in reverse order. */
+     DFBRegion        region;
+     int              cap;
+     int              size;
+     int              curr;
+     SaWManWindow    *windows;
      /* hidden array of SaWManWindow* at the end of this struct */
 } DFBUpdateBin;
 
 static inline DFBUpdateBin *dfb_update_bin_get( const DFBUpdateBin *src, SaWManWindow *window, const int x1, const int y1, const int x2, const int y2, const int max)
 {
-     int           cap  = max;
-     int           size = 0;
-     DFBUpdateBin *bin;
+     int              cap  = max;
+     int              size = 0;
+     DFBUpdateBin    *bin;
+     DirectArena     *arena;
+     DirectArenaMark  mark;
 
 
      if (src) {
           cap = src->cap;
           size = src->size;
+          arena = src->arena;
      }
+     else
+          arena = direct_arena_thread();
 
      D_ASSERT(cap > 0);
+     D_ASSERT(NULL != arena);
 
-     bin = malloc( sizeof(DFBUpdateBin) + (cap - 1) * sizeof(SaWManWindow*) );
+     direct_arena_mark( arena, &mark );
+
+     bin = direct_arena_alloc( arena, sizeof(DFBUpdateBin) + (cap - 1) * sizeof(SaWManWindow*) );
      D_ASSERT(NULL != bin);
 
+     bin->arena  = arena;
+     bin->mark   = mark;
      bin->region = (DFBRegion){ x1, y1, x2, y2 };
      bin->size = size;
      bin->cap = cap;
@@ -135,6 +152,13 @@ static inline DFBUpdateBin *dfb_update_bin_get( const DFBUpdateBin *src, SaWManW
      return bin;
 }
 
+static inline void dfb_update_bin_free( DFBUpdateBin *bin )
+{
+     DirectArenaMark mark = bin->mark;
+
+     direct_arena_release( bin->arena, &mark );
+}
+
 static inline SaWManWindow *dfb_update_bin_window_get( const DFBUpdateBin *bin, const int index )
 {
      D_ASSERT(NULL != bin);
@@ -144,47 +168,27 @@ static inline SaWManWindow *dfb_update_bin_window_get( const DFBUpdateBin *bin,
      return *(&bin->windows + index);
 }
 
-static inline void dfb_linkregionpool_init( DFBLinkRegionPool *pool, DFBLinkRegion *regions, int number )
+static inline void dfb_linkregionpool_init( DFBLinkRegionPool *pool )
 {
-     pool->regions = regions;
-     pool->malloc  = 0;
-     pool->number  = number;
-     pool->free    = 0;
+     pool->arena = direct_arena_thread();
+
+     D_ASSERT( pool->arena != NULL );
+
+     direct_arena_mark( pool->arena, &pool->mark );
 }
 
 static inline void dfb_linkregionpool_delete( DFBLinkRegionPool *pool )
 {
-     if (pool->malloc)
-          free(pool->malloc);
+     direct_arena_release( pool->arena, &pool->mark );
 }
 
 static inline DFBLinkRegion *dfb_linkregionpool_get( DFBLinkRegionPool *pool, DFBRegion *r )
 {
      DFBLinkRegion *lr;
 
-     /* check OOM */
-     if (pool->free == pool->number) {
-          if (pool->malloc) {
-               D_WARN("Out of link regions!");
-               return NULL;
-          }
-          else {
-               pool->free   = 0;
-               pool->number = 400;
-               pool->malloc = malloc( sizeof(DFBLinkRegion) * 400 );
-               if (!pool->malloc) {
-                    D_WARN("out of memory!");
-                    return NULL;
-               }
-          }
-     }
-
-     if (pool->malloc)
-          lr = pool->malloc + pool->free;
-     else
-          lr = pool->regions + pool->free;
-
-     pool->free++;
+     lr = direct_arena_alloc( pool->arena, sizeof(DFBLinkRegion) );
+     if (!lr)
+          return NULL;
 
      if (r)
           lr->region = *r;
@@ -628,7 +632,6 @@ update_region3( SaWMan          *sawman,
      DFBRegion updateRegion = {x1,y1,x2,y2};
 
      DFBLinkRegionPool  regionpool;
-     DFBLinkRegion     *regionstorage;
 
      DirectLink *backgroundNotNeeded = 0;
      DirectLink *backgroundNeeded    = 0;
@@ -654,9 +657,7 @@ update_region3( SaWMan          *sawman,
      D_ASSERT( stack != NULL );
 
      /* we need some intermediate storage */
-     /* 50 = arbitrary */
-     regionstorage = alloca(sizeof(DFBLinkRegion) * 50);
-     dfb_linkregionpool_init( &regionpool, regionstorage, 50 );
+     dfb_linkregionpool_init( &regionpool );
 
      const int numberOfWindows  = fusion_vector_size( &sawman->layout );
      DirectLink *updatesBlend[numberOfWindows];
@@ -1053,7 +1054,7 @@ update_region4_r( SaWMan          *sawman,
                update_region4_r( sawman, tier, state, -1, right_eye, dfb_update_bin_get( bin, sawwin, region.x1, region.y1, region.x2, region.y2, i + 1) );
           }
 
-          free( bin );
+          dfb_update_bin_free( bin );
      }
      else {
           D_DEBUG_AT( SaWMan_Update, "%s --> terminate bin->curr=%d bin->size=%d bin (%d,%d - %d,%d)\n", __FUNCTION__, bin->curr, bin->size, bin->region.x1, bin->region.y1, bin->region.x2, bin->region.y2 );
@@ -1062,7 +1063,7 @@ update_region4_r( SaWMan          *sawman,
           if (bin->size < 1) {
                sawman_draw_background( tier, state, &bin->region );
 
-               free( bin );
+               dfb_update_bin_free( bin );
           }
           else {
                CoreWindow      *window  = dfb_update_bin_window_get(bin, bin->curr - 1)->window;
@@ -1100,7 +1101,7 @@ update_region4_r( SaWMan          *sawman,
                     if (bin->curr >= 1)
                          update_region4_r( sawman, tier, state, -1, right_eye, bin );
                     else
-                         free( bin );
+                         dfb_update_bin_free( bin );
                }
                else {
                     /* single blend */
@@ -1113,7 +1114,7 @@ update_region4_r( SaWMan          *sawman,
                          update_region4_r( sawman, tier, state, -1, right_eye, bin );
                     }
                     else {
-                         free( bin );
+                         dfb_update_bin_free( bin );
                     }
                }
           }
@@ -1498,6 +1499,219 @@ windows_updating( SaWMan     *sawman,
      return false;
 }
 
+/*
+ * A window can be scanned out directly if it's opaque, covers the whole tier without scaling
+ * and nothing else has to be drawn into the layer surface, e.g. a software cursor. Neither must
+ * anyone read the tier surface, i.e. ISaWMan clients waiting for tier updates.
+ */
+static bool
+bypass_possible( SaWMan       *sawman,
+                 SaWManTier   *tier,
+                 SaWManWindow *sawwin )
+{
+     CoreWindow      *window;
+     CoreSurface     *surface;
+     CoreWindowStack *stack;
+
+     D_MAGIC_ASSERT( sawman, SaWMan );
+     D_MAGIC_ASSERT( tier, SaWManTier );
+     D_MAGIC_ASSERT( sawwin, SaWManWindow );
+
+     if (!sawman_config->bypass || tier->update_listeners)
+          return false;
+
+     window = sawwin->window;
+     D_MAGIC_COREWINDOW_ASSERT( window );
+
+     surface = window->surface;
+     if (!surface)
+          return false;
+
+     if (   (window->caps & (DWCAPS_INPUTONLY | DWCAPS_COLOR | DWCAPS_LR_MONO | DWCAPS_STEREO))
+         || SAWMAN_TRANSLUCENT_WINDOW(window)
+         || window->config.rotation
+         || sawman_window_border( sawwin ))
+          return false;
+
+     if (sawwin->dst.x != 0 || sawwin->dst.y != 0 || sawwin->dst.w != tier->size.w || sawwin->dst.h != tier->size.h)
+          return false;
+
+     if (sawwin->src.x != 0 || sawwin->src.y != 0 || sawwin->src.w != sawwin->dst.w || sawwin->src.h != sawwin->dst.h)
+          return false;
+
+     if (sawwin->src.w != surface->config.size.w || sawwin->src.h != surface->config.size.h)
+          return false;
+
+     /* The application must not be rendering into the buffer being displayed. */
+     if (!(surface->config.caps & (DSCAPS_DOUBLE | DSCAPS_TRIPLE)) ||
+          (surface->config.caps & DSCAPS_STEREO) || surface->rotation)
+          return false;
+
+     stack = tier->stack;
+
+     if (tier->cursor_drawn ||
+         (!sawman->cursor.region && stack && stack->cursor.enabled && stack->cursor.opacity))
+          return false;
+
+     return true;
+}
+
+static DFBDisplayLayerBufferMode
+bypass_buffermode( const CoreSurface *surface )
+{
+     return (surface->config.caps & DSCAPS_TRIPLE) ? DLBM_TRIPLE : DLBM_BACKVIDEO;
+}
+
+/*
+ * Check if the layer region is configured to show the surface as is.
+ */
+static bool
+bypass_compatible( SaWManTier        *tier,
+                   const CoreSurface *surface )
+{
+     const CoreLayerRegionConfig *config;
+
+     D_MAGIC_ASSERT( tier, SaWManTier );
+     D_ASSERT( tier->region != NULL );
+
+     config = &tier->region->config;
+
+     return config->width      == surface->config.size.w &&
+            config->height     == surface->config.size.h &&
+            config->format     == surface->config.format &&
+            config->colorspace == surface->config.colorspace &&
+            config->buffermode == bypass_buffermode( surface ) &&
+            config->source.x   == 0 &&
+            config->source.y   == 0 &&
+            config->source.w   == surface->config.size.w &&
+            config->source.h   == surface->config.size.h &&
+            !(config->options & DLOP_STEREO);
+}
+
+static SaWManWindow *
+get_bypass_window( SaWMan     *sawman,
+                   SaWManTier *tier )
+{
+     int           n;
+     SaWManWindow *sawwin;
+
+     D_MAGIC_ASSERT( sawman, SaWMan );
+     D_MAGIC_ASSERT( tier, SaWManTier );
+     FUSION_SKIRMISH_ASSERT( sawman->lock );
+
+     /* Only the top most visible window qualifies, everything below is covered by it. */
+     fusion_vector_foreach_reverse (sawwin, n, sawman->layout) {
+          CoreWindow *window;
+
+          D_MAGIC_ASSERT( sawwin, SaWManWindow );
+
+          window = sawwin->window;
+          D_MAGIC_COREWINDOW_ASSERT( window );
+
+          if (SAWMAN_VISIBLE_WINDOW(window) && (tier->classes & (1 << window->config.stacking)))
+               return bypass_possible( sawman, tier, sawwin ) ? sawwin : NULL;
+     }
+
+     return NULL;
+}
+
+/*
+ * Hand the window surface to the layer region. Flips of the window are then displayed by the
+ * region's surface listener, there's nothing to composite until the bypass ends.
+ */
+static DFBResult
+process_bypass( SaWMan       *sawman,
+                SaWManTier   *tier,
+                SaWManWindow *sawwin )
+{
+     DFBResult    ret;
+     CoreSurface *surface;
+
+     D_MAGIC_ASSERT( sawman, SaWMan );
+     D_MAGIC_ASSERT( tier, SaWManTier );
+     D_MAGIC_ASSERT( sawwin, SaWManWindow );
+
+     surface = sawwin->window->surface;
+     D_ASSERT( surface != NULL );
+
+     if (tier->bypass_window != sawwin) {
+          D_DEBUG_AT( SaWMan_Bypass, "  -> Scanning out %dx%d %s of window %p on tier %p...\n",
+                      surface->config.size.w, surface->config.size.h,
+                      dfb_pixelformat_name( surface->config.format ), sawwin, tier );
+
+          ret = dfb_layer_region_set_surface( tier->region, surface, true );
+          if (ret) {
+               D_DEBUG_AT( SaWMan_Bypass, "  -> region refused surface: %s\n", DirectFBErrorString( ret ) );
+               return ret;
+          }
+
+          tier->bypass_window = sawwin;
+     }
+
+     D_COUNT( SaWMan_Bypass_Frames );
+
+     dfb_updates_reset( &tier->left.updates );
+     dfb_updates_reset( &tier->right.updates );
+
+     /* The whole tier changed, a listener attached meanwhile ends the bypass with the next update. */
+     if (1) {
+          SaWManTierUpdate update;
+
+          update.regions[0].x1 = 0;
+          update.regions[0].y1 = 0;
+          update.regions[0].x2 = tier->size.w - 1;
+          update.regions[0].y2 = tier->size.h - 1;
+
+          update.num_regions   = 1;
+          update.classes       = tier->classes;
+
+          fusion_reactor_dispatch_channel( tier->reactor, SAWMAN_TIER_UPDATE, &update, sizeof(update), true, NULL );
+     }
+
+     fusion_skirmish_notify( sawman->lock );
+
+     return DFB_OK;
+}
+
+void
+sawman_leave_bypass( SaWMan     *sawman,
+                     SaWManTier *tier )
+{
+     DFBResult ret;
+     DFBRegion region;
+
+     D_MAGIC_ASSERT( sawman, SaWMan );
+     D_MAGIC_ASSERT( tier, SaWManTier );
+     FUSION_SKIRMISH_ASSERT( sawman->lock );
+
+     if (!tier->bypass_window)
+          return;
+
+     D_DEBUG_AT( SaWMan_Bypass, "%s( %p, %p ) <- window %p\n", __FUNCTION__, sawman, tier, tier->bypass_window );
+
+     D_COUNT( SaWMan_Bypass_Fallback );
+
+     tier->bypass_window = NULL;
+
+     ret = dfb_layer_region_set_surface( tier->region, tier->surface, true );
+     if (ret)
+          D_DERROR( ret, "SaWMan/Bypass: Could not restore layer surface!\n" );
+
+     /* Nothing has been drawn into the layer surface meanwhile. */
+     tier->single_window   = NULL;
+     tier->cursor_bs_valid = false;
+
+     region.x1 = 0;
+     region.y1 = 0;
+     region.x2 = tier->size.w - 1;
+     region.y2 = tier->size.h - 1;
+
+     dfb_updates_add( &tier->left.updates, &region );
+
+     if (tier->region->config.options & DLOP_STEREO)
+          dfb_updates_add( &tier->right.updates, &region );
+}
+
 static DFBResult
 process_single( SaWMan              *sawman,
                 SaWManTier          *tier,
@@ -1631,6 +1845,7 @@ process_single( SaWMan              *sawman,
      {
           DFBDisplayLayerConfig config;
           CoreLayerRegionConfig region_config;
+          bool                  bypass = bypass_possible( sawman, tier, single );
 
           D_DEBUG_AT( SaWMan_Auto, "  -> Switching to %dx%d [%dx%d] %s single mode for %p on %p...\n",
                       single->src.w, single->src.h, src.w, src.h,
@@ -1642,7 +1857,7 @@ process_single( SaWMan              *sawman,
           config.height       = src.h;
           config.pixelformat  = surface->config.format;
           config.options      = options;
-          config.buffermode   = DLBM_FRONTONLY;
+          config.buffermode   = bypass ? bypass_buffermode( surface ) : DLBM_FRONTONLY;
           config.surface_caps = tier->context->config.surface_caps | (options & DLOP_STEREO ? DSCAPS_STEREO : 0);
 
           sawman->callback.layer_reconfig.layer_id = tier->layer_id;
@@ -1735,6 +1950,15 @@ process_single( SaWMan              *sawman,
           dfb_layer_context_unlock( tier->context );
 
 
+          if (bypass && bypass_compatible( tier, surface ) && process_bypass( sawman, tier, single ) == DFB_OK) {
+               tier->active = true;
+
+               if (sawman->cursor.context && tier->context->layer_id == sawman->cursor.context->layer_id)
+                    dfb_layer_activate_context( dfb_layer_at(tier->context->layer_id), tier->context );
+
+               return DFB_OK;
+          }
+
           sawman_dispatch_blit( sawman, single, false, &single->src, &single->dst, NULL );
 
           // FIXME: put in function, same as below
@@ -1911,6 +2135,8 @@ set_config( SaWMan     *sawman,
      tier->size.w = config->width;
      tier->size.h = config->height;
 
+     sawman->index_valid = false;
+
      /* Notify application manager about new tier size if previous mode was single. */
      if (tier->single_mode)
           sawman_call( sawman, SWMCID_STACK_RESIZED, &tier->size, sizeof(tier->size), false );
@@ -2260,6 +2486,7 @@ sawman_process_updates( SaWMan              *sawman,
           bool          none = false;
           bool          border_only;
           SaWManWindow *single;
+          SaWManWindow *bypass;
 
           idx++;
 
@@ -2293,6 +2520,14 @@ sawman_process_updates( SaWMan              *sawman,
           if (!tier->config.width || !tier->config.height)
                continue;
 
+          /* Keep scanning out the top most window as long as the layer can show its surface. */
+          bypass = get_bypass_window( sawman, tier );
+          if (bypass && tier->active && bypass_compatible( tier, bypass->window->surface ) &&
+              process_bypass( sawman, tier, bypass ) == DFB_OK)
+               continue;
+
+          sawman_leave_bypass( sawman, tier );
+
           single = get_single_window( sawman, tier, &none );
 
           if (none && !sawman_config->show_empty) {
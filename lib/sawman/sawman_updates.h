@@ -49,6 +49,9 @@ void         sawman_flush_updating ( SaWMan                *sawman,
                                      SaWManTier            *tier,
                                      WMData                *wmdata );
 
+void         sawman_leave_bypass   ( SaWMan                *sawman,
+                                     SaWManTier            *tier );
+
 
 #ifdef __cplusplus
 }
@@ -567,6 +567,8 @@ sawman_insert_window( SaWMan       *sawman,
           if (old != index) {
                fusion_vector_move( &sawman->layout, old, index );
 
+               sawman->index_valid = false;
+
                dfb_wm_dispatch_WindowRestack( layer->core, window, index );
           }
      }
@@ -575,6 +577,8 @@ sawman_insert_window( SaWMan       *sawman,
           if (ret)
                return ret;
 
+          sawman->index_valid = false;
+
           dfb_wm_dispatch_WindowRestack( layer->core, window, index );
 
           /* Set 'inserted' flag. */
@@ -622,6 +626,8 @@ sawman_remove_window( SaWMan       *sawman,
 
      fusion_vector_remove( &sawman->layout, index );
 
+     sawman->index_valid = false;
+
      /* Release all explicit key grabs. */
      direct_list_foreach_safe (key, next, sawman->grabbed_keys) {
           if (key->owner == sawwin) {
@@ -844,9 +850,12 @@ sawman_update_geometry( SaWManWindow *sawwin )
      sawman = sawwin->sawman;
      D_MAGIC_ASSERT_IF( sawman, SaWMan );
 
-     if (sawman)
+     if (sawman) {
           FUSION_SKIRMISH_ASSERT( sawman->lock );
 
+          sawman->index_valid = false;
+     }
+
      window = sawwin->window;
      D_MAGIC_COREWINDOW_ASSERT( window );
 
@@ -1074,6 +1083,9 @@ sawman_restack_window( SaWMan                 *sawman,
           window->config.stacking = stacking;
 
           sawwin->priority = sawman_window_priority( sawwin );
+
+          /* Window may belong to another tier now. */
+          sawman->index_valid = false;
      }
 
      /* Make sure window is inserted and not kept above/under parent. */
@@ -1303,6 +1315,8 @@ sawman_restack_window( SaWMan                 *sawman,
           /* Actually change the stacking order now. */
           fusion_vector_move( &sawman->layout, old, index );
 
+          sawman->index_valid = false;
+
           D_DEBUG_AT( SaWMan_Stacking, "  -> now index %d\n", fusion_vector_index_of( &sawman->layout, sawwin ) );
 
           dfb_wm_dispatch_WindowRestack( layer->core, window, index );
@@ -1649,13 +1663,57 @@ sawman_update_focus( SaWMan          *sawman,
      return false;
 }
 
+/*
+ * Indexes the bounds of all windows in the layout, converted from tier coordinates
+ * to the resolution and extended to include every point mapped into the bounds.
+ */
+static void
+update_index( SaWMan *sawman )
+{
+     int           i;
+     SaWManWindow *sawwin;
+     int           rw = sawman->resolution.w;
+     int           rh = sawman->resolution.h;
+
+     D_MAGIC_ASSERT( sawman, SaWMan );
+
+     if (dfb_region_index_reset( &sawman->index, sawman->layout.count ))
+          return;
+
+     fusion_vector_foreach (sawwin, i, sawman->layout) {
+          SaWManTier   *tier;
+          DFBRectangle *bounds = &sawwin->bounds;
+          DFBRegion     region = { -1, -1, rw, rh };
+
+          D_MAGIC_ASSERT( sawwin, SaWManWindow );
+
+          if (bounds->w < 1 || bounds->h < 1)
+               continue;
+
+          tier = sawman_tier_by_class( sawman, sawwin->window->config.stacking );
+          D_MAGIC_ASSERT( tier, SaWManTier );
+
+          if (tier->size.w > 0 && tier->size.h > 0) {
+               region.x1 = (s64) bounds->x * rw / tier->size.w - 1;
+               region.y1 = (s64) bounds->y * rh / tier->size.h - 1;
+               region.x2 = ((s64) (bounds->x + bounds->w) * rw + tier->size.w - 1) / tier->size.w + 1;
+               region.y2 = ((s64) (bounds->y + bounds->h) * rh + tier->size.h - 1) / tier->size.h + 1;
+          }
+
+          dfb_region_index_set( &sawman->index, i, &region );
+     }
+
+     sawman->index_valid = (dfb_region_index_build( &sawman->index, rw, rh ) == DFB_OK);
+}
+
 SaWManWindow*
 sawman_window_at_pointer( SaWMan          *sawman,
                           CoreWindowStack *stack,
                           int              x,
                           int              y )
 {
-     int           i;
+     int           i, n;
+     const int    *candidates = NULL;
      SaWManWindow *sawwin;
      CoreWindow   *window;
 
@@ -1680,10 +1738,20 @@ sawman_window_at_pointer( SaWMan          *sawman,
      if (y < 0)
           y = stack->cursor.y;
 
-     fusion_vector_foreach_reverse (sawwin, i, sawman->layout) {
+     if (!sawman->index_valid)
+          update_index( sawman );
+
+     /* Only look at windows listed for the cell containing the pointer. */
+     if (sawman->index_valid)
+          n = dfb_region_index_at( &sawman->index, x, y, &candidates );
+     else
+          n = sawman->layout.count;
+
+     while (n--) {
           SaWManTier *tier;
           int         tx, ty;
 
+          sawwin = fusion_vector_at( &sawman->layout, candidates ? candidates[n] : n );
           D_MAGIC_ASSERT( sawwin, SaWManWindow );
           window = sawwin->window;
           D_ASSERT( window != NULL );
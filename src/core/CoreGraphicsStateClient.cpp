@@ -41,6 +41,7 @@ extern "C" {
 #include <direct/mem.h>
 #include <direct/memcpy.h>
 #include <direct/messages.h>
+#include <direct/perf.h>
 
 #include <core/core.h>
 #include <core/graphics_state.h>
@@ -198,7 +199,7 @@ static Direct::TLSObject2<StateHolder> state_holder_tls;
 class ThrottleBlocking : public Graphics::Throttle
 {
 private:
-    bool           blocking;
+    bool volatile  blocking;
     Direct::LockWQ lwq;
 
 public:
@@ -214,6 +215,10 @@ public:
     {
          D_DEBUG_AT( Core_GraphicsStateClient_Throttle, "%s( %p, gfx_state %p )\n", __FUNCTION__, this, gfx_state );
 
+         /* Flushing threads only take the lock when they actually have to wait. */
+         if (!blocking)
+              return;
+
          Direct::LockWQ::Lock l1( lwq );
 
          while (blocking) {
@@ -928,11 +933,15 @@ CoreGraphicsStateClient_FillRectangles( CoreGraphicsStateClient *client,
                                         const DFBRectangle      *rects,
                                         unsigned int             num )
 {
+     static D_COUNTER( Core_GraphicsStateClient_FillRectangles, "Core/GraphicsStateClient/FillRectangles" );
+
      D_DEBUG_AT( Core_GraphicsStateClient, "%s( client %p )\n", __FUNCTION__, client );
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
      D_ASSERT( rects != NULL );
 
+     D_COUNT_N( Core_GraphicsStateClient_FillRectangles, num );
+
      if (client->renderer)
           client->renderer->FillRectangles( rects, num );
      else {
@@ -1059,12 +1068,16 @@ CoreGraphicsStateClient_Blit( CoreGraphicsStateClient *client,
                               const DFBPoint          *points,
                               unsigned int             num )
 {
+     static D_COUNTER( Core_GraphicsStateClient_Blit, "Core/GraphicsStateClient/Blit" );
+
      D_DEBUG_AT( Core_GraphicsStateClient, "%s( client %p )\n", __FUNCTION__, client );
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
      D_ASSERT( rects != NULL );
      D_ASSERT( points != NULL );
 
+     D_COUNT_N( Core_GraphicsStateClient_Blit, num );
+
      if (client->renderer)
           client->renderer->Blit( rects, points, num );
      else {
@@ -1098,6 +1111,8 @@ CoreGraphicsStateClient_Blit2( CoreGraphicsStateClient *client,
                                const DFBPoint          *points2,
                                unsigned int             num )
 {
+     static D_COUNTER( Core_GraphicsStateClient_Blit2, "Core/GraphicsStateClient/Blit2" );
+
      D_DEBUG_AT( Core_GraphicsStateClient, "%s( client %p )\n", __FUNCTION__, client );
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
@@ -1105,6 +1120,8 @@ CoreGraphicsStateClient_Blit2( CoreGraphicsStateClient *client,
      D_ASSERT( points1 != NULL );
      D_ASSERT( points2 != NULL );
 
+     D_COUNT_N( Core_GraphicsStateClient_Blit2, num );
+
      if (client->renderer)
           client->renderer->Blit2( rects, points1, points2, num );
      else {
@@ -1134,12 +1151,16 @@ CoreGraphicsStateClient_StretchBlit( CoreGraphicsStateClient *client,
                                      const DFBRectangle      *drects,
                                      unsigned int             num )
 {
+     static D_COUNTER( Core_GraphicsStateClient_StretchBlit, "Core/GraphicsStateClient/StretchBlit" );
+
      D_DEBUG_AT( Core_GraphicsStateClient, "%s( client %p, source buffer %p )\n", __FUNCTION__, client, client->state->source_buffer );
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
      D_ASSERT( srects != NULL );
      D_ASSERT( drects != NULL );
 
+     D_COUNT_N( Core_GraphicsStateClient_StretchBlit, num );
+
      if (num == 0)
           return DFB_OK;
 
@@ -1193,6 +1214,8 @@ CoreGraphicsStateClient_TileBlit( CoreGraphicsStateClient *client,
                                   const DFBPoint          *points2,
                                   unsigned int             num )
 {
+     static D_COUNTER( Core_GraphicsStateClient_TileBlit, "Core/GraphicsStateClient/TileBlit" );
+
      D_DEBUG_AT( Core_GraphicsStateClient, "%s( client %p )\n", __FUNCTION__, client );
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
@@ -1200,6 +1223,8 @@ CoreGraphicsStateClient_TileBlit( CoreGraphicsStateClient *client,
      D_ASSERT( points1 != NULL );
      D_ASSERT( points2 != NULL );
 
+     D_COUNT_N( Core_GraphicsStateClient_TileBlit, num );
+
      if (client->renderer)
           client->renderer->TileBlit( rects, points1, points2, num );
      else {
@@ -870,6 +870,9 @@ ISurface_Real::Flip2(
                    r.x2 == obj->config.size.w - 1 &&
                    r.y2 == obj->config.size.h - 1))
               {
+                  dfb_surface_set_flip_damage( obj, &l );
+                  dfb_surface_set_flip_damage( obj, &r );
+
                   ret = dfb_surface_flip_buffers( obj, swap );
                   if (ret)
                       goto out;
@@ -892,6 +895,8 @@ ISurface_Real::Flip2(
                   l.x2 == obj->config.size.w - 1 &&
                   l.y2 == obj->config.size.h - 1))
              {
+                  dfb_surface_set_flip_damage( obj, &l );
+
                   ret = dfb_surface_flip_buffers( obj, swap );
                   if (ret)
                       goto out;
@@ -1070,9 +1075,15 @@ ISurface_Real::DispatchUpdate(
      else
           r = l;
 
-     if (!(flags & DSFLIP_UPDATE))
+     if (!(flags & DSFLIP_UPDATE) && obj->flips != flip_count) {
+          dfb_surface_set_flip_damage( obj, &l );
+          dfb_surface_set_flip_damage( obj, &r );
+
           obj->flips = flip_count;
 
+          dfb_surface_track_flip( obj );
+     }
+
      // FIXME: this always updates full when a side is empty
      dfb_surface_dispatch_update( obj, &l, &r, timestamp, flags );
 
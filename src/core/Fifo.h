@@ -38,8 +38,10 @@
 extern "C" {
 #endif
 
+#include <direct/atomic.h>
 #include <direct/fifo.h>
 #include <direct/os/mutex.h>
+#include <direct/os/thread.h>
 #include <direct/os/waitqueue.h>
 
 
@@ -226,6 +228,207 @@ private:
 };
 
 
+/*
+ * Multi producer, single consumer FIFO
+ *
+ * Producers push onto a lock-free stack using compare and swap, the consumer takes the whole stack at once and
+ * reverses it into its private list, so items pushed by one thread are pulled in order. The mutex is only taken
+ * for sleeping on an empty FIFO and by producers waking up a sleeping consumer.
+ *
+ * Elements are recycled: the consumer pushes them onto a free stack, a producer running out of elements in its
+ * thread local cache takes the whole free stack at once, which is not prone to ABA like popping single elements.
+ */
+template <typename T>
+class MPSCFIFO
+{
+class Element {
+public:
+     Element *next;     /* must be first for D_SYNC_PUSH */
+     T        val;
+};
+
+public:
+     MPSCFIFO()
+          :
+          stack( NULL ),
+          list( NULL ),
+          released( NULL ),
+          waiting( 0 ),
+          num_items( 0 )
+     {
+          direct_mutex_init( &lock );
+          direct_waitqueue_init( &wq );
+          direct_tls_register( &cache, destroyElements );
+     }
+
+     ~MPSCFIFO()
+     {
+          T e;
+
+          while (take( &e ));
+
+          destroyElements( (Element*) direct_tls_get( cache ) );
+          destroyElements( released );
+
+          direct_tls_unregister( &cache );
+          direct_mutex_deinit( &lock );
+          direct_waitqueue_deinit( &wq );
+     }
+
+     void
+     push( T e )
+     {
+          Element *element = (Element*) direct_tls_get( cache );
+
+          if (!element)
+               element = (Element*) D_SYNC_FETCH_AND_CLEAR( (long*) &released );
+
+          if (element)
+               direct_tls_set( cache, element->next );
+          else
+               element = new Element;
+
+          element->val = e;
+
+          D_SYNC_PUSH_MULTI( &stack, element );
+
+          D_SYNC_ADD( &num_items, 1 );
+
+          /* The atomic operations above order the push before reading 'waiting'. */
+          if (waiting) {
+               direct_mutex_lock( &lock );
+               direct_waitqueue_signal( &wq );
+               direct_mutex_unlock( &lock );
+          }
+     }
+
+     T
+     pull()
+     {
+          T e;
+
+          while (!take( &e )) {
+               direct_mutex_lock( &lock );
+
+               D_SYNC_ADD( &waiting, 1 );
+
+               if (!stack)
+                    direct_waitqueue_wait( &wq, &lock );
+
+               D_SYNC_ADD( &waiting, -1 );
+
+               direct_mutex_unlock( &lock );
+          }
+
+          return e;
+     }
+
+     DirectResult
+     pull( T         *ret_item,
+           long long  timeout_us,  // timeout target timestamp (monotic clock) in micro seconds
+           long long  now = 0 )
+     {
+          DirectResult ret = DR_OK;
+
+          while (!take( ret_item )) {
+               if (now == 0)
+                    now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+               if (now >= timeout_us)
+                    return DR_TIMEOUT;
+
+               direct_mutex_lock( &lock );
+
+               D_SYNC_ADD( &waiting, 1 );
+
+               if (!stack)
+                    ret = direct_waitqueue_wait_timeout( &wq, &lock, timeout_us - now );
+
+               D_SYNC_ADD( &waiting, -1 );
+
+               direct_mutex_unlock( &lock );
+
+               if (ret)
+                    return ret;
+
+               now = 0;
+          }
+
+          return DR_OK;
+     }
+
+     bool
+     empty()
+     {
+          return num_items == 0;
+     }
+
+     size_t
+     count()
+     {
+          return num_items;
+     }
+
+private:
+     /* Consumer only */
+     bool
+     take( T *ret_item )
+     {
+          Element *element;
+
+          if (!list) {
+               Element *stacked = (Element*) D_SYNC_FETCH_AND_CLEAR( (long*) &stack );
+
+               while (stacked) {
+                    element = stacked;
+                    stacked = element->next;
+
+                    element->next = list;
+                    list          = element;
+               }
+
+               if (!list)
+                    return false;
+          }
+
+          element = list;
+          list    = element->next;
+
+          *ret_item = element->val;
+
+          D_SYNC_PUSH( &released, element );
+
+          D_SYNC_ADD( &num_items, -1 );
+
+          return true;
+     }
+
+     static void
+     destroyElements( void *arg )
+     {
+          Element *element = (Element*) arg;
+
+          while (element) {
+               Element *next = element->next;
+
+               delete element;
+
+               element = next;
+          }
+     }
+
+     Element * volatile  stack;
+     Element            *list;
+     Element * volatile  released;      /* released by the consumer, taken as a whole by producers */
+     DirectTLS           cache;         /* per producer list of elements */
+     int volatile        waiting;
+     int volatile        num_items;
+
+     DirectMutex         lock;
+     DirectWaitQueue     wq;
+};
+
+
 template <typename T>
 class FastFIFO
 {
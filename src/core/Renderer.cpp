@@ -39,6 +39,7 @@
 extern "C" {
 #include <directfb.h>
 
+#include <direct/atomic.h>
 #include <direct/debug.h>
 #include <direct/messages.h>
 
@@ -2013,7 +2014,8 @@ Quadrangles::render( Renderer::Setup *setup,
 Throttle::Throttle( Renderer &renderer )
      :
      ref_count(1),
-     task_count(0)
+     credits(dfb_config->max_render_tasks),
+     throttled(false)
 {
      D_DEBUG_AT( DirectFB_Renderer_Throttle, "Renderer::Throttle::%s( %p )\n", __FUNCTION__, this );
 
@@ -2034,41 +2036,34 @@ Throttle::~Throttle()
 void
 Throttle::ref()
 {
+     int refs;
+
      D_DEBUG_AT( DirectFB_Renderer_Throttle, "Renderer::Throttle::%s( %p )\n", __FUNCTION__, this );
 
      CHECK_MAGIC();
 
-     lwq.lock();
-
-     ref_count++;
-
-     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> %d refs now\n", ref_count );
+     refs = D_SYNC_ADD_AND_FETCH( &ref_count, 1 );
 
-     lwq.unlock();
+     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> %d refs now\n", refs );
 }
 
 void
 Throttle::unref()
 {
+     int refs;
+
      D_DEBUG_AT( DirectFB_Renderer_Throttle, "Renderer::Throttle::%s( %p )\n", __FUNCTION__, this );
 
      CHECK_MAGIC();
 
-     lwq.lock();
-
      D_ASSERT( ref_count > 0 );
 
-     ref_count--;
-
-     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> %d refs now\n", ref_count );
+     refs = D_SYNC_ADD_AND_FETCH( &ref_count, -1 );
 
-     if (ref_count == 0) {
-          lwq.unlock();
+     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> %d refs now\n", refs );
 
+     if (refs == 0)
           delete this;
-     }
-     else
-          lwq.unlock();
 }
 
 void
@@ -2094,32 +2089,57 @@ Throttle::waitDone( unsigned long timeout_us )
 
      Direct::LockWQ::Lock l1( lwq );
 
-     if (task_count > 0) {
+     while (credits < (int) dfb_config->max_render_tasks) {
           ret = l1.wait( timeout_us );
           if (ret) {
-               D_DERROR_AT( DirectFB_Renderer_Throttle, ret, "  -> error waiting for %u tasks to be done\n", task_count );
+               D_DERROR_AT( DirectFB_Renderer_Throttle, ret, "  -> error waiting for %d tasks to be done\n",
+                            (int) dfb_config->max_render_tasks - credits );
                DirectFB::TaskManager::dumpTasks();
+               break;
           }
      }
 
      return (DFBResult) ret;
 }
 
+/*
+ * Called with the lock held after the credits crossed zero in either direction.
+ *
+ * Setup and finalise of different tasks race on the credits, so the throttle is always
+ * derived from the current value rather than from the transition that triggered the call.
+ */
+void
+Throttle::updateThrottle()
+{
+     bool blocked = (credits <= 0);
+
+     if (blocked != throttled) {
+          D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> throttling at %s from now\n",
+                      blocked ? "100% (blocked)" : "0% (full speed)" );
+
+          throttled = blocked;
+
+          SetThrottle( blocked ? 100 : 0 );
+     }
+}
+
 DFBResult
 Throttle::Hook::setup( SurfaceTask *task )
 {
+     int credits;
+
      D_DEBUG_AT( DirectFB_Renderer_Throttle, "Renderer::Throttle::%s( %p, task %p )\n", __FUNCTION__, this, task );
 
      throttle.CHECK_MAGIC();
 
-     throttle.task_count++;
-
-     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> count %d\n", throttle.task_count );
+     credits = D_SYNC_ADD_AND_FETCH( &throttle.credits, -1 );
 
-     if (throttle.task_count == dfb_config->max_render_tasks) {
-          D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> throttling at 100%% (blocked) from now\n" );
+     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> credits %d\n", credits );
 
-          throttle.SetThrottle( 100 );
+     if (credits == 0) {
+          throttle.lwq.lock();
+          throttle.updateThrottle();
+          throttle.lwq.unlock();
      }
 
      return DFB_OK;
@@ -2128,27 +2148,30 @@ Throttle::Hook::setup( SurfaceTask *task )
 void
 Throttle::Hook::finalise( SurfaceTask *task )
 {
+     int credits;
+
      D_DEBUG_AT( DirectFB_Renderer_Throttle, "Renderer::Throttle::%s( %p, task %p )\n", __FUNCTION__, this, task );
 
      throttle.CHECK_MAGIC();
 
-     D_ASSERT( throttle.task_count > 0 );
+     D_ASSERT( throttle.credits < (int) dfb_config->max_render_tasks );
 
-     if (throttle.task_count == dfb_config->max_render_tasks) {
-          D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> throttling at 0%% (full speed) from now\n" );
+     credits = D_SYNC_ADD_AND_FETCH( &throttle.credits, 1 );
 
-          throttle.SetThrottle( 0 );
-     }
+     if (credits == 1 || credits == (int) dfb_config->max_render_tasks) {
+          throttle.lwq.lock();
 
-     throttle.lwq.lock();
+          if (credits == 1)
+               throttle.updateThrottle();
 
-     if (!--throttle.task_count)
-          throttle.lwq.notifyAll();
+          if (throttle.credits == (int) dfb_config->max_render_tasks)
+               throttle.lwq.notifyAll();
 
-     throttle.lwq.unlock();
+          throttle.lwq.unlock();
+     }
 
-     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> count  %d\n", throttle.task_count );
-     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> cookie %u\n", cookie );
+     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> credits %d\n", credits );
+     D_DEBUG_AT( DirectFB_Renderer_Throttle, "  -> cookie  %u\n", cookie );
 
      if (cookie)
           dfb_graphics_state_dispatch_done( throttle.gfx_state, cookie );
@@ -2360,7 +2383,7 @@ Renderer::update( DFBAccelerationMask accel )
           D_ASSERT( setup->tiles == setup->tiles_render );
 
           if (state_mod & SMF_CLIP) {
-               D_ASSERT( setup->tiles <= 32 );
+               D_ASSERT( setup->tiles <= DFB_RENDERER_TILES_MAX );
 
                setup->task_mask = 0;
 
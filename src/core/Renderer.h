@@ -80,6 +80,13 @@ extern "C" {
 #include <direct/Magic.h>
 
 
+/* Maximum number of tiles per Setup, limited by 'task_mask' */
+#define DFB_RENDERER_TILES_MAX          32
+
+/* Minimum height of a tile, surfaces too small for the requested number of tiles get less */
+#define DFB_RENDERER_TILE_MIN_HEIGHT    16
+
+
 namespace DirectFB {
 
 namespace Graphics {
@@ -150,8 +157,11 @@ protected:
      CoreGraphicsState *gfx_state;
 
 private:
-     unsigned int       ref_count;
-     unsigned int       task_count;
+     void      updateThrottle();
+
+     int volatile       ref_count;
+     int volatile       credits;
+     bool               throttled;
      Direct::LockWQ     lwq;
 };
 
@@ -170,12 +180,12 @@ public:
 
           SurfaceAllocationMap     allocations;
 
-          Setup( int width, int height, unsigned int tiles = 1 )
+          Setup( int width, int height, unsigned int num_tiles = 1 )
                :
-               tiles( tiles ),
+               tiles( limitTiles( height, num_tiles ) ),
                tiles_render( tiles )
           {
-               D_ASSERT( tiles > 0 );
+               D_ASSERT( num_tiles > 0 );
 
                tasks         = new SurfaceTask*[tiles];
                clips         = new DFBRegion[tiles*2];
@@ -217,6 +227,20 @@ public:
                delete[] tasks;
                delete[] clips;
           }
+
+     private:
+          static unsigned int limitTiles( int height, unsigned int tiles )
+          {
+               unsigned int max = height / DFB_RENDERER_TILE_MIN_HEIGHT;
+
+               if (tiles > DFB_RENDERER_TILES_MAX)
+                    tiles = DFB_RENDERER_TILES_MAX;
+
+               if (tiles > max)
+                    tiles = max ? max : 1;
+
+               return tiles;
+          }
      };
 
 public:
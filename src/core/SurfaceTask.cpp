@@ -490,5 +490,30 @@ SurfaceTask::Describe( Direct::String &string ) const
                     accesses.size() > 0 ? accesses[0].allocation->index : -1 );
 }
 
+/*
+ * Accessor and id of the surface written (or else first accessed) by the task, see DFB_TASK_TRACE_READY
+ */
+u64
+SurfaceTask::TraceInfo() const
+{
+     u32 surface_id = 0;
+
+     for (std::vector<SurfaceAllocationAccess>::const_iterator it=accesses.begin(); it!=accesses.end(); it++) {
+          CoreSurface *surface = (*it).allocation->surface;
+
+          if (!surface)
+               continue;
+
+          if (!surface_id || ((*it).flags & CSAF_WRITE)) {
+               surface_id = surface->object.id;
+
+               if ((*it).flags & CSAF_WRITE)
+                    break;
+          }
+     }
+
+     return ((u64) accessor << 32) | surface_id;
+}
+
 
 }
@@ -138,6 +138,7 @@ protected:
 public:
      virtual void                  Describe( Direct::String &string ) const;
      virtual const Direct::String &TypeName() const;
+     virtual u64                   TraceInfo() const;
 
 protected:
      virtual DFBResult CacheFlush();
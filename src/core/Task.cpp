@@ -57,6 +57,7 @@ extern "C" {
 #include <core/Debug.h>
 #include <core/Task.h>
 #include <core/TaskManager.h>
+#include <core/TaskTrace.h>
 #include <core/Util.h>
 
 /*********************************************************************************************************************/
@@ -254,6 +255,8 @@ Task::Task()
 
      DFB_TASK_LOG( "Task()" );
 
+     DFB_TASK_TRACE( DFB_TASK_TRACE_NEW, this );
+
 #if DFB_TASK_DEBUG_TIMING
      ts_flushed = 0;
      ts_ready   = 0;
@@ -417,6 +420,8 @@ Task::Flush()
      ts_flushed = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+     DFB_TASK_TRACE( DFB_TASK_TRACE_FLUSH, this, 0, 0, *TypeName() );
+
      TaskManager::pushTask( this );
 }
 
@@ -446,6 +451,8 @@ Task::emit()
      ts_running = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+     DFB_TASK_TRACE( DFB_TASK_TRACE_RUN, this );
+
      ret = Push();
      switch (ret) {
           case DFB_BUSY:
@@ -473,6 +480,8 @@ Task::emit()
                ts_running = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+               DFB_TASK_TRACE( DFB_TASK_TRACE_RUN, slave );
+
                ret = slave->Push();
                switch (ret) {
                     case DFB_BUSY:
@@ -518,6 +527,8 @@ Task::finish()
 
      DFB_TASK_LOG( "finish()" );
 
+     DFB_TASK_TRACE( DFB_TASK_TRACE_FINISH, this );
+
      state = TASK_FINISH;
 
      if (master) { /* has master? */
@@ -589,6 +600,8 @@ Task::Done( DFBResult ret )
      ts_done = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
 #endif
 
+     DFB_TASK_TRACE( DFB_TASK_TRACE_DONE, this, ret );
+
      if (ret)
           enableDump();
 
@@ -690,6 +703,12 @@ Task::Describe( Direct::String &string ) const
                     next );
 }
 
+u64
+Task::TraceInfo() const
+{
+     return hwid;
+}
+
 void
 Task::AddNotify( Task *notified,
                  bool  follow )
@@ -748,6 +767,8 @@ Task::AddNotify( Task *notified,
 
      notifies.push_back( TaskNotify( notified, follow ? TASK_RUNNING : TASK_FINISH ) );
 
+     DFB_TASK_TRACE( DFB_TASK_TRACE_NOTIFY, this, (unsigned long) notified, follow ? TASK_RUNNING : TASK_FINISH );
+
      notified->block_count++;
 
      D_DEBUG_AT( DirectFB_Task, "Task::%s() done\n", __FUNCTION__ );
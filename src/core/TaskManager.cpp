@@ -56,6 +56,7 @@ extern "C" {
 
 #include <core/Debug.h>
 #include <core/TaskManager.h>
+#include <core/TaskTrace.h>
 #include <core/Util.h>
 
 /*********************************************************************************************************************/
@@ -104,7 +105,7 @@ TaskManager_DumpTasks()
 
 bool              TaskManager::running;
 DirectThread     *TaskManager::thread;
-FIFO<Task*>       TaskManager::fifo;
+MPSCFIFO<Task*>   TaskManager::fifo;
 TaskThreads      *TaskManager::threads;
 #if DFB_TASK_DEBUG_TASKS
 std::list<Task*>  TaskManager::tasks;
@@ -117,6 +118,8 @@ std::set<Task*,TaskManager>   TaskManager::timed_emits;
 DFBResult
 TaskManager::Initialise()
 {
+     DFBResult ret;
+
      D_DEBUG_AT( DirectFB_Task, "TaskManager::%s()\n", __FUNCTION__ );
 
      D_ASSERT( thread == NULL );
@@ -125,6 +128,10 @@ TaskManager::Initialise()
      direct_recursive_mutex_init( &tasks_lock );
 #endif
 
+     ret = TaskTrace::Initialise();
+     if (ret)
+          return ret;
+
      if (dfb_config->task_manager) {
           running = true;
 
@@ -162,6 +169,8 @@ TaskManager::Shutdown()
           threads = NULL;
      }
 
+     TaskTrace::Shutdown();
+
 #if DFB_TASK_DEBUG_TASKS
      direct_mutex_deinit( &tasks_lock );
 #endif
@@ -273,6 +282,8 @@ TaskManager::handleTask( Task *task )
                     goto finish;
                }
 
+               DFB_TASK_TRACE( DFB_TASK_TRACE_READY, task, task->TraceInfo() );
+
 #if DFB_TASK_DEBUG_TIMES
                t2 = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
                if (t2 - t1 > DFB_TASK_WARN_SETUP) {
@@ -96,7 +96,7 @@ private:
      static bool               running;
 
      static DirectThread      *thread;
-     static FIFO<Task*>        fifo;
+     static MPSCFIFO<Task*>    fifo;
 
      static TaskThreads       *threads;
 
@@ -41,8 +41,10 @@
 
 
 extern "C" {
+#include <direct/atomic.h>
 #include <direct/debug.h>
 #include <direct/messages.h>
+#include <direct/util.h>
 
 #include <fusion/conf.h>
 
@@ -74,33 +76,47 @@ extern "C" {
 
 /*********************************************************************************************************************/
 
-TaskThreadsQ::Runner::Runner( TaskThreadsQ         *threads,
-                              unsigned int          index,
-                              DirectThreadType      type,
-                              const Direct::String &name )
+TaskThreadsQ::Runner::Runner( TaskThreadsQ *threads,
+                              unsigned int  index )
      :
      threads( threads ),
-     index( index )
+     index( index ),
+     thread( NULL )
 {
-     thread = direct_thread_create( type, taskLoop, this, name.buffer() );
+     direct_mutex_init( &lock );
 }
 
 TaskThreadsQ::Runner::~Runner()
 {
-     direct_thread_join( thread );
-     direct_thread_destroy( thread );
+     if (thread) {
+          direct_thread_join( thread );
+          direct_thread_destroy( thread );
+     }
+
+     direct_mutex_deinit( &lock );
 }
 
 /*********************************************************************************************************************/
 
 TaskThreadsQ::TaskThreadsQ( const std::string &name, size_t num, DirectThreadType type )
+     :
+     ready( 0 ),
+     sleepers( 0 ),
+     next_runner( 0 )
 {
      D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s( '%s', num %zu, type %d )\n", __FUNCTION__, name.c_str(), num, type );
 
+     direct_mutex_init( &lock );
+     direct_waitqueue_init( &wq );
+
+     /* All runners need to exist before the first one starts looking for work to steal */
+     for (size_t i=0; i<num; i++)
+          runners.push_back( new Runner( this, i ) );
+
      for (size_t i=0; i<num; i++) {
-          runners.push_back( new Runner( this, i, type, (num > 1) ?
-                                                            Direct::String::F( "%s/%zu", name.c_str(), i ) :
-                                                            Direct::String::F( "%s", name.c_str() ) ) );
+          runners[i]->thread = direct_thread_create( type, taskLoop, runners[i], (num > 1) ?
+                                                                      *Direct::String::F( "%s/%zu", name.c_str(), i ) :
+                                                                      *Direct::String::F( "%s", name.c_str() ) );
      }
 
      D_ASSUME( runners.size() == num );
@@ -109,12 +125,123 @@ TaskThreadsQ::TaskThreadsQ( const std::string &name, size_t num, DirectThreadTyp
 TaskThreadsQ::~TaskThreadsQ()
 {
      for (size_t i=0; i<runners.size(); i++)
-          fifo.push( NULL );
+          push( NULL, runners[i] );
 
      for (std::vector<Runner*>::const_iterator it = runners.begin(); it != runners.end(); it++)
           delete *it;
+
+     direct_waitqueue_deinit( &wq );
+     direct_mutex_deinit( &lock );
+}
+
+void
+TaskThreadsQ::push( Task   *task,
+                    Runner *runner )
+{
+     D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s( task %p, runner %p )\n", __FUNCTION__, task, runner );
+
+     D_ASSERT( runners.size() > 0 );
+
+     if (!runner)
+          runner = runners[(D_SYNC_ADD_AND_FETCH( &next_runner, 1 ) - 1) % runners.size()];
+
+     direct_mutex_lock( &runner->lock );
+     runner->tasks.push_back( task );
+     direct_mutex_unlock( &runner->lock );
+
+     /*
+      * The task is published before 'ready' is incremented and 'sleepers' is read after it (full barrier),
+      * while pull() increments 'sleepers' before reading 'ready', so either side sees the other.
+      */
+     D_SYNC_ADD_AND_FETCH( &ready, 1 );
+
+     if (*(volatile unsigned int *) &sleepers) {
+          direct_mutex_lock( &lock );
+          direct_waitqueue_signal( &wq );
+          direct_mutex_unlock( &lock );
+     }
 }
 
+bool
+TaskThreadsQ::claim()
+{
+     unsigned int num;
+
+     while ((num = *(volatile unsigned int *) &ready) > 0) {
+          if (D_SYNC_BOOL_COMPARE_AND_SWAP( &ready, num, num - 1 ))
+               return true;
+     }
+
+     return false;
+}
+
+Task *
+TaskThreadsQ::pull( Runner *runner )
+{
+     Task   *task = NULL;
+     size_t  num  = runners.size();
+
+     D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s( runner %u )\n", __FUNCTION__, runner->index );
+
+     /* Claim one of the ready tasks, it is guaranteed to stay in one of the deques until we find it */
+     if (!claim()) {
+          direct_mutex_lock( &lock );
+
+          D_SYNC_ADD_AND_FETCH( &sleepers, 1 );
+
+          while (!claim())
+               direct_waitqueue_wait( &wq, &lock );
+
+          D_SYNC_ADD_AND_FETCH( &sleepers, -1 );
+
+          direct_mutex_unlock( &lock );
+     }
+
+     while (true) {
+          /* Own tasks first, oldest first */
+          direct_mutex_lock( &runner->lock );
+
+          if (!runner->tasks.empty()) {
+               task = runner->tasks.front();
+               runner->tasks.pop_front();
+
+               direct_mutex_unlock( &runner->lock );
+
+               return task;
+          }
+
+          direct_mutex_unlock( &runner->lock );
+
+          /* Steal the most recent task from the next runner having some */
+          for (size_t i=1; i<num; i++) {
+               Runner *victim = runners[(runner->index + i) % num];
+
+               direct_mutex_lock( &victim->lock );
+
+               if (!victim->tasks.empty()) {
+                    static D_PERF_COUNTER( TaskThreadsQ__Steal, "TaskThreadsQ::Steal" );
+
+                    D_PERF_COUNT( TaskThreadsQ__Steal );
+
+                    task = victim->tasks.back();
+                    victim->tasks.pop_back();
+
+                    direct_mutex_unlock( &victim->lock );
+
+                    D_DEBUG_AT( DirectFB_TaskThreadsQ, "  -> stole task %p from runner %u\n", task, victim->index );
+
+                    return task;
+               }
+
+               direct_mutex_unlock( &victim->lock );
+          }
+
+          /* A deque we passed may have been refilled after others took from the ones ahead, look again */
+          direct_sched_yield();
+     }
+
+     return NULL;
+}
 
 void TaskThreadsQ::Push( Task *task )
 {
@@ -144,7 +271,7 @@ void TaskThreadsQ::Push( Task *task )
      else {
           D_DEBUG_AT( DirectFB_TaskThreadsQ, "  -> pushing task %p\n", task );
 
-          fifo.push( task );
+          push( task );
      }
 }
 
@@ -173,7 +300,7 @@ void TaskThreadsQ::Finalise( Task *task )
 
                D_DEBUG_AT( DirectFB_TaskThreadsQ, "  -> pushing task %p to resume operation\n", task->next );
 
-               fifo.push( task->next );
+               push( task->next, task->hwid < runners.size() ? runners[task->hwid] : NULL );
           }
           else {
                D_ASSERT( queues[task->qid] == task );
@@ -197,7 +324,7 @@ TaskThreadsQ::taskLoop( DirectThread *thread,
      D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s()\n", __FUNCTION__ );
 
      while (true) {
-          task = thiz->fifo.pull();
+          task = thiz->pull( runner );
           if (!task) {
                D_DEBUG_AT( DirectFB_TaskThreadsQ, "TaskThreadsQ::%s()  -> got NULL task (exit signal)\n", __FUNCTION__ );
                return NULL;
@@ -248,7 +375,7 @@ next:
 
                D_MAGIC_ASSERT( next, Task );
 
-               thiz->fifo.push( next );
+               thiz->push( next, runner );
           }
      }
 
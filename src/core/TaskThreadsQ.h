@@ -41,6 +41,8 @@ extern "C" {
 #endif
 
 #include <direct/fifo.h>
+#include <direct/os/mutex.h>
+#include <direct/os/waitqueue.h>
 #include <direct/thread.h>
 #include <direct/trace.h>
 
@@ -64,6 +66,7 @@ extern "C" {
 #include <core/Fifo.h>
 #include <core/Util.h>
 
+#include <deque>
 #include <list>
 #include <map>
 #include <queue>
@@ -79,28 +82,42 @@ class TaskManager;
 class TaskThreads;
 
 
+/*
+ * Runs tasks on a number of threads while keeping the order of tasks with the same queue id (qid).
+ *
+ * Each runner has its own deque of ready tasks. Tasks pushed from outside are distributed round robin,
+ * the next task of a queue is pushed to the deque of the runner that has finished its predecessor.
+ * Runners without work steal from the back of other runners' deques, so that uneven tiles or queues
+ * do not leave threads idle.
+ */
 class TaskThreadsQ : public Direct::Magic<TaskThreadsQ> {
 private:
      class Runner : public Direct::Magic<Runner> {
      public:
-          TaskThreadsQ *threads;
-          unsigned int  index;
-          DirectThread *thread;
+          TaskThreadsQ      *threads;
+          unsigned int       index;
+          DirectThread      *thread;
+          DirectMutex        lock;
+          std::deque<Task*>  tasks;
 
-          Runner( TaskThreadsQ         *threads,
-                  unsigned int          index,
-                  DirectThreadType      type,
-                  const Direct::String &name );
+          Runner( TaskThreadsQ *threads,
+                  unsigned int  index );
 
           ~Runner();
      };
 
 public:
-     DirectFB::FIFO<Task*>              fifo;   // TODO: try to find better structure without lock, maybe futex
      std::vector<Runner*>               runners;
      std::map<u64,Task*>                queues;
      std::map<u64,Direct::PerfCounter>  perfs;
 
+private:
+     DirectMutex                        lock;         // only for idle runners going to sleep and waking them up
+     DirectWaitQueue                    wq;
+     unsigned int                       ready;        // number of unclaimed tasks in all deques, atomic
+     unsigned int                       sleepers;     // number of runners waiting on 'wq', atomic
+     unsigned int                       next_runner;  // atomic
+
 public:
      TaskThreadsQ( const std::string &name, size_t num, DirectThreadType type = DTT_DEFAULT );
 
@@ -111,13 +128,16 @@ public:
      void Finalise( Task *task );
 
 private:
+     void  push( Task *task, Runner *runner = NULL );
+     bool  claim();
+     Task *pull( Runner *runner );
+
      static void *
      taskLoop( DirectThread *thread,
                void         *arg );
 };
 
 
-
 }
 
 
@@ -0,0 +1,195 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+//#define DIRECT_ENABLE_DEBUG
+
+#include <config.h>
+
+#include <directfb.h>    // include here to prevent it being included indirectly causing nested extern "C"
+
+#include <direct/Types++.h>
+
+extern "C" {
+#include <fcntl.h>
+#include <limits.h>
+
+#include <direct/atomic.h>
+#include <direct/clock.h>
+#include <direct/debug.h>
+#include <direct/filesystem.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/system.h>
+#include <direct/util.h>
+
+#include <misc/conf.h>
+}
+
+#include <core/Task.h>
+#include <core/TaskTrace.h>
+
+D_DEBUG_DOMAIN( DirectFB_TaskTrace, "DirectFB/Task/Trace", "DirectFB Task Trace" );
+
+/*********************************************************************************************************************/
+
+namespace DirectFB {
+
+
+DFBTaskTraceRecord *TaskTrace::ring;
+unsigned int        TaskTrace::mask;
+unsigned long       TaskTrace::pos;
+
+
+DFBResult
+TaskTrace::Initialise()
+{
+     unsigned int size = 1;
+
+     D_DEBUG_AT( DirectFB_TaskTrace, "TaskTrace::%s()\n", __FUNCTION__ );
+
+     D_ASSERT( ring == NULL );
+
+     if (!dfb_config->task_trace)
+          return DFB_OK;
+
+     if (dfb_config->task_trace_size > (UINT_MAX >> 1) + 1) {
+          D_ERROR( "DirectFB/TaskTrace: Size of %u events is too large!\n", dfb_config->task_trace_size );
+          return DFB_LIMITEXCEEDED;
+     }
+
+     while (size < dfb_config->task_trace_size)
+          size <<= 1;
+
+     ring = (DFBTaskTraceRecord*) D_CALLOC( size, sizeof(DFBTaskTraceRecord) );
+     if (!ring)
+          return (DFBResult) D_OOM();
+
+     mask = size - 1;
+     pos  = 0;
+
+     D_INFO( "DirectFB/TaskTrace: Recording up to %u events for '%s'\n", size, dfb_config->task_trace );
+
+     return DFB_OK;
+}
+
+void
+TaskTrace::Shutdown()
+{
+     DFBTaskTraceRecord *records = ring;
+
+     D_DEBUG_AT( DirectFB_TaskTrace, "TaskTrace::%s()\n", __FUNCTION__ );
+
+     if (!records)
+          return;
+
+     Write( dfb_config->task_trace );
+
+     ring = NULL;
+
+     D_FREE( records );
+}
+
+void
+TaskTrace::Add( DFBTaskTraceEvent  event,
+                const Task        *task,
+                u64                arg,
+                u32                flags,
+                const char        *name )
+{
+     unsigned long       index  = D_SYNC_ADD_AND_FETCH( &pos, 1 ) - 1;
+     DFBTaskTraceRecord *record = &ring[index & mask];
+
+     record->micros = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+     record->task   = (unsigned long) task;
+     record->arg    = arg;
+     record->event  = event;
+     record->flags  = flags;
+     record->tid    = direct_gettid();
+
+     if (name)
+          direct_snputs( record->name, name, sizeof(record->name) );
+     else
+          record->name[0] = 0;
+}
+
+DFBResult
+TaskTrace::Write( const char *filename )
+{
+     DirectResult        ret;
+     DirectFile          fd;
+     DFBTaskTraceHeader  header;
+     unsigned long       end   = pos;
+     unsigned long       count = MIN( end, (unsigned long) mask + 1 );
+     unsigned long       start = end - count;
+     size_t              bytes;
+
+     D_DEBUG_AT( DirectFB_TaskTrace, "TaskTrace::%s( '%s' )\n", __FUNCTION__, filename );
+
+     D_ASSERT( ring != NULL );
+
+     ret = direct_file_open( &fd, filename, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+     if (ret) {
+          D_DERROR( ret, "DirectFB/TaskTrace: Could not open '%s' for writing!\n", filename );
+          return (DFBResult) ret;
+     }
+
+     header.magic       = DFB_TASK_TRACE_MAGIC;
+     header.version     = DFB_TASK_TRACE_VERSION;
+     header.record_size = sizeof(DFBTaskTraceRecord);
+     header.count       = count;
+     header.lost        = start;
+
+     ret = direct_file_write( &fd, &header, sizeof(header), &bytes );
+
+     /* Write the ring in two parts, oldest first. */
+     if (!ret && count) {
+          unsigned int first = start & mask;
+          unsigned int num   = MIN( count, (unsigned long) mask + 1 - first );
+
+          ret = direct_file_write( &fd, &ring[first], num * sizeof(DFBTaskTraceRecord), &bytes );
+          if (!ret && num < count)
+               ret = direct_file_write( &fd, &ring[0], (count - num) * sizeof(DFBTaskTraceRecord), &bytes );
+     }
+
+     if (ret)
+          D_DERROR( ret, "DirectFB/TaskTrace: Could not write to '%s'!\n", filename );
+     else
+          D_INFO( "DirectFB/TaskTrace: Wrote %lu events (%lu lost) to '%s'\n", count, start, filename );
+
+     direct_file_close( &fd );
+
+     return (DFBResult) ret;
+}
+
+
+}
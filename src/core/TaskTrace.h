@@ -0,0 +1,130 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#ifndef ___DirectFB__TaskTrace__H___
+#define ___DirectFB__TaskTrace__H___
+
+
+#include <directfb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Task trace file format
+ *
+ * The file starts with a DFBTaskTraceHeader followed by 'count' records, oldest first.
+ * Tasks are identified by their address, which is only unique between TASK_TRACE_NEW and
+ * the next TASK_TRACE_NEW at the same address.
+ */
+
+#define DFB_TASK_TRACE_MAGIC       0x54424644     /* 'DFBT' */
+#define DFB_TASK_TRACE_VERSION     1
+
+typedef enum {
+     DFB_TASK_TRACE_NEW      = 1,     /* task constructed */
+     DFB_TASK_TRACE_FLUSH    = 2,     /* task handed to the TaskManager (enqueue), 'name' is valid */
+     DFB_TASK_TRACE_READY    = 3,     /* Setup() done, 'arg' is accessor << 32 | surface id */
+     DFB_TASK_TRACE_RUN      = 4,     /* all dependencies resolved, task is pushed to its engine */
+     DFB_TASK_TRACE_DONE     = 5,     /* engine finished the task, 'arg' is the result */
+     DFB_TASK_TRACE_FINISH   = 6,     /* TaskManager finished the task */
+     DFB_TASK_TRACE_NOTIFY   = 7,     /* dependency edge, 'arg' is the blocked task, 'flags' is TASK_RUNNING or TASK_FINISH */
+} DFBTaskTraceEvent;
+
+typedef struct {
+     u32       magic;
+     u32       version;
+     u32       record_size;
+     u32       count;
+     u64       lost;                  /* records overwritten in the ring before writing the file */
+} DFBTaskTraceHeader;
+
+typedef struct {
+     u64       micros;                /* monotonic clock */
+     u64       task;
+     u64       arg;
+     u32       event;
+     u32       flags;
+     u32       tid;
+     char      name[12];
+} DFBTaskTraceRecord;
+
+
+#ifdef __cplusplus
+}
+
+
+namespace DirectFB {
+
+
+class Task;
+
+
+class TaskTrace
+{
+public:
+     static DFBResult Initialise();
+     static void      Shutdown();
+
+     static void      Add( DFBTaskTraceEvent  event,
+                           const Task        *task,
+                           u64                arg   = 0,
+                           u32                flags = 0,
+                           const char        *name  = NULL );
+
+     static DFBResult Write( const char *filename );
+
+     static DFBTaskTraceRecord *ring;
+
+private:
+     static unsigned int        mask;
+     static unsigned long       pos;
+};
+
+
+}
+
+/*
+ * Cheap check for disabled tracing, arguments are not evaluated unless "task-trace" is set.
+ */
+#define DFB_TASK_TRACE( _event, _task, ... )                                         \
+     do {                                                                            \
+          if (DirectFB::TaskTrace::ring)                                             \
+               DirectFB::TaskTrace::Add( (_event), (_task), ##__VA_ARGS__ );         \
+     } while (0)
+
+#endif // __cplusplus
+
+
+#endif
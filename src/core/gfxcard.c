@@ -3105,6 +3105,10 @@ void dfb_gfxcard_batchblit( DFBRectangle *rects, DFBPoint *points,
           }
           else {
                if (gAcquire( state, DFXL_BLIT )) {
+                    DFBRectangle batch_rects[64];
+                    DFBPoint     batch_points[64];
+                    int          batch_num = 0;
+
                     for (; i<num; i++) {
                          DFBRectangle drect = { points[i].x, points[i].y, rects[i].w, rects[i].h };
 
@@ -3118,10 +3122,21 @@ void dfb_gfxcard_batchblit( DFBRectangle *rects, DFBPoint *points,
                               DFBRectangle srect = rects[i];
 
                               dfb_clip_blit_flipped_rotated( &state->clip, &srect, &drect, blittingflags );
-                              gBlit( state, &srect, drect.x, drect.y );
+
+                              /* Let Genefx render runs of blits (e.g. glyphs) row by row. */
+                              batch_rects[batch_num]  = srect;
+                              batch_points[batch_num] = (DFBPoint){ drect.x, drect.y };
+
+                              if (++batch_num == D_ARRAY_SIZE(batch_rects)) {
+                                   gBatchBlit( state, batch_rects, batch_points, batch_num );
+                                   batch_num = 0;
+                              }
                          }
                     }
 
+                    if (batch_num)
+                         gBatchBlit( state, batch_rects, batch_points, batch_num );
+
                     gRelease( state );
                }
           }
@@ -4323,11 +4338,24 @@ dfb_gfxcard_update_stats( DFBGraphicsCore *card,
           D_ASSERT( card->shared != NULL );
 
           if (total > dfb_config->gfxcard_stats * 1000LL) {
-               long long promille = (1000 * card->shared->ts_busy_sum / total);
+               long long           promille = (1000 * card->shared->ts_busy_sum / total);
+               unsigned int        hits;
+               unsigned int        misses;
+               static unsigned int last_hits;
+               static unsigned int last_misses;
 
                D_INFO( "busy %lld / %lld => %3lld.%lld%%\n", card->shared->ts_busy_sum, total,
                        promille / 10LL, promille % 10LL );
 
+               gGetPipelineCacheStats( &hits, &misses );
+
+               if (hits != last_hits || misses != last_misses)
+                    D_INFO( "software pipelines: %u cache hits, %u misses\n",
+                            hits - last_hits, misses - last_misses );
+
+               last_hits   = hits;
+               last_misses = misses;
+
                card->shared->ts_start    = now;
                card->shared->ts_busy_sum = 0;
           }
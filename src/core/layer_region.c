@@ -612,6 +612,17 @@ dfb_layer_region_flip_update( CoreLayerRegion     *region,
                {
                     D_DEBUG_AT( Core_Layers, "  -> Going to swap buffers...\n" );
 
+                    /* Remember the damage for bringing the other buffers up to date, unless the
+                       caller has set the actual regions within the update before. */
+                    if (update) {
+                         if (!surface->damage.num_next) {
+                              dfb_region_from_rotated( &rotated, update, &surface->config.size, surface->rotation );
+                              dfb_surface_set_flip_damage( surface, &rotated );
+                         }
+                    }
+                    else
+                         dfb_surface_set_flip_damage( surface, NULL );
+
                     /* Use the driver's routine if the region is realized. */
                     if (D_FLAGS_IS_SET( region->state, CLRSF_REALIZED )) {
                          CoreSurfaceBufferLock left;
@@ -846,6 +857,18 @@ dfb_layer_region_flip_update_stereo( CoreLayerRegion     *region,
                {
                     D_DEBUG_AT( Core_Layers, "  -> Going to swap buffers...\n" );
 
+                    /* Remember the damage of both eyes for bringing the other buffers up to date. */
+                    if (left_update && right_update) {
+                         DFBRegion damage = *left_update;
+
+                         dfb_region_region_union( &damage, right_update );
+
+                         dfb_region_from_rotated( &left_rotated, &damage, &surface->config.size, surface->rotation );
+                         dfb_surface_set_flip_damage( surface, &left_rotated );
+                    }
+                    else
+                         dfb_surface_set_flip_damage( surface, NULL );
+
                     /* Use the driver's routine if the region is realized. */
                     if (D_FLAGS_IS_SET( region->state, CLRSF_REALIZED )) {
                          CoreSurfaceBufferLock left, right;
@@ -39,6 +39,8 @@
 #endif
 
 #include <direct/debug.h>
+#include <direct/memcpy.h>
+#include <direct/perf.h>
 
 #include <core/core.h>
 #include <core/palette.h>
@@ -748,10 +750,14 @@ dfb_surface_flip_buffers( CoreSurface *surface, bool swap )
 {
      unsigned int back, front;
 
+     static D_COUNTER( Core_Surface_Flip, "Core/Surface/Flip" );
+
      D_DEBUG_AT( Core_Surface, "%s( %p, %sswap )\n", __FUNCTION__, surface, swap ? "" : "NO " );
 
      D_MAGIC_ASSERT( surface, CoreSurface );
 
+     D_COUNT( Core_Surface_Flip );
+
      FUSION_SKIRMISH_ASSERT( &surface->lock );
 
      if (surface->num_buffers == 0)
@@ -771,10 +777,16 @@ dfb_surface_flip_buffers( CoreSurface *surface, bool swap )
           int tmp = surface->buffer_indices[back];
           surface->buffer_indices[back] = surface->buffer_indices[front];
           surface->buffer_indices[front] = tmp;
+
+          /* Buffers changed roles without a flip count, forget their age. */
+          memset( surface->damage.serials, 0, sizeof(surface->damage.serials) );
      }
-     else
+     else {
           surface->flips++;
 
+          dfb_surface_track_flip( surface );
+     }
+
      D_DEBUG_AT( Core_Surface, "  -> flips %d <-----------------\n", surface->flips );
 
      // FIXME: cleanup, only used by desktop background via primary surface,
@@ -784,6 +796,145 @@ dfb_surface_flip_buffers( CoreSurface *surface, bool swap )
      return DFB_OK;
 }
 
+void
+dfb_surface_set_flip_damage( CoreSurface     *surface,
+                             const DFBRegion *damage )
+{
+     CoreSurfaceDamage *tracking;
+     DFBRegion          region;
+     DFBUpdates         updates;
+
+     D_MAGIC_ASSERT( surface, CoreSurface );
+     DFB_REGION_ASSERT_IF( damage );
+
+     FUSION_SKIRMISH_ASSERT( &surface->lock );
+
+     tracking = &surface->damage;
+     region   = DFB_REGION_INIT_FROM_DIMENSION( &surface->config.size );
+
+     if (damage && !dfb_region_region_intersect( &region, damage ))
+          return;
+
+     /* Keep the list disjoint, merging regions that cost the least when running out of them. */
+     dfb_updates_init( &updates, tracking->next, CORE_SURFACE_DAMAGE_REGIONS );
+
+     updates.num_regions = tracking->num_next;
+     updates.bounding    = tracking->next_bounding;
+
+     dfb_updates_add( &updates, &region );
+
+     tracking->num_next      = updates.num_regions;
+     tracking->next_bounding = updates.bounding;
+
+     dfb_updates_deinit( &updates );
+}
+
+void
+dfb_surface_track_flip( CoreSurface *surface )
+{
+     CoreSurfaceDamage *tracking;
+     u32                flips;
+     int                slot;
+
+     D_MAGIC_ASSERT( surface, CoreSurface );
+
+     FUSION_SKIRMISH_ASSERT( &surface->lock );
+
+     if (!surface->num_buffers)
+          return;
+
+     tracking = &surface->damage;
+     flips    = surface->flips;
+     slot     = flips % CORE_SURFACE_DAMAGE_HISTORY;
+
+     /* Start over if flips have been missed, e.g. by reconfiguration. */
+     if (tracking->last != flips - 1)
+          tracking->first = flips - 1;
+
+     if (tracking->num_next) {
+          direct_memcpy( tracking->regions[slot], tracking->next, sizeof(DFBRegion) * tracking->num_next );
+
+          tracking->num_regions[slot] = tracking->num_next;
+     }
+     else {
+          tracking->regions[slot][0]  = DFB_REGION_INIT_FROM_DIMENSION( &surface->config.size );
+          tracking->num_regions[slot] = 1;
+     }
+
+     tracking->last     = flips;
+     tracking->num_next = 0;
+
+     tracking->serials[surface->buffer_indices[flips % surface->num_buffers]] = flips;
+
+     D_DEBUG_AT( Core_Surface, "%s( %p ) -> flips %u, %d damaged region(s)\n", __FUNCTION__, surface, flips,
+                 tracking->num_regions[slot] );
+}
+
+int
+dfb_surface_get_buffer_damage( CoreSurface           *surface,
+                               CoreSurfaceBufferRole  role,
+                               DFBRegion             *ret_regions )
+{
+     CoreSurfaceDamage *tracking;
+     u32                flips;
+     u32                serial;
+     u32                f;
+     int                num = 0;
+
+     D_MAGIC_ASSERT( surface, CoreSurface );
+     D_ASSERT( ret_regions != NULL );
+
+     FUSION_SKIRMISH_ASSERT( &surface->lock );
+
+     if (!surface->num_buffers)
+          return 0;
+
+     tracking = &surface->damage;
+     flips    = surface->flips;
+     serial   = tracking->serials[surface->buffer_indices[(flips + role) % surface->num_buffers]];
+
+     /* Unknown content or damage not recorded for all flips since? */
+     if (!serial || tracking->last != flips || serial - tracking->first > flips - tracking->first ||
+         flips - serial > CORE_SURFACE_DAMAGE_HISTORY)
+     {
+          ret_regions[0] = DFB_REGION_INIT_FROM_DIMENSION( &surface->config.size );
+
+          return 1;
+     }
+
+     for (f = serial + 1; f != flips + 1; f++) {
+          int slot = f % CORE_SURFACE_DAMAGE_HISTORY;
+
+          direct_memcpy( &ret_regions[num], tracking->regions[slot], sizeof(DFBRegion) * tracking->num_regions[slot] );
+
+          num += tracking->num_regions[slot];
+     }
+
+     return num;
+}
+
+void
+dfb_surface_set_buffer_current( CoreSurface           *surface,
+                                CoreSurfaceBufferRole  role )
+{
+     CoreSurfaceDamage *tracking;
+
+     D_MAGIC_ASSERT( surface, CoreSurface );
+
+     FUSION_SKIRMISH_ASSERT( &surface->lock );
+
+     if (!surface->num_buffers)
+          return;
+
+     tracking = &surface->damage;
+
+     /* Damage of later flips is only valid if recorded from now on. */
+     if (tracking->last != surface->flips)
+          tracking->first = tracking->last = surface->flips;
+
+     tracking->serials[surface->buffer_indices[(surface->flips + role) % surface->num_buffers]] = surface->flips;
+}
+
 DFBResult
 dfb_surface_dispatch_event( CoreSurface         *surface,
                             DFBSurfaceEventType  type )
@@ -942,6 +1093,9 @@ dfb_surface_reconfig( CoreSurface             *surface,
 
           direct_serial_increase( &surface->config_serial );
 
+          /* Recorded damage may lie outside of the new size, start over. */
+          memset( &surface->damage, 0, sizeof(CoreSurfaceDamage) );
+
           fusion_skirmish_dismiss( &surface->lock );
           return DFB_OK;
      }
@@ -1005,6 +1159,9 @@ dfb_surface_reconfig( CoreSurface             *surface,
      surface->num_buffers = 0;
      surface->flips++;
 
+     /* New buffers have no known content. */
+     memset( &surface->damage, 0, sizeof(CoreSurfaceDamage) );
+
      Core_Resource_UpdateSurface( surface, &new_config );
 
      surface->config = new_config;
@@ -1327,12 +1484,7 @@ dfb_surface_read_buffer( CoreSurface            *surface,
                lock.addr += DFB_BYTES_PER_LINE( format, rect.x ) + rect.y * lock.pitch;
 
                /* Copy the data. */
-               for (y=0; y<rect.h; y++) {
-                    direct_memcpy( destination, lock.addr, bytes );
-
-                    destination += pitch;
-                    lock.addr   += lock.pitch;
-               }
+               direct_memcpy_2d( destination, pitch, lock.addr, lock.pitch, bytes, rect.h );
 
                /* Unlock the allocation. */
                ret = dfb_surface_pool_unlock( allocation->pool, allocation, &lock );
@@ -1426,16 +1578,14 @@ dfb_surface_write_buffer( CoreSurface            *surface,
                lock.addr += DFB_BYTES_PER_LINE( format, rect.x ) + rect.y * lock.pitch;
 
                /* Copy the data. */
-               for (y=0; y<rect.h; y++) {
-                    if (source) {
-                         direct_memcpy( lock.addr, source, bytes );
-
-                         source += pitch;
-                    }
-                    else
+               if (source)
+                    direct_memcpy_2d( lock.addr, lock.pitch, source, pitch, bytes, rect.h );
+               else {
+                    for (y=0; y<rect.h; y++) {
                          memset( lock.addr, 0, bytes );
 
-                    lock.addr += lock.pitch;
+                         lock.addr += lock.pitch;
+                    }
                }
 
                /* Unlock the allocation. */
@@ -220,6 +220,32 @@ typedef enum {
      CSSF_ALL            = 0x00000001
 } CoreSurfaceStateFlags;
 
+#define CORE_SURFACE_DAMAGE_HISTORY  4  /* number of flips whose damage is remembered */
+#define CORE_SURFACE_DAMAGE_REGIONS  8  /* regions per flip, more are merged */
+
+#define CORE_SURFACE_DAMAGE_MAX      (CORE_SURFACE_DAMAGE_HISTORY * CORE_SURFACE_DAMAGE_REGIONS)
+
+/*
+ * Damage of recent flips, for bringing a buffer up to date with the front buffer by copying or
+ * repainting only what changed since the buffer was the front buffer itself (buffer age).
+ *
+ * Each flip keeps a short list of disjoint regions, so separate updates are not copied as their
+ * bounding box.
+ */
+typedef struct {
+     u32                      serials[MAX_SURFACE_BUFFERS];            /* flip count when each buffer was the
+                                                                          front buffer, 0 if unknown */
+     DFBRegion                regions[CORE_SURFACE_DAMAGE_HISTORY]
+                                     [CORE_SURFACE_DAMAGE_REGIONS];    /* damage of flips by flip count */
+     int                      num_regions[CORE_SURFACE_DAMAGE_HISTORY];
+     u32                      first;                                   /* flips after this one are recorded */
+     u32                      last;                                    /* last recorded flip */
+
+     DFBRegion                next[CORE_SURFACE_DAMAGE_REGIONS];       /* damage for the next flip */
+     DFBRegion                next_bounding;
+     int                      num_next;                                /* 0 if not set */
+} CoreSurfaceDamage;
+
 struct __DFB_CoreSurface
 {
      FusionObject             object;
@@ -250,6 +276,8 @@ struct __DFB_CoreSurface
 
      u32                      flips;
 
+     CoreSurfaceDamage        damage;
+
      CorePalette             *palette;
      GlobalReaction           palette_reaction;
 
@@ -340,6 +368,33 @@ DFBResult dfb_surface_flip          ( CoreSurface                  *surface,
 DFBResult dfb_surface_flip_buffers  ( CoreSurface                  *surface,
                                       bool                          swap );
 
+/*
+ * Adds to the damage of the next flip, all of the surface is damaged if not set.
+ *
+ * Regions set before dfb_layer_region_flip_update() replace its update, which is just their bounding box.
+ */
+void      dfb_surface_set_flip_damage( CoreSurface                 *surface,
+                                       const DFBRegion             *damage );
+
+/*
+ * Records the damage of the flip done by changing 'flips' to the next flip count.
+ */
+void      dfb_surface_track_flip    ( CoreSurface                  *surface );
+
+/*
+ * Returns the areas to copy from the front buffer to bring the buffer up to date, all of the
+ * surface if unknown. 'ret_regions' needs room for CORE_SURFACE_DAMAGE_MAX regions.
+ */
+int       dfb_surface_get_buffer_damage( CoreSurface               *surface,
+                                         CoreSurfaceBufferRole      role,
+                                         DFBRegion                 *ret_regions );
+
+/*
+ * Marks the buffer as being up to date with the front buffer.
+ */
+void      dfb_surface_set_buffer_current( CoreSurface              *surface,
+                                          CoreSurfaceBufferRole     role );
+
 DFBResult dfb_surface_dispatch_event( CoreSurface                  *surface,
                                       DFBSurfaceEventType           type );
 
@@ -272,8 +272,6 @@ transfer_buffer( const CoreSurfaceConfig *config,
                  int                      srcpitch,
                  int                      dstpitch )
 {
-     int i;
-
      D_DEBUG_AT( Core_SurfAllocation, "%s( %p, %p [%d] -> %p [%d] ) * %d\n",
                  __FUNCTION__, config, src, srcpitch, dst, dstpitch, config->size.h );
 
@@ -285,59 +283,37 @@ transfer_buffer( const CoreSurfaceConfig *config,
      D_ASSERT( srcpitch >= DFB_BYTES_PER_LINE( config->format, config->size.w ) );
      D_ASSERT( dstpitch >= DFB_BYTES_PER_LINE( config->format, config->size.w ) );
 
-     for (i=0; i<config->size.h; i++) {
-          direct_memcpy( dst, src, DFB_BYTES_PER_LINE( config->format, config->size.w ) );
+     direct_memcpy_2d( dst, dstpitch, src, srcpitch, DFB_BYTES_PER_LINE( config->format, config->size.w ), config->size.h );
 
-          src += srcpitch;
-          dst += dstpitch;
-     }
+     src += srcpitch * config->size.h;
+     dst += dstpitch * config->size.h;
 
      switch (config->format) {
           case DSPF_YV12:
           case DSPF_I420:
-               for (i=0; i<config->size.h; i++) {
-                    direct_memcpy( dst, src,
-                                   DFB_BYTES_PER_LINE( config->format, config->size.w / 2 ) );
-                    src += srcpitch / 2;
-                    dst += dstpitch / 2;
-               }
+               direct_memcpy_2d( dst, dstpitch / 2, src, srcpitch / 2,
+                                 DFB_BYTES_PER_LINE( config->format, config->size.w / 2 ), config->size.h );
                break;
 
           case DSPF_YV16:
-               for (i=0; i<config->size.h*2; i++) {
-                    direct_memcpy( dst, src,
-                                   DFB_BYTES_PER_LINE( config->format, config->size.w / 2 ) );
-                    src += srcpitch / 2;
-                    dst += dstpitch / 2;
-               }
+               direct_memcpy_2d( dst, dstpitch / 2, src, srcpitch / 2,
+                                 DFB_BYTES_PER_LINE( config->format, config->size.w / 2 ), config->size.h * 2 );
                break;
 
           case DSPF_NV12:
           case DSPF_NV21:
-               for (i=0; i<config->size.h/2; i++) {
-                    direct_memcpy( dst, src,
-                                   DFB_BYTES_PER_LINE( config->format, config->size.w ) );
-                    src += srcpitch;
-                    dst += dstpitch;
-               }
+               direct_memcpy_2d( dst, dstpitch, src, srcpitch,
+                                 DFB_BYTES_PER_LINE( config->format, config->size.w ), config->size.h / 2 );
                break;
 
           case DSPF_NV16:
-               for (i=0; i<config->size.h; i++) {
-                    direct_memcpy( dst, src,
-                                   DFB_BYTES_PER_LINE( config->format, config->size.w ) );
-                    src += srcpitch;
-                    dst += dstpitch;
-               }
+               direct_memcpy_2d( dst, dstpitch, src, srcpitch,
+                                 DFB_BYTES_PER_LINE( config->format, config->size.w ), config->size.h );
                break;
 
           case DSPF_YUV444P:
-               for (i=0; i<config->size.h*2; i++) {
-                    direct_memcpy( dst, src,
-                                   DFB_BYTES_PER_LINE( config->format, config->size.w ) );
-                    src += srcpitch;
-                    dst += dstpitch;
-               }
+               direct_memcpy_2d( dst, dstpitch, src, srcpitch,
+                                 DFB_BYTES_PER_LINE( config->format, config->size.w ), config->size.h * 2 );
                break;
 
           default:
@@ -576,12 +576,7 @@ dfb_surface_buffer_read( CoreSurfaceBuffer  *buffer,
                lock.addr += DFB_BYTES_PER_LINE( format, rect.x ) + rect.y * lock.pitch;
 
                /* Copy the data. */
-               for (y=0; y<rect.h; y++) {
-                    direct_memcpy( destination, lock.addr, bytes );
-
-                    destination += pitch;
-                    lock.addr   += lock.pitch;
-               }
+               direct_memcpy_2d( destination, pitch, lock.addr, lock.pitch, bytes, rect.h );
 
                /* Unlock the allocation. */
                ret = dfb_surface_pool_unlock( allocation->pool, allocation, &lock );
@@ -679,16 +674,14 @@ dfb_surface_buffer_write( CoreSurfaceBuffer  *buffer,
                lock.addr += DFB_BYTES_PER_LINE( format, rect.x ) + rect.y * lock.pitch;
 
                /* Copy the data. */
-               for (y=0; y<rect.h; y++) {
-                    if (source) {
-                         direct_memcpy( lock.addr, source, bytes );
-
-                         source += pitch;
-                    }
-                    else
+               if (source)
+                    direct_memcpy_2d( lock.addr, lock.pitch, source, pitch, bytes, rect.h );
+               else {
+                    for (y=0; y<rect.h; y++) {
                          memset( lock.addr, 0, bytes );
 
-                    lock.addr += lock.pitch;
+                         lock.addr += lock.pitch;
+                    }
                }
 
                /* Unlock the allocation. */
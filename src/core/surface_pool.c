@@ -35,7 +35,11 @@
 #include <directfb_util.h>
 
 #include <direct/debug.h>
+#include <direct/hash.h>
 #include <direct/mem.h>
+#include <direct/perf.h>
+#include <direct/thread.h>
+#include <direct/util.h>
 
 #include <fusion/conf.h>
 #include <fusion/shmalloc.h>
@@ -67,6 +71,37 @@ static unsigned int            pool_order[MAX_SURFACE_POOLS];
 
 /**********************************************************************************************************************/
 
+#define NEGOTIATION_CACHE_SIZE  64
+
+/*
+ * Everything that decides whether a pool refuses a buffer for good, i.e. not just for lack of memory.
+ */
+typedef struct {
+     DFBSurfacePixelFormat    format;
+     DFBSurfacePixelFormat    buffer_format;
+     DFBSurfaceCapabilities   caps;
+     unsigned int             size_class;    /* bit length of width and height */
+     CoreSurfaceTypeFlags     type;
+     unsigned long            layer_id;      /* resource id of layer surfaces */
+     CoreSurfaceAccessorID    accessor;
+     CoreSurfaceAccessFlags   access;
+} NegotiationKey;
+
+typedef struct {
+     NegotiationKey           key;
+     bool                     valid;
+     unsigned int             refused;       /* pools refusing the buffer, one bit per pool id */
+} NegotiationEntry;
+
+static DirectMutex             negotiation_lock = DIRECT_MUTEX_INITIALIZER( negotiation_lock );
+static NegotiationEntry        negotiation_cache[NEGOTIATION_CACHE_SIZE];
+static unsigned int            negotiation_serial;
+
+static D_COUNTER( Core_SurfacePool_NegotiationHit,  "Core/SurfacePool/Negotiation/Hit" );
+static D_COUNTER( Core_SurfacePool_NegotiationMiss, "Core/SurfacePool/Negotiation/Miss" );
+
+/**********************************************************************************************************************/
+
 static inline const SurfacePoolFuncs *
 get_funcs( const CoreSurfacePool *pool )
 {
@@ -113,6 +148,10 @@ static DFBResult backup_allocation( CoreSurfaceAllocation *allocation );
 
 /**********************************************************************************************************************/
 
+static void      negotiation_flush( void );
+
+/**********************************************************************************************************************/
+
 /*
  * Enable a surface pool to obtain its own local data without having to
  * explicitly store a static local pointer to it during init/join.
@@ -412,6 +451,10 @@ dfb_surface_pools_negotiate( CoreSurfaceBuffer       *buffer,
      CoreSurfacePool      *free_pools[pool_count];
      unsigned int          oom_count = 0;
      CoreSurfacePool      *oom_pools[pool_count];
+     NegotiationKey        key;
+     NegotiationEntry     *entry   = NULL;
+     unsigned int          serial  = 0;
+     unsigned int          refused = 0;
 
      D_MAGIC_ASSERT( buffer, CoreSurfaceBuffer );
 
@@ -488,6 +531,41 @@ dfb_surface_pools_negotiate( CoreSurfaceBuffer       *buffer,
           D_DEBUG_AT( Core_SurfacePool, "  ->     PREALLOCATED\n" );
 #endif
 
+     /*
+      * Look up the pools known to refuse this kind of buffer. Preallocated buffers are not cached,
+      * because acceptance depends on the identity of the surface owner.
+      */
+     if (!(type & CSTF_PREALLOCATED) && !(surface->config.flags & CSCONF_PREALLOCATED)) {
+          memset( &key, 0, sizeof(key) );
+
+          key.format        = surface->config.format;
+          key.buffer_format = buffer->format;
+          key.caps          = surface->config.caps;
+          key.size_class    = (direct_log2( surface->config.size.w ) << 8) | direct_log2( surface->config.size.h );
+          key.type          = type;
+          key.layer_id      = (type & CSTF_LAYER) ? surface->resource_id : 0;
+          key.accessor      = accessor;
+          key.access        = access;
+
+          entry = &negotiation_cache[ direct_hash_mix( key.format ^ (key.caps << 7) ^ (key.size_class << 13) ^
+                                                       (key.type << 3) ^ key.layer_id ^
+                                                       (key.accessor << 21) ^ (key.access << 26) ) % NEGOTIATION_CACHE_SIZE ];
+
+          direct_mutex_lock( &negotiation_lock );
+
+          serial = negotiation_serial;
+
+          if (entry->valid && !memcmp( &entry->key, &key, sizeof(key) )) {
+               refused = entry->refused;
+
+               D_COUNT( Core_SurfacePool_NegotiationHit );
+          }
+          else
+               D_COUNT( Core_SurfacePool_NegotiationMiss );
+
+          direct_mutex_unlock( &negotiation_lock );
+     }
+
      for (i=0; i<pool_count; i++) {
           CoreSurfacePool *pool;
 
@@ -505,6 +583,11 @@ dfb_surface_pools_negotiate( CoreSurfaceBuffer       *buffer,
                continue;
           }
 
+          if (refused & (1 << pool->pool_id)) {
+               D_DEBUG_AT( Core_SurfacePool, "    => REFUSED (cached)\n" );
+               continue;
+          }
+
           if (D_FLAGS_ARE_SET( pool->desc.access[accessor], access ) &&
               D_FLAGS_ARE_SET( pool->desc.types, type & ~CSTF_PREALLOCATED ))
           {
@@ -528,11 +611,31 @@ dfb_surface_pools_negotiate( CoreSurfaceBuffer       *buffer,
                          oom_pools[oom_count++] = pool;
                          break;
 
+                    case DFB_UNSUPPORTED:
+                         D_DEBUG_AT( Core_SurfacePool, "    => UNSUPPORTED\n" );
+                         refused |= 1 << pool->pool_id;
+                         continue;
+
                     default:
                          D_DEBUG_AT( Core_SurfacePool, "    => %s\n", DirectResultString(ret) );
                          continue;
                }
           }
+          else
+               refused |= 1 << pool->pool_id;
+     }
+
+     if (entry) {
+          direct_mutex_lock( &negotiation_lock );
+
+          /* Drop the result if pools have been changed meanwhile. */
+          if (serial == negotiation_serial) {
+               entry->key     = key;
+               entry->valid   = true;
+               entry->refused = refused;
+          }
+
+          direct_mutex_unlock( &negotiation_lock );
      }
 
      D_DEBUG_AT( Core_SurfacePool, "  => %d pools available\n", free_count );
@@ -1388,6 +1491,9 @@ dfb_surface_pool_gfx_driver_update( CoreSurfaceTypeFlags   types,
           }
      }
 
+     if (addedAccessFlags)
+          negotiation_flush();
+
      return addedAccessFlags;
 }
 
@@ -1487,6 +1593,8 @@ insert_pool_local( CoreSurfacePool *pool )
 
      pool_order[n] = pool_count - 1;
 
+     negotiation_flush();
+
 #if D_DEBUG_ENABLED
      for (i=0; i<pool_count; i++) {
           D_DEBUG_AT( Core_SurfacePool, "  %c> [%d] %p - '%s' [%d] (%d), %p\n",
@@ -1513,6 +1621,8 @@ remove_pool_local( CoreSurfacePoolID pool_id )
      pool_array[pool_id] = NULL;
      pool_funcs[pool_id] = NULL;
 
+     negotiation_flush();
+
      while (pool_count > 0 && !pool_array[pool_count-1]) {
           pool_count--;
 
@@ -1527,6 +1637,20 @@ remove_pool_local( CoreSurfacePoolID pool_id )
 
 /**********************************************************************************************************************/
 
+static void
+negotiation_flush( void )
+{
+     direct_mutex_lock( &negotiation_lock );
+
+     memset( negotiation_cache, 0, sizeof(negotiation_cache) );
+
+     negotiation_serial++;
+
+     direct_mutex_unlock( &negotiation_lock );
+}
+
+/**********************************************************************************************************************/
+
 static void
 remove_allocation( CoreSurfacePool       *pool,
                    CoreSurfaceAllocation *allocation )
@@ -40,8 +40,10 @@
 
 
 extern "C" {
+#include <direct/arena.h>
 #include <direct/debug.h>
 #include <direct/messages.h>
+#include <direct/perf.h>
 
 #include <core/core.h>
 #include <core/palette.h>
@@ -75,15 +77,66 @@ extern "C" {
 #define DFB_GENEFX_TASK_WEIGHT_MAX           1000000
 #endif
 
+/* Number of tiles per thread, letting idle threads pick up tiles of busy ones */
+#define DFB_GENEFX_TILES_PER_CORE            2
+
 
 D_DEBUG_DOMAIN( DirectFB_GenefxEngine, "DirectFB/Genefx/Engine", "DirectFB Genefx Engine" );
 D_DEBUG_DOMAIN( DirectFB_GenefxTask,   "DirectFB/Genefx/Task",   "DirectFB Genefx Task" );
 
 /*********************************************************************************************************************/
 
+/*
+ * Tasks and their command buffers are created for each tile on every flush,
+ * so they are taken from pools instead of the heap.
+ */
+
+static D_COUNTER( Genefx_Task_Pooled,   "Genefx/Task/Pooled" );
+static D_COUNTER( Genefx_Buffer_Pooled, "Genefx/CommandBuffer/Pooled" );
+
+static DirectOnce genefx_pools_once = DIRECT_ONCE_INIT;
+static DirectPool genefx_task_pool;
+static DirectPool genefx_buffer_pool;
+
+static void genefx_pools_init( void );
+
+/*********************************************************************************************************************/
+
 namespace DirectFB {
 
 
+class GenefxBuffer {
+public:
+     GenefxBuffer( size_t size )
+          :
+          size( size ),
+          length( 0 )
+     {
+          if (size == DFB_GENEFX_COMMAND_BUFFER_BLOCK_SIZE) {
+               direct_once( &genefx_pools_once, genefx_pools_init );
+
+               ptr = direct_pool_get( &genefx_buffer_pool );
+          }
+          else
+               ptr = direct_malloc( size );
+
+          D_ASSERT( ptr != NULL );
+     }
+
+     ~GenefxBuffer()
+     {
+          if (size == DFB_GENEFX_COMMAND_BUFFER_BLOCK_SIZE)
+               direct_pool_put( &genefx_buffer_pool, ptr );
+          else
+               direct_free( ptr );
+     }
+
+     size_t  size;
+     size_t  length;
+     void   *ptr;
+};
+
+
 class GenefxEngine;
 
 class GenefxTask : public DirectFB::SurfaceTask
@@ -112,6 +165,9 @@ public:
      {
      }
 
+     static void *operator new( size_t size );
+     static void  operator delete( void *ptr );
+
 protected:
      virtual DFBResult Setup();
      virtual DFBResult Push();
@@ -139,6 +195,7 @@ private:
           TYPE_SET_SRC_COLORKEY,
           TYPE_SET_DESTINATION_PALETTE,
           TYPE_SET_SOURCE_PALETTE,
+          TYPE_SET_RENDER_OPTIONS,
           TYPE_FILL_RECTS,
           TYPE_DRAW_LINES,
           TYPE_BLIT,
@@ -146,7 +203,7 @@ private:
           TYPE_TEXTURE_TRIANGLES
      } Type;
 
-     typedef Util::PacketBuffer<> Commands;
+     typedef Util::PacketBuffer<GenefxBuffer> Commands;
 
      Commands                 commands;
      DFBRegion                clip;
@@ -169,6 +226,22 @@ private:
      static const Direct::String _Type;
 };
 
+void *
+GenefxTask::operator new( size_t size )
+{
+     D_ASSERT( size == sizeof(GenefxTask) );
+
+     direct_once( &genefx_pools_once, genefx_pools_init );
+
+     return direct_pool_get( &genefx_task_pool );
+}
+
+void
+GenefxTask::operator delete( void *ptr )
+{
+     direct_pool_put( &genefx_task_pool, ptr );
+}
+
 void
 GenefxTask::Describe( Direct::String &string ) const
 {
@@ -185,6 +258,19 @@ GenefxTask::TypeName() const
 
 const Direct::String GenefxTask::_Type( "Genefx" );
 
+}
+
+
+static void
+genefx_pools_init()
+{
+     direct_pool_init( &genefx_task_pool, sizeof(DirectFB::GenefxTask), 32, &Genefx_Task_Pooled );
+     direct_pool_init( &genefx_buffer_pool, DFB_GENEFX_COMMAND_BUFFER_BLOCK_SIZE, 1, &Genefx_Buffer_Pooled );
+}
+
+
+namespace DirectFB {
+
 
 class GenefxEngine : public Graphics::Engine {
 private:
@@ -195,14 +281,21 @@ private:
 public:
      GenefxEngine( unsigned int cores = 1 )
           :
-          threads( "Genefx", cores < 8 ? cores : 8 )
+          threads( "Genefx", cores < DFB_RENDERER_TILES_MAX ? cores : DFB_RENDERER_TILES_MAX )
      {
           D_DEBUG_AT( DirectFB_GenefxEngine, "GenefxEngine::%s( cores %d )\n", __FUNCTION__, cores );
 
           D_ASSERT( cores > 0 );
 
+          if (cores > DFB_RENDERER_TILES_MAX) {
+               D_INFO( "DirectFB/Genefx: Limiting number of cores to %d\n", DFB_RENDERER_TILES_MAX );
+
+               cores = DFB_RENDERER_TILES_MAX;
+          }
+
           caps.software       = true;
-          caps.cores          = cores < 8 ? cores : 8;
+          /* Number of tiles the Renderer splits the destination into, more than cores (if possible) for load balancing */
+          caps.cores          = (cores > 1) ? MIN( cores * DFB_GENEFX_TILES_PER_CORE, DFB_RENDERER_TILES_MAX ) : 1;
           caps.clipping       = (DFBAccelerationMask)(DFXL_FILLRECTANGLE |
                                                       DFXL_DRAWRECTANGLE |
                                                       DFXL_DRAWLINE |
@@ -338,7 +431,7 @@ public:
           D_FLAGS_CLEAR( mytask->modified, emitting );
 
 
-          u32 max = 8 + 5 + 8 + 2 + 2 + 2 + 2 + 2 + 2;
+          u32 max = 8 + 5 + 8 + 2 + 2 + 2 + 2 + 2 + 2 + 2;
 
           if ((emitting & SMF_DESTINATION) && DFB_PIXELFORMAT_IS_INDEXED( state->destination->config.format ))
                max += 2 + 2 * state->destination->palette->num_entries;
@@ -473,6 +566,11 @@ public:
                *buf++ = state->src_colorkey;
           }
 
+          if (emitting & SMF_RENDER_OPTIONS) {
+               *buf++ = GenefxTask::TYPE_SET_RENDER_OPTIONS;
+               *buf++ = state->render_options & (DSRO_SMOOTH_UPSCALE | DSRO_SMOOTH_DOWNSCALE);
+          }
+
           state->mod_hw = SMF_NONE;
           state->set    = (DFBAccelerationMask)(state->set | accel);
 
@@ -862,7 +960,7 @@ GenefxTask::Run()
      CacheInvalidate();
 
      for (Commands::buffer_vector::const_iterator it = commands.buffers.begin(); it != commands.buffers.end(); ++it) {
-          const Util::HeapBuffer *packet_buffer = *it;
+          const GenefxBuffer    *packet_buffer = *it;
           const u32              *buffer        = (const u32*) packet_buffer->ptr;
           size_t                  size          = packet_buffer->length / 4;
 
@@ -989,6 +1087,13 @@ GenefxTask::Run()
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> 0x%08x\n", state.src_colorkey );
                          break;
 
+                    case GenefxTask::TYPE_SET_RENDER_OPTIONS:
+                         D_DEBUG_AT( DirectFB_GenefxTask, "  -> SET_RENDER_OPTIONS\n" );
+
+                         state.render_options = (DFBSurfaceRenderOptions) buffer[++i];
+                         D_DEBUG_AT( DirectFB_GenefxTask, "  -> 0x%08x\n", state.render_options );
+                         break;
+
                     case GenefxTask::TYPE_SET_DESTINATION_PALETTE:
                          D_DEBUG_AT( DirectFB_GenefxTask, "  -> SET_DESTINATION_PALETTE\n" );
 
@@ -1093,6 +1198,10 @@ GenefxTask::Run()
 
                          // TODO: run gAcquireSetup in Engine, requires lots of Genefx changes :(
                          if (!disable_rendering && gAcquireSetup( &state, DFXL_BLIT )) {
+                              DFBRectangle rects[256];
+                              DFBPoint     points[256];
+                              u32          count = 0;
+
                               for (u32 n=0; n<num; n++) {
                                    int x  = buffer[++i];
                                    int y  = buffer[++i];
@@ -1107,15 +1216,27 @@ GenefxTask::Run()
                                         x, y, w, h
                                    };
 
-                                   if (single_tile)
-                                        gBlit( &state, &rect, dx, dy );
-                                   else if (dfb_clip_blit_precheck( &state.clip, rect.w, rect.h, dx, dy )) {
+                                   if (!single_tile) {
+                                        if (!dfb_clip_blit_precheck( &state.clip, rect.w, rect.h, dx, dy ))
+                                             continue;
+
                                         dfb_clip_blit( &state.clip, &rect, &dx, &dy );  // FIXME: support rotation!
                                         //dfb_clip_blit_flipped_rotated( &mytask->clip, &rect, &drect, blittingflags );
+                                   }
+
+                                   rects[count]    = rect;
+                                   points[count].x = dx;
+                                   points[count].y = dy;
 
-                                        gBlit( &state, &rect, dx, dy );
+                                   /* Batches like the glyphs of a string are rendered row by row in one pass */
+                                   if (++count == D_ARRAY_SIZE(rects)) {
+                                        gBatchBlit( &state, rects, points, count );
+                                        count = 0;
                                    }
                               }
+
+                              if (count)
+                                   gBatchBlit( &state, rects, points, count );
                          }
                          else
                               i += num * 6;
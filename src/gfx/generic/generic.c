@@ -40,6 +40,13 @@
 
 #include <pthread.h>
 
+#ifdef USE_NEON
+#include <sys/auxv.h>
+#ifndef __aarch64__
+#include <asm/hwcap.h>
+#endif
+#endif
+
 #include <directfb.h>
 
 #include <core/core.h>
@@ -54,6 +61,7 @@
 #include <misc/util.h>
 #include <misc/conf.h>
 
+#include <direct/atomic.h>
 #include <direct/clock.h>
 #include <direct/mem.h>
 #include <direct/memcpy.h>
@@ -80,12 +88,24 @@ static const u8 lookup2to8[] = { 0x00, 0x55, 0xaa, 0xff};
 #define EXPAND_7to8(v)   (((v) << 1) | ((v) >> 6))
 
 
-static int use_mmx = 0;
+static int use_mmx  = 0;
+static int use_sse2 = 0;
+static int use_avx2 = 0;
+static int use_neon = 0;
 
 #ifdef USE_MMX
 static void gInit_MMX( void );
 #endif
 
+#ifdef USE_SSE2
+static void gInit_SSE2( void );
+static void gInit_AVX2( void );
+#endif
+
+#ifdef USE_NEON
+static void gInit_NEON( void );
+#endif
+
 #if SIZEOF_LONG == 8
 static void gInit_64bit( void );
 #endif
@@ -7946,7 +7966,7 @@ static const GenefxFunc Dacc_modulate_mask_argb_from_PFI[DFB_NUM_PIXELFORMATS] =
 
 /********************************* misc accumulator operations ****************/
 
-static void Dacc_premultiply( GenefxState *gfxs )
+static void Dacc_premultiply_C( GenefxState *gfxs )
 {
      int                w = gfxs->length+1;
      GenefxAccumulator *D = gfxs->Dacc;
@@ -7964,6 +7984,8 @@ static void Dacc_premultiply( GenefxState *gfxs )
      }
 }
 
+static GenefxFunc Dacc_premultiply = Dacc_premultiply_C;
+
 static void Dacc_premultiply_color_alpha( GenefxState *gfxs )
 {
      int                w  = gfxs->length+1;
@@ -8263,7 +8285,7 @@ static void Bop_argb_blend_alphachannel_src_invsrc_Aop_argb8565( GenefxState *gf
      }
 }
 
-static const GenefxFunc Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+static GenefxFunc Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb16,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]    = NULL,
@@ -8343,7 +8365,7 @@ static void Bop_argb_blend_alphachannel_one_invsrc_Aop_argb( GenefxState *gfxs )
 #undef SET_PIXEL_DUFFS_DEVICE
 #undef SET_PIXEL
 
-static const GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+static GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]    = NULL,
@@ -8428,7 +8450,7 @@ static void Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb( GenefxS
 #undef SET_PIXEL_DUFFS_DEVICE
 #undef SET_PIXEL
 
-static const GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+static GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]    = NULL,
@@ -8471,6 +8493,138 @@ static const GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_P
      [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]     = NULL,
 };
 
+/********************************* Fused pipelines ****************************/
+
+/* ARGB to ARGB */
+#define SRC_ALPHA( s ) ((s) >> 24)
+#define DST_ALPHA( d ) ((d) >> 24)
+#define PIXEL_OUT( a, r, g, b ) PIXEL_ARGB( a, r, g, b )
+#define Cop_OP_Aop_PFI( op ) Cop_##op##_Aop_argb
+#define Bop_PFI_OP_Aop_PFI( op ) Bop_argb_##op##_Aop_argb
+#include "template_fused_32.h"
+
+/* ARGB to RGB32 */
+#define SRC_ALPHA( s ) ((s) >> 24)
+#define DST_ALPHA( d ) 0xFF
+#define PIXEL_OUT( a, r, g, b ) PIXEL_RGB32( r, g, b )
+#define Cop_OP_Aop_PFI( op ) Cop_##op##_Aop_rgb32
+#define Bop_PFI_OP_Aop_PFI( op ) Bop_argb_##op##_Aop_rgb32
+#include "template_fused_32.h"
+
+/* RGB32 to ARGB */
+#define SRC_ALPHA( s ) 0xFF
+#define DST_ALPHA( d ) ((d) >> 24)
+#define PIXEL_OUT( a, r, g, b ) PIXEL_ARGB( a, r, g, b )
+#define Bop_PFI_OP_Aop_PFI( op ) Bop_rgb32_##op##_Aop_argb
+#include "template_fused_32.h"
+
+/* RGB32 to RGB32 */
+#define SRC_ALPHA( s ) 0xFF
+#define DST_ALPHA( d ) 0xFF
+#define PIXEL_OUT( a, r, g, b ) PIXEL_RGB32( r, g, b )
+#define Bop_PFI_OP_Aop_PFI( op ) Bop_rgb32_##op##_Aop_rgb32
+#include "template_fused_32.h"
+
+/*
+ * Fused pipelines replace the whole chain of accumulator functions for a specific
+ * combination of operation, flags, blend functions and formats by a single span function.
+ *
+ * The chain is still built by gAcquireSetup() to setup the state (e.g. SCacc),
+ * before it is collapsed if an entry matches.
+ */
+typedef struct {
+     bool                     blit;        /* DFXL_BLIT if true, drawing functions otherwise */
+     u32                      flags;       /* simplified blitting flags or drawing flags */
+     DFBSurfaceBlendFunction  src_blend;
+     DFBSurfaceBlendFunction  dst_blend;
+     DFBSurfacePixelFormat    src_format;  /* DSPF_UNKNOWN for drawing */
+     DFBSurfacePixelFormat    dst_format;
+     GenefxFunc               func;
+} GenefxFusedPipeline;
+
+#define FUSED_BLIT( flags, src, dst, func ) \
+     { true, flags, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSPF_##src, DSPF_##dst, func }
+
+#define FUSED_DRAW( flags, src_blend, dst, func ) \
+     { false, flags, DSBF_##src_blend, DSBF_INVSRCALPHA, DSPF_UNKNOWN, DSPF_##dst, func }
+
+static const GenefxFusedPipeline fused_pipelines[] = {
+     /* ARGB to RGB32 with DSBLIT_BLEND_ALPHACHANNEL only is handled by Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI */
+     FUSED_BLIT( DSBLIT_BLEND_ALPHACHANNEL, ARGB, ARGB, Bop_argb_fused_src_invsrc_alphachannel_Aop_argb ),
+     FUSED_BLIT( DSBLIT_BLEND_ALPHACHANNEL, RGB32, ARGB, Bop_rgb32_fused_src_invsrc_alphachannel_Aop_argb ),
+     FUSED_BLIT( DSBLIT_BLEND_ALPHACHANNEL, RGB32, RGB32, Bop_rgb32_fused_src_invsrc_alphachannel_Aop_rgb32 ),
+
+     FUSED_BLIT( DSBLIT_BLEND_COLORALPHA, ARGB, ARGB, Bop_argb_fused_src_invsrc_coloralpha_Aop_argb ),
+     FUSED_BLIT( DSBLIT_BLEND_COLORALPHA, ARGB, RGB32, Bop_argb_fused_src_invsrc_coloralpha_Aop_rgb32 ),
+     FUSED_BLIT( DSBLIT_BLEND_COLORALPHA, RGB32, ARGB, Bop_rgb32_fused_src_invsrc_coloralpha_Aop_argb ),
+     FUSED_BLIT( DSBLIT_BLEND_COLORALPHA, RGB32, RGB32, Bop_rgb32_fused_src_invsrc_coloralpha_Aop_rgb32 ),
+
+     FUSED_BLIT( DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA, ARGB, ARGB,
+                 Bop_argb_fused_src_invsrc_alphachannel_coloralpha_Aop_argb ),
+     FUSED_BLIT( DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA, ARGB, RGB32,
+                 Bop_argb_fused_src_invsrc_alphachannel_coloralpha_Aop_rgb32 ),
+     FUSED_BLIT( DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA, RGB32, ARGB,
+                 Bop_rgb32_fused_src_invsrc_alphachannel_coloralpha_Aop_argb ),
+     FUSED_BLIT( DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA, RGB32, RGB32,
+                 Bop_rgb32_fused_src_invsrc_alphachannel_coloralpha_Aop_rgb32 ),
+
+     FUSED_DRAW( DSDRAW_BLEND, ONE,      ARGB,  Cop_fused_blend_invsrc_Aop_argb ),
+     FUSED_DRAW( DSDRAW_BLEND, SRCALPHA, ARGB,  Cop_fused_blend_invsrc_Aop_argb ),
+     FUSED_DRAW( DSDRAW_BLEND, ONE,      RGB32, Cop_fused_blend_invsrc_Aop_rgb32 ),
+     FUSED_DRAW( DSDRAW_BLEND, SRCALPHA, RGB32, Cop_fused_blend_invsrc_Aop_rgb32 ),
+};
+
+#undef FUSED_BLIT
+#undef FUSED_DRAW
+
+static GenefxFunc
+gLookupFusedPipeline( const CardState         *state,
+                      DFBAccelerationMask      accel,
+                      DFBSurfaceBlittingFlags  blittingflags )
+{
+     unsigned int          i;
+     bool                  blit;
+     u32                   flags;
+     DFBSurfacePixelFormat src_format = DSPF_UNKNOWN;
+
+     if (!dfb_config->software_fused)
+          return NULL;
+
+     switch (accel) {
+          case DFXL_BLIT:
+               blit       = true;
+               flags      = blittingflags;
+               src_format = state->source->config.format;
+               break;
+
+          case DFXL_FILLRECTANGLE:
+          case DFXL_DRAWRECTANGLE:
+          case DFXL_DRAWLINE:
+          case DFXL_FILLTRIANGLE:
+               blit  = false;
+               /* source premultiplication is applied to the color in advance */
+               flags = state->drawingflags & ~DSDRAW_SRC_PREMULTIPLY;
+               break;
+
+          default:
+               return NULL;
+     }
+
+     for (i=0; i<D_ARRAY_SIZE(fused_pipelines); i++) {
+          const GenefxFusedPipeline *fused = &fused_pipelines[i];
+
+          if (fused->blit       == blit                             &&
+              fused->flags      == flags                            &&
+              fused->src_blend  == state->src_blend                 &&
+              fused->dst_blend  == state->dst_blend                 &&
+              fused->src_format == src_format                       &&
+              fused->dst_format == state->destination->config.format)
+               return fused->func;
+     }
+
+     return NULL;
+}
+
 /**********************************************************************************************************************/
 
 /* A8/A1 to YCbCr */
@@ -8569,6 +8723,17 @@ static bool has_mmx( void )
 }
 #endif
 
+#ifdef USE_NEON
+static bool has_neon( void )
+{
+#ifdef __aarch64__
+     return true;
+#else
+     return (getauxval( AT_HWCAP ) & HWCAP_NEON) ? true : false;
+#endif
+}
+#endif
+
 void gGetDriverInfo( GraphicsDriverInfo *info )
 {
      snprintf( info->name,
@@ -8601,6 +8766,46 @@ void gGetDriverInfo( GraphicsDriverInfo *info )
      }
 #endif
 
+#ifdef USE_SSE2
+     __builtin_cpu_init();
+
+     if (__builtin_cpu_supports( "sse2" )) {
+          if (!dfb_config->sse) {
+               D_INFO( "DirectFB/Genefx: SSE2 detected, but disabled by option 'no-sse'\n");
+          }
+          else {
+               gInit_SSE2();
+
+               if (__builtin_cpu_supports( "avx2" ))
+                    gInit_AVX2();
+
+               snprintf( info->name, DFB_GRAPHICS_DRIVER_INFO_NAME_LENGTH,
+                         "%s Software Driver", use_avx2 ? "AVX2" : "SSE2" );
+
+               D_INFO( "DirectFB/Genefx: %s detected and enabled\n", use_avx2 ? "AVX2" : "SSE2" );
+          }
+     }
+#endif
+
+#ifdef USE_NEON
+     if (has_neon()) {
+          if (!dfb_config->neon) {
+               D_INFO( "DirectFB/Genefx: NEON detected, but disabled by option 'no-neon'\n");
+          }
+          else {
+               gInit_NEON();
+
+               snprintf( info->name, DFB_GRAPHICS_DRIVER_INFO_NAME_LENGTH,
+                         "NEON Software Driver" );
+
+               D_INFO( "DirectFB/Genefx: NEON detected and enabled\n");
+          }
+     }
+     else {
+          D_INFO( "DirectFB/Genefx: No NEON detected\n" );
+     }
+#endif
+
      snprintf( info->vendor, DFB_GRAPHICS_DRIVER_INFO_VENDOR_LENGTH, "directfb.org" );
 
      info->version.major = 0;
@@ -8613,7 +8818,7 @@ void gGetDeviceInfo( GraphicsDeviceInfo *info )
                "Software Rasterizer" );
 
      snprintf( info->vendor, DFB_GRAPHICS_DEVICE_INFO_VENDOR_LENGTH,
-               use_mmx ? "MMX" : "Generic" );
+               use_neon ? "NEON" : use_avx2 ? "AVX2" : use_sse2 ? "SSE2" : use_mmx ? "MMX" : "Generic" );
 
      info->caps.accel    = DFXL_NONE;
      info->caps.flags    = 0;
@@ -8695,7 +8900,7 @@ Bop_rgb24_to_Aop_rgb16_LE( GenefxState *gfxs )
  * Fast RGB32 to RGB16 conversion.
  */
 static void
-Bop_rgb32_to_Aop_rgb16_LE( GenefxState *gfxs )
+Bop_rgb32_to_Aop_rgb16_LE_C( GenefxState *gfxs )
 {
      int  w = gfxs->length;
      u32 *S = gfxs->Bop[0];
@@ -8726,6 +8931,8 @@ Bop_rgb32_to_Aop_rgb16_LE( GenefxState *gfxs )
           d[0] = RGB32_TO_RGB16( S[0] );
      }
 }
+
+static GenefxFunc Bop_rgb32_to_Aop_rgb16_LE = Bop_rgb32_to_Aop_rgb16_LE_C;
 #endif  /* #ifndef WORDS_BIGENDIAN */
 
 /**********************************************************************************************************************/
@@ -8899,6 +9106,143 @@ gAcquireUnlockBuffers( CardState *state )
      return DFB_OK;
 }
 
+/********************************* Pipeline cache *****************************/
+
+static unsigned int pipeline_cache_hits;
+static unsigned int pipeline_cache_misses;
+
+static bool
+gPipelineKeyInit( const CardState         *state,
+                  DFBAccelerationMask      accel,
+                  DFBSurfaceBlittingFlags  blittingflags,
+                  GenefxPipelineKey       *key )
+{
+     /* keys must be comparable as a whole, including padding */
+     memset( key, 0, sizeof(GenefxPipelineKey) );
+
+     /* palettes and index translation tables are not part of the key */
+     if (DFB_PIXELFORMAT_IS_INDEXED( state->destination->config.format ))
+          return false;
+
+     key->accel        = accel;
+     key->src_blend    = state->src_blend;
+     key->dst_blend    = state->dst_blend;
+     key->dst_format   = state->destination->config.format;
+     key->color        = state->color;
+     key->dst_colorkey = state->dst_colorkey;
+     key->fused        = dfb_config->software_fused;
+
+     if (DFB_BLITTING_FUNCTION( accel )) {
+          if (DFB_PIXELFORMAT_IS_INDEXED( state->source->config.format ))
+               return false;
+
+          key->blittingflags = blittingflags;
+          key->src_format    = state->source->config.format;
+          key->src_colorkey  = state->src_colorkey;
+
+          if (blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR))
+               key->mask_format = state->source_mask->config.format;
+     }
+     else
+          key->drawingflags = state->drawingflags;
+
+     return true;
+}
+
+static u32
+gPipelineKeyHash( const GenefxPipelineKey *key )
+{
+     unsigned int  i;
+     const u32    *data = (const u32*) key;
+     u32           hash = 2166136261u;
+
+     /* FNV-1a on 32 bit words */
+     for (i=0; i<sizeof(GenefxPipelineKey)/4; i++)
+          hash = (hash ^ data[i]) * 16777619u;
+
+     return hash;
+}
+
+static bool
+gPipelineCacheRestore( GenefxState             *gfxs,
+                       const GenefxPipelineKey *key,
+                       u32                      hash )
+{
+     int i;
+
+     for (i=0; i<GENEFX_PIPELINE_CACHE_SIZE; i++) {
+          GenefxPipeline *pipeline = &gfxs->pipelines[i];
+
+          if (pipeline->stamp && pipeline->hash == hash &&
+              !memcmp( &pipeline->key, key, sizeof(GenefxPipelineKey) ))
+          {
+               pipeline->stamp = ++gfxs->pipeline_stamp;
+
+               memcpy( gfxs->funcs, pipeline->funcs, sizeof(gfxs->funcs) );
+
+               gfxs->color            = pipeline->color;
+               gfxs->Cop              = pipeline->Cop;
+               gfxs->YCop             = pipeline->YCop;
+               gfxs->CbCop            = pipeline->CbCop;
+               gfxs->CrCop            = pipeline->CrCop;
+               gfxs->Dkey             = pipeline->Dkey;
+               gfxs->Skey             = pipeline->Skey;
+               gfxs->Cacc             = pipeline->Cacc;
+               gfxs->SCacc            = pipeline->SCacc;
+               gfxs->need_accumulator = pipeline->need_accumulator;
+
+               /* same initialization as done while building the pipeline */
+               gfxs->Astep = gfxs->Bstep = gfxs->Ostep = 1;
+               gfxs->Sop   = gfxs->Bop;
+
+               return true;
+          }
+     }
+
+     return false;
+}
+
+static void
+gPipelineCacheStore( GenefxState             *gfxs,
+                     const GenefxPipelineKey *key,
+                     u32                      hash )
+{
+     int             i;
+     GenefxPipeline *pipeline = &gfxs->pipelines[0];
+
+     /* replace an unused or the least recently used entry */
+     for (i=1; i<GENEFX_PIPELINE_CACHE_SIZE && pipeline->stamp; i++) {
+          if (gfxs->pipelines[i].stamp < pipeline->stamp)
+               pipeline = &gfxs->pipelines[i];
+     }
+
+     pipeline->hash  = hash;
+     pipeline->stamp = ++gfxs->pipeline_stamp;
+     pipeline->key   = *key;
+
+     memcpy( pipeline->funcs, gfxs->funcs, sizeof(gfxs->funcs) );
+
+     pipeline->color            = gfxs->color;
+     pipeline->Cop              = gfxs->Cop;
+     pipeline->YCop             = gfxs->YCop;
+     pipeline->CbCop            = gfxs->CbCop;
+     pipeline->CrCop            = gfxs->CrCop;
+     pipeline->Dkey             = gfxs->Dkey;
+     pipeline->Skey             = gfxs->Skey;
+     pipeline->Cacc             = gfxs->Cacc;
+     pipeline->SCacc            = gfxs->SCacc;
+     pipeline->need_accumulator = gfxs->need_accumulator;
+}
+
+void
+gGetPipelineCacheStats( unsigned int *hits, unsigned int *misses )
+{
+     *hits   = pipeline_cache_hits;
+     *misses = pipeline_cache_misses;
+}
+
+/**********************************************************************************************************************/
+
 bool
 gAcquireSetup( CardState *state, DFBAccelerationMask accel )
 {
@@ -8912,6 +9256,10 @@ gAcquireSetup( CardState *state, DFBAccelerationMask accel )
      DFBColor     color       = state->color;
      bool         src_ycbcr   = false;
      bool         dst_ycbcr   = false;
+     bool         cacheable;
+     u32          hash        = 0;
+
+     GenefxPipelineKey        key;
 
      DFBSurfaceBlittingFlags  simpld_blittingflags = state->blittingflags;
 
@@ -9056,6 +9404,25 @@ gAcquireSetup( CardState *state, DFBAccelerationMask accel )
           }
      }
 
+     /*
+      * Reuse a previously built pipeline for the same state
+      */
+     cacheable = gPipelineKeyInit( state, accel, simpld_blittingflags, &key );
+     if (cacheable) {
+          hash = gPipelineKeyHash( &key );
+
+          if (gPipelineCacheRestore( gfxs, &key, hash )) {
+               D_SYNC_ADD( &pipeline_cache_hits, 1 );
+
+               // FIXME
+               dfb_state_update( state, state->flags & CSF_SOURCE_LOCKED );
+
+               return true;
+          }
+
+          D_SYNC_ADD( &pipeline_cache_misses, 1 );
+     }
+
      /* premultiply source (color) */
      if (DFB_DRAWING_FUNCTION(accel) && (state->drawingflags & DSDRAW_SRC_PREMULTIPLY)) {
           u16 ca = color.a + 1;
@@ -9947,8 +10314,24 @@ gAcquireSetup( CardState *state, DFBAccelerationMask accel )
                return false;
      }
 
+     /* collapse the pipeline into a single function if there's a fused one for this state */
+     if (funcs - gfxs->funcs > 1) {
+          GenefxFunc fused = gLookupFusedPipeline( state, accel, simpld_blittingflags );
+
+          if (fused) {
+               funcs = gfxs->funcs;
+
+               *funcs++ = fused;
+
+               gfxs->need_accumulator = false;
+          }
+     }
+
      *funcs = NULL;
 
+     if (cacheable)
+          gPipelineCacheStore( gfxs, &key, hash );
+
      // FIXME
      dfb_state_update( state, state->flags & CSF_SOURCE_LOCKED );
 
@@ -10047,6 +10430,164 @@ static void gInit_MMX( void )
 #endif
 
 
+#ifdef USE_SSE2
+
+#include "generic_sse2.h"
+#include "generic_avx2.h"
+
+/*
+ * patches function pointers to SSE2 functions
+ */
+static void gInit_SSE2( void )
+{
+     use_sse2 = 1;
+
+/********************************* Cop_to_Aop_PFI ********************************/
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Cop_to_Aop_32_SSE2;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Cop_to_Aop_32_SSE2;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Cop_to_Aop_32_SSE2;
+/********************************* Sop_PFI_to_Dacc *******************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sop_rgb16_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_A8)]    = Sop_a8_to_Dacc_SSE2;
+/********************************* Sacc_to_Aop_PFI *******************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sacc_to_Aop_rgb16_SSE2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_SSE2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_SSE2;
+/********************************* Xacc_blend ************************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_SSE2;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_SSE2;
+/********************************* Dacc_modulation *******************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA] = Dacc_modulate_alpha_SSE2;
+     Dacc_modulation[DSBLIT_COLORIZE] = Dacc_modulate_rgb_SSE2;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_ALPHACHANNEL] = Dacc_modulate_rgb_SSE2;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_COLORALPHA] = Dacc_modulate_rgb_set_alpha_SSE2;
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA |
+                     DSBLIT_COLORIZE] = Dacc_modulate_argb_SSE2;
+/********************************* Bop_argb_blend_alphachannel *******************/
+     Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32_SSE2;
+     Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_SSE2;
+     Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)] =
+          Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_SSE2;
+     Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb_SSE2;
+     Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)] =
+          Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb_SSE2;
+/********************************* misc accumulator operations *******************/
+     Dacc_premultiply  = Dacc_premultiply_SSE2;
+     SCacc_add_to_Dacc = SCacc_add_to_Dacc_SSE2;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_SSE2;
+}
+
+/*
+ * patches function pointers to AVX2 functions, on top of gInit_SSE2()
+ */
+static void gInit_AVX2( void )
+{
+     use_avx2 = 1;
+
+/********************************* Sop_PFI_to_Dacc *******************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_AVX2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_AVX2;
+/********************************* Sacc_to_Aop_PFI *******************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_AVX2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_AVX2;
+/********************************* Xacc_blend ************************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_AVX2;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_AVX2;
+/********************************* Dacc_modulation *******************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA] = Dacc_modulate_alpha_AVX2;
+     Dacc_modulation[DSBLIT_COLORIZE] = Dacc_modulate_rgb_AVX2;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_ALPHACHANNEL] = Dacc_modulate_rgb_AVX2;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_COLORALPHA] = Dacc_modulate_rgb_set_alpha_AVX2;
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA |
+                     DSBLIT_COLORIZE] = Dacc_modulate_argb_AVX2;
+/********************************* Bop_argb_blend_alphachannel *******************/
+     Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32_AVX2;
+     Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_AVX2;
+     Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)] =
+          Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_AVX2;
+}
+
+#endif
+
+
+#ifdef USE_NEON
+
+#include "generic_neon.h"
+
+/*
+ * patches function pointers to NEON functions
+ */
+static void gInit_NEON( void )
+{
+     use_neon = 1;
+
+/********************************* Cop_to_Aop_PFI ********************************/
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Cop_to_Aop_16_NEON;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Cop_to_Aop_32_NEON;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Cop_to_Aop_32_NEON;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Cop_to_Aop_32_NEON;
+/********************************* Sop_PFI_to_Dacc *******************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sop_rgb16_to_Dacc_NEON;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_NEON;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_NEON;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_A8)]    = Sop_a8_to_Dacc_NEON;
+/********************************* Sacc_to_Aop_PFI *******************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sacc_to_Aop_rgb16_NEON;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_NEON;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_NEON;
+/********************************* Xacc_blend ************************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_NEON;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_NEON;
+/********************************* Dacc_modulation *******************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA] = Dacc_modulate_alpha_NEON;
+     Dacc_modulation[DSBLIT_COLORIZE] = Dacc_modulate_rgb_NEON;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_ALPHACHANNEL] = Dacc_modulate_rgb_NEON;
+     Dacc_modulation[DSBLIT_COLORIZE |
+                     DSBLIT_BLEND_COLORALPHA] = Dacc_modulate_rgb_set_alpha_NEON;
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL |
+                     DSBLIT_BLEND_COLORALPHA |
+                     DSBLIT_COLORIZE] = Dacc_modulate_argb_NEON;
+/********************************* Bop_argb_blend_alphachannel *******************/
+     Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] =
+          Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb16_NEON;
+     Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32_NEON;
+     Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_NEON;
+     Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)] =
+          Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_NEON;
+     Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] =
+          Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb_NEON;
+     Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)] =
+          Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb_NEON;
+/********************************* Bop_rgb32_to_Aop_rgb16 ************************/
+     Bop_rgb32_to_Aop_rgb16_LE = Bop_rgb32_to_Aop_rgb16_NEON;
+/********************************* misc accumulator operations *******************/
+     Dacc_premultiply  = Dacc_premultiply_NEON;
+     SCacc_add_to_Dacc = SCacc_add_to_Dacc_NEON;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_NEON;
+}
+
+#endif
+
+
 #if SIZEOF_LONG == 8
 
 #include "generic_64.h"
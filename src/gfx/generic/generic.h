@@ -61,6 +61,51 @@ typedef struct _GenefxState GenefxState;
 
 typedef void (*GenefxFunc)(GenefxState *gfxs);
 
+/*
+ * Number of pipelines remembered per state, see gAcquireSetup().
+ */
+#define GENEFX_PIPELINE_CACHE_SIZE 8
+
+/*
+ * Everything (except buffer addresses and geometry) that has an influence on the pipeline.
+ */
+typedef struct {
+     DFBAccelerationMask      accel;
+     DFBSurfaceDrawingFlags   drawingflags;
+     DFBSurfaceBlittingFlags  blittingflags;
+     DFBSurfaceBlendFunction  src_blend;
+     DFBSurfaceBlendFunction  dst_blend;
+     DFBSurfacePixelFormat    dst_format;
+     DFBSurfacePixelFormat    src_format;
+     DFBSurfacePixelFormat    mask_format;
+     DFBColor                 color;
+     u32                      src_colorkey;
+     u32                      dst_colorkey;
+     bool                     fused;
+} GenefxPipelineKey;
+
+/*
+ * A fully built pipeline with the values computed during its setup.
+ */
+typedef struct {
+     u32                hash;
+     unsigned int       stamp;   /* last use, zero if unused */
+     GenefxPipelineKey  key;
+
+     GenefxFunc         funcs[32];
+
+     DFBColor           color;
+     u32                Cop;
+     u8                 YCop;
+     u8                 CbCop;
+     u8                 CrCop;
+     u32                Dkey;
+     u32                Skey;
+     GenefxAccumulator  Cacc;
+     GenefxAccumulator  SCacc;
+     bool               need_accumulator;
+} GenefxPipeline;
+
 /*
  * State of the virtual graphics processing unit "Genefx" (pron. 'genie facts').
  */
@@ -173,6 +218,12 @@ struct _GenefxState {
 
      int *trans;
      int  num_trans;
+
+     /*
+      * pipeline cache (least recently used entry is replaced)
+      */
+     GenefxPipeline pipelines[GENEFX_PIPELINE_CACHE_SIZE];
+     unsigned int   pipeline_stamp;
 };
 
 /**********************************************************************************************************************/
@@ -197,10 +248,16 @@ void gRelease ( CardState *state );
 bool gAcquireCheck( CardState *state, DFBAccelerationMask accel );
 bool gAcquireSetup( CardState *state, DFBAccelerationMask accel );
 
+/*
+ * Returns the number of pipeline cache hits and misses since startup.
+ */
+void gGetPipelineCacheStats( unsigned int *hits, unsigned int *misses );
+
 void gFillRectangle ( CardState *state, DFBRectangle *rect );
 void gDrawLine      ( CardState *state, DFBRegion    *line );
 
 void gBlit          ( CardState *state, DFBRectangle *rect, int dx, int dy );
+void gBatchBlit     ( CardState *state, const DFBRectangle *rects, const DFBPoint *points, int num );
 void gStretchBlit   ( CardState *state, DFBRectangle *srect, DFBRectangle *drect );
 
 
@@ -0,0 +1,288 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+/*
+ * AVX2 versions of the hottest span functions, processing four accumulators
+ * or eight pixels at once. The remainder is done by the SSE2 span helpers.
+ *
+ * Unpack and pack instructions work within 128 bit lanes, which is why data is
+ * either widened with vpmovzx or reordered with vpermq after packing.
+ */
+
+#define __avx2  __attribute__((target("avx2")))
+
+
+static inline __avx2 __m256i
+acc_alpha_AVX2( __m256i acc )
+{
+     return _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( acc, 0xFF ), 0xFF );
+}
+
+static inline __avx2 __m256i
+acc_valid_AVX2( __m256i acc )
+{
+     return _mm256_cmpeq_epi16( _mm256_and_si256( acc_alpha_AVX2( acc ), _mm256_set1_epi16( 0xF000 ) ),
+                                _mm256_setzero_si256() );
+}
+
+static inline __avx2 __m256i
+mul_shr8_AVX2( __m256i a, __m256i b )
+{
+     return _mm256_or_si256( _mm256_srli_epi16( _mm256_mullo_epi16( a, b ), 8 ),
+                             _mm256_slli_epi16( _mm256_mulhi_epu16( a, b ), 8 ) );
+}
+
+static inline __avx2 __m256i
+acc_clamp_AVX2( __m256i acc )
+{
+     __m256i fits = _mm256_cmpeq_epi16( _mm256_and_si256( acc, _mm256_set1_epi16( 0xFF00 ) ),
+                                        _mm256_setzero_si256() );
+
+     return _mm256_blendv_epi8( _mm256_set1_epi16( 0x00FF ), acc, fits );
+}
+
+/**********************************************************************************************************************/
+
+static __avx2 void Sop_argb_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     u32               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     if (gfxs->Ostep != 1) {
+          Sop_argb_to_Dacc( gfxs );
+          return;
+     }
+
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          _mm256_storeu_si256( (__m256i*) D,       _mm256_cvtepu8_epi16( _mm_loadu_si128( (__m128i*) S ) ) );
+          _mm256_storeu_si256( (__m256i*) (D + 4), _mm256_cvtepu8_epi16( _mm_loadu_si128( (__m128i*) (S + 4) ) ) );
+     }
+
+     argb_to_acc_span_SSE2( S, D, w, false );
+}
+
+static __avx2 void Sop_rgb32_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     u32               *S     = gfxs->Sop[0];
+     GenefxAccumulator *D     = gfxs->Dacc;
+     __m128i            alpha = _mm_set1_epi32( 0xFF000000 );
+
+     if (gfxs->Ostep != 1) {
+          Sop_rgb32_to_Dacc( gfxs );
+          return;
+     }
+
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          __m128i s0 = _mm_or_si128( _mm_loadu_si128( (__m128i*) S ),       alpha );
+          __m128i s1 = _mm_or_si128( _mm_loadu_si128( (__m128i*) (S + 4) ), alpha );
+
+          _mm256_storeu_si256( (__m256i*) D,       _mm256_cvtepu8_epi16( s0 ) );
+          _mm256_storeu_si256( (__m256i*) (D + 4), _mm256_cvtepu8_epi16( s1 ) );
+     }
+
+     argb_to_acc_span_SSE2( S, D, w, true );
+}
+
+static inline __avx2 void
+acc_to_argb_span_AVX2( GenefxAccumulator *S, u32 *D, int w, bool opaque )
+{
+     __m256i alpha = _mm256_set1_epi32( opaque ? 0xFF000000 : 0 );
+
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          __m256i s0   = _mm256_loadu_si256( (__m256i*) S );
+          __m256i s1   = _mm256_loadu_si256( (__m256i*) (S + 4) );
+          __m256i mask = _mm256_packs_epi16( acc_valid_AVX2( s0 ), acc_valid_AVX2( s1 ) );
+          __m256i p    = _mm256_packus_epi16( acc_clamp_AVX2( s0 ), acc_clamp_AVX2( s1 ) );
+
+          /* undo the lane interleaving of the packs */
+          mask = _mm256_permute4x64_epi64( mask, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+          p    = _mm256_permute4x64_epi64( _mm256_or_si256( p, alpha ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_blendv_epi8( _mm256_loadu_si256( (__m256i*) D ), p, mask ) );
+     }
+
+     acc_to_argb_span_SSE2( S, D, w, opaque );
+}
+
+static __avx2 void Sacc_to_Aop_argb_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_argb( gfxs );
+     else
+          acc_to_argb_span_AVX2( gfxs->Sacc, gfxs->Aop[0], gfxs->length, false );
+}
+
+static __avx2 void Sacc_to_Aop_rgb32_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_rgb32( gfxs );
+     else
+          acc_to_argb_span_AVX2( gfxs->Sacc, gfxs->Aop[0], gfxs->length, true );
+}
+
+/********************************* Xacc_blend *********************************/
+
+static inline __avx2 void
+acc_blend_alpha_span_AVX2( GenefxAccumulator *X, GenefxAccumulator *Y, GenefxAccumulator *S,
+                           int w, u16 Sa, bool inverse )
+{
+     __m256i f    = _mm256_set1_epi16( Sa );
+     __m256i one  = _mm256_set1_epi16( 1 );
+     __m256i full = _mm256_set1_epi16( 0x100 );
+
+     for (; w >= 4; w -= 4, X += 4, Y += 4) {
+          __m256i y = _mm256_loadu_si256( (__m256i*) Y );
+
+          if (S) {
+               __m256i sa = acc_alpha_AVX2( _mm256_loadu_si256( (__m256i*) S ) );
+
+               f = inverse ? _mm256_sub_epi16( full, sa ) : _mm256_add_epi16( sa, one );
+
+               S += 4;
+          }
+
+          _mm256_storeu_si256( (__m256i*) X, _mm256_blendv_epi8( y, mul_shr8_AVX2( f, y ), acc_valid_AVX2( y ) ) );
+     }
+
+     acc_blend_alpha_span_SSE2( X, Y, S, w, Sa, inverse );
+}
+
+static __avx2 void Xacc_blend_srcalpha_AVX2( GenefxState *gfxs )
+{
+     acc_blend_alpha_span_AVX2( gfxs->Xacc, gfxs->Yacc, gfxs->Sacc, gfxs->length, gfxs->color.a + 1, false );
+}
+
+static __avx2 void Xacc_blend_invsrcalpha_AVX2( GenefxState *gfxs )
+{
+     acc_blend_alpha_span_AVX2( gfxs->Xacc, gfxs->Yacc, gfxs->Sacc, gfxs->length, 0x100 - gfxs->color.a, true );
+}
+
+/********************************* Dacc_modulation ****************************/
+
+static inline __avx2 void
+acc_modulate_span_AVX2( GenefxAccumulator *D, int w, u16 b, u16 g, u16 r, u16 a, bool set_alpha )
+{
+     __m256i f     = _mm256_setr_epi16( b, g, r, a, b, g, r, a, b, g, r, a, b, g, r, a );
+     __m256i amask = _mm256_set1_epi64x( 0xFFFF000000000000ULL );
+     __m256i aval  = _mm256_set1_epi16( a );
+
+     for (; w >= 4; w -= 4, D += 4) {
+          __m256i d = _mm256_loadu_si256( (__m256i*) D );
+          __m256i m = mul_shr8_AVX2( f, d );
+
+          if (set_alpha)
+               m = _mm256_blendv_epi8( m, aval, amask );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_blendv_epi8( d, m, acc_valid_AVX2( d ) ) );
+     }
+
+     acc_modulate_span_SSE2( D, w, b, g, r, a, set_alpha );
+}
+
+static __avx2 void Dacc_modulate_alpha_AVX2( GenefxState *gfxs )
+{
+     acc_modulate_span_AVX2( gfxs->Dacc, gfxs->length, 0x100, 0x100, 0x100, gfxs->Cacc.RGB.a, false );
+}
+
+static __avx2 void Dacc_modulate_rgb_AVX2( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_AVX2( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, 0x100, false );
+}
+
+static __avx2 void Dacc_modulate_rgb_set_alpha_AVX2( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_AVX2( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, gfxs->color.a, true );
+}
+
+static __avx2 void Dacc_modulate_argb_AVX2( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_AVX2( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, Cacc.RGB.a, false );
+}
+
+/********************************* Bop_argb_blend_alphachannel ****************/
+
+static __avx2 void Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32_AVX2( GenefxState *gfxs )
+{
+     int      w    = gfxs->length;
+     u32     *S    = gfxs->Bop[0];
+     u32     *D    = gfxs->Aop[0];
+     __m256i  one  = _mm256_set1_epi16( 1 );
+     __m256i  full = _mm256_set1_epi16( 128 );
+     __m256i  rgb  = _mm256_set1_epi32( 0x00FFFFFF );
+
+     if (gfxs->Astep != 1) {
+          Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32( gfxs );
+          return;
+     }
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          __m256i s  = _mm256_cvtepu8_epi16( _mm_loadu_si128( (__m128i*) S ) );
+          __m256i d  = _mm256_cvtepu8_epi16( _mm_loadu_si128( (__m128i*) D ) );
+          __m256i sa = _mm256_add_epi16( _mm256_srli_epi16( acc_alpha_AVX2( s ), 1 ), one );
+          __m256i r  = _mm256_add_epi16( _mm256_mullo_epi16( s, sa ),
+                                         _mm256_mullo_epi16( d, _mm256_sub_epi16( full, sa ) ) );
+
+          r = _mm256_srli_epi16( r, 7 );
+          r = _mm256_packus_epi16( r, _mm256_permute2x128_si256( r, r, 0x01 ) );
+
+          _mm_storeu_si128( (__m128i*) D, _mm256_castsi256_si128( _mm256_and_si256( r, rgb ) ) );
+     }
+
+     blend_src_invsrc_rgb32_span_SSE2( S, D, w );
+}
+
+static __avx2 void Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_AVX2( GenefxState *gfxs )
+{
+     int      w    = gfxs->length;
+     u32     *S    = gfxs->Bop[0];
+     u32     *D    = gfxs->Aop[0];
+     __m256i  full = _mm256_set1_epi16( 0x100 );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          __m128i s  = _mm_loadu_si128( (__m128i*) S );
+          __m256i sa = acc_alpha_AVX2( _mm256_cvtepu8_epi16( s ) );
+          __m256i d  = _mm256_cvtepu8_epi16( _mm_loadu_si128( (__m128i*) D ) );
+
+          d = _mm256_srli_epi16( _mm256_mullo_epi16( d, _mm256_sub_epi16( full, sa ) ), 8 );
+          d = _mm256_packus_epi16( d, _mm256_permute2x128_si256( d, d, 0x01 ) );
+
+          _mm_storeu_si128( (__m128i*) D, _mm_add_epi32( s, _mm256_castsi256_si128( d ) ) );
+     }
+
+     blend_one_invsrc_argb_span_SSE2( S, D, w, false );
+}
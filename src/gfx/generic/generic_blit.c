@@ -32,6 +32,7 @@
 
 #include <config.h>
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -386,3 +387,158 @@ void gBlit( CardState *state, DFBRectangle *rect, int dx, int dy )
      Genefx_ABacc_flush( gfxs );
 }
 
+
+typedef struct {
+     int y;
+     int index;
+} BatchStart;
+
+static int
+batch_start_compare( const void *a, const void *b )
+{
+     const BatchStart *sa = a;
+     const BatchStart *sb = b;
+
+     if (sa->y != sb->y)
+          return sa->y - sb->y;
+
+     return sa->index - sb->index;
+}
+
+/*
+ * Blits a batch of already clipped rectangles, e.g. the glyphs of a string, in a single pass over the destination
+ * rows instead of one rectangle after another. Within each row the rectangles are processed in their original
+ * order, so overlapping rectangles yield the same result as separate blits.
+ *
+ * The rectangles are sorted by their first row once, each row only walks the ones covering it.
+ */
+void gBatchBlit( CardState *state, const DFBRectangle *rects, const DFBPoint *points, int num )
+{
+     GenefxState             *gfxs  = state->gfxs;
+     DFBSurfaceBlittingFlags  flags = state->blittingflags;
+     int                      i, n, y;
+     int                      y1    = INT_MAX;
+     int                      y2    = INT_MIN;
+     int                      width = 0;
+     int                      count = 0;
+     int                      next  = 0;
+     int                      num_active = 0;
+     BatchStart              *starts;
+     int                     *active;
+
+     D_ASSERT( gfxs != NULL );
+     D_ASSERT( rects != NULL );
+     D_ASSERT( points != NULL );
+
+     dfb_simplify_blittingflags( &flags );
+
+     if (num < 2 ||
+         (flags & (DSBLIT_FLIP_HORIZONTAL | DSBLIT_FLIP_VERTICAL | DSBLIT_ROTATE90 | DSBLIT_DEINTERLACE |
+                   DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR)) ||
+         gfxs->src_org[0] == gfxs->dst_org[0] ||
+         DFB_PIXELFORMAT_ALIGNMENT( gfxs->src_format ) || DFB_PIXELFORMAT_ALIGNMENT( gfxs->dst_format ))
+          goto single;
+
+     if (dfb_config->software_warn) {
+          D_WARN( "BatchBlit     (%4d rects) %6s, flags 0x%08x, funcs %d/%d, color 0x%02x%02x%02x%02x, source %6s",
+                  num, dfb_pixelformat_name(gfxs->dst_format), state->blittingflags,
+                  state->src_blend, state->dst_blend,
+                  state->color.a, state->color.r, state->color.g, state->color.b,
+                  dfb_pixelformat_name(gfxs->src_format) );
+     }
+
+     CHECK_PIPELINE();
+
+     starts = D_MALLOC( (sizeof(BatchStart) + sizeof(int)) * num );
+     if (!starts)
+          goto single;
+
+     active = (int*) (starts + num);
+
+     for (i=0; i<num; i++) {
+          D_ASSERT( state->clip.x1 <= points[i].x );
+          D_ASSERT( state->clip.y1 <= points[i].y );
+          D_ASSERT( state->clip.x2 >= (points[i].x + rects[i].w - 1) );
+          D_ASSERT( state->clip.y2 >= (points[i].y + rects[i].h - 1) );
+
+          if (rects[i].w < 1 || rects[i].h < 1)
+               continue;
+
+          if (width < rects[i].w)
+               width = rects[i].w;
+
+          if (y1 > points[i].y)
+               y1 = points[i].y;
+
+          if (y2 < points[i].y + rects[i].h)
+               y2 = points[i].y + rects[i].h;
+
+          starts[count].y     = points[i].y;
+          starts[count].index = i;
+
+          count++;
+     }
+
+     if (!width || !Genefx_ABacc_prepare( gfxs, width )) {
+          D_FREE( starts );
+          return;
+     }
+
+     qsort( starts, count, sizeof(BatchStart), batch_start_compare );
+
+     gfxs->Astep = gfxs->Bstep = 1;
+
+     for (y=y1; y<y2; y++) {
+          int keep = 0;
+
+          /* Rectangles starting here join the active ones, which are kept in their original order. */
+          while (next < count && starts[next].y == y) {
+               int index = starts[next++].index;
+
+               for (n=num_active; n > 0 && active[n-1] > index; n--)
+                    active[n] = active[n-1];
+
+               active[n] = index;
+
+               num_active++;
+          }
+
+          for (n=0; n<num_active; n++) {
+               int line;
+
+               i    = active[n];
+               line = y - points[i].y;
+
+               if (line >= rects[i].h)
+                    continue;
+
+               active[keep++] = i;
+
+               gfxs->length = rects[i].w;
+
+               Genefx_Aop_xy( gfxs, points[i].x, y );
+               Genefx_Bop_xy( gfxs, rects[i].x, rects[i].y + line );
+
+               RUN_PIPELINE();
+          }
+
+          num_active = keep;
+
+          /* Skip rows between rectangles. */
+          if (!num_active && next < count)
+               y = starts[next].y - 1;
+     }
+
+     Genefx_ABacc_flush( gfxs );
+
+     D_FREE( starts );
+     return;
+
+
+single:
+     for (i=0; i<num; i++) {
+          DFBRectangle rect = rects[i];
+
+          gBlit( state, &rect, points[i].x, points[i].y );
+     }
+}
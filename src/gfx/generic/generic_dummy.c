@@ -76,6 +76,13 @@ gRelease( CardState *state )
 {
 }
 
+void
+gGetPipelineCacheStats( unsigned int *hits, unsigned int *misses )
+{
+     *hits   = 0;
+     *misses = 0;
+}
+
 void
 gFillRectangle( CardState *state, DFBRectangle *rect )
 {
@@ -91,6 +98,11 @@ gBlit( CardState *state, DFBRectangle *rect, int dx, int dy )
 {
 }
 
+void
+gBatchBlit( CardState *state, const DFBRectangle *rects, const DFBPoint *points, int num )
+{
+}
+
 void
 gStretchBlit( CardState *state, DFBRectangle *srect, DFBRectangle *drect )
 {
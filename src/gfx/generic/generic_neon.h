@@ -0,0 +1,687 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+#include <arm_neon.h>
+
+/*
+ * NEON versions of the most frequently used span functions.
+ *
+ * All functions produce exactly the same results as their C counterparts,
+ * spans with a step other than one (overlapping blits) are passed to the C version.
+ *
+ * Accumulators are loaded eight at a time with VLD4, which deinterleaves them
+ * into one register per component, i.e. b, g, r and a in val[0] to val[3].
+ * Accumulators with (a & 0xF000) set are left untouched as usual.
+ *
+ * The blending functions on whole pixels use the packed arithmetic of the C
+ * versions on four 32 bit lanes, which makes them exact by construction.
+ *
+ * Only little endian is supported, configure does not define USE_NEON otherwise.
+ */
+
+
+/* Mask with all bits set in accumulators that are not flagged by 0xF000 */
+static inline uint16x8_t
+acc_valid_NEON( uint16x8_t a )
+{
+     return vceqq_u16( vandq_u16( a, vdupq_n_u16( 0xF000 ) ), vdupq_n_u16( 0 ) );
+}
+
+/* Returns (a * b) >> 8 truncated to 16 bit, like the C code does after int promotion */
+static inline uint16x8_t
+mul_shr8_NEON( uint16x8_t a, uint16x8_t b )
+{
+     return vcombine_u16( vshrn_n_u32( vmull_u16( vget_low_u16( a ), vget_low_u16( b ) ), 8 ),
+                          vshrn_n_u32( vmull_u16( vget_high_u16( a ), vget_high_u16( b ) ), 8 ) );
+}
+
+/**********************************************************************************************************************/
+
+static inline void
+fill32_span_NEON( u32 *D, int w, u32 Cop )
+{
+     uint32x4_t c = vdupq_n_u32( Cop );
+
+     for (; w >= 8; w -= 8, D += 8) {
+          vst1q_u32( D,     c );
+          vst1q_u32( D + 4, c );
+     }
+
+     for (; w >= 4; w -= 4, D += 4)
+          vst1q_u32( D, c );
+
+     while (w--)
+          *D++ = Cop;
+}
+
+static inline void
+fill16_span_NEON( u16 *D, int w, u16 Cop )
+{
+     uint16x8_t c = vdupq_n_u16( Cop );
+
+     for (; w >= 16; w -= 16, D += 16) {
+          vst1q_u16( D,     c );
+          vst1q_u16( D + 8, c );
+     }
+
+     for (; w >= 8; w -= 8, D += 8)
+          vst1q_u16( D, c );
+
+     while (w-- > 0)
+          *D++ = Cop;
+}
+
+/* ARGB or RGB32 (opaque) to accumulators */
+static inline void
+argb_to_acc_span_NEON( const u32 *S, GenefxAccumulator *D, int w, bool opaque )
+{
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          uint8x8x4_t  s = vld4_u8( (const u8*) S );
+          uint16x8x4_t d;
+
+          d.val[0] = vmovl_u8( s.val[0] );
+          d.val[1] = vmovl_u8( s.val[1] );
+          d.val[2] = vmovl_u8( s.val[2] );
+          d.val[3] = opaque ? vdupq_n_u16( 0xFF ) : vmovl_u8( s.val[3] );
+
+          vst4q_u16( (u16*) D, d );
+     }
+
+     for (; w; w--, S++, D++) {
+          u32 s = *S;
+
+          D->RGB.a = opaque ? 0xFF : (s >> 24);
+          D->RGB.r = (s >> 16) & 0xff;
+          D->RGB.g = (s >>  8) & 0xff;
+          D->RGB.b = (s      ) & 0xff;
+     }
+}
+
+static inline void
+rgb16_to_acc_span_NEON( const u16 *S, GenefxAccumulator *D, int w )
+{
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          uint16x8_t   s = vld1q_u16( S );
+          uint16x8_t   r = vshrq_n_u16( s, 11 );
+          uint16x8_t   g = vandq_u16( vshrq_n_u16( s, 5 ), vdupq_n_u16( 0x3F ) );
+          uint16x8_t   b = vandq_u16( s, vdupq_n_u16( 0x1F ) );
+          uint16x8x4_t d;
+
+          d.val[0] = vorrq_u16( vshlq_n_u16( b, 3 ), vshrq_n_u16( b, 2 ) );
+          d.val[1] = vorrq_u16( vshlq_n_u16( g, 2 ), vshrq_n_u16( g, 4 ) );
+          d.val[2] = vorrq_u16( vshlq_n_u16( r, 3 ), vshrq_n_u16( r, 2 ) );
+          d.val[3] = vdupq_n_u16( 0xFF );
+
+          vst4q_u16( (u16*) D, d );
+     }
+
+     for (; w; w--, S++, D++) {
+          u16 s = *S;
+
+          D->RGB.a = 0xFF;
+          D->RGB.r = EXPAND_5to8( (s & 0xf800) >> 11 );
+          D->RGB.g = EXPAND_6to8( (s & 0x07e0) >>  5 );
+          D->RGB.b = EXPAND_5to8( (s & 0x001f)       );
+     }
+}
+
+static inline void
+a8_to_acc_span_NEON( const u8 *S, GenefxAccumulator *D, int w )
+{
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          uint16x8x4_t d;
+
+          d.val[0] = vdupq_n_u16( 0xFF );
+          d.val[1] = d.val[0];
+          d.val[2] = d.val[0];
+          d.val[3] = vmovl_u8( vld1_u8( S ) );
+
+          vst4q_u16( (u16*) D, d );
+     }
+
+     for (; w; w--, S++, D++) {
+          D->RGB.a = *S;
+          D->RGB.r = 0xFF;
+          D->RGB.g = 0xFF;
+          D->RGB.b = 0xFF;
+     }
+}
+
+/*
+ * Accumulators to ARGB or RGB32 (opaque), the saturating narrow
+ * clamps the components to 0xFF like PIXEL() in the accumulator templates.
+ */
+static inline void
+acc_to_argb_span_NEON( const GenefxAccumulator *S, u32 *D, int w, bool opaque )
+{
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          uint16x8x4_t s     = vld4q_u16( (const u16*) S );
+          uint8x8x4_t  d     = vld4_u8( (const u8*) D );
+          uint8x8_t    valid = vmovn_u16( acc_valid_NEON( s.val[3] ) );
+
+          d.val[0] = vbsl_u8( valid, vqmovn_u16( s.val[0] ), d.val[0] );
+          d.val[1] = vbsl_u8( valid, vqmovn_u16( s.val[1] ), d.val[1] );
+          d.val[2] = vbsl_u8( valid, vqmovn_u16( s.val[2] ), d.val[2] );
+          d.val[3] = vbsl_u8( valid, opaque ? vdup_n_u8( 0xFF ) : vqmovn_u16( s.val[3] ), d.val[3] );
+
+          vst4_u8( (u8*) D, d );
+     }
+
+     for (; w; w--, S++, D++) {
+          if (!(S->RGB.a & 0xF000))
+               *D = PIXEL_ARGB( opaque ? 0xFF : (S->RGB.a & 0xFF00) ? 0xFF : S->RGB.a,
+                                (S->RGB.r & 0xFF00) ? 0xFF : S->RGB.r,
+                                (S->RGB.g & 0xFF00) ? 0xFF : S->RGB.g,
+                                (S->RGB.b & 0xFF00) ? 0xFF : S->RGB.b );
+     }
+}
+
+static inline void
+acc_to_rgb16_span_NEON( const GenefxAccumulator *S, u16 *D, int w )
+{
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          uint16x8x4_t s = vld4q_u16( (const u16*) S );
+          uint16x8_t   r = vmovl_u8( vqmovn_u16( s.val[2] ) );
+          uint16x8_t   g = vmovl_u8( vqmovn_u16( s.val[1] ) );
+          uint16x8_t   b = vmovl_u8( vqmovn_u16( s.val[0] ) );
+          uint16x8_t   p;
+
+          p = vorrq_u16( vorrq_u16( vshlq_n_u16( vandq_u16( r, vdupq_n_u16( 0xF8 ) ), 8 ),
+                                    vshlq_n_u16( vandq_u16( g, vdupq_n_u16( 0xFC ) ), 3 ) ),
+                         vshrq_n_u16( b, 3 ) );
+
+          vst1q_u16( D, vbslq_u16( acc_valid_NEON( s.val[3] ), p, vld1q_u16( D ) ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          if (!(S->RGB.a & 0xF000))
+               *D = PIXEL_RGB16( (S->RGB.r & 0xFF00) ? 0xFF : S->RGB.r,
+                                 (S->RGB.g & 0xFF00) ? 0xFF : S->RGB.g,
+                                 (S->RGB.b & 0xFF00) ? 0xFF : S->RGB.b );
+     }
+}
+
+/*
+ * X = (Y * f) >> 8 for all valid Y, otherwise X = Y.
+ *
+ * With S being NULL the factor is the constant 'Sa', otherwise it's the alpha
+ * of the corresponding S accumulator plus one or 0x100 minus it (inverse).
+ */
+static inline void
+acc_blend_alpha_span_NEON( GenefxAccumulator *X, const GenefxAccumulator *Y, const GenefxAccumulator *S,
+                           int w, u16 Sa, bool inverse )
+{
+     uint16x8_t f = vdupq_n_u16( Sa );
+
+     for (; w >= 8; w -= 8, X += 8, Y += 8) {
+          uint16x8x4_t y     = vld4q_u16( (const u16*) Y );
+          uint16x8_t   valid = acc_valid_NEON( y.val[3] );
+          int          i;
+
+          if (S) {
+               uint16x8_t sa = vld4q_u16( (const u16*) S ).val[3];
+
+               f = inverse ? vsubq_u16( vdupq_n_u16( 0x100 ), sa ) : vaddq_u16( sa, vdupq_n_u16( 1 ) );
+
+               S += 8;
+          }
+
+          for (i = 0; i < 4; i++)
+               y.val[i] = vbslq_u16( valid, mul_shr8_NEON( f, y.val[i] ), y.val[i] );
+
+          vst4q_u16( (u16*) X, y );
+     }
+
+     for (; w; w--, X++, Y++) {
+          if (!(Y->RGB.a & 0xF000)) {
+               if (S)
+                    Sa = inverse ? 0x100 - S->RGB.a : S->RGB.a + 1;
+
+               X->RGB.r = (Sa * Y->RGB.r) >> 8;
+               X->RGB.g = (Sa * Y->RGB.g) >> 8;
+               X->RGB.b = (Sa * Y->RGB.b) >> 8;
+               X->RGB.a = (Sa * Y->RGB.a) >> 8;
+          }
+          else
+               *X = *Y;
+
+          if (S)
+               S++;
+     }
+}
+
+/*
+ * Multiplies all valid accumulators by the factors (b, g, r, a) and shifts right by 8,
+ * a factor of 0x100 leaves the component unchanged. With 'set_alpha' the alpha
+ * is replaced by 'a' instead.
+ */
+static inline void
+acc_modulate_span_NEON( GenefxAccumulator *D, int w, u16 b, u16 g, u16 r, u16 a, bool set_alpha )
+{
+     for (; w >= 8; w -= 8, D += 8) {
+          uint16x8x4_t d     = vld4q_u16( (const u16*) D );
+          uint16x8_t   valid = acc_valid_NEON( d.val[3] );
+
+          d.val[0] = vbslq_u16( valid, mul_shr8_NEON( vdupq_n_u16( b ), d.val[0] ), d.val[0] );
+          d.val[1] = vbslq_u16( valid, mul_shr8_NEON( vdupq_n_u16( g ), d.val[1] ), d.val[1] );
+          d.val[2] = vbslq_u16( valid, mul_shr8_NEON( vdupq_n_u16( r ), d.val[2] ), d.val[2] );
+          d.val[3] = vbslq_u16( valid, set_alpha ? vdupq_n_u16( a ) : mul_shr8_NEON( vdupq_n_u16( a ), d.val[3] ),
+                                d.val[3] );
+
+          vst4q_u16( (u16*) D, d );
+     }
+
+     for (; w; w--, D++) {
+          if (!(D->RGB.a & 0xF000)) {
+               D->RGB.a = set_alpha ? a : (a * D->RGB.a) >> 8;
+               D->RGB.r = (r * D->RGB.r) >> 8;
+               D->RGB.g = (g * D->RGB.g) >> 8;
+               D->RGB.b = (b * D->RGB.b) >> 8;
+          }
+     }
+}
+
+static inline void
+acc_premultiply_span_NEON( GenefxAccumulator *D, int w )
+{
+     for (; w >= 8; w -= 8, D += 8) {
+          uint16x8x4_t d     = vld4q_u16( (const u16*) D );
+          uint16x8_t   valid = acc_valid_NEON( d.val[3] );
+          uint16x8_t   da    = vaddq_u16( d.val[3], vdupq_n_u16( 1 ) );
+
+          d.val[0] = vbslq_u16( valid, mul_shr8_NEON( da, d.val[0] ), d.val[0] );
+          d.val[1] = vbslq_u16( valid, mul_shr8_NEON( da, d.val[1] ), d.val[1] );
+          d.val[2] = vbslq_u16( valid, mul_shr8_NEON( da, d.val[2] ), d.val[2] );
+
+          vst4q_u16( (u16*) D, d );
+     }
+
+     for (; w; w--, D++) {
+          if (!(D->RGB.a & 0xF000)) {
+               u16 Da = D->RGB.a + 1;
+
+               D->RGB.r = (Da * D->RGB.r) >> 8;
+               D->RGB.g = (Da * D->RGB.g) >> 8;
+               D->RGB.b = (Da * D->RGB.b) >> 8;
+          }
+     }
+}
+
+/* D += S for all valid D, with S being NULL the constant 'SC' is added */
+static inline void
+acc_add_span_NEON( GenefxAccumulator *D, const GenefxAccumulator *S, int w, GenefxAccumulator SC )
+{
+     uint16x8x4_t s;
+
+     s.val[0] = vdupq_n_u16( SC.RGB.b );
+     s.val[1] = vdupq_n_u16( SC.RGB.g );
+     s.val[2] = vdupq_n_u16( SC.RGB.r );
+     s.val[3] = vdupq_n_u16( SC.RGB.a );
+
+     for (; w >= 8; w -= 8, D += 8) {
+          uint16x8x4_t d     = vld4q_u16( (const u16*) D );
+          uint16x8_t   valid = acc_valid_NEON( d.val[3] );
+          int          i;
+
+          if (S) {
+               s  = vld4q_u16( (const u16*) S );
+               S += 8;
+          }
+
+          for (i = 0; i < 4; i++)
+               d.val[i] = vbslq_u16( valid, vaddq_u16( d.val[i], s.val[i] ), d.val[i] );
+
+          vst4q_u16( (u16*) D, d );
+     }
+
+     for (; w; w--, D++) {
+          if (S)
+               SC = *S++;
+
+          if (!(D->RGB.a & 0xF000)) {
+               D->RGB.a += SC.RGB.a;
+               D->RGB.r += SC.RGB.r;
+               D->RGB.g += SC.RGB.g;
+               D->RGB.b += SC.RGB.b;
+          }
+     }
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Packed RGB32 to RGB16 conversion of four pixels, see RGB32_TO_RGB16().
+ */
+static inline uint16x4_t
+rgb32_to_rgb16_NEON( uint32x4_t s )
+{
+     return vmovn_u32( vorrq_u32( vorrq_u32( vshrq_n_u32( vandq_u32( s, vdupq_n_u32( 0xF80000 ) ), 8 ),
+                                             vshrq_n_u32( vandq_u32( s, vdupq_n_u32( 0x00FC00 ) ), 5 ) ),
+                                  vshrq_n_u32( vandq_u32( s, vdupq_n_u32( 0x0000F8 ) ), 3 ) ) );
+}
+
+static inline void
+rgb32_to_rgb16_span_NEON( const u32 *S, u16 *D, int w )
+{
+     for (; w >= 8; w -= 8, S += 8, D += 8)
+          vst1q_u16( D, vcombine_u16( rgb32_to_rgb16_NEON( vld1q_u32( S ) ),
+                                      rgb32_to_rgb16_NEON( vld1q_u32( S + 4 ) ) ) );
+
+     for (; w; w--, S++, D++)
+          *D = RGB32_TO_RGB16( *S );
+}
+
+/*
+ * The packed (S - D) * (Sa >> 1 + 1) + (D << 7) arithmetic of the C version on four pixels.
+ */
+static inline void
+blend_src_invsrc_rgb32_span_NEON( const u32 *S, u32 *D, int w )
+{
+     uint32x4_t mrb = vdupq_n_u32( 0x00ff00ff );
+     uint32x4_t mg  = vdupq_n_u32( 0x0000ff00 );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          uint32x4_t s      = vld1q_u32( S );
+          uint32x4_t d      = vld1q_u32( D );
+          uint32x4_t salpha = vaddq_u32( vshrq_n_u32( s, 25 ), vdupq_n_u32( 1 ) );
+          uint32x4_t drb    = vandq_u32( d, mrb );
+          uint32x4_t dg     = vandq_u32( d, mg );
+          uint32x4_t rb, g;
+
+          rb = vmulq_u32( vsubq_u32( vandq_u32( s, mrb ), drb ), salpha );
+          rb = vandq_u32( vaddq_u32( rb, vshlq_n_u32( drb, 7 ) ), vdupq_n_u32( 0x7f807f80 ) );
+
+          g  = vmulq_u32( vsubq_u32( vandq_u32( s, mg ), dg ), salpha );
+          g  = vandq_u32( vaddq_u32( g, vshlq_n_u32( dg, 7 ) ), vdupq_n_u32( 0x007f8000 ) );
+
+          vst1q_u32( D, vshrq_n_u32( vaddq_u32( rb, g ), 7 ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          u32 dp32   = *D;
+          u32 sp32   = *S;
+          int salpha = (sp32 >> 25) + 1;
+
+          *D = (((((sp32 & 0xff00ff) - (dp32 & 0xff00ff)) * salpha + ((dp32 & 0xff00ff) << 7)) & 0x7f807f80) +
+                ((((sp32 & 0x00ff00) - (dp32 & 0x00ff00)) * salpha + ((dp32 & 0x00ff00) << 7)) & 0x007f8000)) >> 7;
+     }
+}
+
+/*
+ * The packed 5/6/5 arithmetic of the C version on four pixels,
+ * pixels with an alpha below four leave the destination unchanged.
+ */
+static inline void
+blend_src_invsrc_rgb16_span_NEON( const u32 *S, u16 *D, int w )
+{
+     uint32x4_t mrb = vdupq_n_u32( 0xf81f );
+     uint32x4_t mg  = vdupq_n_u32( 0x07e0 );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          uint32x4_t s      = vld1q_u32( S );
+          uint16x4_t d16    = vld1_u16( D );
+          uint32x4_t d      = vmovl_u16( d16 );
+          uint32x4_t a      = vshrq_n_u32( s, 26 );
+          uint32x4_t salpha = vaddq_u32( a, vdupq_n_u32( 1 ) );
+          uint32x4_t drb    = vandq_u32( d, mrb );
+          uint32x4_t dg     = vandq_u32( d, mg );
+          uint32x4_t srb    = vorrq_u32( vandq_u32( vshrq_n_u32( s, 8 ), vdupq_n_u32( 0xf800 ) ),
+                                         vandq_u32( vshrq_n_u32( s, 3 ), vdupq_n_u32( 0x001f ) ) );
+          uint32x4_t sg     = vandq_u32( vshrq_n_u32( s, 5 ), mg );
+          uint32x4_t rb, g;
+
+          rb = vmulq_u32( vsubq_u32( srb, drb ), salpha );
+          rb = vandq_u32( vaddq_u32( rb, vshlq_n_u32( drb, 6 ) ), vdupq_n_u32( 0x003e07c0 ) );
+
+          g  = vmulq_u32( vsubq_u32( sg, dg ), salpha );
+          g  = vandq_u32( vaddq_u32( g, vshlq_n_u32( dg, 6 ) ), vdupq_n_u32( 0x0001f800 ) );
+
+          d16 = vbsl_u16( vmovn_u32( vceqq_u32( a, vdupq_n_u32( 0 ) ) ), d16,
+                          vmovn_u32( vshrq_n_u32( vaddq_u32( rb, g ), 6 ) ) );
+
+          vst1_u16( D, d16 );
+     }
+
+     for (; w; w--, S++, D++) {
+          u32 s = *S;
+          u32 d = *D;
+
+          if (s >> 26)
+               *D = (((( (((s>>8) & 0xf800) | ((s>>3) & 0x001f)) - (d & 0xf81f)) * ((s>>26)+1) +
+                       ((d & 0xf81f)<<6)) & 0x003e07c0) +
+                     ((( ((s>>5) & 0x07e0) - (d & 0x07e0)) * ((s>>26)+1) +
+                       ((d & 0x07e0)<<6)) & 0x0001f800)) >> 6;
+     }
+}
+
+/*
+ * S' + ((D * (256 - Sa)) >> 8) like the C version on four pixels, where S' is either S or,
+ * with 'premultiply', S multiplied by (Sa + 1) keeping Sa.
+ */
+static inline void
+blend_one_invsrc_argb_span_NEON( const u32 *S, u32 *D, int w, bool premultiply )
+{
+     uint32x4_t mrb = vdupq_n_u32( 0x00ff00ff );
+     uint32x4_t mag = vdupq_n_u32( 0xff00ff00 );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          uint32x4_t s      = vld1q_u32( S );
+          uint32x4_t d      = vld1q_u32( D );
+          uint32x4_t invsrc = vsubq_u32( vdupq_n_u32( 256 ), vshrq_n_u32( s, 24 ) );
+
+          if (premultiply) {
+               uint32x4_t src = vaddq_u32( vshrq_n_u32( s, 24 ), vdupq_n_u32( 1 ) );
+
+               s = vaddq_u32( vaddq_u32( vandq_u32( vshrq_n_u32( vmulq_u32( vandq_u32( s, mrb ), src ), 8 ), mrb ),
+                                         vandq_u32( vmulq_u32( vshrq_n_u32( vandq_u32( s, mag ), 8 ), src ),
+                                                    vdupq_n_u32( 0x0000ff00 ) ) ),
+                              vandq_u32( s, vdupq_n_u32( 0xff000000 ) ) );
+          }
+
+          d = vaddq_u32( vandq_u32( vshrq_n_u32( vmulq_u32( vandq_u32( d, mrb ), invsrc ), 8 ), mrb ),
+                         vandq_u32( vmulq_u32( vshrq_n_u32( vandq_u32( d, mag ), 8 ), invsrc ), mag ) );
+
+          vst1q_u32( D, vaddq_u32( s, d ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          u32 s      = *S;
+          u32 d      = *D;
+          int invsrc = 256 - (s >> 24);
+
+          if (premultiply) {
+               int src = (s >> 24) + 1;
+
+               s = ((((s & 0x00ff00ff) * src) >> 8) & 0x00ff00ff) +
+                   ((((s & 0xff00ff00) >> 8) * src) & 0x0000ff00) + (s & 0xff000000);
+          }
+
+          *D = s + ((((d & 0x00ff00ff) * invsrc) >> 8) & 0x00ff00ff) + ((((d & 0xff00ff00) >> 8) * invsrc) & 0xff00ff00);
+     }
+}
+
+/********************************* Cop_to_Aop_PFI ****************************/
+
+static void Cop_to_Aop_32_NEON( GenefxState *gfxs )
+{
+     fill32_span_NEON( gfxs->Aop[0], gfxs->length, gfxs->Cop );
+}
+
+static void Cop_to_Aop_16_NEON( GenefxState *gfxs )
+{
+     fill16_span_NEON( gfxs->Aop[0], gfxs->length, gfxs->Cop );
+}
+
+/********************************* Sop_PFI_to_Dacc ****************************/
+
+static void Sop_argb_to_Dacc_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_argb_to_Dacc( gfxs );
+     else
+          argb_to_acc_span_NEON( gfxs->Sop[0], gfxs->Dacc, gfxs->length, false );
+}
+
+static void Sop_rgb32_to_Dacc_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_rgb32_to_Dacc( gfxs );
+     else
+          argb_to_acc_span_NEON( gfxs->Sop[0], gfxs->Dacc, gfxs->length, true );
+}
+
+static void Sop_rgb16_to_Dacc_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_rgb16_to_Dacc( gfxs );
+     else
+          rgb16_to_acc_span_NEON( gfxs->Sop[0], gfxs->Dacc, gfxs->length );
+}
+
+static void Sop_a8_to_Dacc_NEON( GenefxState *gfxs )
+{
+     a8_to_acc_span_NEON( gfxs->Sop[0], gfxs->Dacc, gfxs->length );
+}
+
+/********************************* Sacc_to_Aop_PFI ****************************/
+
+static void Sacc_to_Aop_argb_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_argb( gfxs );
+     else
+          acc_to_argb_span_NEON( gfxs->Sacc, gfxs->Aop[0], gfxs->length, false );
+}
+
+static void Sacc_to_Aop_rgb32_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_rgb32( gfxs );
+     else
+          acc_to_argb_span_NEON( gfxs->Sacc, gfxs->Aop[0], gfxs->length, true );
+}
+
+static void Sacc_to_Aop_rgb16_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_rgb16( gfxs );
+     else
+          acc_to_rgb16_span_NEON( gfxs->Sacc, gfxs->Aop[0], gfxs->length );
+}
+
+/********************************* Xacc_blend *********************************/
+
+static void Xacc_blend_srcalpha_NEON( GenefxState *gfxs )
+{
+     acc_blend_alpha_span_NEON( gfxs->Xacc, gfxs->Yacc, gfxs->Sacc, gfxs->length, gfxs->color.a + 1, false );
+}
+
+static void Xacc_blend_invsrcalpha_NEON( GenefxState *gfxs )
+{
+     acc_blend_alpha_span_NEON( gfxs->Xacc, gfxs->Yacc, gfxs->Sacc, gfxs->length, 0x100 - gfxs->color.a, true );
+}
+
+/********************************* Dacc_modulation ****************************/
+
+static void Dacc_modulate_alpha_NEON( GenefxState *gfxs )
+{
+     acc_modulate_span_NEON( gfxs->Dacc, gfxs->length, 0x100, 0x100, 0x100, gfxs->Cacc.RGB.a, false );
+}
+
+static void Dacc_modulate_rgb_NEON( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_NEON( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, 0x100, false );
+}
+
+static void Dacc_modulate_rgb_set_alpha_NEON( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_NEON( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, gfxs->color.a, true );
+}
+
+static void Dacc_modulate_argb_NEON( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_NEON( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, Cacc.RGB.a, false );
+}
+
+/********************************* misc accumulator operations ****************/
+
+static void Dacc_premultiply_NEON( GenefxState *gfxs )
+{
+     acc_premultiply_span_NEON( gfxs->Dacc, gfxs->length );
+}
+
+static void SCacc_add_to_Dacc_NEON( GenefxState *gfxs )
+{
+     acc_add_span_NEON( gfxs->Dacc, NULL, gfxs->length, gfxs->SCacc );
+}
+
+static void Sacc_add_to_Dacc_NEON( GenefxState *gfxs )
+{
+     acc_add_span_NEON( gfxs->Dacc, gfxs->Sacc, gfxs->length, gfxs->SCacc );
+}
+
+/********************************* Bop_rgb32_to_Aop_rgb16 *********************/
+
+static void Bop_rgb32_to_Aop_rgb16_NEON( GenefxState *gfxs )
+{
+     rgb32_to_rgb16_span_NEON( gfxs->Bop[0], gfxs->Aop[0], gfxs->length );
+}
+
+/********************************* Bop_argb_blend_alphachannel ****************/
+
+static void Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32_NEON( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32( gfxs );
+     else
+          blend_src_invsrc_rgb32_span_NEON( gfxs->Bop[0], gfxs->Aop[0], gfxs->length );
+}
+
+static void Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb16_NEON( GenefxState *gfxs )
+{
+     blend_src_invsrc_rgb16_span_NEON( gfxs->Bop[0], gfxs->Aop[0], gfxs->length );
+}
+
+static void Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_NEON( GenefxState *gfxs )
+{
+     blend_one_invsrc_argb_span_NEON( gfxs->Bop[0], gfxs->Aop[0], gfxs->length, false );
+}
+
+static void Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb_NEON( GenefxState *gfxs )
+{
+     blend_one_invsrc_argb_span_NEON( gfxs->Bop[0], gfxs->Aop[0], gfxs->length, true );
+}
@@ -0,0 +1,616 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+#include <immintrin.h>
+
+/*
+ * SSE2 versions of the most frequently used span functions.
+ *
+ * All functions produce exactly the same results as their C counterparts,
+ * spans with a step other than one (overlapping blits) are passed to the C version.
+ *
+ * One accumulator is 64 bit wide, i.e. an XMM register holds two of them.
+ * Accumulators with (a & 0xF000) set are left untouched as usual.
+ *
+ * The span helpers are also used by the AVX2 functions to process the remainder.
+ */
+
+#define __sse2  __attribute__((target("sse2")))
+
+
+/* Broadcast the alpha of each accumulator to all of its four components */
+static inline __sse2 __m128i
+acc_alpha_SSE2( __m128i acc )
+{
+     return _mm_shufflehi_epi16( _mm_shufflelo_epi16( acc, 0xFF ), 0xFF );
+}
+
+/* Mask with all bits set in accumulators that are not flagged by 0xF000 */
+static inline __sse2 __m128i
+acc_valid_SSE2( __m128i acc )
+{
+     return _mm_cmpeq_epi16( _mm_and_si128( acc_alpha_SSE2( acc ), _mm_set1_epi16( 0xF000 ) ),
+                             _mm_setzero_si128() );
+}
+
+static inline __sse2 __m128i
+select_SSE2( __m128i mask, __m128i a, __m128i b )
+{
+     return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+/* Returns (a * b) >> 8 truncated to 16 bit, like the C code does after int promotion */
+static inline __sse2 __m128i
+mul_shr8_SSE2( __m128i a, __m128i b )
+{
+     return _mm_or_si128( _mm_srli_epi16( _mm_mullo_epi16( a, b ), 8 ),
+                          _mm_slli_epi16( _mm_mulhi_epu16( a, b ), 8 ) );
+}
+
+/* Clamps all components to 0xFF like PIXEL() in the accumulator templates */
+static inline __sse2 __m128i
+acc_clamp_SSE2( __m128i acc )
+{
+     __m128i fits = _mm_cmpeq_epi16( _mm_and_si128( acc, _mm_set1_epi16( 0xFF00 ) ), _mm_setzero_si128() );
+
+     return select_SSE2( fits, acc, _mm_set1_epi16( 0x00FF ) );
+}
+
+/**********************************************************************************************************************/
+
+static inline __sse2 void
+fill32_span_SSE2( u32 *D, int w, u32 Cop )
+{
+     __m128i c = _mm_set1_epi32( Cop );
+
+     while (w && ((unsigned long) D & 15)) {
+          *D++ = Cop;
+          w--;
+     }
+
+     for (; w >= 8; w -= 8, D += 8) {
+          _mm_store_si128( (__m128i*) D,       c );
+          _mm_store_si128( (__m128i*) (D + 4), c );
+     }
+
+     for (; w >= 4; w -= 4, D += 4)
+          _mm_store_si128( (__m128i*) D, c );
+
+     while (w--)
+          *D++ = Cop;
+}
+
+/* ARGB or RGB32 (opaque) to accumulators */
+static inline __sse2 void
+argb_to_acc_span_SSE2( const u32 *S, GenefxAccumulator *D, int w, bool opaque )
+{
+     __m128i z     = _mm_setzero_si128();
+     __m128i alpha = _mm_set1_epi32( opaque ? 0xFF000000 : 0 );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          __m128i s = _mm_or_si128( _mm_loadu_si128( (__m128i*) S ), alpha );
+
+          _mm_storeu_si128( (__m128i*) D,       _mm_unpacklo_epi8( s, z ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), _mm_unpackhi_epi8( s, z ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          u32 s = *S;
+
+          D->RGB.a = opaque ? 0xFF : (s >> 24);
+          D->RGB.r = (s >> 16) & 0xff;
+          D->RGB.g = (s >>  8) & 0xff;
+          D->RGB.b = (s      ) & 0xff;
+     }
+}
+
+static inline __sse2 void
+rgb16_to_acc_span_SSE2( const u16 *S, GenefxAccumulator *D, int w )
+{
+     __m128i m5    = _mm_set1_epi16( 0x1F );
+     __m128i m6    = _mm_set1_epi16( 0x3F );
+     __m128i alpha = _mm_set1_epi16( 0xFF );
+
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+          __m128i r = _mm_srli_epi16( s, 11 );
+          __m128i g = _mm_and_si128( _mm_srli_epi16( s, 5 ), m6 );
+          __m128i b = _mm_and_si128( s, m5 );
+          __m128i bg, ra;
+
+          r = _mm_or_si128( _mm_slli_epi16( r, 3 ), _mm_srli_epi16( r, 2 ) );
+          g = _mm_or_si128( _mm_slli_epi16( g, 2 ), _mm_srli_epi16( g, 4 ) );
+          b = _mm_or_si128( _mm_slli_epi16( b, 3 ), _mm_srli_epi16( b, 2 ) );
+
+          bg = _mm_unpacklo_epi16( b, g );
+          ra = _mm_unpacklo_epi16( r, alpha );
+
+          _mm_storeu_si128( (__m128i*) D,       _mm_unpacklo_epi32( bg, ra ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), _mm_unpackhi_epi32( bg, ra ) );
+
+          bg = _mm_unpackhi_epi16( b, g );
+          ra = _mm_unpackhi_epi16( r, alpha );
+
+          _mm_storeu_si128( (__m128i*) (D + 4), _mm_unpacklo_epi32( bg, ra ) );
+          _mm_storeu_si128( (__m128i*) (D + 6), _mm_unpackhi_epi32( bg, ra ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          u16 s = *S;
+
+          D->RGB.a = 0xFF;
+          D->RGB.r = EXPAND_5to8( (s & 0xf800) >> 11 );
+          D->RGB.g = EXPAND_6to8( (s & 0x07e0) >>  5 );
+          D->RGB.b = EXPAND_5to8( (s & 0x001f)       );
+     }
+}
+
+static inline __sse2 void
+a8_to_acc_span_SSE2( const u8 *S, GenefxAccumulator *D, int w )
+{
+     __m128i z  = _mm_setzero_si128();
+     __m128i ff = _mm_set1_epi16( 0xFF );
+
+     for (; w >= 8; w -= 8, S += 8, D += 8) {
+          __m128i a  = _mm_unpacklo_epi8( _mm_loadl_epi64( (__m128i*) S ), z );
+          __m128i lo = _mm_unpacklo_epi16( ff, a );
+          __m128i hi = _mm_unpackhi_epi16( ff, a );
+
+          _mm_storeu_si128( (__m128i*) D,       _mm_unpacklo_epi32( ff, lo ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), _mm_unpackhi_epi32( ff, lo ) );
+          _mm_storeu_si128( (__m128i*) (D + 4), _mm_unpacklo_epi32( ff, hi ) );
+          _mm_storeu_si128( (__m128i*) (D + 6), _mm_unpackhi_epi32( ff, hi ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          D->RGB.a = *S;
+          D->RGB.r = 0xFF;
+          D->RGB.g = 0xFF;
+          D->RGB.b = 0xFF;
+     }
+}
+
+/*
+ * Converts four accumulators into four ARGB pixels and returns a byte mask
+ * of the pixels to be written in 'ret_mask'.
+ */
+static inline __sse2 __m128i
+acc_to_argb_SSE2( const GenefxAccumulator *S, __m128i *ret_mask )
+{
+     __m128i s0 = _mm_loadu_si128( (__m128i*) S );
+     __m128i s1 = _mm_loadu_si128( (__m128i*) (S + 2) );
+
+     *ret_mask = _mm_packs_epi16( acc_valid_SSE2( s0 ), acc_valid_SSE2( s1 ) );
+
+     return _mm_packus_epi16( acc_clamp_SSE2( s0 ), acc_clamp_SSE2( s1 ) );
+}
+
+/* Accumulators to ARGB or RGB32 (opaque) */
+static inline __sse2 void
+acc_to_argb_span_SSE2( const GenefxAccumulator *S, u32 *D, int w, bool opaque )
+{
+     __m128i alpha = _mm_set1_epi32( opaque ? 0xFF000000 : 0 );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          __m128i mask;
+          __m128i p = _mm_or_si128( acc_to_argb_SSE2( S, &mask ), alpha );
+
+          _mm_storeu_si128( (__m128i*) D, select_SSE2( mask, p, _mm_loadu_si128( (__m128i*) D ) ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          if (!(S->RGB.a & 0xF000))
+               *D = PIXEL_ARGB( opaque ? 0xFF : (S->RGB.a & 0xFF00) ? 0xFF : S->RGB.a,
+                                (S->RGB.r & 0xFF00) ? 0xFF : S->RGB.r,
+                                (S->RGB.g & 0xFF00) ? 0xFF : S->RGB.g,
+                                (S->RGB.b & 0xFF00) ? 0xFF : S->RGB.b );
+     }
+}
+
+static inline __sse2 void
+acc_to_rgb16_span_SSE2( const GenefxAccumulator *S, u16 *D, int w )
+{
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          __m128i mask;
+          __m128i p = acc_to_argb_SSE2( S, &mask );
+
+          p = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_srli_epi32( p, 8 ), _mm_set1_epi32( 0xF800 ) ),
+                                          _mm_and_si128( _mm_srli_epi32( p, 5 ), _mm_set1_epi32( 0x07E0 ) ) ),
+                            _mm_and_si128( _mm_srli_epi32( p, 3 ), _mm_set1_epi32( 0x001F ) ) );
+
+          /* sign extend so that the signed saturation of packs is a no-op */
+          p    = _mm_srai_epi32( _mm_slli_epi32( p, 16 ), 16 );
+          p    = _mm_packs_epi32( p, p );
+          mask = _mm_packs_epi16( mask, mask );
+
+          _mm_storel_epi64( (__m128i*) D, select_SSE2( mask, p, _mm_loadl_epi64( (__m128i*) D ) ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          if (!(S->RGB.a & 0xF000))
+               *D = PIXEL_RGB16( (S->RGB.r & 0xFF00) ? 0xFF : S->RGB.r,
+                                 (S->RGB.g & 0xFF00) ? 0xFF : S->RGB.g,
+                                 (S->RGB.b & 0xFF00) ? 0xFF : S->RGB.b );
+     }
+}
+
+/*
+ * X = (Y * f) >> 8 for all valid Y, otherwise X = Y.
+ *
+ * With S being NULL the factor is the constant 'Sa', otherwise it's the alpha
+ * of the corresponding S accumulator plus one or 0x100 minus it (inverse).
+ */
+static inline __sse2 void
+acc_blend_alpha_span_SSE2( GenefxAccumulator *X, const GenefxAccumulator *Y, const GenefxAccumulator *S,
+                           int w, u16 Sa, bool inverse )
+{
+     __m128i f    = _mm_set1_epi16( Sa );
+     __m128i one  = _mm_set1_epi16( 1 );
+     __m128i full = _mm_set1_epi16( 0x100 );
+
+     for (; w >= 2; w -= 2, X += 2, Y += 2) {
+          __m128i y = _mm_loadu_si128( (__m128i*) Y );
+
+          if (S) {
+               __m128i sa = acc_alpha_SSE2( _mm_loadu_si128( (__m128i*) S ) );
+
+               f = inverse ? _mm_sub_epi16( full, sa ) : _mm_add_epi16( sa, one );
+
+               S += 2;
+          }
+
+          _mm_storeu_si128( (__m128i*) X, select_SSE2( acc_valid_SSE2( y ), mul_shr8_SSE2( f, y ), y ) );
+     }
+
+     if (w) {
+          if (!(Y->RGB.a & 0xF000)) {
+               if (S)
+                    Sa = inverse ? 0x100 - S->RGB.a : S->RGB.a + 1;
+
+               X->RGB.r = (Sa * Y->RGB.r) >> 8;
+               X->RGB.g = (Sa * Y->RGB.g) >> 8;
+               X->RGB.b = (Sa * Y->RGB.b) >> 8;
+               X->RGB.a = (Sa * Y->RGB.a) >> 8;
+          }
+          else
+               *X = *Y;
+     }
+}
+
+/*
+ * Multiplies all valid accumulators by the factors (b, g, r, a) and shifts right by 8,
+ * a factor of 0x100 leaves the component unchanged. With 'set_alpha' the alpha
+ * is replaced by 'a' instead.
+ */
+static inline __sse2 void
+acc_modulate_span_SSE2( GenefxAccumulator *D, int w, u16 b, u16 g, u16 r, u16 a, bool set_alpha )
+{
+     __m128i f     = _mm_setr_epi16( b, g, r, a, b, g, r, a );
+     __m128i amask = _mm_setr_epi16( 0, 0, 0, -1, 0, 0, 0, -1 );
+     __m128i aval  = _mm_set1_epi16( a );
+
+     for (; w >= 2; w -= 2, D += 2) {
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+          __m128i m = mul_shr8_SSE2( f, d );
+
+          if (set_alpha)
+               m = select_SSE2( amask, aval, m );
+
+          _mm_storeu_si128( (__m128i*) D, select_SSE2( acc_valid_SSE2( d ), m, d ) );
+     }
+
+     if (w && !(D->RGB.a & 0xF000)) {
+          D->RGB.a = set_alpha ? a : (a * D->RGB.a) >> 8;
+          D->RGB.r = (r * D->RGB.r) >> 8;
+          D->RGB.g = (g * D->RGB.g) >> 8;
+          D->RGB.b = (b * D->RGB.b) >> 8;
+     }
+}
+
+static inline __sse2 void
+acc_premultiply_span_SSE2( GenefxAccumulator *D, int w )
+{
+     __m128i amask = _mm_setr_epi16( 0, 0, 0, -1, 0, 0, 0, -1 );
+     __m128i full  = _mm_set1_epi16( 0x100 );
+     __m128i one   = _mm_set1_epi16( 1 );
+
+     for (; w >= 2; w -= 2, D += 2) {
+          __m128i d  = _mm_loadu_si128( (__m128i*) D );
+          __m128i da = select_SSE2( amask, full, _mm_add_epi16( acc_alpha_SSE2( d ), one ) );
+
+          _mm_storeu_si128( (__m128i*) D, select_SSE2( acc_valid_SSE2( d ), mul_shr8_SSE2( da, d ), d ) );
+     }
+
+     if (w && !(D->RGB.a & 0xF000)) {
+          u16 Da = D->RGB.a + 1;
+
+          D->RGB.r = (Da * D->RGB.r) >> 8;
+          D->RGB.g = (Da * D->RGB.g) >> 8;
+          D->RGB.b = (Da * D->RGB.b) >> 8;
+     }
+}
+
+/* D += S for all valid D, with S being NULL the constant 'SC' is added */
+static inline __sse2 void
+acc_add_span_SSE2( GenefxAccumulator *D, const GenefxAccumulator *S, int w, GenefxAccumulator SC )
+{
+     __m128i s = _mm_setr_epi16( SC.RGB.b, SC.RGB.g, SC.RGB.r, SC.RGB.a, SC.RGB.b, SC.RGB.g, SC.RGB.r, SC.RGB.a );
+
+     for (; w >= 2; w -= 2, D += 2) {
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          if (S) {
+               s  = _mm_loadu_si128( (__m128i*) S );
+               S += 2;
+          }
+
+          _mm_storeu_si128( (__m128i*) D, select_SSE2( acc_valid_SSE2( d ), _mm_add_epi16( d, s ), d ) );
+     }
+
+     if (w && !(D->RGB.a & 0xF000)) {
+          if (S)
+               SC = *S;
+
+          D->RGB.a += SC.RGB.a;
+          D->RGB.r += SC.RGB.r;
+          D->RGB.g += SC.RGB.g;
+          D->RGB.b += SC.RGB.b;
+     }
+}
+
+/*
+ * Per component (S * ((Sa >> 1) + 1) + D * (127 - (Sa >> 1))) >> 7 with zero alpha,
+ * which is what the packed arithmetic of the C version computes.
+ */
+static inline __sse2 void
+blend_src_invsrc_rgb32_span_SSE2( const u32 *S, u32 *D, int w )
+{
+     __m128i z    = _mm_setzero_si128();
+     __m128i one  = _mm_set1_epi16( 1 );
+     __m128i full = _mm_set1_epi16( 128 );
+     __m128i rgb  = _mm_set1_epi32( 0x00FFFFFF );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          __m128i s    = _mm_loadu_si128( (__m128i*) S );
+          __m128i d    = _mm_loadu_si128( (__m128i*) D );
+          __m128i slo  = _mm_unpacklo_epi8( s, z );
+          __m128i shi  = _mm_unpackhi_epi8( s, z );
+          __m128i salo = _mm_add_epi16( _mm_srli_epi16( acc_alpha_SSE2( slo ), 1 ), one );
+          __m128i sahi = _mm_add_epi16( _mm_srli_epi16( acc_alpha_SSE2( shi ), 1 ), one );
+          __m128i lo, hi;
+
+          lo = _mm_add_epi16( _mm_mullo_epi16( slo, salo ),
+                              _mm_mullo_epi16( _mm_unpacklo_epi8( d, z ), _mm_sub_epi16( full, salo ) ) );
+          hi = _mm_add_epi16( _mm_mullo_epi16( shi, sahi ),
+                              _mm_mullo_epi16( _mm_unpackhi_epi8( d, z ), _mm_sub_epi16( full, sahi ) ) );
+
+          _mm_storeu_si128( (__m128i*) D,
+                            _mm_and_si128( _mm_packus_epi16( _mm_srli_epi16( lo, 7 ), _mm_srli_epi16( hi, 7 ) ), rgb ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          u32 dp32   = *D;
+          u32 sp32   = *S;
+          int salpha = (sp32 >> 25) + 1;
+
+          *D = (((((sp32 & 0xff00ff) - (dp32 & 0xff00ff)) * salpha + ((dp32 & 0xff00ff) << 7)) & 0x7f807f80) +
+                ((((sp32 & 0x00ff00) - (dp32 & 0x00ff00)) * salpha + ((dp32 & 0x00ff00) << 7)) & 0x007f8000)) >> 7;
+     }
+}
+
+/*
+ * Per component S' + ((D * (256 - Sa)) >> 8), where S' is either S or, with 'premultiply',
+ * S multiplied by (Sa + 1) keeping Sa. The final addition is done on whole pixels like
+ * in the C version to produce identical results even for invalid premultiplied input.
+ */
+static inline __sse2 void
+blend_one_invsrc_argb_span_SSE2( const u32 *S, u32 *D, int w, bool premultiply )
+{
+     __m128i z     = _mm_setzero_si128();
+     __m128i one   = _mm_set1_epi16( 1 );
+     __m128i full  = _mm_set1_epi16( 0x100 );
+     __m128i amask = _mm_setr_epi16( 0, 0, 0, -1, 0, 0, 0, -1 );
+
+     for (; w >= 4; w -= 4, S += 4, D += 4) {
+          __m128i s    = _mm_loadu_si128( (__m128i*) S );
+          __m128i d    = _mm_loadu_si128( (__m128i*) D );
+          __m128i slo  = _mm_unpacklo_epi8( s, z );
+          __m128i shi  = _mm_unpackhi_epi8( s, z );
+          __m128i salo = acc_alpha_SSE2( slo );
+          __m128i sahi = acc_alpha_SSE2( shi );
+          __m128i dlo  = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( d, z ), _mm_sub_epi16( full, salo ) ), 8 );
+          __m128i dhi  = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( d, z ), _mm_sub_epi16( full, sahi ) ), 8 );
+
+          if (premultiply) {
+               slo = select_SSE2( amask, slo, _mm_srli_epi16( _mm_mullo_epi16( slo, _mm_add_epi16( salo, one ) ), 8 ) );
+               shi = select_SSE2( amask, shi, _mm_srli_epi16( _mm_mullo_epi16( shi, _mm_add_epi16( sahi, one ) ), 8 ) );
+
+               s = _mm_packus_epi16( slo, shi );
+          }
+
+          _mm_storeu_si128( (__m128i*) D, _mm_add_epi32( s, _mm_packus_epi16( dlo, dhi ) ) );
+     }
+
+     for (; w; w--, S++, D++) {
+          u32 s      = *S;
+          u32 d      = *D;
+          int invsrc = 256 - (s >> 24);
+
+          if (premultiply) {
+               int src = (s >> 24) + 1;
+
+               s = ((((s & 0x00ff00ff) * src) >> 8) & 0x00ff00ff) +
+                   ((((s & 0xff00ff00) >> 8) * src) & 0x0000ff00) + (s & 0xff000000);
+          }
+
+          *D = s + ((((d & 0x00ff00ff) * invsrc) >> 8) & 0x00ff00ff) + ((((d & 0xff00ff00) >> 8) * invsrc) & 0xff00ff00);
+     }
+}
+
+/********************************* Cop_to_Aop_PFI ****************************/
+
+static __sse2 void Cop_to_Aop_32_SSE2( GenefxState *gfxs )
+{
+     fill32_span_SSE2( gfxs->Aop[0], gfxs->length, gfxs->Cop );
+}
+
+/********************************* Sop_PFI_to_Dacc ****************************/
+
+static __sse2 void Sop_argb_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_argb_to_Dacc( gfxs );
+     else
+          argb_to_acc_span_SSE2( gfxs->Sop[0], gfxs->Dacc, gfxs->length, false );
+}
+
+static __sse2 void Sop_rgb32_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_rgb32_to_Dacc( gfxs );
+     else
+          argb_to_acc_span_SSE2( gfxs->Sop[0], gfxs->Dacc, gfxs->length, true );
+}
+
+static __sse2 void Sop_rgb16_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_rgb16_to_Dacc( gfxs );
+     else
+          rgb16_to_acc_span_SSE2( gfxs->Sop[0], gfxs->Dacc, gfxs->length );
+}
+
+static __sse2 void Sop_a8_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     a8_to_acc_span_SSE2( gfxs->Sop[0], gfxs->Dacc, gfxs->length );
+}
+
+/********************************* Sacc_to_Aop_PFI ****************************/
+
+static __sse2 void Sacc_to_Aop_argb_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_argb( gfxs );
+     else
+          acc_to_argb_span_SSE2( gfxs->Sacc, gfxs->Aop[0], gfxs->length, false );
+}
+
+static __sse2 void Sacc_to_Aop_rgb32_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_rgb32( gfxs );
+     else
+          acc_to_argb_span_SSE2( gfxs->Sacc, gfxs->Aop[0], gfxs->length, true );
+}
+
+static __sse2 void Sacc_to_Aop_rgb16_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_rgb16( gfxs );
+     else
+          acc_to_rgb16_span_SSE2( gfxs->Sacc, gfxs->Aop[0], gfxs->length );
+}
+
+/********************************* Xacc_blend *********************************/
+
+static __sse2 void Xacc_blend_srcalpha_SSE2( GenefxState *gfxs )
+{
+     acc_blend_alpha_span_SSE2( gfxs->Xacc, gfxs->Yacc, gfxs->Sacc, gfxs->length, gfxs->color.a + 1, false );
+}
+
+static __sse2 void Xacc_blend_invsrcalpha_SSE2( GenefxState *gfxs )
+{
+     acc_blend_alpha_span_SSE2( gfxs->Xacc, gfxs->Yacc, gfxs->Sacc, gfxs->length, 0x100 - gfxs->color.a, true );
+}
+
+/********************************* Dacc_modulation ****************************/
+
+static __sse2 void Dacc_modulate_alpha_SSE2( GenefxState *gfxs )
+{
+     acc_modulate_span_SSE2( gfxs->Dacc, gfxs->length, 0x100, 0x100, 0x100, gfxs->Cacc.RGB.a, false );
+}
+
+static __sse2 void Dacc_modulate_rgb_SSE2( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_SSE2( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, 0x100, false );
+}
+
+static __sse2 void Dacc_modulate_rgb_set_alpha_SSE2( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_SSE2( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, gfxs->color.a, true );
+}
+
+static __sse2 void Dacc_modulate_argb_SSE2( GenefxState *gfxs )
+{
+     GenefxAccumulator Cacc = gfxs->Cacc;
+
+     acc_modulate_span_SSE2( gfxs->Dacc, gfxs->length, Cacc.RGB.b, Cacc.RGB.g, Cacc.RGB.r, Cacc.RGB.a, false );
+}
+
+/********************************* misc accumulator operations ****************/
+
+static __sse2 void Dacc_premultiply_SSE2( GenefxState *gfxs )
+{
+     acc_premultiply_span_SSE2( gfxs->Dacc, gfxs->length );
+}
+
+static __sse2 void SCacc_add_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     acc_add_span_SSE2( gfxs->Dacc, NULL, gfxs->length, gfxs->SCacc );
+}
+
+static __sse2 void Sacc_add_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     acc_add_span_SSE2( gfxs->Dacc, gfxs->Sacc, gfxs->length, gfxs->SCacc );
+}
+
+/********************************* Bop_argb_blend_alphachannel ****************/
+
+static __sse2 void Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32( gfxs );
+     else
+          blend_src_invsrc_rgb32_span_SSE2( gfxs->Bop[0], gfxs->Aop[0], gfxs->length );
+}
+
+static __sse2 void Bop_argb_blend_alphachannel_one_invsrc_Aop_argb_SSE2( GenefxState *gfxs )
+{
+     blend_one_invsrc_argb_span_SSE2( gfxs->Bop[0], gfxs->Aop[0], gfxs->length, false );
+}
+
+static __sse2 void Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_argb_SSE2( GenefxState *gfxs )
+{
+     blend_one_invsrc_argb_span_SSE2( gfxs->Bop[0], gfxs->Aop[0], gfxs->length, true );
+}
@@ -302,6 +302,383 @@ static const StretchFunctionTable *stretch_tables[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]     = NULL,
 };
 
+/**********************************************************************************************************************/
+/*** Separable two pass scaler ****************************************************************************************/
+/**********************************************************************************************************************/
+
+/*
+ * Each axis gets a table of taps, i.e. the first source sample, the number of samples and their 2.14 fixed point
+ * coefficients which always sum up to SEPARABLE_ONE. Axes shrinking by a factor of two or more use a box filter
+ * covering the whole footprint of the destination sample, all other axes use bilinear taps.
+ *
+ * The horizontal pass keeps eight fractional bits per channel in a planar line buffer, the vertical pass
+ * accumulates these lines with plain loops over contiguous arrays which the compiler vectorizes.
+ */
+
+#define SEPARABLE_SHIFT   14
+#define SEPARABLE_ONE     (1 << SEPARABLE_SHIFT)
+#define SEPARABLE_MAX_CH  4
+
+typedef struct {
+     int        start;
+     int        count;
+     const u16 *weights;
+} SeparableTap;
+
+static inline bool
+separable_use_box( int src_len, int dst_len )
+{
+     return src_len >= dst_len * 2;
+}
+
+/* Upper bound of coefficients needed for 'num' taps of an axis. */
+static inline int
+separable_num_weights( int src_len, int dst_len, int num )
+{
+     return separable_use_box( src_len, dst_len ) ? src_len + 2 * num : 2 * num;
+}
+
+static void
+separable_taps( SeparableTap *taps,
+                u16          *weights,
+                int           src_len,
+                int           dst_len,
+                int           first,
+                int           num )
+{
+     int i, k;
+
+     if (separable_use_box( src_len, dst_len )) {
+          for (i=0; i<num; i++) {
+               long long a   = (long long)(first + i) * src_len;
+               long long b   = a + src_len;
+               int       end = (b + dst_len - 1) / dst_len;
+               long long cum = 0;
+               int       sum = 0;
+
+               taps[i].start   = a / dst_len;
+               taps[i].count   = end - taps[i].start;
+               taps[i].weights = weights;
+
+               /* Distribute rounding errors so that coefficients sum up exactly. */
+               for (k=taps[i].start; k<end; k++) {
+                    long long x1 = MAX( a, (long long) k * dst_len );
+                    long long x2 = MIN( b, (long long) (k + 1) * dst_len );
+                    int       w;
+
+                    cum += x2 - x1;
+
+                    w = (cum * SEPARABLE_ONE + src_len / 2) / src_len - sum;
+
+                    *weights++ = w;
+
+                    sum += w;
+               }
+          }
+     }
+     else {
+          for (i=0; i<num; i++) {
+               long long p = (long long)(2 * (first + i) + 1) * src_len - dst_len;
+               int       f;
+
+               if (p < 0)
+                    p = 0;
+
+               taps[i].start   = p / (2 * dst_len);
+               taps[i].weights = weights;
+
+               if (taps[i].start >= src_len - 1) {
+                    taps[i].start = src_len - 1;
+                    taps[i].count = 1;
+
+                    *weights++ = SEPARABLE_ONE;
+               }
+               else {
+                    f = (p % (2 * dst_len)) * SEPARABLE_ONE / (2 * dst_len);
+
+                    taps[i].count = 2;
+
+                    *weights++ = SEPARABLE_ONE - f;
+                    *weights++ = f;
+               }
+          }
+     }
+}
+
+static void
+separable_hpass( u16                *out,
+                 const u8           *src,
+                 int                 step,
+                 int                 channels,
+                 int                 coff,
+                 const SeparableTap *taps,
+                 int                 num )
+{
+     int x, k, c;
+
+     for (x=0; x<num; x++) {
+          const u8  *s = src + taps[x].start * step;
+          const u16 *w = taps[x].weights;
+          u32        sum[SEPARABLE_MAX_CH] = { 0, 0, 0, 0 };
+
+          for (k=0; k<taps[x].count; k++) {
+               for (c=0; c<channels; c++)
+                    sum[c] += w[k] * s[c * coff];
+
+               s += step;
+          }
+
+          for (c=0; c<channels; c++)
+               out[c * num + x] = (sum[c] + (1 << 5)) >> 6;
+     }
+}
+
+static void
+separable_expand_rgb16( u8 *dst, const u16 *src, int num )
+{
+     int x;
+
+     for (x=0; x<num; x++) {
+          u16 p = src[x];
+
+          dst[0] = ((p & 0x001f) << 3) | ((p & 0x001f) >> 2);
+          dst[1] = ((p & 0x07e0) >> 3) | ((p & 0x07e0) >> 9);
+          dst[2] = ((p & 0xf800) >> 8) | ((p & 0xf800) >> 13);
+
+          dst += 3;
+     }
+}
+
+/*
+ * Scales one plane of 'channels' interleaved 8 bit samples, 'step' bytes apart per pixel and 'coff' bytes apart
+ * per channel. With 'rgb16' set the plane holds RGB16 pixels which are expanded to three channels on the fly.
+ */
+static void
+stretch_separable_plane( u8              *dst,
+                         int              dpitch,
+                         const u8        *src,
+                         int              spitch,
+                         int              width,
+                         int              height,
+                         int              dst_width,
+                         int              dst_height,
+                         const DFBRegion *clip,
+                         int              step,
+                         int              channels,
+                         int              coff,
+                         bool             rgb16 )
+{
+     int           x, y, k, j;
+     int           cw = clip->x2 - clip->x1 + 1;
+     int           ch = clip->y2 - clip->y1 + 1;
+     int           sx = 0;
+     int           n  = channels * cw;
+     int           row;
+     SeparableTap  htaps[cw];
+     SeparableTap  vtaps[ch];
+     u16           hweights[separable_num_weights( width, dst_width, cw )];
+     u16           vweights[separable_num_weights( height, dst_height, ch )];
+     u16           line[n];
+     u32           acc[n];
+     int           line_row = -1;
+
+     D_ASSERT( channels <= SEPARABLE_MAX_CH );
+
+     separable_taps( htaps, hweights, width, dst_width, clip->x1, cw );
+     separable_taps( vtaps, vweights, height, dst_height, clip->y1, ch );
+
+     if (rgb16) {
+          /* Expand only the source columns covered by the taps, rebasing them to the first one. */
+          sx = htaps[0].start;
+
+          for (x=0; x<cw; x++)
+               htaps[x].start -= sx;
+
+          step     = 3;
+          channels = 3;
+          coff     = 1;
+          n        = 3 * cw;
+     }
+
+     {
+          int  sw = rgb16 ? htaps[cw-1].start + htaps[cw-1].count : 1;
+          u8   expanded[3 * sw];
+
+          dst += clip->y1 * dpitch + clip->x1 * (rgb16 ? 2 : step);
+
+          for (y=0; y<ch; y++) {
+               const u16 *w = vtaps[y].weights;
+
+               for (k=0; k<vtaps[y].count; k++) {
+                    row = vtaps[y].start + k;
+
+                    /* The last line of a destination row often is the first one of the next. */
+                    if (row != line_row) {
+                         const u8 *s = src + row * spitch;
+
+                         if (rgb16) {
+                              separable_expand_rgb16( expanded, (const u16*) s + sx, sw );
+
+                              s = expanded;
+                         }
+
+                         separable_hpass( line, s, step, channels, coff, htaps, cw );
+
+                         line_row = row;
+                    }
+
+                    if (k == 0) {
+                         for (j=0; j<n; j++)
+                              acc[j] = w[0] * line[j];
+                    }
+                    else {
+                         for (j=0; j<n; j++)
+                              acc[j] += w[k] * line[j];
+                    }
+               }
+
+               if (rgb16) {
+                    u16 *d = (u16*) dst;
+
+                    for (x=0; x<cw; x++)
+                         d[x] = PIXEL_RGB16( (acc[2*cw+x] + (1 << 21)) >> 22,
+                                             (acc[  cw+x] + (1 << 21)) >> 22,
+                                             (acc[     x] + (1 << 21)) >> 22 );
+               }
+               else {
+                    int c;
+
+                    for (c=0; c<channels; c++) {
+                         u8        *d = dst + c * coff;
+                         const u32 *a = acc + c * cw;
+
+                         for (x=0; x<cw; x++)
+                              d[x * step] = (a[x] + (1 << 21)) >> 22;
+                    }
+               }
+
+               dst += dpitch;
+          }
+     }
+}
+
+__attribute__((noinline))
+static bool
+stretch_separable( CardState *state, DFBRectangle *srect, DFBRectangle *drect )
+{
+     GenefxState *gfxs;
+     u8          *dst;
+     const u8    *src;
+     DFBRegion    clip;
+     bool         box;
+
+     D_ASSERT( state != NULL );
+     DFB_RECTANGLE_ASSERT( srect );
+     DFB_RECTANGLE_ASSERT( drect );
+
+     gfxs = state->gfxs;
+
+     if (state->blittingflags)
+          return false;
+
+     if (gfxs->dst_format != gfxs->src_format)
+          return false;
+
+     box = separable_use_box( srect->w, drect->w ) || separable_use_box( srect->h, drect->h );
+
+     switch (gfxs->dst_format) {
+          case DSPF_ARGB:
+          case DSPF_ABGR:
+          case DSPF_RGB32:
+          case DSPF_RGB16:
+               /* Bilinear scaling on both axes is done by the hvx scalers. */
+               if (!box)
+                    return false;
+               break;
+
+          case DSPF_NV12:
+          case DSPF_NV21:
+               if (!box || (srect->x | srect->y | drect->x | drect->y) & 1)
+                    return false;
+
+               if (srect->w < 2 || srect->h < 2 || drect->w < 2 || drect->h < 2)
+                    return false;
+               break;
+
+          case DSPF_YUY2:
+          case DSPF_UYVY:
+               if ((srect->x | drect->x) & 1 || srect->w < 2 || drect->w < 2)
+                    return false;
+               break;
+
+          default:
+               return false;
+     }
+
+     clip = state->clip;
+
+     if (!dfb_region_rectangle_intersect( &clip, drect ))
+          return false;
+
+     dfb_region_translate( &clip, - drect->x, - drect->y );
+
+     dst = gfxs->dst_org[0] + drect->y * gfxs->dst_pitch + DFB_BYTES_PER_LINE( gfxs->dst_format, drect->x );
+     src = gfxs->src_org[0] + srect->y * gfxs->src_pitch + DFB_BYTES_PER_LINE( gfxs->src_format, srect->x );
+
+     switch (gfxs->dst_format) {
+          case DSPF_ARGB:
+          case DSPF_ABGR:
+          case DSPF_RGB32:
+               stretch_separable_plane( dst, gfxs->dst_pitch, src, gfxs->src_pitch,
+                                        srect->w, srect->h, drect->w, drect->h, &clip, 4, 4, 1, false );
+               break;
+
+          case DSPF_RGB16:
+               stretch_separable_plane( dst, gfxs->dst_pitch, src, gfxs->src_pitch,
+                                        srect->w, srect->h, drect->w, drect->h, &clip, 2, 3, 1, true );
+               break;
+
+          case DSPF_NV12:
+          case DSPF_NV21:
+               stretch_separable_plane( dst, gfxs->dst_pitch, src, gfxs->src_pitch,
+                                        srect->w, srect->h, drect->w, drect->h, &clip, 1, 1, 0, false );
+
+               clip.x1 /= 2;
+               clip.x2 /= 2;
+               clip.y1 /= 2;
+               clip.y2 /= 2;
+
+               dst = gfxs->dst_org[1] + drect->y/2 * gfxs->dst_pitch + drect->x;
+               src = gfxs->src_org[1] + srect->y/2 * gfxs->src_pitch + srect->x;
+
+               stretch_separable_plane( dst, gfxs->dst_pitch, src, gfxs->src_pitch,
+                                        srect->w/2, srect->h/2, drect->w/2, drect->h/2, &clip, 2, 2, 1, false );
+               break;
+
+          case DSPF_YUY2:
+          case DSPF_UYVY: {
+               int luma = gfxs->dst_format == DSPF_UYVY;
+
+               stretch_separable_plane( dst + luma, gfxs->dst_pitch, src + luma, gfxs->src_pitch,
+                                        srect->w, srect->h, drect->w, drect->h, &clip, 2, 1, 0, false );
+
+               /* Chroma of pixel pairs partially inside the clip is written like in the accumulator path. */
+               clip.x1 /= 2;
+               clip.x2 /= 2;
+
+               stretch_separable_plane( dst + !luma, gfxs->dst_pitch, src + !luma, gfxs->src_pitch,
+                                        srect->w/2, srect->h, drect->w/2, drect->h, &clip, 4, 2, 2, false );
+               break;
+          }
+
+          default:
+               D_BUG( "unexpected format" );
+               return false;
+     }
+
+     return true;
+}
+
 /**********************************************************************************************************************/
 
 __attribute__((noinline))
@@ -400,6 +777,9 @@ stretch_hvx( CardState *state, DFBRectangle *srect, DFBRectangle *drect )
                return false;
      }
 
+     if (stretch_separable( state, srect, drect ))
+          return true;
+
      switch (gfxs->dst_format) {
           case DSPF_NV12:
           case DSPF_NV21:
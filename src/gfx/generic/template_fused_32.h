@@ -0,0 +1,173 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+/*
+ * Fused span functions for 32 bit formats.
+ *
+ * Each function does the work of a complete accumulator pipeline in a single
+ * loop, producing exactly the same result as the chain of functions that
+ * gAcquireSetup() would have built for the same state.
+ *
+ * Example:
+ * #define SRC_ALPHA( s ) ((s) >> 24)
+ * #define DST_ALPHA( d ) ((d) >> 24)
+ * #define PIXEL_OUT( a, r, g, b ) PIXEL_ARGB( a, r, g, b )
+ * #define Cop_OP_Aop_PFI( op ) Cop_##op##_Aop_argb             (optional)
+ * #define Bop_PFI_OP_Aop_PFI( op ) Bop_argb_##op##_Aop_argb
+ * #include "template_fused_32.h"
+ */
+
+/*
+ * Blend source with destination using DSBF_SRCALPHA / DSBF_INVSRCALPHA,
+ * where 'sa' is the (modulated) alpha of the source pixel.
+ *
+ * The sum of both terms never exceeds 0xff, so no clamping is needed.
+ */
+#define BLEND_PIXEL( D, s, d, sa )                                                \
+do {                                                                              \
+     int _sa = (sa) + 1;                                                          \
+     int _da = 0x100 - (sa);                                                      \
+                                                                                  \
+     D = PIXEL_OUT( ((_sa * (sa)) >> 8)                + ((_da * DST_ALPHA( d )) >> 8),         \
+                    ((_sa * (((s) >> 16) & 0xff)) >> 8) + ((_da * (((d) >> 16) & 0xff)) >> 8), \
+                    ((_sa * (((s) >>  8) & 0xff)) >> 8) + ((_da * (((d) >>  8) & 0xff)) >> 8), \
+                    ((_sa * ( (s)        & 0xff)) >> 8) + ((_da * ( (d)        & 0xff)) >> 8) ); \
+} while (0)
+
+/********************************* Bop_PFI_fused_src_invsrc_alphachannel_Aop_PFI *****/
+
+static void Bop_PFI_OP_Aop_PFI(fused_src_invsrc_alphachannel)( GenefxState *gfxs )
+{
+     int  w     = gfxs->length+1;
+     u32 *S     = gfxs->Bop[0];
+     u32 *D     = gfxs->Aop[0];
+     int  Sstep = gfxs->Bstep;
+     int  Dstep = gfxs->Astep;
+
+     while (--w) {
+          u32 s = *S;
+          u32 d = *D;
+
+          BLEND_PIXEL( *D, s, d, SRC_ALPHA( s ) );
+
+          S += Sstep;
+          D += Dstep;
+     }
+}
+
+/********************************* Bop_PFI_fused_src_invsrc_coloralpha_Aop_PFI *******/
+
+static void Bop_PFI_OP_Aop_PFI(fused_src_invsrc_coloralpha)( GenefxState *gfxs )
+{
+     int  w     = gfxs->length+1;
+     u32 *S     = gfxs->Bop[0];
+     u32 *D     = gfxs->Aop[0];
+     int  Sstep = gfxs->Bstep;
+     int  Dstep = gfxs->Astep;
+     int  ca    = gfxs->color.a;
+
+     while (--w) {
+          u32 s = *S;
+          u32 d = *D;
+
+          BLEND_PIXEL( *D, s, d, ca );
+
+          S += Sstep;
+          D += Dstep;
+     }
+}
+
+/********************************* Bop_PFI_fused_src_invsrc_alphachannel_coloralpha_Aop_PFI */
+
+static void Bop_PFI_OP_Aop_PFI(fused_src_invsrc_alphachannel_coloralpha)( GenefxState *gfxs )
+{
+     int  w     = gfxs->length+1;
+     u32 *S     = gfxs->Bop[0];
+     u32 *D     = gfxs->Aop[0];
+     int  Sstep = gfxs->Bstep;
+     int  Dstep = gfxs->Astep;
+     int  ca    = gfxs->color.a + 1;
+
+     while (--w) {
+          u32 s = *S;
+          u32 d = *D;
+
+          BLEND_PIXEL( *D, s, d, (ca * SRC_ALPHA( s )) >> 8 );
+
+          S += Sstep;
+          D += Dstep;
+     }
+}
+
+/********************************* Cop_fused_blend_invsrc_Aop_PFI ********************/
+
+#ifdef Cop_OP_Aop_PFI
+
+#define CLAMP_8( x ) (((x) & 0xFF00) ? 0xFF : (x))
+
+/*
+ * Blend the color with the destination using DSBF_INVSRCALPHA for the destination,
+ * with the source term (SCacc) being precomputed by gAcquireSetup().
+ */
+static void Cop_OP_Aop_PFI(fused_blend_invsrc)( GenefxState *gfxs )
+{
+     int                w     = gfxs->length+1;
+     u32               *D     = gfxs->Aop[0];
+     int                Dstep = gfxs->Astep;
+     int                da    = 0x100 - gfxs->color.a;
+     GenefxAccumulator  SCacc = gfxs->SCacc;
+
+     while (--w) {
+          u32 d = *D;
+
+          *D = PIXEL_OUT( CLAMP_8( ((da * DST_ALPHA( d )) >> 8)        + SCacc.RGB.a ),
+                          CLAMP_8( ((da * ((d >> 16) & 0xff)) >> 8) + SCacc.RGB.r ),
+                          CLAMP_8( ((da * ((d >>  8) & 0xff)) >> 8) + SCacc.RGB.g ),
+                          CLAMP_8( ((da * ((d      ) & 0xff)) >> 8) + SCacc.RGB.b ) );
+
+          D += Dstep;
+     }
+}
+
+#undef CLAMP_8
+
+#undef Cop_OP_Aop_PFI
+#endif
+
+/******************************************************************************/
+
+#undef BLEND_PIXEL
+
+#undef SRC_ALPHA
+#undef DST_ALPHA
+#undef PIXEL_OUT
+#undef Bop_PFI_OP_Aop_PFI
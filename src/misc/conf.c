@@ -124,6 +124,13 @@ static const char *config_usage_strings[]  = {
 #ifdef USE_MMX
      "  [no-]mmx                       Enable mmx support\n"
 #endif
+#ifdef USE_SSE2
+     "  [no-]sse                       Enable sse2/avx2 support\n"
+#endif
+#ifdef USE_NEON
+     "  [no-]neon                      Enable neon support\n"
+#endif
+     "  [no-]software-fused            Use fused software pipelines for common blending operations\n"
      "  [no-]agp[=<mode>]              Enable AGP support\n"
      "  [no-]thrifty-surface-buffers   Free sysmem instance on xfer to video memory\n"
      "  font-format=<pixelformat>      Set the preferred font format\n"
@@ -189,6 +196,8 @@ static const char *config_usage_strings[]  = {
      "  font-resource-id=<id>          Resource ID to use for font cache row surfaces\n"
      "  resource-manager=<impl>        Use this resource manager implementation\n"
      "  [no-]task-manager              Use experimental task manager (default: no)\n"
+     "  task-trace=<filename>          Record task events to file for dfbtasktrace (written at shutdown)\n"
+     "  task-trace-size=<num>          Number of task events kept in the trace ring buffer (default 65536, max 16M)\n"
      "  [no-]force-frametime           Call GetFrameTime() before each Flip() automatically\n"
      "  software-cores=<num>           Set number of threads to use for software rendering\n"
      "\n",
@@ -471,6 +480,9 @@ static void config_allocate( void )
      dfb_config->banner                   = true;
      dfb_config->deinit_check             = true;
      dfb_config->mmx                      = true;
+     dfb_config->sse                      = true;
+     dfb_config->neon                     = true;
+     dfb_config->software_fused           = true;
      dfb_config->vt                       = true;
      dfb_config->vt_switch                = true;
      dfb_config->vt_num                   = -1;
@@ -528,6 +540,7 @@ static void config_allocate( void )
      dfb_config->graphics_state_call_limit = 5000;
 
      dfb_config->max_render_tasks          = 10;
+     dfb_config->task_trace_size           = 0x10000;
      dfb_config->max_frame_advance         = 100000;
 
      dfb_config->ownership_check           = true;
@@ -966,6 +979,24 @@ DFBResult dfb_config_set( const char *name, const char *value )
      if (strcmp (name, "no-mmx" ) == 0) {
           dfb_config->mmx = false;
      } else
+     if (strcmp (name, "sse" ) == 0) {
+          dfb_config->sse = true;
+     } else
+     if (strcmp (name, "no-sse" ) == 0) {
+          dfb_config->sse = false;
+     } else
+     if (strcmp (name, "neon" ) == 0) {
+          dfb_config->neon = true;
+     } else
+     if (strcmp (name, "no-neon" ) == 0) {
+          dfb_config->neon = false;
+     } else
+     if (strcmp (name, "software-fused" ) == 0) {
+          dfb_config->software_fused = true;
+     } else
+     if (strcmp (name, "no-software-fused" ) == 0) {
+          dfb_config->software_fused = false;
+     } else
      if (strcmp (name, "agp" ) == 0) {
           if (value) {
                int mode;
@@ -2064,6 +2095,42 @@ DFBResult dfb_config_set( const char *name, const char *value )
      if (strcmp (name, "no-task-manager" ) == 0) {
           dfb_config->task_manager = false;
      } else
+     if (strcmp (name, "task-trace" ) == 0) {
+          if (value) {
+               if (dfb_config->task_trace)
+                    D_FREE( dfb_config->task_trace );
+               dfb_config->task_trace = D_STRDUP( value );
+          }
+          else {
+               D_ERROR("DirectFB/Config 'task-trace': No file name specified!\n");
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "task-trace-size" ) == 0) {
+          if (value) {
+               char          *error;
+               unsigned long  size;
+
+               size = strtoul( value, &error, 10 );
+
+               if (*error || !size) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+
+               /* Rounded up to a power of two for the ring buffer. */
+               if (size > 0x1000000) {
+                    D_ERROR( "DirectFB/Config '%s': Value '%s' exceeds maximum of %d!\n", name, value, 0x1000000 );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->task_trace_size = size;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
      if (strcmp (name, "force-frametime" ) == 0) {
           dfb_config->force_frametime = true;
      } else
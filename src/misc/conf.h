@@ -307,6 +307,9 @@ typedef struct
      bool          task_manager;
      unsigned int  software_cores;
 
+     char         *task_trace;                     /* file name for task event trace */
+     unsigned int  task_trace_size;                /* number of events in trace ring buffer */
+
      DFBSurfacePixelFormat image_format;
 
      bool          linux_input_touch_abs;
@@ -330,6 +333,11 @@ typedef struct
      bool          ownership_check;
 
      bool          force_frametime;
+
+     bool          sse;                            /* sse2/avx2 support */
+     bool          neon;                           /* neon support */
+
+     bool          software_fused;                 /* use fused software pipelines */
 } DFBConfig;
 
 extern DFBConfig DIRECTFB_API *dfb_config;
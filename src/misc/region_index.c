@@ -0,0 +1,376 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <directfb_util.h>
+
+#include <direct/debug.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+
+#include <fusion/shmalloc.h>
+
+#include <misc/region_index.h>
+
+
+D_DEBUG_DOMAIN( DFB_RegionIndex, "DirectFB/RegionIndex", "DirectFB Region Index" );
+
+/* Grid size is limited to this number of cells per row and column. */
+#define REGION_INDEX_MAX_CELLS  32
+
+/**********************************************************************************************************************/
+
+static void *
+index_alloc( DFBRegionIndex *index,
+             size_t          bytes )
+{
+     if (index->pool)
+          return SHMALLOC( index->pool, bytes );
+
+     return D_MALLOC( bytes );
+}
+
+static void
+index_free( DFBRegionIndex *index,
+            void           *mem )
+{
+     if (!mem)
+          return;
+
+     if (index->pool)
+          SHFREE( index->pool, mem );
+     else
+          D_FREE( mem );
+}
+
+static int
+compare_entries( const void *a,
+                 const void *b )
+{
+     return *(const int*) a - *(const int*) b;
+}
+
+/**********************************************************************************************************************/
+
+void
+dfb_region_index_init( DFBRegionIndex      *index,
+                       FusionSHMPoolShared *pool )
+{
+     D_ASSERT( index != NULL );
+
+     memset( index, 0, sizeof(DFBRegionIndex) );
+
+     index->pool = pool;
+
+     D_MAGIC_SET( index, DFBRegionIndex );
+}
+
+void
+dfb_region_index_deinit( DFBRegionIndex *index )
+{
+     D_MAGIC_ASSERT( index, DFBRegionIndex );
+
+     index_free( index, index->regions );
+     index_free( index, index->marks );
+     index_free( index, index->cells );
+     index_free( index, index->items );
+
+     D_MAGIC_CLEAR( index );
+}
+
+DFBResult
+dfb_region_index_reset( DFBRegionIndex *index,
+                        int             num )
+{
+     int i;
+
+     D_MAGIC_ASSERT( index, DFBRegionIndex );
+     D_ASSERT( num >= 0 );
+
+     if (num > index->capacity) {
+          int capacity = index->capacity ? index->capacity : 16;
+
+          while (capacity < num)
+               capacity *= 2;
+
+          index_free( index, index->regions );
+          index_free( index, index->marks );
+
+          index->regions  = index_alloc( index, capacity * sizeof(DFBRegion) );
+          index->marks    = index_alloc( index, capacity * sizeof(unsigned int) );
+          index->capacity = capacity;
+
+          if (!index->regions || !index->marks) {
+               index_free( index, index->regions );
+               index_free( index, index->marks );
+
+               index->regions  = NULL;
+               index->marks    = NULL;
+               index->capacity = 0;
+               index->num      = 0;
+
+               return D_OOM();
+          }
+     }
+
+     for (i=0; i<num; i++) {
+          index->regions[i] = (DFBRegion) { 0, 0, -1, -1 };
+          index->marks[i]   = 0;
+     }
+
+     index->num       = num;
+     index->stamp     = 0;
+     index->num_cells = 0;
+
+     return DFB_OK;
+}
+
+void
+dfb_region_index_set( DFBRegionIndex  *index,
+                      int              entry,
+                      const DFBRegion *region )
+{
+     D_MAGIC_ASSERT( index, DFBRegionIndex );
+     D_ASSERT( entry >= 0 );
+     D_ASSERT( entry < index->num );
+     DFB_REGION_ASSERT( region );
+
+     index->regions[entry] = *region;
+}
+
+DFBResult
+dfb_region_index_build( DFBRegionIndex *index,
+                        int             width,
+                        int             height )
+{
+     int  i, c, x, y;
+     int  shift, cols, rows, num_cells, total;
+     int *cells;
+
+     D_MAGIC_ASSERT( index, DFBRegionIndex );
+
+     if (width < 0)
+          width = 0;
+
+     if (height < 0)
+          height = 0;
+
+     for (shift = 4; (width >> shift) >= REGION_INDEX_MAX_CELLS || (height >> shift) >= REGION_INDEX_MAX_CELLS; shift++);
+
+     cols      = (width  + (1 << shift) - 1) >> shift;
+     rows      = (height + (1 << shift) - 1) >> shift;
+     num_cells = cols * rows + 1;
+
+     if (num_cells + 1 > index->cells_capacity) {
+          index_free( index, index->cells );
+
+          index->cells          = index_alloc( index, (num_cells + 1) * sizeof(int) );
+          index->cells_capacity = index->cells ? num_cells + 1 : 0;
+
+          if (!index->cells) {
+               index->num_cells = 0;
+               return D_OOM();
+          }
+     }
+
+     index->width     = width;
+     index->height    = height;
+     index->shift     = shift;
+     index->cols      = cols;
+     index->rows      = rows;
+     index->num_cells = 0;
+
+     cells = index->cells;
+
+     memset( cells, 0, (num_cells + 1) * sizeof(int) );
+
+     /* Count the entries of each cell, stored at the following cell. */
+     for (i=0; i<index->num; i++) {
+          DFBRegion region = index->regions[i];
+
+          if (region.x2 < region.x1)
+               continue;
+
+          if (region.x1 < 0 || region.y1 < 0 || region.x2 >= width || region.y2 >= height)
+               cells[num_cells]++;
+
+          if (!dfb_region_intersect( &region, 0, 0, width - 1, height - 1 ))
+               continue;
+
+          for (y = region.y1 >> shift; y <= region.y2 >> shift; y++) {
+               for (x = region.x1 >> shift; x <= region.x2 >> shift; x++)
+                    cells[y * cols + x + 1]++;
+          }
+     }
+
+     for (c=1; c<=num_cells; c++)
+          cells[c] += cells[c-1];
+
+     total = cells[num_cells];
+
+     if (total > index->items_capacity) {
+          int capacity = index->items_capacity ? index->items_capacity : 64;
+
+          while (capacity < total)
+               capacity *= 2;
+
+          index_free( index, index->items );
+
+          index->items          = index_alloc( index, capacity * sizeof(int) );
+          index->items_capacity = index->items ? capacity : 0;
+
+          if (!index->items)
+               return D_OOM();
+     }
+
+     /* Fill in ascending order, advancing the start of each cell to the start of the following one. */
+     for (i=0; i<index->num; i++) {
+          DFBRegion region = index->regions[i];
+
+          if (region.x2 < region.x1)
+               continue;
+
+          if (region.x1 < 0 || region.y1 < 0 || region.x2 >= width || region.y2 >= height)
+               index->items[cells[num_cells - 1]++] = i;
+
+          if (!dfb_region_intersect( &region, 0, 0, width - 1, height - 1 ))
+               continue;
+
+          for (y = region.y1 >> shift; y <= region.y2 >> shift; y++) {
+               for (x = region.x1 >> shift; x <= region.x2 >> shift; x++)
+                    index->items[cells[y * cols + x]++] = i;
+          }
+     }
+
+     for (c=num_cells; c>0; c--)
+          cells[c] = cells[c-1];
+
+     cells[0] = 0;
+
+     index->num_cells = num_cells;
+
+     D_DEBUG_AT( DFB_RegionIndex, "%s( %dx%d ) -> %d entries, %dx%d cells of %d, %d items\n", __FUNCTION__,
+                 width, height, index->num, cols, rows, 1 << shift, total );
+
+     return DFB_OK;
+}
+
+int
+dfb_region_index_at( const DFBRegionIndex  *index,
+                     int                    x,
+                     int                    y,
+                     const int            **ret_entries )
+{
+     int cell;
+
+     D_MAGIC_ASSERT( index, DFBRegionIndex );
+     D_ASSERT( index->num_cells > 0 );
+     D_ASSERT( ret_entries != NULL );
+
+     if (x < 0 || y < 0 || x >= index->width || y >= index->height)
+          cell = index->num_cells - 1;
+     else
+          cell = (y >> index->shift) * index->cols + (x >> index->shift);
+
+     *ret_entries = &index->items[index->cells[cell]];
+
+     return index->cells[cell+1] - index->cells[cell];
+}
+
+int
+dfb_region_index_query( DFBRegionIndex  *index,
+                        const DFBRegion *region,
+                        int             *ret_entries )
+{
+     int          i, c, x, y;
+     int          num   = 0;
+     int          shift = index->shift;
+     DFBRegion    clipped;
+     unsigned int stamp;
+
+     D_MAGIC_ASSERT( index, DFBRegionIndex );
+     D_ASSERT( index->num_cells > 0 );
+     DFB_REGION_ASSERT( region );
+     D_ASSERT( ret_entries != NULL );
+
+     if (!++index->stamp) {
+          memset( index->marks, 0, index->num * sizeof(unsigned int) );
+
+          index->stamp = 1;
+     }
+
+     stamp   = index->stamp;
+     clipped = *region;
+
+     if (dfb_region_intersect( &clipped, 0, 0, index->width - 1, index->height - 1 )) {
+          for (y = clipped.y1 >> shift; y <= clipped.y2 >> shift; y++) {
+               for (x = clipped.x1 >> shift; x <= clipped.x2 >> shift; x++) {
+                    c = y * index->cols + x;
+
+                    for (i=index->cells[c]; i<index->cells[c+1]; i++) {
+                         int entry = index->items[i];
+
+                         if (index->marks[entry] == stamp)
+                              continue;
+
+                         index->marks[entry] = stamp;
+
+                         if (dfb_region_region_intersects( &index->regions[entry], region ))
+                              ret_entries[num++] = entry;
+                    }
+               }
+          }
+     }
+
+     /* Entries beyond the area may only intersect outside. */
+     if (region->x1 < 0 || region->y1 < 0 || region->x2 >= index->width || region->y2 >= index->height) {
+          c = index->num_cells - 1;
+
+          for (i=index->cells[c]; i<index->cells[c+1]; i++) {
+               int entry = index->items[i];
+
+               if (index->marks[entry] == stamp)
+                    continue;
+
+               index->marks[entry] = stamp;
+
+               if (dfb_region_region_intersects( &index->regions[entry], region ))
+                    ret_entries[num++] = entry;
+          }
+     }
+
+     qsort( ret_entries, num, sizeof(int), compare_entries );
+
+     return num;
+}
@@ -0,0 +1,107 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+#ifndef __MISC__REGION_INDEX_H__
+#define __MISC__REGION_INDEX_H__
+
+#include <directfb.h>
+
+#include <fusion/types.h>
+
+/*
+ * Uniform grid over an area listing the entries whose region touches each cell, for finding the entries
+ * at a point or within a region without looking at all of them. Entries are numbered, e.g. by their position
+ * in a stacking order, and are listed in ascending order.
+ *
+ * Entries extending beyond the area are also listed in an extra list used for points and regions outside.
+ */
+typedef struct {
+     int                  magic;
+
+     FusionSHMPoolShared *pool;          /* shared memory pool or NULL for local memory */
+
+     int                  width;         /* area covered by the grid */
+     int                  height;
+     int                  shift;         /* cells have a size of 1 << shift */
+     int                  cols;
+     int                  rows;
+
+     int                  num;           /* number of entries */
+     int                  capacity;
+     DFBRegion           *regions;       /* region of each entry, x2 < x1 if not set */
+     unsigned int        *marks;         /* stamp of the last query listing the entry */
+     unsigned int         stamp;
+
+     int                  num_cells;     /* cols * rows plus the list of entries outside */
+     int                 *cells;         /* start of each cell in 'items', num_cells + 1 */
+     int                  cells_capacity;
+     int                 *items;         /* entries of all cells */
+     int                  items_capacity;
+} DFBRegionIndex;
+
+
+void      dfb_region_index_init  ( DFBRegionIndex      *index,
+                                   FusionSHMPoolShared *pool );
+
+void      dfb_region_index_deinit( DFBRegionIndex      *index );
+
+/*
+ * Starts over with the given number of entries, all of them not set.
+ */
+DFBResult dfb_region_index_reset ( DFBRegionIndex      *index,
+                                   int                  num );
+
+void      dfb_region_index_set   ( DFBRegionIndex      *index,
+                                   int                  entry,
+                                   const DFBRegion     *region );
+
+/*
+ * Builds the lists of all cells after setting the entries.
+ */
+DFBResult dfb_region_index_build ( DFBRegionIndex      *index,
+                                   int                  width,
+                                   int                  height );
+
+/*
+ * Returns the entries listed for the cell containing the point, which may not contain the point themselves.
+ */
+int       dfb_region_index_at    ( const DFBRegionIndex *index,
+                                   int                   x,
+                                   int                   y,
+                                   const int           **ret_entries );
+
+/*
+ * Returns the entries intersecting the region in ascending order, 'ret_entries' having room for all entries.
+ */
+int       dfb_region_index_query ( DFBRegionIndex      *index,
+                                   const DFBRegion     *region,
+                                   int                 *ret_entries );
+
+#endif
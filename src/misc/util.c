@@ -32,6 +32,7 @@
 
 #include <config.h>
 
+#include <limits.h>
 #include <string.h>
 
 #include <directfb_util.h>
@@ -288,12 +289,154 @@ dfb_updates_init( DFBUpdates *updates,
      D_MAGIC_SET( updates, DFBUpdates );
 }
 
+static __inline__ int
+region_area( const DFBRegion *region )
+{
+     return (region->x2 - region->x1 + 1) * (region->y2 - region->y1 + 1);
+}
+
+static __inline__ void
+updates_remove( DFBUpdates *updates,
+                int         index )
+{
+     updates->regions[index] = updates->regions[--updates->num_regions];
+}
+
+/*
+ * Keeps the regions disjoint. Regions are only combined if the union does not cover more pixels than both
+ * of them (overlapping or adjacent with a common edge). Otherwise the new region is cut around the existing
+ * one. When running out of regions, the pair with the least additional area is combined.
+ */
+static void
+updates_insert( DFBUpdates *updates,
+                DFBRegion   region )
+{
+     int       i, j;
+     int       best_i, best_j, best_waste;
+     DFBRegion cut;
+
+restart:
+     for (i=0; i<updates->num_regions; i++) {
+          DFBRegion united = updates->regions[i];
+
+          if (dfb_region_region_contains( &updates->regions[i], &region )) {
+               D_DEBUG_AT( DFB_Updates, "  -> contained in  [%d] %4d,%4d-%4dx%4d\n", i,
+                           DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[i]) );
+               return;
+          }
+
+          dfb_region_region_union( &united, &region );
+
+          if (region_area( &united ) <= region_area( &updates->regions[i] ) + region_area( &region )) {
+               D_DEBUG_AT( DFB_Updates, "  -> combined with [%d] %4d,%4d-%4dx%4d\n", i,
+                           DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[i]) );
+
+               updates_remove( updates, i );
+
+               region = united;
+
+               goto restart;
+          }
+     }
+
+     for (i=0; i<updates->num_regions; i++) {
+          if (!dfb_region_region_intersects( &updates->regions[i], &region ))
+               continue;
+
+          /* Add the parts outside of the overlapped region, which may change during insertion. */
+          cut = updates->regions[i];
+
+          D_DEBUG_AT( DFB_Updates, "  -> cut by        [%d] %4d,%4d-%4dx%4d\n", i,
+                      DFB_RECTANGLE_VALS_FROM_REGION(&cut) );
+
+          if (region.y1 < cut.y1) {
+               updates_insert( updates, (DFBRegion) { region.x1, region.y1, region.x2, cut.y1 - 1 } );
+
+               region.y1 = cut.y1;
+          }
+
+          if (region.y2 > cut.y2) {
+               updates_insert( updates, (DFBRegion) { region.x1, cut.y2 + 1, region.x2, region.y2 } );
+
+               region.y2 = cut.y2;
+          }
+
+          if (region.x1 < cut.x1)
+               updates_insert( updates, (DFBRegion) { region.x1, region.y1, cut.x1 - 1, region.y2 } );
+
+          if (region.x2 > cut.x2)
+               updates_insert( updates, (DFBRegion) { cut.x2 + 1, region.y1, region.x2, region.y2 } );
+
+          return;
+     }
+
+     if (updates->num_regions < updates->max_regions) {
+          updates->regions[updates->num_regions++] = region;
+
+          D_DEBUG_AT( DFB_Updates, "  -> added as      [%d] %4d,%4d-%4dx%4d\n", updates->num_regions - 1,
+                      DFB_RECTANGLE_VALS_FROM_REGION(&region) );
+          return;
+     }
+
+     /* Find the pair whose union adds the fewest pixels, the new region having index -1. */
+     best_i     = -1;
+     best_j     = 0;
+     best_waste = INT_MAX;
+
+     for (i=-1; i<updates->num_regions; i++) {
+          const DFBRegion *a = (i < 0) ? &region : &updates->regions[i];
+
+          for (j=i+1; j<updates->num_regions; j++) {
+               const DFBRegion *b      = &updates->regions[j];
+               DFBRegion        united = *a;
+               int              waste;
+
+               dfb_region_region_union( &united, b );
+
+               waste = region_area( &united ) - region_area( a ) - region_area( b );
+               if (waste < best_waste) {
+                    best_i     = i;
+                    best_j     = j;
+                    best_waste = waste;
+               }
+          }
+     }
+
+     D_DEBUG_AT( DFB_Updates, "  -> combining [%d] and [%d] (%d more pixels)\n", best_i, best_j, best_waste );
+
+     cut = updates->regions[best_j];
+
+     updates_remove( updates, best_j );
+
+     if (best_i >= 0) {
+          /* Put the new region in place of the pair and go on with their union. */
+          DFBRegion united = updates->regions[best_i];
+
+          updates->regions[best_i] = region;
+
+          region = united;
+     }
+
+     dfb_region_region_union( &region, &cut );
+
+     /* Absorb any region overlapped by the union, which frees at least one region. */
+     for (i=0; i<updates->num_regions; i++) {
+          if (dfb_region_region_intersects( &updates->regions[i], &region )) {
+               dfb_region_region_union( &region, &updates->regions[i] );
+
+               updates_remove( updates, i );
+
+               i = -1;
+          }
+     }
+
+     updates->regions[updates->num_regions++] = region;
+}
+
 void
 dfb_updates_add( DFBUpdates      *updates,
                  const DFBRegion *region )
 {
-     int i;
-
      D_MAGIC_ASSERT( updates, DFBUpdates );
      DFB_REGION_ASSERT( region );
      D_ASSERT( updates->regions != NULL );
@@ -312,41 +455,9 @@ dfb_updates_add( DFBUpdates      *updates,
           return;
      }
 
-     for (i=0; i<updates->num_regions; i++) {
-          if (dfb_region_region_extends( &updates->regions[i], region ) ||
-              dfb_region_region_intersects( &updates->regions[i], region ))
-          {
-               D_DEBUG_AT( DFB_Updates, "  -> combined with [%d] %4d,%4d-%4dx%4d\n", i,
-                           DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[i]) );
-
-               dfb_region_region_union( &updates->regions[i], region );
-
-               dfb_region_region_union( &updates->bounding, region );
-
-               D_DEBUG_AT( DFB_Updates, "  -> resulting in  [%d] %4d,%4d-%4dx%4d\n", i,
-                           DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[i]) );
-
-               return;
-          }
-     }
-
-     if (updates->num_regions == updates->max_regions) {
-          dfb_region_region_union( &updates->bounding, region );
+     dfb_region_region_union( &updates->bounding, region );
 
-          updates->regions[0]  = updates->bounding;
-          updates->num_regions = 1;
-
-          D_DEBUG_AT( DFB_Updates, "  -> collapsing to [0] %4d,%4d-%4dx%4d\n",
-                      DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[0]) );
-     }
-     else {
-          updates->regions[updates->num_regions++] = *region;
-
-          dfb_region_region_union( &updates->bounding, region );
-
-          D_DEBUG_AT( DFB_Updates, "  -> added as      [%d] %4d,%4d-%4dx%4d\n", updates->num_regions - 1,
-                      DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[updates->num_regions - 1]) );
-     }
+     updates_insert( updates, *region );
 }
 
 void
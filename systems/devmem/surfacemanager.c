@@ -67,6 +67,15 @@ static Chunk *occupy_chunk( SurfaceManager        *manager,
                             int                    length,
                             int                    pitch );
 
+static void   free_list_insert( SurfaceManager *manager,
+                                Chunk          *chunk );
+
+static void   free_list_remove( SurfaceManager *manager,
+                                Chunk          *chunk );
+
+static Chunk *free_list_find  ( SurfaceManager *manager,
+                                int             length );
+
 
 DFBResult
 dfb_surfacemanager_create( CoreDFB         *core,
@@ -108,6 +117,8 @@ dfb_surfacemanager_create( CoreDFB         *core,
 
      D_MAGIC_SET( chunk, Chunk );
 
+     free_list_insert( manager, chunk );
+
      D_DEBUG_AT( SurfMan, "  -> %p\n", manager );
 
      *ret_manager = manager;
@@ -200,30 +211,18 @@ DFBResult dfb_surfacemanager_allocate( CoreDFB                *core,
                manager->length = length;
                manager->avail  = length - manager->offset;
 
-               c->length = length - manager->offset;
-          }
-     }
-
-     while (c) {
-          D_MAGIC_ASSERT( c, Chunk );
-
-          if (!c->buffer && c->length >= length) {
-               /* NULL means check only. */
-               if (!ret_chunk)
-                    return DFB_OK;
+               if (!c->buffer)
+                    free_list_remove( manager, c );
 
-               /* found a nice place to chill */
-               if (!best_free  ||  best_free->length > c->length)
-                    /* first found or better one? */
-                    best_free = c;
+               c->length = length - manager->offset;
 
-               if (c->length == length)
-                    break;
+               if (!c->buffer)
+                    free_list_insert( manager, c );
           }
-
-          c = c->next;
      }
 
+     best_free = free_list_find( manager, length );
+
      /* if we found a place */
      if (best_free) {
           D_DEBUG_AT( SurfMan, "  -> found free (%d)\n", best_free->length );
@@ -235,7 +234,17 @@ DFBResult dfb_surfacemanager_allocate( CoreDFB                *core,
           return DFB_OK;
      }
 
-     D_DEBUG_AT( SurfMan, "  -> failed (%d/%d avail)\n", manager->avail, manager->length );
+#if D_DEBUG_ENABLED
+     if (direct_log_domain_check( &SurfMan )) {
+          SurfaceManagerStats stats;
+
+          dfb_surfacemanager_get_stats( manager, &stats );
+
+          D_DEBUG_AT( SurfMan, "  -> failed (%d/%d avail, %d free in %d chunks, largest %d, %d%% fragmented)\n",
+                      manager->avail, stats.length, stats.free, stats.free_chunks,
+                      stats.largest_free, stats.fragmentation );
+     }
+#endif
 
      /* no luck */
      return DFB_NOVIDEOMEMORY;
@@ -461,8 +470,143 @@ DFBResult dfb_surfacemanager_deallocate( SurfaceManager *manager,
      return DFB_OK;
 }
 
+void
+dfb_surfacemanager_get_stats( SurfaceManager      *manager,
+                              SurfaceManagerStats *ret_stats )
+{
+     int    largest = 0;
+     Chunk *c;
+
+     D_MAGIC_ASSERT( manager, SurfaceManager );
+     D_ASSERT( ret_stats != NULL );
+
+     /* The largest free chunk is in the highest non-empty list. */
+     if (manager->free_mask) {
+          c = manager->free_lists[63 - __builtin_clzll( manager->free_mask )];
+
+          while (c) {
+               D_MAGIC_ASSERT( c, Chunk );
+
+               if (c->length > largest)
+                    largest = c->length;
+
+               c = c->free_next;
+          }
+     }
+
+     ret_stats->length        = manager->length;
+     ret_stats->free          = manager->free_bytes;
+     ret_stats->free_chunks   = manager->free_chunks;
+     ret_stats->used_chunks   = manager->used_chunks;
+     ret_stats->largest_free  = largest;
+     ret_stats->fragmentation = manager->free_bytes ? (manager->free_bytes - largest) * 100LL / manager->free_bytes : 0;
+}
+
 /** internal functions NOT locking the surfacemanager **/
 
+/*
+ * Size class of a chunk, four classes per power of two, all below 4k in the first one.
+ */
+static __inline__ int
+free_list_index( int length )
+{
+     int shift, index;
+
+     if (length < 4096)
+          return 0;
+
+     shift = 31 - __builtin_clz( length );
+     index = (shift - 12) * 4 + ((length >> (shift - 2)) & 3) + 1;
+
+     return (index < SURFMAN_FREE_LISTS) ? index : SURFMAN_FREE_LISTS - 1;
+}
+
+static void
+free_list_insert( SurfaceManager *manager, Chunk *chunk )
+{
+     int index = free_list_index( chunk->length );
+
+     D_MAGIC_ASSERT( chunk, Chunk );
+     D_ASSERT( chunk->buffer == NULL );
+
+     chunk->free_prev = NULL;
+     chunk->free_next = manager->free_lists[index];
+
+     if (chunk->free_next)
+          chunk->free_next->free_prev = chunk;
+
+     manager->free_lists[index] = chunk;
+     manager->free_mask        |= 1ULL << index;
+
+     manager->free_chunks++;
+     manager->free_bytes += chunk->length;
+}
+
+static void
+free_list_remove( SurfaceManager *manager, Chunk *chunk )
+{
+     int index = free_list_index( chunk->length );
+
+     D_MAGIC_ASSERT( chunk, Chunk );
+     D_ASSERT( chunk->buffer == NULL );
+
+     if (chunk->free_prev)
+          chunk->free_prev->free_next = chunk->free_next;
+     else {
+          D_ASSERT( manager->free_lists[index] == chunk );
+
+          manager->free_lists[index] = chunk->free_next;
+
+          if (!chunk->free_next)
+               manager->free_mask &= ~(1ULL << index);
+     }
+
+     if (chunk->free_next)
+          chunk->free_next->free_prev = chunk->free_prev;
+
+     chunk->free_prev = NULL;
+     chunk->free_next = NULL;
+
+     manager->free_chunks--;
+     manager->free_bytes -= chunk->length;
+}
+
+/*
+ * Best fit within the size class of the request, otherwise the first chunk of the next larger class,
+ * which always fits.
+ */
+static Chunk *
+free_list_find( SurfaceManager *manager, int length )
+{
+     int    index = free_list_index( length );
+     u64    mask;
+     Chunk *c;
+     Chunk *best = NULL;
+
+     for (c = manager->free_lists[index]; c; c = c->free_next) {
+          D_MAGIC_ASSERT( c, Chunk );
+
+          if (c->length >= length && (!best || best->length > c->length)) {
+               best = c;
+
+               if (c->length == length)
+                    break;
+          }
+     }
+
+     if (best)
+          return best;
+
+     if (index == SURFMAN_FREE_LISTS - 1)
+          return NULL;
+
+     mask = manager->free_mask & ~((2ULL << index) - 1);
+     if (!mask)
+          return NULL;
+
+     return manager->free_lists[__builtin_ctzll( mask )];
+}
+
 static Chunk *
 split_chunk( SurfaceManager *manager, Chunk *c, int length )
 {
@@ -518,9 +662,13 @@ free_chunk( SurfaceManager *manager, Chunk *chunk )
 
      manager->min_toleration--;
 
+     manager->used_chunks--;
+
      if (chunk->prev  &&  !chunk->prev->buffer) {
           Chunk *prev = chunk->prev;
 
+          free_list_remove( manager, prev );
+
           //D_DEBUG_AT( SurfMan, "  -> merging with previous chunk at %d\n", prev->offset );
 
           prev->length += chunk->length;
@@ -540,6 +688,8 @@ free_chunk( SurfaceManager *manager, Chunk *chunk )
      if (chunk->next  &&  !chunk->next->buffer) {
           Chunk *next = chunk->next;
 
+          free_list_remove( manager, next );
+
           //D_DEBUG_AT( SurfMan, "  -> merging with next chunk at %d\n", next->offset );
 
           chunk->length += next->length;
@@ -553,12 +703,16 @@ free_chunk( SurfaceManager *manager, Chunk *chunk )
           SHFREE( manager->shmpool, next );
      }
 
+     free_list_insert( manager, chunk );
+
      return chunk;
 }
 
 static Chunk *
 occupy_chunk( SurfaceManager *manager, Chunk *chunk, CoreSurfaceAllocation *allocation, int length, int pitch )
 {
+     Chunk *occupied;
+
      D_MAGIC_ASSERT( manager, SurfaceManager );
      D_MAGIC_ASSERT( chunk, Chunk );
      D_MAGIC_ASSERT( allocation, CoreSurfaceAllocation );
@@ -567,9 +721,19 @@ occupy_chunk( SurfaceManager *manager, Chunk *chunk, CoreSurfaceAllocation *allo
      if (allocation->buffer->policy == CSP_VIDEOONLY)
           manager->avail -= length;
 
-     chunk = split_chunk( manager, chunk, length );
-     if (!chunk)
+     free_list_remove( manager, chunk );
+
+     occupied = split_chunk( manager, chunk, length );
+     if (!occupied) {
+          free_list_insert( manager, chunk );
           return NULL;
+     }
+
+     /* Remaining free part at the beginning */
+     if (occupied != chunk)
+          free_list_insert( manager, chunk );
+
+     chunk = occupied;
 
      D_DEBUG_AT( SurfMan, "Allocating %d bytes at offset %d.\n", chunk->length, chunk->offset );
 
@@ -578,6 +742,7 @@ occupy_chunk( SurfaceManager *manager, Chunk *chunk, CoreSurfaceAllocation *allo
      chunk->pitch      = pitch;
 
      manager->min_toleration++;
+     manager->used_chunks++;
 
      return chunk;
 }
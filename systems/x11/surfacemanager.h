@@ -40,6 +40,11 @@
 typedef struct _SurfaceManager SurfaceManager;
 typedef struct _Chunk          Chunk;
 
+/*
+ * number of segregated free lists, four per power of two from 4k on
+ */
+#define SURFMAN_FREE_LISTS  64
+
 /*
  * initially there is one big free chunk,
  * chunks are splitted into a free and an occupied chunk if memory is allocated,
@@ -61,6 +66,9 @@ struct _Chunk {
      int                  tolerations; /* number of times this chunk was scanned
                                           occupied, resetted in assure_video */
 
+     Chunk               *free_prev;   /* free list of the size class, if the chunk is free */
+     Chunk               *free_next;
+
      Chunk               *prev;
      Chunk               *next;
 };
@@ -79,8 +87,24 @@ struct _SurfaceManager {
      int                  min_toleration;
      
      bool                 suspended;
+
+     Chunk               *free_lists[SURFMAN_FREE_LISTS];    /* free chunks by size class */
+     u64                  free_mask;                         /* bit set for each non-empty free list */
+
+     int                  free_chunks;
+     int                  free_bytes;
+     int                  used_chunks;
 };
 
+typedef struct {
+     int                  length;         /* length of the heap in bytes */
+     int                  free;           /* free bytes */
+     int                  free_chunks;
+     int                  used_chunks;
+     int                  largest_free;   /* length of the largest free chunk */
+     int                  fragmentation;  /* percentage of free bytes outside of the largest free chunk */
+} SurfaceManagerStats;
+
 
 DFBResult dfb_surfacemanager_create ( CoreDFB             *core,
                                       unsigned int         length,
@@ -110,5 +134,8 @@ DFBResult dfb_surfacemanager_displace( CoreDFB           *core,
 DFBResult dfb_surfacemanager_deallocate( SurfaceManager *manager,
                                          Chunk          *chunk );
 
+void      dfb_surfacemanager_get_stats( SurfaceManager      *manager,
+                                        SurfaceManagerStats *ret_stats );
+
 #endif
 
@@ -0,0 +1,575 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <direct/clock.h>
+#include <direct/messages.h>
+
+#include <core/core.h>
+#include <core/state.h>
+#include <core/surface.h>
+
+#include <gfx/generic/generic.h>
+
+#include <directfb.h>
+#include <directfb_util.h>
+
+
+#define MAX_SIZES     8
+
+typedef enum {
+     KERNEL_FILL,
+     KERNEL_BLIT,
+     KERNEL_STRETCH
+} KernelType;
+
+typedef struct {
+     const char              *name;
+     KernelType               type;
+     DFBSurfaceDrawingFlags   drawingflags;
+     DFBSurfaceBlittingFlags  blittingflags;
+     DFBSurfaceBlendFunction  src_blend;
+     DFBSurfaceBlendFunction  dst_blend;
+     DFBSurfaceRenderOptions  render_options;
+} KernelMode;
+
+typedef struct {
+     char   name[128];
+     double mpixels;
+} BaselineEntry;
+
+static const KernelMode modes[] = {
+     { "fill",                    KERNEL_FILL,    DSDRAW_NOFX,  DSBLIT_NOFX, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "fill_blend",              KERNEL_FILL,    DSDRAW_BLEND, DSBLIT_NOFX, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "copy",                    KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_NOFX, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "alphachannel",            KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_BLEND_ALPHACHANNEL, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "alphachannel_premul",     KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_BLEND_ALPHACHANNEL, DSBF_ONE, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "coloralpha",              KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_BLEND_COLORALPHA, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "colorize",                KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_COLORIZE, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "alphachannel_colorize",   KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_COLORIZE, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "src_colorkey",            KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_SRC_COLORKEY, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "src_premultiply",         KERNEL_BLIT,    DSDRAW_NOFX,  DSBLIT_SRC_PREMULTIPLY, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "stretch",                 KERNEL_STRETCH, DSDRAW_NOFX,  DSBLIT_NOFX, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_NONE },
+     { "stretch_smooth",          KERNEL_STRETCH, DSDRAW_NOFX,  DSBLIT_NOFX, DSBF_SRCALPHA, DSBF_INVSRCALPHA, DSRO_SMOOTH_UPSCALE | DSRO_SMOOTH_DOWNSCALE },
+};
+
+static const DFBSurfacePixelFormat formats[] = {
+     DSPF_ARGB,
+     DSPF_ABGR,
+     DSPF_RGB32,
+     DSPF_RGB24,
+     DSPF_RGB16,
+     DSPF_ARGB1555,
+     DSPF_ARGB4444,
+     DSPF_A8,
+     DSPF_YUY2,
+     DSPF_NV12
+};
+
+static int            m_duration   = 100;
+static int            m_num_sizes  = 3;
+static DFBDimension   m_sizes[MAX_SIZES] = { { 16, 16 }, { 64, 64 }, { 512, 512 } };
+static const char    *m_filter     = NULL;
+static const char    *m_output     = NULL;
+static const char    *m_baseline   = NULL;
+static double         m_tolerance  = 10.0;
+
+static BaselineEntry *m_base       = NULL;
+static int            m_num_base   = 0;
+static int            m_max_base   = 0;
+
+/**********************************************************************************************************************/
+
+static int
+print_usage( const char *prg )
+{
+     fprintf (stderr, "\n");
+     fprintf (stderr, "== DirectFB Genefx Benchmark (version %s) ==\n", DIRECTFB_VERSION);
+     fprintf (stderr, "\n");
+     fprintf (stderr, "Runs all Genefx pipelines (format pairs x flags x sizes) directly without a display\n");
+     fprintf (stderr, "and reports the throughput of each kernel in Mpixel/s.\n");
+     fprintf (stderr, "\n");
+     fprintf (stderr, "Usage: %s [options]\n", prg);
+     fprintf (stderr, "\n");
+     fprintf (stderr, "Options:\n");
+     fprintf (stderr, "  -h, --help                        Show this help message\n");
+     fprintf (stderr, "  -v, --version                     Print version information\n");
+     fprintf (stderr, "  -d, --duration  <ms>              Duration of each kernel (default: 100)\n");
+     fprintf (stderr, "  -s, --sizes     <w>x<h>[,...]     Rectangle sizes (default: 16x16,64x64,512x512)\n");
+     fprintf (stderr, "  -f, --filter    <string>          Only run kernels whose name contains the string\n");
+     fprintf (stderr, "  -o, --output    <file>            Write the results to a file (one 'name mpixels' per line)\n");
+     fprintf (stderr, "  -b, --baseline  <file>            Compare with results written by --output before\n");
+     fprintf (stderr, "  -t, --tolerance <percent>         Slowdown reported as regression (default: 10)\n");
+     fprintf (stderr, "\n");
+     fprintf (stderr, "The exit code is non-zero if a kernel regressed compared to the baseline.\n");
+
+     return -1;
+}
+
+static bool
+parse_sizes( const char *arg )
+{
+     m_num_sizes = 0;
+
+     while (*arg) {
+          int w, h;
+
+          if (m_num_sizes == MAX_SIZES || sscanf( arg, "%dx%d", &w, &h ) != 2 || w < 1 || h < 1)
+               return false;
+
+          m_sizes[m_num_sizes].w = w;
+          m_sizes[m_num_sizes].h = h;
+
+          m_num_sizes++;
+
+          arg = strchr( arg, ',' );
+          if (!arg)
+               break;
+
+          arg++;
+     }
+
+     return m_num_sizes > 0;
+}
+
+static bool
+load_baseline( const char *filename )
+{
+     FILE *file;
+     char  line[256];
+
+     file = fopen( filename, "r" );
+     if (!file) {
+          D_PERROR( "CoreTest/GenefxBench: Could not open baseline '%s'!\n", filename );
+          return false;
+     }
+
+     while (fgets( line, sizeof(line), file )) {
+          BaselineEntry *entry;
+
+          if (line[0] == '#')
+               continue;
+
+          if (m_num_base == m_max_base) {
+               int            max  = m_max_base ? m_max_base * 2 : 256;
+               BaselineEntry *base = realloc( m_base, max * sizeof(BaselineEntry) );
+
+               if (!base) {
+                    D_OOM();
+                    fclose( file );
+                    return false;
+               }
+
+               m_base     = base;
+               m_max_base = max;
+          }
+
+          entry = &m_base[m_num_base];
+
+          if (sscanf( line, "%127s %lf", entry->name, &entry->mpixels ) == 2)
+               m_num_base++;
+     }
+
+     fclose( file );
+
+     return true;
+}
+
+static const BaselineEntry *
+lookup_baseline( const char *name )
+{
+     int i;
+
+     for (i=0; i<m_num_base; i++) {
+          if (!strcmp( m_base[i].name, name ))
+               return &m_base[i];
+     }
+
+     return NULL;
+}
+
+/**********************************************************************************************************************/
+
+static void *
+alloc_buffer( DFBSurfacePixelFormat format, int width, int height, int *ret_pitch )
+{
+     int  i;
+     int  pitch = (DFB_BYTES_PER_LINE( format, width ) + 15) & ~15;
+     int  size  = pitch * DFB_PLANE_MULTIPLY( format, height );
+     u8  *buffer;
+
+     buffer = malloc( size );
+     if (!buffer)
+          return NULL;
+
+     /* Random content for a realistic mix of alpha values and colors */
+     for (i=0; i<size; i++)
+          buffer[i] = rand();
+
+     *ret_pitch = pitch;
+
+     return buffer;
+}
+
+static void
+setup_surface( CoreSurface *surface, DFBSurfacePixelFormat format, int width, int height )
+{
+     memset( surface, 0, sizeof(CoreSurface) );
+
+     surface->num_buffers = 1;
+     surface->config.size.w = width;
+     surface->config.size.h = height;
+     surface->config.format = format;
+     surface->config.caps   = DSCAPS_NONE;
+}
+
+/*
+ * Runs one kernel for the configured duration, the state is already set up as the GenefxTask would do.
+ * Returns the throughput in Mpixel/s, zero if Genefx does not support the combination.
+ */
+static double
+run_kernel( CardState *state, const KernelMode *mode, int width, int height, int *ret_funcs )
+{
+     long long          start, now;
+     unsigned long long pixels = 0;
+     DFBAccelerationMask accel;
+
+     switch (mode->type) {
+          case KERNEL_FILL:
+               accel = DFXL_FILLRECTANGLE;
+               break;
+
+          case KERNEL_STRETCH:
+               accel = DFXL_STRETCHBLIT;
+               break;
+
+          default:
+               accel = DFXL_BLIT;
+               break;
+     }
+
+     if (!gAcquireSetup( state, accel ))
+          return 0;
+
+     for (*ret_funcs = 0; state->gfxs->funcs[*ret_funcs]; (*ret_funcs)++);
+
+     start = direct_clock_get_abs_micros();
+
+     do {
+          DFBRectangle srect = { 0, 0, width, height };
+          DFBRectangle drect = { 0, 0, width, height };
+
+          switch (mode->type) {
+               case KERNEL_FILL:
+                    gFillRectangle( state, &drect );
+                    break;
+
+               case KERNEL_BLIT:
+                    gBlit( state, &srect, 0, 0 );
+                    break;
+
+               case KERNEL_STRETCH:
+                    srect.w = (width  + 1) / 2;
+                    srect.h = (height + 1) / 2;
+
+                    gStretchBlit( state, &srect, &drect );
+                    break;
+          }
+
+          pixels += width * height;
+
+          now = direct_clock_get_abs_micros();
+     } while (now - start < m_duration * 1000LL);
+
+     return pixels / (double)(now - start);
+}
+
+/**********************************************************************************************************************/
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult    ret;
+     int          i, m, s, d, z;
+     int          max_w = 0;
+     int          max_h = 0;
+     int          ran   = 0;
+     int          regressions = 0;
+     bool         headless = true;
+     IDirectFB   *dfb;
+     CoreDFB     *core;
+     CoreSurface  dest;
+     CoreSurface  source;
+     CardState    state;
+     void        *dst_buffers[D_ARRAY_SIZE(formats)];
+     void        *src_buffers[D_ARRAY_SIZE(formats)];
+     int          dst_pitches[D_ARRAY_SIZE(formats)];
+     int          src_pitches[D_ARRAY_SIZE(formats)];
+     FILE        *output = NULL;
+
+     /* Parse arguments, DirectFB options are handled by DirectFBInit(). */
+     for (i=1; i<argc; i++) {
+          const char *arg = argv[i];
+
+          if (strncmp( arg, "--dfb:", 6 ) == 0) {
+               if (strstr( arg, "system=" ))
+                    headless = false;
+
+               continue;
+          }
+
+          if (strcmp( arg, "-h" ) == 0 || strcmp (arg, "--help") == 0)
+               return print_usage( argv[0] );
+          else if (strcmp (arg, "-v") == 0 || strcmp (arg, "--version") == 0) {
+               fprintf (stderr, "coretest_genefx_bench version %s\n", DIRECTFB_VERSION);
+               return false;
+          }
+          else if (strcmp (arg, "-d") == 0 || strcmp (arg, "--duration") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               if (sscanf( argv[i], "%d", &m_duration ) != 1 || m_duration < 1)
+                    return print_usage( argv[0] );
+          }
+          else if (strcmp (arg, "-s") == 0 || strcmp (arg, "--sizes") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               if (!parse_sizes( argv[i] ))
+                    return print_usage( argv[0] );
+          }
+          else if (strcmp (arg, "-f") == 0 || strcmp (arg, "--filter") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               m_filter = argv[i];
+          }
+          else if (strcmp (arg, "-o") == 0 || strcmp (arg, "--output") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               m_output = argv[i];
+          }
+          else if (strcmp (arg, "-b") == 0 || strcmp (arg, "--baseline") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               m_baseline = argv[i];
+          }
+          else if (strcmp (arg, "-t") == 0 || strcmp (arg, "--tolerance") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               if (sscanf( argv[i], "%lf", &m_tolerance ) != 1 || m_tolerance < 0)
+                    return print_usage( argv[0] );
+          }
+          else
+               return print_usage( argv[0] );
+     }
+
+     if (m_baseline && !load_baseline( m_baseline ))
+          return -1;
+
+     /* Initialize DirectFB. */
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/GenefxBench: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     /* Genefx is driven directly, no need for a display. */
+     if (headless)
+          DirectFBSetOption( "system", "dummy" );
+
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/GenefxBench: DirectFBCreate() failed!\n" );
+          return ret;
+     }
+
+     dfb_core_create( &core );
+
+     for (s=0; s<m_num_sizes; s++) {
+          if (max_w < m_sizes[s].w)
+               max_w = m_sizes[s].w;
+
+          if (max_h < m_sizes[s].h)
+               max_h = m_sizes[s].h;
+     }
+
+     srand( 1 );
+
+     for (i=0; i<D_ARRAY_SIZE(formats); i++) {
+          dst_buffers[i] = alloc_buffer( formats[i], max_w, max_h, &dst_pitches[i] );
+          src_buffers[i] = alloc_buffer( formats[i], max_w, max_h, &src_pitches[i] );
+
+          if (!dst_buffers[i] || !src_buffers[i]) {
+               D_OOM();
+               return -1;
+          }
+     }
+
+     if (m_output) {
+          output = fopen( m_output, "w" );
+          if (!output) {
+               D_PERROR( "CoreTest/GenefxBench: Could not open output '%s'!\n", m_output );
+               return -1;
+          }
+
+          fprintf( output, "# coretest_genefx_bench %s, %d ms per kernel\n", DIRECTFB_VERSION, m_duration );
+     }
+
+     /* Initialize state like the GenefxTask does. */
+     dfb_state_init( &state, core );
+
+     state.destination = &dest;
+     state.source      = &source;
+
+     state.color.a = 0xc0;
+     state.color.r = 0x80;
+     state.color.g = 0x40;
+     state.color.b = 0xff;
+
+     state.src_colorkey = 0x12345678;
+
+     printf( "\n%-60s %10s %6s %10s\n", "kernel", "Mpixel/s", "funcs", "baseline" );
+
+     for (m=0; m<D_ARRAY_SIZE(modes); m++) {
+          const KernelMode *mode = &modes[m];
+
+          for (z=0; z<D_ARRAY_SIZE(formats); z++) {
+               for (d=0; d<D_ARRAY_SIZE(formats); d++) {
+                    /* Fills have no source format */
+                    if (mode->type == KERNEL_FILL && z > 0)
+                         break;
+
+                    for (s=0; s<m_num_sizes; s++) {
+                         char                 name[128];
+                         double               mpixels;
+                         int                  funcs = 0;
+                         const BaselineEntry *base;
+
+                         if (mode->type == KERNEL_FILL)
+                              snprintf( name, sizeof(name), "%s:%s:%dx%d", mode->name,
+                                        dfb_pixelformat_name( formats[d] ), m_sizes[s].w, m_sizes[s].h );
+                         else
+                              snprintf( name, sizeof(name), "%s:%s:%s:%dx%d", mode->name,
+                                        dfb_pixelformat_name( formats[z] ), dfb_pixelformat_name( formats[d] ),
+                                        m_sizes[s].w, m_sizes[s].h );
+
+                         if (m_filter && !strstr( name, m_filter ))
+                              continue;
+
+                         setup_surface( &dest, formats[d], max_w, max_h );
+                         setup_surface( &source, formats[z], max_w, max_h );
+
+                         state.dst.addr  = dst_buffers[d];
+                         state.dst.pitch = dst_pitches[d];
+                         state.src.addr  = src_buffers[z];
+                         state.src.pitch = src_pitches[z];
+
+                         state.clip.x1 = 0;
+                         state.clip.y1 = 0;
+                         state.clip.x2 = m_sizes[s].w - 1;
+                         state.clip.y2 = m_sizes[s].h - 1;
+
+                         state.drawingflags   = mode->drawingflags;
+                         state.blittingflags  = mode->blittingflags;
+                         state.src_blend      = mode->src_blend;
+                         state.dst_blend      = mode->dst_blend;
+                         state.render_options = mode->render_options;
+
+                         mpixels = run_kernel( &state, mode, m_sizes[s].w, m_sizes[s].h, &funcs );
+                         if (mpixels <= 0)
+                              continue;
+
+                         ran++;
+
+                         if (output)
+                              fprintf( output, "%s %.2f\n", name, mpixels );
+
+                         base = lookup_baseline( name );
+                         if (base && base->mpixels > 0) {
+                              double change = (mpixels / base->mpixels - 1.0) * 100.0;
+                              bool   slower = change < -m_tolerance;
+
+                              printf( "%-60s %10.1f %6d %+9.1f%%%s\n", name, mpixels, funcs, change,
+                                      slower ? "  REGRESSION" : "" );
+
+                              if (slower)
+                                   regressions++;
+                         }
+                         else
+                              printf( "%-60s %10.1f %6d %10s\n", name, mpixels, funcs, "-" );
+                    }
+               }
+          }
+     }
+
+     printf( "\n%d kernels", ran );
+
+     if (m_baseline)
+          printf( ", %d regressions beyond %.1f%%", regressions, m_tolerance );
+
+     printf( "\n\n" );
+
+     if (output)
+          fclose( output );
+
+     /* Shutdown state */
+     state.destination = NULL;
+     state.source      = NULL;
+
+     dfb_state_destroy( &state );
+
+     for (i=0; i<D_ARRAY_SIZE(formats); i++) {
+          free( dst_buffers[i] );
+          free( src_buffers[i] );
+     }
+
+     free( m_base );
+
+     dfb_core_destroy( core, false );
+
+     dfb->Release( dfb );
+
+     return regressions ? 1 : 0;
+}
@@ -0,0 +1,230 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+
+#include <direct/messages.h>
+
+#include <core/core.h>
+#include <core/surface.h>
+
+#include <directfb.h>
+#include <directfb_util.h>
+
+
+static int failures;
+
+static void
+flip( CoreSurface     *surface,
+      const DFBRegion *damage,
+      int              num )
+{
+     int i;
+
+     dfb_surface_lock( surface );
+
+     for (i=0; i<num; i++)
+          dfb_surface_set_flip_damage( surface, &damage[i] );
+
+     dfb_surface_flip_buffers( surface, false );
+
+     dfb_surface_unlock( surface );
+}
+
+static void
+set_current( CoreSurface *surface )
+{
+     dfb_surface_lock( surface );
+
+     dfb_surface_set_buffer_current( surface, CSBR_BACK );
+
+     dfb_surface_unlock( surface );
+}
+
+static void
+check( CoreSurface     *surface,
+       const char      *what,
+       const DFBRegion *expected,
+       int              num_expected )
+{
+     int       i, num;
+     DFBRegion regions[CORE_SURFACE_DAMAGE_MAX];
+
+     dfb_surface_lock( surface );
+
+     num = dfb_surface_get_buffer_damage( surface, CSBR_BACK, regions );
+
+     dfb_surface_unlock( surface );
+
+     if (num == num_expected) {
+          for (i=0; i<num; i++) {
+               if (!DFB_REGION_EQUAL( regions[i], expected[i] ))
+                    break;
+          }
+
+          if (i == num) {
+               printf( "  ok    %s\n", what );
+               return;
+          }
+     }
+
+     printf( "  FAIL  %s, got %d region(s), expected %d\n", what, num, num_expected );
+
+     for (i=0; i<num; i++)
+          printf( "          %4d,%4d-%4dx%4d\n", DFB_RECTANGLE_VALS_FROM_REGION( &regions[i] ) );
+
+     failures++;
+}
+
+static void
+check_full( CoreSurface *surface,
+            const char  *what )
+{
+     DFBRegion full = DFB_REGION_INIT_FROM_DIMENSION( &surface->config.size );
+
+     check( surface, what, &full, 1 );
+}
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult          ret;
+     IDirectFB         *dfb;
+     CoreDFB           *core;
+     CoreSurface       *surface;
+     CoreSurfaceConfig  config;
+     DFBRegion          corners[2] = { {  0,  0,  9,  9 }, { 90, 90, 99, 99 } };
+     DFBRegion          middle[1]  = { { 40, 40, 59, 59 } };
+     DFBRegion          age_two[3] = { {  0,  0,  9,  9 }, { 90, 90, 99, 99 }, { 40, 40, 59, 59 } };
+
+     /* Initialize DirectFB. */
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/SurfaceDamage: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     /* Surfaces are flipped directly, no need for a display. */
+     DirectFBSetOption( "system", "dummy" );
+
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/SurfaceDamage: DirectFBCreate() failed!\n" );
+          return ret;
+     }
+
+     dfb_core_create( &core );
+
+     ret = dfb_surface_create_simple( core, 100, 100, DSPF_ARGB, DSCS_RGB, DSCAPS_TRIPLE, CSTF_NONE, 0, NULL, &surface );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/SurfaceDamage: dfb_surface_create_simple() failed!\n" );
+          goto error_surface;
+     }
+
+     /*
+      * Buffer age
+      */
+     check_full( surface, "new surface" );
+
+     flip( surface, NULL, 0 );
+
+     check_full( surface, "buffer never shown" );
+
+     set_current( surface );
+
+     check( surface, "buffer set current", NULL, 0 );
+
+     flip( surface, corners, 2 );
+     flip( surface, middle, 1 );
+
+     /* The back buffer was the front buffer two flips ago, the corners stay separate regions. */
+     check( surface, "buffer age two", age_two, 3 );
+
+     set_current( surface );
+
+     check( surface, "buffer set current again", NULL, 0 );
+
+     /*
+      * Reset by resizing, within the allocated buffers and with new ones
+      */
+     config.flags  = CSCONF_SIZE;
+     config.size.w = 60;
+     config.size.h = 60;
+
+     ret = dfb_surface_reconfig( surface, &config );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/SurfaceDamage: dfb_surface_reconfig( 60x60 ) failed!\n" );
+          goto error;
+     }
+
+     check_full( surface, "shrunk surface" );
+
+     set_current( surface );
+     flip( surface, corners, 1 );
+
+     config.size.w = 120;
+     config.size.h = 90;
+
+     ret = dfb_surface_reconfig( surface, &config );
+     if (ret) {
+          D_DERROR( ret, "CoreTest/SurfaceDamage: dfb_surface_reconfig( 120x90 ) failed!\n" );
+          goto error;
+     }
+
+     check_full( surface, "enlarged surface" );
+
+     flip( surface, NULL, 0 );
+     set_current( surface );
+
+     check( surface, "buffer set current after resize", NULL, 0 );
+
+     printf( "\n%d failure(s)\n", failures );
+
+     ret = failures ? DFB_FAILURE : DFB_OK;
+
+error:
+     dfb_surface_unref( surface );
+
+error_surface:
+     dfb_core_destroy( core, false );
+
+     /* Shutdown DirectFB. */
+     dfb->Release( dfb );
+
+     return ret;
+}
@@ -0,0 +1,299 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <direct/clock.h>
+#include <direct/messages.h>
+
+#include <directfb.h>
+#include <directfb_util.h>
+
+
+static int m_cores    = 0;
+static int m_width    = 1920;
+static int m_height   = 1080;
+static int m_duration = 2000;
+
+/**********************************************************************************************************************/
+
+static int
+print_usage( const char *prg )
+{
+     fprintf (stderr, "\n");
+     fprintf (stderr, "== DirectFB Genefx Scaling Test (version %s) ==\n", DIRECTFB_VERSION);
+     fprintf (stderr, "\n");
+     fprintf (stderr, "Runs the same workload with 1, 2, 4... software cores and reports the throughput.\n");
+     fprintf (stderr, "Each run happens in a child process, DirectFB options are passed to all of them,\n");
+     fprintf (stderr, "e.g. --dfb:system=dummy for headless rendering.\n");
+     fprintf (stderr, "\n");
+     fprintf (stderr, "Usage: %s [options]\n", prg);
+     fprintf (stderr, "\n");
+     fprintf (stderr, "Options:\n");
+     fprintf (stderr, "  -h, --help                        Show this help message\n");
+     fprintf (stderr, "  -v, --version                     Print version information\n");
+     fprintf (stderr, "  -c, --cores     <num>             Maximum number of cores (default: online CPUs)\n");
+     fprintf (stderr, "  -s, --size      <width>x<height>  Size of the destination (default: 1920x1080)\n");
+     fprintf (stderr, "  -d, --duration  <ms>              Duration of each run (default: 2000)\n");
+
+     return -1;
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Renders frames with an uneven load, the upper part of the destination gets far more
+ * blended blits than the lower part, and returns the number of Mpixels per second.
+ */
+static double
+run_workload( IDirectFB *dfb )
+{
+     DFBResult              ret;
+     int                    i, x, y;
+     long long              start, now;
+     unsigned long long     pixels = 0;
+     DFBSurfaceDescription  desc;
+     IDirectFBSurface      *dest;
+     IDirectFBSurface      *source;
+
+     desc.flags       = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+     desc.width       = m_width;
+     desc.height      = m_height;
+     desc.pixelformat = DSPF_ARGB;
+
+     ret = dfb->CreateSurface( dfb, &desc, &dest );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/GenefxScaling: IDirectFB::CreateSurface( %dx%d ) failed!\n", m_width, m_height );
+          return 0;
+     }
+
+     desc.width  = 128;
+     desc.height = 128;
+
+     ret = dfb->CreateSurface( dfb, &desc, &source );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/GenefxScaling: IDirectFB::CreateSurface( 128x128 ) failed!\n" );
+          dest->Release( dest );
+          return 0;
+     }
+
+     /* Source with an alpha gradient */
+     for (i=0; i<128; i++) {
+          source->SetColor( source, 0x20 + i, 0xff - i, i * 2, i * 2 );
+          source->FillRectangle( source, 0, i, 128, 1 );
+     }
+
+     dest->SetBlittingFlags( dest, DSBLIT_BLEND_ALPHACHANNEL );
+
+     dfb->WaitIdle( dfb );
+
+     start = direct_clock_get_abs_millis();
+
+     do {
+          dest->SetColor( dest, 0x30, 0x40, 0x50, 0xff );
+          dest->FillRectangle( dest, 0, 0, m_width, m_height );
+
+          pixels += m_width * m_height;
+
+          for (y=0; y<m_height / 4; y+=16) {
+               for (x=0; x<m_width; x+=32) {
+                    dest->Blit( dest, source, NULL, x, y );
+
+                    pixels += 128 * 128;
+               }
+          }
+
+          dest->Flip( dest, NULL, DSFLIP_NONE );
+
+          dfb->WaitIdle( dfb );
+
+          now = direct_clock_get_abs_millis();
+     } while (now - start < m_duration);
+
+     source->Release( source );
+     dest->Release( dest );
+
+     return pixels / ((now - start) * 1000.0);
+}
+
+static int
+run_child( int argc, char *argv[], int cores, int fd )
+{
+     DFBResult  ret;
+     IDirectFB *dfb;
+     char       buf[16];
+     double     mpixels;
+
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/GenefxScaling: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     snprintf( buf, sizeof(buf), "%d", cores );
+
+     DirectFBSetOption( "task-manager", NULL );
+     DirectFBSetOption( "software-cores", buf );
+
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/GenefxScaling: DirectFBCreate() failed!\n" );
+          return ret;
+     }
+
+     mpixels = run_workload( dfb );
+
+     if (write( fd, &mpixels, sizeof(mpixels) ) != sizeof(mpixels))
+          D_PERROR( "DFBTest/GenefxScaling: write() failed!\n" );
+
+     dfb->Release( dfb );
+
+     return mpixels > 0 ? 0 : -1;
+}
+
+/**********************************************************************************************************************/
+
+int
+main( int argc, char *argv[] )
+{
+     int    i, cores;
+     double base = 0;
+
+     /* Parse arguments, DirectFB options are handled by the children. */
+     for (i=1; i<argc; i++) {
+          const char *arg = argv[i];
+
+          if (strncmp( arg, "--dfb:", 6 ) == 0)
+               continue;
+
+          if (strcmp( arg, "-h" ) == 0 || strcmp (arg, "--help") == 0)
+               return print_usage( argv[0] );
+          else if (strcmp (arg, "-v") == 0 || strcmp (arg, "--version") == 0) {
+               fprintf (stderr, "dfbtest_genefx_scaling version %s\n", DIRECTFB_VERSION);
+               return false;
+          }
+          else if (strcmp (arg, "-c") == 0 || strcmp (arg, "--cores") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               if (sscanf( argv[i], "%d", &m_cores ) != 1 || m_cores < 1)
+                    return print_usage( argv[0] );
+          }
+          else if (strcmp (arg, "-s") == 0 || strcmp (arg, "--size") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               if (sscanf( argv[i], "%dx%d", &m_width, &m_height ) != 2 || m_width < 128 || m_height < 128)
+                    return print_usage( argv[0] );
+          }
+          else if (strcmp (arg, "-d") == 0 || strcmp (arg, "--duration") == 0) {
+               if (++i == argc)
+                    return print_usage( argv[0] );
+
+               if (sscanf( argv[i], "%d", &m_duration ) != 1 || m_duration < 1)
+                    return print_usage( argv[0] );
+          }
+          else
+               return print_usage( argv[0] );
+     }
+
+     if (!m_cores) {
+          m_cores = sysconf( _SC_NPROCESSORS_ONLN );
+
+          if (m_cores < 1)
+               m_cores = 1;
+     }
+
+     printf( "\nGenefx scaling, %dx%d ARGB, %d ms per run\n\n", m_width, m_height, m_duration );
+     printf( " cores    Mpixel/s   speedup   efficiency\n" );
+
+     /* 1, 2, 4... and finally the maximum */
+     for (cores=1; cores<=m_cores; cores = (cores < m_cores && cores * 2 > m_cores) ? m_cores : cores * 2) {
+          int    fds[2];
+          int    status;
+          pid_t  pid;
+          double mpixels = 0;
+
+          if (pipe( fds )) {
+               D_PERROR( "DFBTest/GenefxScaling: pipe() failed!\n" );
+               return -1;
+          }
+
+          fflush( stdout );
+
+          pid = fork();
+          if (pid < 0) {
+               D_PERROR( "DFBTest/GenefxScaling: fork() failed!\n" );
+               return -1;
+          }
+
+          if (pid == 0) {
+               close( fds[0] );
+
+               _exit( run_child( argc, argv, cores, fds[1] ) ? 1 : 0 );
+          }
+
+          close( fds[1] );
+
+          if (read( fds[0], &mpixels, sizeof(mpixels) ) != sizeof(mpixels))
+               mpixels = 0;
+
+          close( fds[0] );
+
+          waitpid( pid, &status, 0 );
+
+          if (mpixels <= 0) {
+               fprintf( stderr, "DFBTest/GenefxScaling: Run with %d cores failed!\n", cores );
+               return -1;
+          }
+
+          if (cores == 1)
+               base = mpixels;
+
+          printf( " %5d  %10.1f   %7.2f   %9.0f%%\n", cores, mpixels, mpixels / base, mpixels / base / cores * 100.0 );
+     }
+
+     printf( "\n" );
+
+     return 0;
+}
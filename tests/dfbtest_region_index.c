@@ -0,0 +1,190 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <directfb.h>
+#include <directfb_util.h>
+
+#include <direct/mem.h>
+#include <direct/messages.h>
+
+#include <misc/region_index.h>
+
+/*
+ * Compares the results of DFBRegionIndex with a linear scan over all regions for random layouts
+ * including entries not set and entries partially or completely outside of the area.
+ */
+
+#define MAX_ENTRIES  300
+
+static DFBRegion regions[MAX_ENTRIES];
+static bool      set[MAX_ENTRIES];
+
+static int
+random_int( int min, int max )
+{
+     return min + rand() % (max - min + 1);
+}
+
+static void
+random_region( DFBRegion *region, int width, int height )
+{
+     region->x1 = random_int( -width / 4, width + width / 4 );
+     region->y1 = random_int( -height / 4, height + height / 4 );
+     region->x2 = region->x1 + random_int( 0, width / 2 );
+     region->y2 = region->y1 + random_int( 0, height / 2 );
+}
+
+static bool
+contains( const DFBRegion *region, int x, int y )
+{
+     return x >= region->x1 && x <= region->x2 && y >= region->y1 && y <= region->y2;
+}
+
+static int
+check_layout( DFBRegionIndex *index, int num, int width, int height )
+{
+     int        i, n, q, found, expected;
+     int        entries[MAX_ENTRIES];
+     const int *cell;
+
+     if (dfb_region_index_reset( index, num ) || dfb_region_index_build( index, width, height ))
+          return -1;
+
+     for (i=0; i<num; i++) {
+          set[i] = rand() % 8 != 0;
+
+          if (set[i]) {
+               random_region( &regions[i], width, height );
+
+               dfb_region_index_set( index, i, &regions[i] );
+          }
+     }
+
+     if (dfb_region_index_build( index, width, height ))
+          return -1;
+
+     for (q=0; q<200; q++) {
+          int x = random_int( -width / 4, width + width / 4 );
+          int y = random_int( -height / 4, height + height / 4 );
+
+          n = dfb_region_index_at( index, x, y, &cell );
+
+          for (i=0; i<n; i++) {
+               if (i && cell[i] <= cell[i-1]) {
+                    fprintf( stderr, "Entries at %d,%d not in ascending order!\n", x, y );
+                    return -1;
+               }
+          }
+
+          for (i=0, found=0; i<num; i++) {
+               if (!set[i] || !contains( &regions[i], x, y ))
+                    continue;
+
+               while (found < n && cell[found] < i)
+                    found++;
+
+               if (found == n || cell[found] != i) {
+                    fprintf( stderr, "Entry %d missing at %d,%d!\n", i, x, y );
+                    return -1;
+               }
+          }
+     }
+
+     for (q=0; q<200; q++) {
+          DFBRegion region;
+
+          random_region( &region, width, height );
+
+          n = dfb_region_index_query( index, &region, entries );
+
+          for (i=0, expected=0; i<num; i++) {
+               if (!set[i] || !dfb_region_region_intersects( &regions[i], &region ))
+                    continue;
+
+               if (expected == n || entries[expected] != i) {
+                    fprintf( stderr, "Entry %d missing in query of %d,%d-%d,%d!\n",
+                             i, DFB_REGION_VALS( &region ) );
+                    return -1;
+               }
+
+               expected++;
+          }
+
+          if (expected != n) {
+               fprintf( stderr, "Query of %d,%d-%d,%d returned %d entries instead of %d!\n",
+                        DFB_REGION_VALS( &region ), n, expected );
+               return -1;
+          }
+     }
+
+     return 0;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     int            i;
+     int            ret = 0;
+     DFBRegionIndex index;
+
+     srand( argc > 1 ? atoi( argv[1] ) : 1 );
+
+     dfb_region_index_init( &index, NULL );
+
+     for (i=0; i<500; i++) {
+          int width  = random_int( 0, 4096 );
+          int height = random_int( 0, 4096 );
+
+          if (check_layout( &index, random_int( 0, MAX_ENTRIES ), width, height )) {
+               fprintf( stderr, "Layout %d (%dx%d) failed.\n", i, width, height );
+               ret = 1;
+               break;
+          }
+     }
+
+     dfb_region_index_deinit( &index );
+
+     if (!ret)
+          printf( "Region index tests passed.\n" );
+
+     return ret;
+}
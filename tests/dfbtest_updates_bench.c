@@ -0,0 +1,434 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <directfb.h>
+#include <directfb_util.h>
+
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/util.h>
+
+/*
+ * Pixels repainted per frame when the updates of each frame are collected in DFBUpdates and repainted
+ * the way the window managers do, i.e. the individual regions or their bounding box.
+ *
+ * The new implementation is compared to the previous one, which combined touching or overlapping
+ * regions into their bounding box and collapsed all regions into one when running out of regions.
+ *
+ * Traces are either recorded ones read from a file or built in synthetic ones. A trace file has
+ * one update per line as "x y w h", frames are separated by empty lines.
+ */
+
+#define MAX_UPDATES  1000
+
+typedef struct {
+     DFBRegion  updates[MAX_UPDATES];
+     int        num;
+} Frame;
+
+static int         screen_w    = 1920;
+static int         screen_h    = 1080;
+static int         max_regions = 8;
+static int         num_frames  = 1000;
+static const char *trace_file;
+
+static Frame      *frames;
+static int         frames_num;
+
+/**********************************************************************************************************************/
+
+static int parse_cmdline ( int argc, char *argv[] );
+static int show_usage    ( void );
+
+/**********************************************************************************************************************/
+
+static void
+legacy_updates_add( DFBUpdates      *updates,
+                    const DFBRegion *region )
+{
+     int i;
+
+     if (updates->num_regions == 0) {
+          updates->regions[0]  = updates->bounding = *region;
+          updates->num_regions = 1;
+
+          return;
+     }
+
+     for (i=0; i<updates->num_regions; i++) {
+          if (dfb_region_region_extends( &updates->regions[i], region ) ||
+              dfb_region_region_intersects( &updates->regions[i], region ))
+          {
+               dfb_region_region_union( &updates->regions[i], region );
+               dfb_region_region_union( &updates->bounding, region );
+
+               return;
+          }
+     }
+
+     if (updates->num_regions == updates->max_regions) {
+          dfb_region_region_union( &updates->bounding, region );
+
+          updates->regions[0]  = updates->bounding;
+          updates->num_regions = 1;
+     }
+     else {
+          updates->regions[updates->num_regions++] = *region;
+
+          dfb_region_region_union( &updates->bounding, region );
+     }
+}
+
+/**********************************************************************************************************************/
+
+static Frame *
+frame_next( void )
+{
+     if (frames_num == num_frames)
+          return NULL;
+
+     frames[frames_num].num = 0;
+
+     return &frames[frames_num++];
+}
+
+static void
+frame_add( Frame *frame, int x, int y, int w, int h )
+{
+     DFBRegion clip = { 0, 0, screen_w - 1, screen_h - 1 };
+     DFBRegion region;
+
+     if (frame->num == MAX_UPDATES || w < 1 || h < 1)
+          return;
+
+     region = (DFBRegion) { x, y, x + w - 1, y + h - 1 };
+
+     if (!dfb_region_region_intersect( &region, &clip ))
+          return;
+
+     frame->updates[frame->num++] = region;
+}
+
+static int
+load_trace( const char *filename )
+{
+     FILE  *file;
+     char   line[200];
+     Frame *frame = NULL;
+
+     file = fopen( filename, "r" );
+     if (!file) {
+          D_PERROR( "DirectFB/UpdatesBench: Could not open '%s'!\n", filename );
+          return -1;
+     }
+
+     frames_num = 0;
+
+     while (fgets( line, sizeof(line), file )) {
+          int x, y, w, h;
+
+          if (sscanf( line, "%d %d %d %d", &x, &y, &w, &h ) != 4) {
+               frame = NULL;
+               continue;
+          }
+
+          if (!frame) {
+               frame = frame_next();
+               if (!frame)
+                    break;
+          }
+
+          frame_add( frame, x, y, w, h );
+     }
+
+     fclose( file );
+
+     return 0;
+}
+
+/*
+ * A clock and a cursor in opposite corners.
+ */
+static void
+trace_corners( void )
+{
+     Frame *frame;
+     int    n = 0;
+
+     frames_num = 0;
+
+     while ((frame = frame_next()) != NULL) {
+          frame_add( frame, screen_w - 120, 8, 112, 24 );
+          frame_add( frame, 16 + n % 64, screen_h - 48 - n % 32, 32, 32 );
+          frame_add( frame, 17 + n % 64, screen_h - 47 - n % 32, 32, 32 );
+
+          n++;
+     }
+}
+
+/*
+ * Text being typed into a few lines with a blinking caret and a status bar.
+ */
+static void
+trace_typing( void )
+{
+     Frame *frame;
+     int    n = 0;
+
+     frames_num = 0;
+
+     while ((frame = frame_next()) != NULL) {
+          int line   = (n / 80) % 20;
+          int column = n % 80;
+
+          frame_add( frame, 100 + column * 12, 200 + line * 24, 12, 24 );
+          frame_add( frame, 100 + (column + 1) * 12, 200 + line * 24, 2, 24 );
+
+          if (n % 10 == 0)
+               frame_add( frame, 0, screen_h - 24, screen_w, 24 );
+
+          n++;
+     }
+}
+
+/*
+ * Several windows moving around, each leaving its old and covering its new position.
+ */
+static void
+trace_windows( void )
+{
+     Frame *frame;
+     int    i;
+     int    x[6], y[6], w[6], h[6], dx[6], dy[6];
+
+     frames_num = 0;
+
+     for (i=0; i<6; i++) {
+          w[i]  = 64 + rand() % 400;
+          h[i]  = 48 + rand() % 300;
+          x[i]  = rand() % (screen_w - w[i]);
+          y[i]  = rand() % (screen_h - h[i]);
+          dx[i] = rand() % 9 - 4;
+          dy[i] = rand() % 9 - 4;
+     }
+
+     while ((frame = frame_next()) != NULL) {
+          for (i=0; i<6; i++) {
+               if (i > 2 && rand() % 4)
+                    continue;
+
+               frame_add( frame, x[i], y[i], w[i], h[i] );
+
+               x[i] += dx[i];
+               y[i] += dy[i];
+
+               if (x[i] < 0 || x[i] + w[i] > screen_w)
+                    dx[i] = -dx[i];
+
+               if (y[i] < 0 || y[i] + h[i] > screen_h)
+                    dy[i] = -dy[i];
+
+               frame_add( frame, x[i], y[i], w[i], h[i] );
+          }
+     }
+}
+
+/*
+ * Many small scattered updates, like icons or glyphs being animated.
+ */
+static void
+trace_scattered( void )
+{
+     Frame *frame;
+     int    i;
+
+     frames_num = 0;
+
+     while ((frame = frame_next()) != NULL) {
+          int num = 4 + rand() % 20;
+
+          for (i=0; i<num; i++)
+               frame_add( frame, rand() % screen_w, rand() % screen_h, 8 + rand() % 56, 8 + rand() % 56 );
+     }
+}
+
+/**********************************************************************************************************************/
+
+static void
+bench( const char *name, bool legacy )
+{
+     int           i, f;
+     long long     pixels = 0;
+     long long     rects  = 0;
+     long long     us;
+     DirectClock   clock;
+     DFBRegion     regions[max_regions];
+     DFBRectangle  repaint[max_regions];
+     DFBUpdates    updates;
+
+     dfb_updates_init( &updates, regions, max_regions );
+
+     direct_clock_start( &clock );
+
+     for (f=0; f<frames_num; f++) {
+          int num;
+
+          for (i=0; i<frames[f].num; i++) {
+               if (legacy)
+                    legacy_updates_add( &updates, &frames[f].updates[i] );
+               else
+                    dfb_updates_add( &updates, &frames[f].updates[i] );
+          }
+
+          dfb_updates_get_rectangles( &updates, repaint, &num );
+
+          for (i=0; i<num; i++)
+               pixels += repaint[i].w * repaint[i].h;
+
+          rects += num;
+
+          dfb_updates_reset( &updates );
+     }
+
+     direct_clock_stop( &clock );
+
+     dfb_updates_deinit( &updates );
+
+     us = direct_clock_diff( &clock );
+
+     D_INFO( "DirectFB/UpdatesBench: %-10s %-7s %9lld pixels/frame  %5lld.%02lld rects/frame  %6lld.%03lld us/frame\n",
+             name, legacy ? "legacy" : "updates", pixels / frames_num, rects / frames_num, rects * 100 / frames_num % 100,
+             us / frames_num, us * 1000 / frames_num % 1000 );
+}
+
+static void
+bench_trace( const char *name )
+{
+     if (!frames_num)
+          return;
+
+     bench( name, true );
+     bench( name, false );
+}
+
+int
+main( int argc, char *argv[] )
+{
+     if (parse_cmdline( argc, argv ))
+          return -1;
+
+     frames = D_MALLOC( num_frames * sizeof(Frame) );
+     if (!frames)
+          return D_OOM();
+
+     srand( 23 );
+
+     if (trace_file) {
+          if (load_trace( trace_file ))
+               return -1;
+
+          bench_trace( trace_file );
+     }
+     else {
+          trace_corners();
+          bench_trace( "corners" );
+
+          trace_typing();
+          bench_trace( "typing" );
+
+          trace_windows();
+          bench_trace( "windows" );
+
+          trace_scattered();
+          bench_trace( "scattered" );
+     }
+
+     D_FREE( frames );
+
+     return 0;
+}
+
+/**********************************************************************************************************************/
+
+static int
+parse_cmdline( int argc, char *argv[] )
+{
+     int i;
+
+     for (i=1; i<argc; i++) {
+          if (!strcmp( argv[i], "-f" ) && i + 1 < argc)
+               trace_file = argv[++i];
+          else if (!strcmp( argv[i], "-n" ) && i + 1 < argc)
+               num_frames = atoi( argv[++i] );
+          else if (!strcmp( argv[i], "-r" ) && i + 1 < argc)
+               max_regions = atoi( argv[++i] );
+          else if (!strcmp( argv[i], "-s" ) && i + 1 < argc) {
+               if (sscanf( argv[++i], "%dx%d", &screen_w, &screen_h ) != 2)
+                    return show_usage();
+          }
+          else
+               return show_usage();
+     }
+
+     if (num_frames < 1 || max_regions < 1 || screen_w < 64 || screen_h < 64)
+          return show_usage();
+
+     return 0;
+}
+
+static int
+show_usage( void )
+{
+     fprintf( stderr, "\n"
+                      "Usage:\n"
+                      "   dfbtest_updates_bench [options]\n"
+                      "\n"
+                      "Options:\n"
+                      "   -f <file>    Read update trace from file (\"x y w h\" per line, empty line ends frame)\n"
+                      "   -n <frames>  Maximum number of frames (default 1000)\n"
+                      "   -r <num>     Number of regions in DFBUpdates (default 8)\n"
+                      "   -s <w>x<h>   Screen size (default 1920x1080)\n"
+                      "\n"
+              );
+
+     return -1;
+}
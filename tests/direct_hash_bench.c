@@ -0,0 +1,351 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <direct/direct.h>
+#include <direct/hash.h>
+#include <direct/map.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/util.h>
+
+/*
+ * Throughput of DirectHash and DirectMap for sequential keys (like object IDs or glyph indices)
+ * and scattered keys (like pointers in allocation tracking).
+ *
+ * Lookups are done in random order. The churn test removes and inserts keys at a constant table size,
+ * which used to leave tombstones behind and trigger rehashing.
+ */
+
+static int  num_keys = 100000;
+static int  rounds   = 10;
+
+static int *order;
+
+/**********************************************************************************************************************/
+
+static int parse_cmdline ( int argc, char *argv[] );
+static int show_usage    ( void );
+
+/**********************************************************************************************************************/
+
+static void
+report( const char *name, const char *keys, long long ops, DirectClock *clock )
+{
+     long long us = direct_clock_diff( clock );
+
+     if (!us)
+          us = 1;
+
+     D_INFO( "Direct/HashBench: %-20s %-10s %8lld.%03lld Mops/sec\n",
+             name, keys, ops / us, ops * 1000 / us % 1000 );
+}
+
+static void
+bench_hash( const char *keys_name, const unsigned long *keys, const unsigned long *misses )
+{
+     int          i, r;
+     long         sum = 0;
+     DirectHash  *hash;
+     DirectClock  clock;
+
+     direct_hash_create( 17, &hash );
+
+     direct_clock_start( &clock );
+
+     for (i=0; i<num_keys; i++)
+          direct_hash_insert( hash, keys[i], (void*) (keys + i) );
+
+     direct_clock_stop( &clock );
+
+     report( "hash insert", keys_name, num_keys, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (r=0; r<rounds; r++) {
+          for (i=0; i<num_keys; i++)
+               sum += (direct_hash_lookup( hash, keys[order[i]] ) != NULL);
+     }
+
+     direct_clock_stop( &clock );
+
+     report( "hash lookup (hit)", keys_name, (long long) rounds * num_keys, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (r=0; r<rounds; r++) {
+          for (i=0; i<num_keys; i++)
+               sum += (direct_hash_lookup( hash, misses[order[i]] ) != NULL);
+     }
+
+     direct_clock_stop( &clock );
+
+     report( "hash lookup (miss)", keys_name, (long long) rounds * num_keys, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (r=0; r<rounds; r++) {
+          for (i=0; i<num_keys; i++) {
+               direct_hash_remove( hash, keys[i] );
+               direct_hash_insert( hash, misses[i], (void*) (misses + i) );
+          }
+
+          for (i=0; i<num_keys; i++) {
+               direct_hash_remove( hash, misses[i] );
+               direct_hash_insert( hash, keys[i], (void*) (keys + i) );
+          }
+     }
+
+     direct_clock_stop( &clock );
+
+     report( "hash churn", keys_name, (long long) rounds * num_keys * 4, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (i=0; i<num_keys; i++)
+          direct_hash_remove( hash, keys[i] );
+
+     direct_clock_stop( &clock );
+
+     report( "hash remove", keys_name, num_keys, &clock );
+
+     if (sum != (long) rounds * num_keys)
+          D_ERROR( "Direct/HashBench: Lookup returned %ld hits instead of %d!\n", sum, rounds * num_keys );
+
+     direct_hash_destroy( hash );
+}
+
+/**********************************************************************************************************************/
+
+static bool
+map_compare( DirectMap  *map,
+             const void *key,
+             void       *object,
+             void       *ctx )
+{
+     return *(const unsigned long*) key == *(const unsigned long*) object;
+}
+
+static unsigned int
+map_hash( DirectMap  *map,
+          const void *key,
+          void       *ctx )
+{
+     unsigned long k = *(const unsigned long*) key;
+
+     return k ^ (k >> 16);
+}
+
+static void
+bench_map( const char *keys_name, unsigned long *keys, unsigned long *misses )
+{
+     int          i, r;
+     long         sum = 0;
+     DirectMap   *map;
+     DirectClock  clock;
+
+     direct_map_create( 17, map_compare, map_hash, NULL, &map );
+
+     direct_clock_start( &clock );
+
+     for (i=0; i<num_keys; i++)
+          direct_map_insert( map, &keys[i], &keys[i] );
+
+     direct_clock_stop( &clock );
+
+     report( "map insert", keys_name, num_keys, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (r=0; r<rounds; r++) {
+          for (i=0; i<num_keys; i++)
+               sum += (direct_map_lookup( map, &keys[order[i]] ) != NULL);
+     }
+
+     direct_clock_stop( &clock );
+
+     report( "map lookup (hit)", keys_name, (long long) rounds * num_keys, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (r=0; r<rounds; r++) {
+          for (i=0; i<num_keys; i++)
+               sum += (direct_map_lookup( map, &misses[order[i]] ) != NULL);
+     }
+
+     direct_clock_stop( &clock );
+
+     report( "map lookup (miss)", keys_name, (long long) rounds * num_keys, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (r=0; r<rounds; r++) {
+          for (i=0; i<num_keys; i++) {
+               direct_map_remove( map, &keys[i] );
+               direct_map_insert( map, &misses[i], &misses[i] );
+          }
+
+          for (i=0; i<num_keys; i++) {
+               direct_map_remove( map, &misses[i] );
+               direct_map_insert( map, &keys[i], &keys[i] );
+          }
+     }
+
+     direct_clock_stop( &clock );
+
+     report( "map churn", keys_name, (long long) rounds * num_keys * 4, &clock );
+
+
+     direct_clock_start( &clock );
+
+     for (i=0; i<num_keys; i++)
+          direct_map_remove( map, &keys[i] );
+
+     direct_clock_stop( &clock );
+
+     report( "map remove", keys_name, num_keys, &clock );
+
+     if (sum != (long) rounds * num_keys)
+          D_ERROR( "Direct/HashBench: Lookup returned %ld hits instead of %d!\n", sum, rounds * num_keys );
+
+     direct_map_destroy( map );
+}
+
+/**********************************************************************************************************************/
+
+int
+main( int argc, char *argv[] )
+{
+     int            i;
+     unsigned long *keys;
+     unsigned long *misses;
+
+     if (parse_cmdline( argc, argv ))
+          return -1;
+
+     keys   = D_MALLOC( num_keys * sizeof(unsigned long) );
+     misses = D_MALLOC( num_keys * sizeof(unsigned long) );
+     order  = D_MALLOC( num_keys * sizeof(int) );
+     if (!keys || !misses || !order)
+          return D_OOM();
+
+     srand( 23 );
+
+     for (i=0; i<num_keys; i++)
+          order[i] = i;
+
+     for (i=num_keys-1; i>0; i--) {
+          int j = rand() % (i + 1);
+          int t = order[i];
+
+          order[i] = order[j];
+          order[j] = t;
+     }
+
+     /* Sequential IDs, misses are the following range. */
+     for (i=0; i<num_keys; i++) {
+          keys[i]   = i + 1;
+          misses[i] = num_keys + i + 1;
+     }
+
+     bench_hash( "sequential", keys, misses );
+     bench_map( "sequential", keys, misses );
+
+     /* Pointer like keys, 16 byte aligned and scattered. */
+     for (i=0; i<num_keys; i++) {
+          keys[i]   = ((unsigned long) rand() << 12 ^ (unsigned long) i << 4) & ~15UL;
+          misses[i] = keys[i] | 8;
+     }
+
+     bench_hash( "pointers", keys, misses );
+     bench_map( "pointers", keys, misses );
+
+     D_FREE( order );
+     D_FREE( misses );
+     D_FREE( keys );
+
+     return 0;
+}
+
+/**********************************************************************************************************************/
+
+static int
+parse_cmdline( int argc, char *argv[] )
+{
+     int i;
+
+     for (i=1; i<argc; i++) {
+          if (!strcmp( argv[i], "-n" ) && i + 1 < argc)
+               num_keys = atoi( argv[++i] );
+          else if (!strcmp( argv[i], "-r" ) && i + 1 < argc)
+               rounds = atoi( argv[++i] );
+          else
+               return show_usage();
+     }
+
+     if (num_keys < 1 || rounds < 1)
+          return show_usage();
+
+     return 0;
+}
+
+static int
+show_usage( void )
+{
+     fprintf( stderr, "\n"
+                      "Usage:\n"
+                      "   direct_hash_bench [options]\n"
+                      "\n"
+                      "Options:\n"
+                      "   -n <keys>    Number of keys (default 100000)\n"
+                      "   -r <rounds>  Rounds of lookups and churn (default 10)\n"
+                      "\n"
+              );
+
+     return -1;
+}
@@ -54,6 +54,7 @@
 
 
 static bool sync_calls;
+static bool async_calls;
 
 /**********************************************************************************************************************/
 
@@ -81,6 +82,7 @@ call_handler( int           caller,
 /**********************************************************************************************************************/
 
 #define NUM_ITEMS 300000
+#define NUM_ASYNC 64
 
 int
 main( int argc, char *argv[] )
@@ -91,6 +93,8 @@ main( int argc, char *argv[] )
      sigset_t             block;
      FusionCall           call = { 0 };
 
+     FusionCallCompletion *completions[NUM_ASYNC];
+
      int retcall;
      int i;
 
@@ -127,8 +131,28 @@ main( int argc, char *argv[] )
 
      direct_clock_start( &clock );
 
-     for (i=0; i<NUM_ITEMS; i++)
-          fusion_call_execute( &call, sync_calls ? FCEF_NONE : FCEF_ONEWAY, 0, 0, &retcall );
+     if (async_calls) {
+          void *ptr = NULL;
+
+          /* Keep a number of calls in flight, collecting the oldest return before issuing the next. */
+          for (i=0; i<NUM_ITEMS; i++) {
+               if (i >= NUM_ASYNC)
+                    fusion_call_completion_wait( completions[i % NUM_ASYNC], &retcall, NULL );
+
+               ret = fusion_call_execute_async( &call, FCEF_NONE, 0, &ptr, sizeof(ptr), sizeof(retcall), &completions[i % NUM_ASYNC] );
+               if (ret) {
+                    D_DERROR( ret, "Fusion/Call: fusion_call_execute_async() failed!\n" );
+                    return ret;
+               }
+          }
+
+          for (i=NUM_ITEMS-NUM_ASYNC; i<NUM_ITEMS; i++)
+               fusion_call_completion_wait( completions[i % NUM_ASYNC], &retcall, NULL );
+     }
+     else {
+          for (i=0; i<NUM_ITEMS; i++)
+               fusion_call_execute( &call, sync_calls ? FCEF_NONE : FCEF_ONEWAY, 0, 0, &retcall );
+     }
 
      fusion_call_execute( &call, FCEF_NONE, 1, 0, &retcall );
 
@@ -151,6 +175,8 @@ parse_cmdline( int argc, char *argv[] )
      for (i=1; i<argc; i++) {
           if (!strcmp( argv[i], "-s" ))
                sync_calls = true;
+          else if (!strcmp( argv[i], "-a" ))
+               async_calls = true;
           else
                return show_usage();
      }
@@ -167,6 +193,7 @@ show_usage( void )
                       "\n"
                       "Options:\n"
                       "   -s  Synchronous calls\n"
+                      "   -a  Asynchronous calls with returns collected later\n"
                       "\n"
               );
 
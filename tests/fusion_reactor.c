@@ -39,13 +39,17 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <directfb.h>
 
 #include <direct/build.h>
+#include <direct/clock.h>
 #include <direct/debug.h>
 #include <direct/log.h>
 #include <direct/messages.h>
+#include <direct/thread.h>
 
 #include <fusion/fusion.h>
 #include <fusion/reactor.h>
@@ -95,6 +99,158 @@ dispatch_callback (int           caller,
      return FCHR_RETURN;
 }
 
+/**********************************************************************************************************************/
+
+#define BENCH_MAX_REACTIONS  64
+#define BENCH_MAX_THREADS     8
+#define BENCH_DURATION      500  /* ms per run */
+
+typedef struct {
+     DirectThread  *thread;
+     FusionReactor *reactor;
+     unsigned long  count;
+} BenchThread;
+
+static volatile bool bench_stop;
+
+static ReactionResult
+bench_reaction( const void *msg_data,
+                void       *ctx )
+{
+     return RS_OK;
+}
+
+static void *
+bench_dispatch_loop( DirectThread *thread,
+                     void         *arg )
+{
+     BenchThread *bench   = arg;
+     TestMessage  message = {0};
+
+     while (!bench_stop) {
+          fusion_reactor_dispatch( bench->reactor, &message, true, NULL );
+
+          bench->count++;
+     }
+
+     return NULL;
+}
+
+static void *
+bench_churn_loop( DirectThread *thread,
+                  void         *arg )
+{
+     BenchThread *bench = arg;
+     Reaction     reaction;
+
+     /* Keep attaching and detaching while the dispatchers are running. */
+     while (!bench_stop) {
+          if (fusion_reactor_attach( bench->reactor, bench_reaction, NULL, &reaction ))
+               break;
+
+          fusion_reactor_detach( bench->reactor, &reaction );
+
+          bench->count++;
+     }
+
+     return NULL;
+}
+
+static int
+run_benchmark( bool churn )
+{
+     static const int  reactions_num[] = { 1, 4, 16, BENCH_MAX_REACTIONS };
+     static const int  threads_num[]   = { 1, 2, 4, BENCH_MAX_THREADS };
+
+     int               i, r, t;
+     int               attached = 0;
+     FusionReactor    *reactor;
+     Reaction          reactions[BENCH_MAX_REACTIONS];
+     BenchThread       threads[BENCH_MAX_THREADS];
+     BenchThread       churner;
+
+     reactor = fusion_reactor_new( sizeof(TestMessage), "Benchmark", m_world );
+     if (!reactor) {
+          D_ERROR( "fusion_reactor_new() failed\n" );
+          return -1;
+     }
+
+     /* Let the dispatching thread call its local reactions itself. */
+     fusion_reactor_direct( reactor, true );
+
+     printf( "\nLocal dispatch%s:\n\n", churn ? " with concurrent attach/detach" : "" );
+
+     for (r=0; r<D_ARRAY_SIZE(reactions_num); r++) {
+          for (; attached < reactions_num[r]; attached++) {
+               DirectResult ret = fusion_reactor_attach( reactor, bench_reaction, NULL, &reactions[attached] );
+               if (ret) {
+                    D_DERROR( ret, "fusion_reactor_attach() failed" );
+                    return ret;
+               }
+          }
+
+          for (t=0; t<D_ARRAY_SIZE(threads_num); t++) {
+               long long     start, stop;
+               unsigned long total = 0;
+
+               bench_stop = false;
+
+               memset( threads, 0, sizeof(threads) );
+               memset( &churner, 0, sizeof(churner) );
+
+               start = direct_clock_get_micros();
+
+               for (i=0; i<threads_num[t]; i++) {
+                    threads[i].reactor = reactor;
+                    threads[i].thread  = direct_thread_create( DTT_DEFAULT, bench_dispatch_loop, &threads[i], "Dispatch" );
+               }
+
+               if (churn) {
+                    churner.reactor = reactor;
+                    churner.thread  = direct_thread_create( DTT_DEFAULT, bench_churn_loop, &churner, "Churn" );
+               }
+
+               usleep( BENCH_DURATION * 1000 );
+
+               bench_stop = true;
+
+               for (i=0; i<threads_num[t]; i++) {
+                    direct_thread_join( threads[i].thread );
+                    direct_thread_destroy( threads[i].thread );
+
+                    total += threads[i].count;
+               }
+
+               stop = direct_clock_get_micros();
+
+               if (churn) {
+                    direct_thread_join( churner.thread );
+                    direct_thread_destroy( churner.thread );
+               }
+
+               printf( "  %2d reactions, %d threads: %10llu dispatches/sec",
+                       reactions_num[r], threads_num[t], total * 1000000ULL / (stop - start) );
+
+               if (churn)
+                    printf( ", %8llu attach+detach/sec", churner.count * 1000000ULL / (stop - start) );
+
+               printf( "\n" );
+          }
+     }
+
+     for (i=0; i<attached; i++)
+          fusion_reactor_detach( reactor, &reactions[i] );
+
+     fusion_reactor_destroy( reactor );
+     fusion_reactor_free( reactor );
+
+     fusion_exit( m_world, false );
+
+     return 0;
+}
+
+/**********************************************************************************************************************/
+
 int
 main( int argc, char *argv[] )
 {
@@ -116,6 +272,23 @@ main( int argc, char *argv[] )
      MSG( "Entered world %d as master (FusionID %lu, pid %d)\n",
           fusion_world_index( m_world ), fusion_id( m_world ), getpid() );
 
+     /* Benchmark local dispatch instead of testing forked reactions. */
+     if (argc > 1) {
+          if (!strcmp( argv[1], "-b" ))
+               return run_benchmark( false );
+
+          if (!strcmp( argv[1], "-c" ))
+               return run_benchmark( true );
+
+          fprintf( stderr, "Usage: fusion_reactor [-b|-c]\n"
+                           "   -b  Benchmark dispatch to local reactions\n"
+                           "   -c  Same with another thread attaching and detaching\n" );
+
+          fusion_exit( m_world, false );
+
+          return -1;
+     }
+
 
      reactor = fusion_reactor_new( sizeof(TestMessage), "Test", m_world );
      if (!reactor) {
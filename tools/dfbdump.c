@@ -738,6 +738,7 @@ dump_shmpool( FusionSHMPool *pool,
      unsigned int  total = 0;
      int           length;
      FusionSHMPoolShared *shared = pool->shared;
+     FusionSHMPoolStats   stats;
 
      printf( "\n" );
      printf( "----------------------------[ Shared Memory in %s ]----------------------------%n\n", shared->name, &length );
@@ -770,6 +771,17 @@ dump_shmpool( FusionSHMPool *pool,
 
      fusion_skirmish_dismiss( &shared->lock );
 
+     if (fusion_shm_pool_get_stats( shared, &stats ) == DR_OK) {
+          printf( "Heap: %uk used, %uk free in %u chunks\n",
+                  stats.bytes_used >> 10, stats.bytes_free >> 10, stats.chunks_free );
+
+          if (stats.slabs)
+               printf( "Slabs: %u with %uk, %uk free\n",
+                       stats.slabs, stats.slab_bytes >> 10, stats.slab_bytes_free >> 10 );
+
+          printf( "Lock: taken %u times, %u contended\n", stats.locks, stats.contended );
+     }
+
      return DFENUM_OK;
 }
 
@@ -0,0 +1,568 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <directfb.h>
+
+#include <direct/util.h>
+
+#include <core/TaskTrace.h>
+
+/*
+ * Reads a trace written with "task-trace=<file>", rebuilds the task dependency graph,
+ * follows the critical path backwards from each DisplayTask (one per frame) and optionally
+ * exports everything as Chrome trace JSON (chrome://tracing or Perfetto).
+ */
+
+#define MAX_PATH_LENGTH  10000
+
+typedef struct {
+     int                 task;        /* index of the task blocking this one */
+     u32                 state;       /* TASK_RUNNING (follow) or TASK_FINISH */
+} Edge;
+
+typedef struct {
+     u64                 addr;
+     char                name[13];
+     u64                 info;        /* accessor << 32 | surface id */
+
+     long long           t[DFB_TASK_TRACE_FINISH+1];
+     u32                 tid_run;
+     u32                 tid_done;
+
+     Edge               *preds;
+     int                 num_preds;
+
+     bool                critical;
+} TaskNode;
+
+typedef struct {
+     char                key[48];
+     long long           micros;
+     int                 count;
+} Stall;
+
+static TaskNode *nodes;
+static int       num_nodes;
+
+static int      *hash;
+static int       hash_size;
+
+static Stall    *stalls;
+static int       num_stalls;
+
+static int       num_flows;
+
+static bool      verbose;
+static int       only_frame = -1;
+static const char *json_filename;
+static const char *trace_filename;
+
+#define TASK_RUNNING 0x00000008     /* see DirectFB::TaskState */
+
+/**********************************************************************************************************************/
+
+static int
+lookup_task( u64 addr, bool create )
+{
+     unsigned int i = (unsigned int)((addr >> 4) * 2654435761u) & (hash_size - 1);
+
+     while (hash[i] >= 0) {
+          if (nodes[hash[i]].addr == addr) {
+               if (!create)
+                    return hash[i];
+               break;
+          }
+
+          i = (i + 1) & (hash_size - 1);
+     }
+
+     if (!create)
+          return -1;
+
+     /* New instance at this address replaces the old one in the hash. */
+     memset( &nodes[num_nodes], 0, sizeof(TaskNode) );
+
+     nodes[num_nodes].addr = addr;
+
+     hash[i] = num_nodes;
+
+     return num_nodes++;
+}
+
+static int
+get_task( u64 addr )
+{
+     int index = lookup_task( addr, false );
+
+     /* Construction has been overwritten in the ring buffer. */
+     if (index < 0)
+          index = lookup_task( addr, true );
+
+     return index;
+}
+
+static void
+add_edge( int from, int to, u32 state )
+{
+     TaskNode *node = &nodes[to];
+
+     if (!(node->num_preds % 8))
+          node->preds = realloc( node->preds, (node->num_preds + 8) * sizeof(Edge) );
+
+     node->preds[node->num_preds].task  = from;
+     node->preds[node->num_preds].state = state;
+
+     node->num_preds++;
+}
+
+static bool
+load_trace( const char *filename )
+{
+     FILE               *file;
+     DFBTaskTraceHeader  header;
+     DFBTaskTraceRecord  record;
+     unsigned int        i;
+
+     file = fopen( filename, "rb" );
+     if (!file) {
+          perror( filename );
+          return false;
+     }
+
+     if (fread( &header, sizeof(header), 1, file ) != 1 ||
+         header.magic != DFB_TASK_TRACE_MAGIC || header.version != DFB_TASK_TRACE_VERSION ||
+         header.record_size != sizeof(DFBTaskTraceRecord))
+     {
+          fprintf( stderr, "%s: not a task trace (version %d)\n", filename, DFB_TASK_TRACE_VERSION );
+          fclose( file );
+          return false;
+     }
+
+     if (header.lost)
+          fprintf( stderr, "%s: %llu events have been lost, increase task-trace-size\n",
+                   filename, (unsigned long long) header.lost );
+
+     /* Every event creates at most two tasks. */
+     nodes = calloc( header.count * 2 + 1, sizeof(TaskNode) );
+
+     for (hash_size = 1024; hash_size < header.count * 4; hash_size <<= 1);
+
+     hash = malloc( hash_size * sizeof(int) );
+
+     memset( hash, 0xff, hash_size * sizeof(int) );
+
+     for (i=0; i<header.count; i++) {
+          int       index;
+          TaskNode *node;
+
+          if (fread( &record, sizeof(record), 1, file ) != 1) {
+               fprintf( stderr, "%s: truncated after %u of %u events\n", filename, i, header.count );
+               break;
+          }
+
+          if (record.event < DFB_TASK_TRACE_NEW || record.event > DFB_TASK_TRACE_NOTIFY)
+               continue;
+
+          if (record.event == DFB_TASK_TRACE_NEW)
+               index = lookup_task( record.task, true );
+          else
+               index = get_task( record.task );
+
+          node = &nodes[index];
+
+          switch (record.event) {
+               case DFB_TASK_TRACE_NOTIFY:
+                    add_edge( index, get_task( record.arg ), record.flags );
+                    continue;
+
+               case DFB_TASK_TRACE_FLUSH:
+                    direct_snputs( node->name, record.name, sizeof(node->name) );
+                    break;
+
+               case DFB_TASK_TRACE_READY:
+                    node->info = record.arg;
+                    break;
+
+               case DFB_TASK_TRACE_RUN:
+                    node->tid_run = record.tid;
+                    break;
+
+               case DFB_TASK_TRACE_DONE:
+                    node->tid_done = record.tid;
+                    break;
+          }
+
+          if (!node->t[record.event])
+               node->t[record.event] = record.micros;
+     }
+
+     fclose( file );
+
+     return true;
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Time at which 'node' stopped blocking a task depending on it with 'state'.
+ */
+static long long
+release_time( const TaskNode *node, u32 state )
+{
+     if (state == TASK_RUNNING)
+          return node->t[DFB_TASK_TRACE_RUN];
+
+     return node->t[DFB_TASK_TRACE_DONE] ? node->t[DFB_TASK_TRACE_DONE] : node->t[DFB_TASK_TRACE_FINISH];
+}
+
+static void
+describe( const TaskNode *node, char *buf, size_t size )
+{
+     snprintf( buf, size, "%-8s accessor 0x%02x surface %u", node->name[0] ? node->name : "?",
+               (unsigned int)(node->info >> 32), (unsigned int) node->info );
+}
+
+static void
+add_stall( const TaskNode *node, long long micros )
+{
+     char key[48];
+     int  i;
+
+     describe( node, key, sizeof(key) );
+
+     for (i=0; i<num_stalls; i++) {
+          if (!strcmp( stalls[i].key, key ))
+               break;
+     }
+
+     if (i == num_stalls) {
+          stalls = realloc( stalls, (num_stalls + 1) * sizeof(Stall) );
+
+          direct_snputs( stalls[i].key, key, sizeof(stalls[i].key) );
+
+          stalls[i].micros = 0;
+          stalls[i].count  = 0;
+
+          num_stalls++;
+     }
+
+     stalls[i].micros += micros;
+     stalls[i].count++;
+}
+
+/*
+ * Walks from the DisplayTask back along the dependency that was released last, until a task was
+ * not held back by any of its dependencies or it reaches the critical path of a previous frame.
+ */
+static void
+critical_path( int frame, int display, long long base )
+{
+     int        path[MAX_PATH_LENGTH];
+     long long  end[MAX_PATH_LENGTH];
+     int        length = 0;
+     int        current = display;
+     long long  current_end = nodes[display].t[DFB_TASK_TRACE_DONE];
+     long long  start;
+     int        i;
+
+     while (length < MAX_PATH_LENGTH) {
+          TaskNode  *node    = &nodes[current];
+          int        blocker = -1;
+          long long  latest  = 0;
+
+          path[length] = current;
+          end[length]  = current_end;
+          length++;
+
+          for (i=0; i<node->num_preds; i++) {
+               long long release = release_time( &nodes[node->preds[i].task], node->preds[i].state );
+
+               if (release > latest) {
+                    latest  = release;
+                    blocker = node->preds[i].task;
+               }
+          }
+
+          /* Not blocked by a dependency if it was released before the task became ready. */
+          if (blocker < 0 || !node->t[DFB_TASK_TRACE_READY] || latest <= node->t[DFB_TASK_TRACE_READY] ||
+              nodes[blocker].critical)
+               break;
+
+          current     = blocker;
+          current_end = latest;
+     }
+
+     start = nodes[path[length-1]].t[DFB_TASK_TRACE_FLUSH];
+
+     if (!start)
+          start = nodes[path[length-1]].t[DFB_TASK_TRACE_NEW];
+
+     if (only_frame < 0 || only_frame == frame)
+          printf( "frame %5d  at %9.3f ms  latency %8.3f ms  critical path %3d tasks\n", frame,
+                  (nodes[display].t[DFB_TASK_TRACE_DONE] - base) / 1000.0,
+                  (nodes[display].t[DFB_TASK_TRACE_DONE] - start) / 1000.0, length );
+
+     /*
+      * Each task on the path accounts for the time from its own (or its blocker's) release
+      * until it released the next one.
+      */
+     for (i=length-1; i>=0; i--) {
+          TaskNode  *node  = &nodes[path[i]];
+          long long  begin = (i < length-1) ? end[i+1] : (node->t[DFB_TASK_TRACE_FLUSH] ? node->t[DFB_TASK_TRACE_FLUSH] : start);
+          long long  took  = end[i] - begin;
+
+          node->critical = true;
+
+          add_stall( node, took );
+
+          if (verbose && (only_frame < 0 || only_frame == frame)) {
+               char buf[48];
+
+               describe( node, buf, sizeof(buf) );
+
+               printf( "    %-40s  %8.3f ms  (queued %.3f, blocked %.3f, running %.3f)\n", buf, took / 1000.0,
+                       node->t[DFB_TASK_TRACE_READY] && node->t[DFB_TASK_TRACE_FLUSH] ?
+                       (node->t[DFB_TASK_TRACE_READY] - node->t[DFB_TASK_TRACE_FLUSH]) / 1000.0 : 0.0,
+                       node->t[DFB_TASK_TRACE_RUN] && node->t[DFB_TASK_TRACE_READY] ?
+                       (node->t[DFB_TASK_TRACE_RUN] - node->t[DFB_TASK_TRACE_READY]) / 1000.0 : 0.0,
+                       node->t[DFB_TASK_TRACE_DONE] && node->t[DFB_TASK_TRACE_RUN] ?
+                       (node->t[DFB_TASK_TRACE_DONE] - node->t[DFB_TASK_TRACE_RUN]) / 1000.0 : 0.0 );
+          }
+     }
+}
+
+static int
+compare_stalls( const void *a, const void *b )
+{
+     const Stall *sa = a;
+     const Stall *sb = b;
+
+     return (sb->micros > sa->micros) - (sb->micros < sa->micros);
+}
+
+/**********************************************************************************************************************/
+
+static void
+write_json( const char *filename, long long base )
+{
+     FILE *file;
+     int   i, j;
+     bool  first = true;
+
+     file = fopen( filename, "w" );
+     if (!file) {
+          perror( filename );
+          return;
+     }
+
+     fprintf( file, "{\"traceEvents\":[\n" );
+
+     for (i=0; i<num_nodes; i++) {
+          const TaskNode *node = &nodes[i];
+          long long       flush = node->t[DFB_TASK_TRACE_FLUSH];
+          long long       run   = node->t[DFB_TASK_TRACE_RUN];
+          long long       done  = node->t[DFB_TASK_TRACE_DONE];
+
+          if (!run || !done)
+               continue;
+
+          /* Execution on the thread that reported Done(), i.e. the engine. */
+          fprintf( file, "%s{\"name\":\"%s\",\"cat\":\"task\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld,%s"
+                   "\"args\":{\"task\":\"0x%llx\",\"accessor\":%u,\"surface\":%u,\"critical\":%s}}",
+                   first ? "" : ",\n", node->name[0] ? node->name : "?", node->tid_done, run - base, done - run,
+                   node->critical ? "\"cname\":\"terrible\"," : "",
+                   (unsigned long long) node->addr, (unsigned int)(node->info >> 32), (unsigned int) node->info,
+                   node->critical ? "true" : "false" );
+
+          first = false;
+
+          /* Pending time from flush to emit as an async slice, as these overlap a lot. */
+          if (flush && flush < run)
+               fprintf( file, ",\n{\"name\":\"%s pending\",\"cat\":\"pending\",\"ph\":\"b\",\"id\":%d,\"pid\":2,\"tid\":0,\"ts\":%lld},\n"
+                        "{\"name\":\"%s pending\",\"cat\":\"pending\",\"ph\":\"e\",\"id\":%d,\"pid\":2,\"tid\":0,\"ts\":%lld}",
+                        node->name, i, flush - base, node->name, i, run - base );
+
+          /* Dependency arrows */
+          for (j=0; j<node->num_preds; j++) {
+               const TaskNode *pred    = &nodes[node->preds[j].task];
+               long long       release = release_time( pred, node->preds[j].state );
+
+               if (!release || !pred->tid_done)
+                    continue;
+
+               /* Start the arrow inside the slice of the blocking task, not at its end. */
+               if (node->preds[j].state != TASK_RUNNING && release > pred->t[DFB_TASK_TRACE_RUN])
+                    release--;
+
+               fprintf( file, ",\n{\"name\":\"dep\",\"cat\":\"dep\",\"ph\":\"s\",\"id\":%d,\"pid\":1,\"tid\":%u,\"ts\":%lld},\n"
+                        "{\"name\":\"dep\",\"cat\":\"dep\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%d,\"pid\":1,\"tid\":%u,\"ts\":%lld}",
+                        num_flows, pred->tid_done, release - base, num_flows, node->tid_done, run - base );
+
+               num_flows++;
+          }
+     }
+
+     fprintf( file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"trace\":\"%s\"}}\n", trace_filename );
+
+     fclose( file );
+}
+
+/**********************************************************************************************************************/
+
+static void
+print_usage( const char *prg_name )
+{
+     fprintf( stderr, "\n"
+                      "DirectFB Task Trace Analyzer (version %s)\n"
+                      "\n"
+                      "Usage: %s [options] <trace file>\n"
+                      "\n"
+                      "Record a trace by running an application with --dfb:task-manager,task-trace=<file>\n"
+                      "\n"
+                      "Options:\n"
+                      "   -v, --verbose                 Print all tasks on the critical path of each frame\n"
+                      "   -f, --frame       <num>       Only print the given frame\n"
+                      "   -j, --json        <file>      Export Chrome trace JSON (chrome://tracing, Perfetto)\n"
+                      "   -h, --help                    Show this help message\n"
+                      "\n", DIRECTFB_VERSION, prg_name );
+}
+
+static DFBBoolean
+parse_command_line( int argc, char *argv[] )
+{
+     int i;
+
+     for (i=1; i<argc; i++) {
+          const char *arg = argv[i];
+
+          if (strcmp (arg, "-h") == 0 || strcmp (arg, "--help") == 0) {
+               print_usage (argv[0]);
+               return DFB_FALSE;
+          }
+
+          if (strcmp (arg, "-v") == 0 || strcmp (arg, "--verbose") == 0) {
+               verbose = true;
+               continue;
+          }
+
+          if (strcmp (arg, "-f") == 0 || strcmp (arg, "--frame") == 0) {
+               if (++i == argc) {
+                    print_usage (argv[0]);
+                    return DFB_FALSE;
+               }
+
+               only_frame = atoi( argv[i] );
+               continue;
+          }
+
+          if (strcmp (arg, "-j") == 0 || strcmp (arg, "--json") == 0) {
+               if (++i == argc) {
+                    print_usage (argv[0]);
+                    return DFB_FALSE;
+               }
+
+               json_filename = argv[i];
+               continue;
+          }
+
+          if (arg[0] != '-' && !trace_filename) {
+               trace_filename = arg;
+               continue;
+          }
+
+          print_usage (argv[0]);
+          return DFB_FALSE;
+     }
+
+     if (!trace_filename) {
+          print_usage (argv[0]);
+          return DFB_FALSE;
+     }
+
+     return DFB_TRUE;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     int       i;
+     int       frames = 0;
+     long long base   = 0;
+     long long total  = 0;
+
+     if (!parse_command_line( argc, argv ))
+          return -1;
+
+     if (!load_trace( trace_filename ))
+          return -2;
+
+     for (i=0; i<num_nodes; i++) {
+          if (nodes[i].t[DFB_TASK_TRACE_NEW] && (!base || nodes[i].t[DFB_TASK_TRACE_NEW] < base))
+               base = nodes[i].t[DFB_TASK_TRACE_NEW];
+     }
+
+     /* Every DisplayTask completes a frame. */
+     for (i=0; i<num_nodes; i++) {
+          if (!strcmp( nodes[i].name, "Display" ) && nodes[i].t[DFB_TASK_TRACE_DONE])
+               critical_path( frames++, i, base );
+     }
+
+     printf( "\n%d tasks, %d frames\n", num_nodes, frames );
+
+     if (num_stalls) {
+          qsort( stalls, num_stalls, sizeof(Stall), compare_stalls );
+
+          for (i=0; i<num_stalls; i++)
+               total += stalls[i].micros;
+
+          printf( "\nTime on critical paths by task type, accessor and surface:\n\n" );
+
+          for (i=0; i<num_stalls && i<20; i++)
+               printf( "  %-40s  %10.3f ms  %5.1f%%  %6d tasks\n", stalls[i].key, stalls[i].micros / 1000.0,
+                       total ? stalls[i].micros * 100.0 / total : 0.0, stalls[i].count );
+     }
+
+     if (json_filename)
+          write_json( json_filename, base );
+
+     return 0;
+}
@@ -454,6 +454,22 @@ bench_flock( void )
      fclose( tmp );
 }
 
+static void
+print_shmpool_stats( FusionSHMPoolShared *pool )
+{
+     FusionSHMPoolStats stats;
+
+     if (fusion_shm_pool_get_stats( pool, &stats ))
+          return;
+
+     printf( "    heap %uk used, %uk free in %u chunks, slabs %uk (%uk free) in %u slabs\n",
+             stats.bytes_used >> 10, stats.bytes_free >> 10, stats.chunks_free,
+             stats.slab_bytes >> 10, stats.slab_bytes_free >> 10, stats.slabs );
+
+     printf( "    lock taken %u times, %u contended (%.1f%%)\n", stats.locks, stats.contended,
+             stats.locks ? stats.contended * 100.0f / stats.locks : 0.0f );
+}
+
 static void
 bench_shmpool( bool debug )
 {
@@ -498,7 +514,68 @@ bench_shmpool( bool debug )
      printf( "shm pool alloc/free %s           -> %8.2f k/sec\n",
              debug ? "(debug)" : "       ", BENCH_RESULT_BY(256) );
 
+     print_shmpool_stats( pool );
+
+     fusion_shm_pool_destroy( world, pool );
+}
+
+static void *
+shmpool_alloc_free_loop( void *arg )
+{
+     FusionSHMPoolShared *pool = arg;
+     void                *mem[64];
+     const int            sizes[8] = { 12, 36, 200, 120, 39, 3082, 8, 1040 };
+
+     BENCH_LOOP() {
+          int i;
+
+          for (i=0; i<64; i++)
+               mem[i] = SHMALLOC( pool, sizes[i&7] );
+
+          for (i=0; i<64; i++)
+               SHFREE( pool, mem[i] );
+     }
+
+     return NULL;
+}
+
+static void
+bench_shmpool_threaded( void )
+{
+     int                  i;
+     DirectResult         ret;
+     FusionSHMPoolShared *pool;
+
+     ret = fusion_shm_pool_create( world, "Threaded Benchmark Pool", 524288, false, &pool );
+     if (ret) {
+          DirectFBError( "fusion_shm_pool_create() failed", ret );
+          return;
+     }
+
+
+     /* shm pool alloc/free (2-5 threads) */
+     for (i=2; i<=5; i++) {
+          int       t;
+          pthread_t threads[i];
+
+          BENCH_START();
+
+          for (t=0; t<i; t++)
+               pthread_create( &threads[t], NULL, shmpool_alloc_free_loop, pool );
+
+          for (t=0; t<i; t++)
+               pthread_join( threads[t], NULL );
+
+          BENCH_STOP();
+
+          printf( "shm pool alloc/free (%d threads)       -> %8.2f k/sec\n", i, BENCH_RESULT_BY(64) );
+     }
+
+     print_shmpool_stats( pool );
+
      fusion_shm_pool_destroy( world, pool );
+
+     printf( "\n" );
 }
 
 int
@@ -545,6 +622,7 @@ main( int argc, char *argv[] )
 
      bench_shmpool( false );
      bench_shmpool( true );
+     bench_shmpool_threaded();
 
      printf( "\n" );
 
@@ -70,6 +70,7 @@
 #include <gfx/util.h>
 
 #include <misc/conf.h>
+#include <misc/region_index.h>
 #include <misc/util.h>
 
 #include <core/wm_module.h>
@@ -94,6 +95,7 @@ typedef struct {
 
 #define MAX_KEYS                  16
 #define MAX_UPDATE_REGIONS         8    /* dirty region */
+#define MAX_SYNC_REGIONS           8    /* stale regions of the back buffer */
 #define MAX_UPDATING_REGIONS       8    /* updated region to be scheduled for display */
 #define MAX_UPDATED_REGIONS        8    /* updated region scheduled for display */
 
@@ -133,6 +135,12 @@ typedef struct {
 
      FusionVector                  windows;
 
+     bool                          visibility_valid;   /* drawing order of windows below is up to date */
+     int                           visibility_top;     /* index of the top most window to draw, -1 if none */
+
+     DFBRegionIndex                index;              /* bounds of all windows for hit testing and updates */
+     bool                          index_valid;        /* built along with the visibility */
+
      CoreWindow                   *pointer_window;     /* window grabbing the pointer */
      CoreWindow                   *keyboard_window;    /* window grabbing the keyboard */
      CoreWindow                   *focused_window;     /* window having the focus */
@@ -172,6 +180,12 @@ typedef struct {
      int                           priority;           /* derived from stacking class */
 
      CoreLayerRegionConfig         config;
+
+     struct {
+          DFBRegion                bounds;             /* window bounds in stack coordinates */
+          int                      below;              /* index of the next window to draw, -1 for the background */
+          bool                     drawn;              /* linked from the top most window to draw */
+     } visibility;
 } WindowData;
 
 /**************************************************************************************************/
@@ -197,6 +211,9 @@ update_window( CoreWindow          *window,
 static void
 flush_updating( StackData *data );
 
+static void
+update_visibility( StackData *data );
+
 /**************************************************************************************************/
 
 static int keys_compare( const void *key1,
@@ -489,7 +506,8 @@ window_at_pointer( CoreWindowStack *stack,
                    int              x,
                    int              y )
 {
-     int         i;
+     int         i, n;
+     const int  *candidates = NULL;
      CoreWindow *window;
 
      D_ASSERT( stack != NULL );
@@ -508,12 +526,24 @@ window_at_pointer( CoreWindowStack *stack,
      if (y < 0)
           y = stack->cursor.y;
 
-     fusion_vector_foreach_reverse (window, i, data->windows) {
-          CoreWindowConfig *config  = &window->config;
-          DFBWindowOptions  options = config->options;
+     update_visibility( data );
+
+     /* Only look at windows listed for the cell containing the point. */
+     if (data->index_valid)
+          n = dfb_region_index_at( &data->index, x, y, &candidates );
+     else
+          n = fusion_vector_size( &data->windows );
+
+     while (n--) {
+          CoreWindowConfig *config;
+          DFBWindowOptions  options;
           DFBRectangle      rotated;
           DFBRectangle     *bounds  = &rotated;
 
+          window  = fusion_vector_at( &data->windows, candidates ? candidates[n] : n );
+          config  = &window->config;
+          options = config->options;
+
           transform_window_to_stack( window, &config->bounds, &rotated );
 
           if (!(options & DWOP_GHOST) && config->opacity &&
@@ -1253,46 +1283,182 @@ draw_background( CoreWindowStack *stack, CardState *state, const DFBRegion *regi
      }
 }
 
+/*
+ * Links the visible windows from top to bottom, leaving out windows completely hidden by an opaque window above.
+ */
+static void
+update_visibility( StackData *data )
+{
+     int        i, n;
+     int        num      = fusion_vector_size( &data->windows );
+     int       *link     = &data->visibility_top;
+     int        occluded = 0;
+     int        num_opaque = 0;
+     DFBRegion  opaque[num];
+
+     if (data->visibility_valid)
+          return;
+
+     *link = -1;
+
+     data->index_valid = (dfb_region_index_reset( &data->index, num ) == DFB_OK);
+
+     for (i=num-1; i>=0; i--) {
+          CoreWindow       *window      = fusion_vector_at( &data->windows, i );
+          WindowData       *window_data = window->window_data;
+          CoreWindowConfig *config      = &window->config;
+          DFBRectangle      rotated;
+          DFBRegion         bounds;
+
+          D_MAGIC_ASSERT( window_data, WindowData );
+
+          window_data->visibility.drawn = false;
+
+          transform_window_to_stack( window, &config->bounds, &rotated );
+
+          if (rotated.w < 1 || rotated.h < 1)
+               continue;
+
+          bounds = DFB_REGION_INIT_FROM_RECTANGLE( &rotated );
+
+          /* Index all windows, hit testing has its own criteria. */
+          if (data->index_valid)
+               dfb_region_index_set( &data->index, i, &bounds );
+
+          if (!VISIBLE_WINDOW( window ))
+               continue;
+
+          for (n=0; n<num_opaque; n++) {
+               if (dfb_region_region_contains( &opaque[n], &bounds ))
+                    break;
+          }
+
+          if (n < num_opaque) {
+               occluded++;
+               continue;
+          }
+
+          window_data->visibility.bounds = bounds;
+          window_data->visibility.below  = -1;
+          window_data->visibility.drawn  = true;
+
+          *link = i;
+          link  = &window_data->visibility.below;
+
+          /* Remember the part hiding windows below, the same as drawn without blending by update_region(). */
+          if (!TRANSLUCENT_WINDOW( window )) {
+               opaque[num_opaque++] = bounds;
+          }
+          else if (D_FLAGS_ARE_SET( config->options, DWOP_ALPHACHANNEL | DWOP_OPAQUE_REGION ) &&
+                   config->opacity == 0xff && !(config->options & DWOP_COLORKEYING))
+          {
+               opaque[num_opaque] = DFB_REGION_INIT_TRANSLATED( &config->opaque, config->bounds.x, config->bounds.y );
+
+               if (dfb_region_region_intersect( &opaque[num_opaque], &bounds ))
+                    num_opaque++;
+          }
+     }
+
+     if (data->index_valid)
+          data->index_valid = (dfb_region_index_build( &data->index, data->stack->width, data->stack->height ) == DFB_OK);
+
+     D_DEBUG_AT( WM_Default, "%s() -> %d windows, %d occluded, %d opaque\n", __FUNCTION__, num, occluded, num_opaque );
+
+     data->visibility_valid = true;
+}
+
+/*
+ * Returns the windows to draw intersecting the update in stacking order, from bottom to top.
+ */
+static int
+update_candidates( StackData       *data,
+                   const DFBRegion *update,
+                   int             *ret_windows )
+{
+     int i, n;
+     int num = 0;
+
+     D_ASSERT( data->visibility_valid );
+
+     if (data->index_valid) {
+          n = dfb_region_index_query( &data->index, update, ret_windows );
+
+          for (i=0; i<n; i++) {
+               CoreWindow *window      = fusion_vector_at( &data->windows, ret_windows[i] );
+               WindowData *window_data = window->window_data;
+
+               if (window_data->visibility.drawn)
+                    ret_windows[num++] = ret_windows[i];
+          }
+
+          return num;
+     }
+
+     for (i=data->visibility_top; i>=0; ) {
+          CoreWindow *window      = fusion_vector_at( &data->windows, i );
+          WindowData *window_data = window->window_data;
+
+          if (dfb_region_region_intersects( &window_data->visibility.bounds, update ))
+               num++;
+
+          i = window_data->visibility.below;
+     }
+
+     for (i=data->visibility_top, n=num; i>=0; ) {
+          CoreWindow *window      = fusion_vector_at( &data->windows, i );
+          WindowData *window_data = window->window_data;
+
+          if (dfb_region_region_intersects( &window_data->visibility.bounds, update ))
+               ret_windows[--n] = i;
+
+          i = window_data->visibility.below;
+     }
+
+     return num;
+}
+
 static void
 update_region( CoreWindowStack *stack,
                StackData       *data,
                CardState       *state,
+               const int       *windows,
                int              start,
                int              x1,
                int              y1,
                int              x2,
                int              y2 )
 {
-     int       i      = start;
-     DFBRegion region = { x1, y1, x2, y2 };
+     int         n      = start;
+     int         below;
+     DFBRegion   region = { x1, y1, x2, y2 };
 
      D_ASSERT( stack != NULL );
      D_ASSERT( data != NULL );
      D_MAGIC_ASSERT( state, CardState );
+     D_ASSERT( data->visibility_valid );
+     D_ASSERT( windows != NULL );
      D_ASSERT( start < fusion_vector_size( &data->windows ) );
      D_ASSERT( x1 <= x2 );
      D_ASSERT( y1 <= y2 );
 
-     /* Find next intersecting window. */
-     while (i >= 0) {
-          CoreWindow *window = fusion_vector_at( &data->windows, i );
+     /* Find next intersecting window among the candidates, which are in stacking order. */
+     while (n >= 0) {
+          CoreWindow *window      = fusion_vector_at( &data->windows, windows[n] );
+          WindowData *window_data = window->window_data;
 
-          if (VISIBLE_WINDOW( window )) {
-               DFBRectangle rotated;
+          D_MAGIC_ASSERT( window_data, WindowData );
 
-               transform_window_to_stack( window, &window->config.bounds, &rotated );
-
-               if (dfb_region_intersect( &region,
-                                         DFB_REGION_VALS_FROM_RECTANGLE( &rotated )))
-                    break;
-          }
+          if (VISIBLE_WINDOW( window ) && dfb_region_region_intersect( &region, &window_data->visibility.bounds ))
+               break;
 
-          i--;
+          n--;
      }
 
+     below = n - 1;
+
      /* Intersecting window found? */
-     if (i >= 0) {
-          CoreWindow       *window = fusion_vector_at( &data->windows, i );
+     if (n >= 0) {
+          CoreWindow       *window = fusion_vector_at( &data->windows, windows[n] );
           CoreWindowConfig *config = &window->config;
 
           if (D_FLAGS_ARE_SET( config->options, DWOP_ALPHACHANNEL | DWOP_OPAQUE_REGION )) {
@@ -1301,31 +1467,31 @@ update_region( CoreWindowStack *stack,
                                                               config->bounds.y );
 
                if (!dfb_region_region_intersect( &opaque, &region )) {
-                    update_region( stack, data, state, i-1, x1, y1, x2, y2 );
+                    update_region( stack, data, state, windows, below, x1, y1, x2, y2 );
 
                     draw_window( window, state, &region, true );
                }
                else {
                     if ((config->opacity < 0xff) || (config->options & DWOP_COLORKEYING)) {
                          /* draw everything below */
-                         update_region( stack, data, state, i-1, x1, y1, x2, y2 );
+                         update_region( stack, data, state, windows, below, x1, y1, x2, y2 );
                     }
                     else {
                          /* left */
                          if (opaque.x1 != x1)
-                              update_region( stack, data, state, i-1, x1, opaque.y1, opaque.x1-1, opaque.y2 );
+                              update_region( stack, data, state, windows, below, x1, opaque.y1, opaque.x1-1, opaque.y2 );
 
                          /* upper */
                          if (opaque.y1 != y1)
-                              update_region( stack, data, state, i-1, x1, y1, x2, opaque.y1-1 );
+                              update_region( stack, data, state, windows, below, x1, y1, x2, opaque.y1-1 );
 
                          /* right */
                          if (opaque.x2 != x2)
-                              update_region( stack, data, state, i-1, opaque.x2+1, opaque.y1, x2, opaque.y2 );
+                              update_region( stack, data, state, windows, below, opaque.x2+1, opaque.y1, x2, opaque.y2 );
 
                          /* lower */
                          if (opaque.y2 != y2)
-                              update_region( stack, data, state, i-1, x1, opaque.y2+1, x2, y2 );
+                              update_region( stack, data, state, windows, below, x1, opaque.y2+1, x2, y2 );
                     }
 
                     /* left */
@@ -1359,24 +1525,24 @@ update_region( CoreWindowStack *stack,
           else {
                if (TRANSLUCENT_WINDOW( window )) {
                     /* draw everything below */
-                    update_region( stack, data, state, i-1, x1, y1, x2, y2 );
+                    update_region( stack, data, state, windows, below, x1, y1, x2, y2 );
                }
                else {
                     /* left */
                     if (region.x1 != x1)
-                         update_region( stack, data, state, i-1, x1, region.y1, region.x1-1, region.y2 );
+                         update_region( stack, data, state, windows, below, x1, region.y1, region.x1-1, region.y2 );
 
                     /* upper */
                     if (region.y1 != y1)
-                         update_region( stack, data, state, i-1, x1, y1, x2, region.y1-1 );
+                         update_region( stack, data, state, windows, below, x1, y1, x2, region.y1-1 );
 
                     /* right */
                     if (region.x2 != x2)
-                         update_region( stack, data, state, i-1, region.x2+1, region.y1, x2, region.y2 );
+                         update_region( stack, data, state, windows, below, region.x2+1, region.y1, x2, region.y2 );
 
                     /* lower */
                     if (region.y2 != y2)
-                         update_region( stack, data, state, i-1, x1, region.y2+1, x2, y2 );
+                         update_region( stack, data, state, windows, below, x1, region.y2+1, x2, y2 );
                }
 
                draw_window( window, state, &region, true );
@@ -1470,6 +1636,97 @@ defaultwm_surface_display_notify( void     *ctx,
      return DFB_OK;
 }
 
+/*
+ * With double buffering the back buffer is brought up to date before drawing into it,
+ * rather than copying the updates back after each flip, to skip what is repainted anyway.
+ */
+static inline bool
+back_buffer_tracked( CoreWindowStack *stack,
+                     CoreLayerRegion *region )
+{
+     return region->config.buffermode == DLBM_BACKVIDEO && !stack->rotation && !dfb_config->task_manager;
+}
+
+static void
+add_uncovered( DFBUpdates      *updates,
+               const DFBRegion *region,
+               const DFBRegion *covered,
+               int              num_covered )
+{
+     DFBRegion inter = *region;
+
+     while (num_covered && !dfb_region_region_intersect( &inter, covered )) {
+          covered++;
+          num_covered--;
+     }
+
+     if (!num_covered) {
+          dfb_updates_add( updates, region );
+          return;
+     }
+
+     /* upper */
+     if (inter.y1 != region->y1) {
+          DFBRegion r = { region->x1, region->y1, region->x2, inter.y1 - 1 };
+          add_uncovered( updates, &r, covered + 1, num_covered - 1 );
+     }
+
+     /* lower */
+     if (inter.y2 != region->y2) {
+          DFBRegion r = { region->x1, inter.y2 + 1, region->x2, region->y2 };
+          add_uncovered( updates, &r, covered + 1, num_covered - 1 );
+     }
+
+     /* left */
+     if (inter.x1 != region->x1) {
+          DFBRegion r = { region->x1, inter.y1, inter.x1 - 1, inter.y2 };
+          add_uncovered( updates, &r, covered + 1, num_covered - 1 );
+     }
+
+     /* right */
+     if (inter.x2 != region->x2) {
+          DFBRegion r = { inter.x2 + 1, inter.y1, region->x2, inter.y2 };
+          add_uncovered( updates, &r, covered + 1, num_covered - 1 );
+     }
+}
+
+/*
+ * Copies what changed since the back buffer was the front buffer, leaving out the regions to be repainted.
+ */
+static void
+sync_back_buffer( CoreSurface     *surface,
+                  WMData          *wmdata,
+                  const DFBRegion *repaint,
+                  int              num_repaint )
+{
+     int        i, num;
+     DFBRegion  damage[CORE_SURFACE_DAMAGE_MAX];
+     DFBRegion  regions[MAX_SYNC_REGIONS];
+     DFBUpdates stale;
+
+     dfb_surface_lock( surface );
+
+     num = dfb_surface_get_buffer_damage( surface, CSBR_BACK, damage );
+
+     dfb_surface_set_buffer_current( surface, CSBR_BACK );
+
+     dfb_surface_unlock( surface );
+
+     if (!num)
+          return;
+
+     dfb_updates_init( &stale, regions, MAX_SYNC_REGIONS );
+
+     for (i=0; i<num; i++)
+          add_uncovered( &stale, &damage[i], repaint, num_repaint );
+
+     D_DEBUG_AT( WM_Default, "%s() -> %d damaged, %d stale region(s)\n", __FUNCTION__, num, stale.num_regions );
+
+     if (stale.num_regions)
+          dfb_gfx_copy_regions_client( surface, CSBR_FRONT, DSSE_LEFT, surface, CSBR_BACK, DSSE_LEFT,
+                                       stale.regions, stale.num_regions, 0, 0, &wmdata->client );
+}
+
 static void
 flush_updating( StackData *data )
 {
@@ -1580,6 +1837,8 @@ repaint_stack( CoreWindowStack     *stack,
      CoreSurface     *surface;
      DFBRegion        flips[num_updates];
      int              num_flips = 0;
+     int              windows[fusion_vector_size( &data->windows ) + 1];
+     int              num_windows;
 
      D_ASSERT( stack != NULL );
      D_ASSERT( stack->context != NULL );
@@ -1597,10 +1856,16 @@ repaint_stack( CoreWindowStack     *stack,
 
      fusion_skirmish_prevail( &wmdata->update_skirmish );
 
+     /* Bring the back buffer up to date except for the updates. */
+     if (back_buffer_tracked( stack, region ))
+          sync_back_buffer( surface, wmdata, updates, num_updates );
+
      /* Set destination. */
      state->destination  = surface;
      state->modified    |= SMF_DESTINATION;
 
+     update_visibility( data );
+
      for (i=0; i<num_updates; i++) {
           DFBRegion        dest;
           const DFBRegion *update = &updates[i];
@@ -1619,9 +1884,9 @@ repaint_stack( CoreWindowStack     *stack,
           dfb_state_set_clip( state, &dest );
 
           /* Compose updated region. */
-          update_region( stack, data, state,
-                         fusion_vector_size( &data->windows ) - 1,
-                         DFB_REGION_VALS( update ) );
+          num_windows = update_candidates( data, update, windows );
+
+          update_region( stack, data, state, windows, num_windows - 1, DFB_REGION_VALS( update ) );
 
           CoreGraphicsStateClient_Flush( &wmdata->client, 0, CGSCFF_NONE );
 
@@ -1677,12 +1942,21 @@ repaint_stack( CoreWindowStack     *stack,
                break;
 
           case DLBM_BACKVIDEO:
+               /* Record the updates as damage, rather than their bounding box. */
+               if (back_buffer_tracked( stack, region ) && !region->surface->rotation) {
+                    dfb_surface_lock( region->surface );
+
+                    for (i=0; i<num_flips; i++)
+                         dfb_surface_set_flip_damage( region->surface, &flips[i] );
+
+                    dfb_surface_unlock( region->surface );
+               }
+
                /* Flip the whole region. */
                dfb_layer_region_flip_update( region, bounding, flags | DSFLIP_WAITFORSYNC | DSFLIP_SWAP );
 
-               /* Copy back the updated region. */
-
-               if (!dfb_config->wm_fullscreen_updates)
+               /* Copy back the updated region, unless done before drawing next time. */
+               if (!dfb_config->wm_fullscreen_updates && !back_buffer_tracked( stack, region ))
                     dfb_gfx_copy_regions_client( region->surface, CSBR_FRONT, DSSE_LEFT, region->surface, CSBR_BACK, DSSE_LEFT, updates, num_updates, 0, 0, &wmdata->client );
 
                break;
@@ -2010,6 +2284,8 @@ insert_window( WMData          *wmdata,
      /* Insert the window at the acquired position. */
      fusion_vector_insert( &data->windows, window, index );
 
+     data->visibility_valid = false;
+
      window->flags |= CWF_INSERTED;
 
      dfb_wm_dispatch_WindowState( wmdata->core, window );
@@ -2106,6 +2382,8 @@ remove_window( WMData          *wmdata,
 
      fusion_vector_remove( &data->windows, fusion_vector_index_of( &data->windows, window ) );
 
+     data->visibility_valid = false;
+
      window->flags &= ~CWF_INSERTED;
 
      dfb_wm_dispatch_WindowState( wmdata->core, window );
@@ -2137,6 +2415,8 @@ move_window( CoreWindow *window,
 
           bounds->x += dx;
           bounds->y += dy;
+
+          data->stack_data->visibility_valid = false;
      }
      else {
           update_window( window, data, NULL, 0, false, false, false );
@@ -2144,6 +2424,8 @@ move_window( CoreWindow *window,
           bounds->x += dx;
           bounds->y += dy;
 
+          data->stack_data->visibility_valid = false;
+
           update_window( window, data, NULL, 0, false, false, false );
      }
 
@@ -2230,6 +2512,8 @@ resize_window( CoreWindow *window,
      bounds->w = width;
      bounds->h = height;
 
+     data->stack_data->visibility_valid = false;
+
      /* Send new size */
      evt.type = DWET_SIZE;
      evt.w    = bounds->w;
@@ -2294,6 +2578,8 @@ set_window_bounds( CoreWindow *window,
      if (!dfb_region_region_intersect( &window->config.opaque, &new_region ))
           window->config.opaque = new_region;
 
+     data->stack_data->visibility_valid = false;
+
      /* Update exposed area. */
      if (VISIBLE_WINDOW( window )) {
           if (dfb_region_region_intersect( &new_region, &old_region )) {
@@ -2444,6 +2730,8 @@ restack_window( WMData                 *wmdata,
      /* Actually change the stacking order now. */
      fusion_vector_move( &data->windows, old, index );
 
+     data->visibility_valid = false;
+
      dfb_wm_dispatch_WindowRestack( wmdata->core, window, index );
 
      update_window( window, window_data, NULL, DSFLIP_NONE, (index < old), false, false );
@@ -2479,6 +2767,8 @@ set_opacity( CoreWindow *window,
 
           window->config.opacity = opacity;
 
+          data->visibility_valid = false;
+
           if (window->region && window->stack->context->config.buffermode == DLBM_WINDOWS) {
                window_data->config.opacity = opacity;
 
@@ -3593,6 +3883,8 @@ wm_init_stack( CoreWindowStack *stack,
 
      fusion_vector_init( &data->windows, 64, stack->shmpool );
 
+     dfb_region_index_init( &data->index, stack->shmpool );
+
      for (i=0; i<MAX_KEYS; i++)
           data->keys[i].code = -1;
 
@@ -3650,6 +3942,8 @@ wm_close_stack( CoreWindowStack *stack,
 
      fusion_vector_destroy( &data->windows );
 
+     dfb_region_index_deinit( &data->index );
+
      if (!dfb_config->task_manager)
           dfb_surface_detach( data->surface, &data->surface_reaction );
 
@@ -3718,10 +4012,15 @@ wm_resize_stack( CoreWindowStack *stack,
                  int              width,
                  int              height )
 {
+     StackData *data = stack_data;
+
      D_ASSERT( stack != NULL );
      D_ASSERT( wm_data != NULL );
      D_ASSERT( stack_data != NULL );
 
+     /* The index covers the stack area. */
+     data->visibility_valid = false;
+
      return DFB_OK;
 }
 
@@ -4082,6 +4381,7 @@ wm_set_window_config( CoreWindow             *window,
      DFBResult        ret;
      CoreWindowStack *stack;
      WMData          *wmdata = wm_data;
+     WindowData      *data   = window_data;
 
      D_ASSERT( window != NULL );
      D_ASSERT( window->stack != NULL );
@@ -4114,6 +4414,8 @@ wm_set_window_config( CoreWindow             *window,
           }
 
           window->config.options = config->options;
+
+          data->stack_data->visibility_valid = false;
      }
 
      if (flags & CWCF_EVENTS)
@@ -4125,9 +4427,12 @@ wm_set_window_config( CoreWindow             *window,
      if (flags & CWCF_COLOR_KEY)
           window->config.color_key = config->color_key;
 
-     if (flags & CWCF_OPAQUE)
+     if (flags & CWCF_OPAQUE) {
           window->config.opaque = config->opaque;
 
+          data->stack_data->visibility_valid = false;
+     }
+
      if (flags & CWCF_OPACITY && !config->opacity)
           set_opacity( window, window_data, wm_data, config->opacity );
 
@@ -4159,6 +4464,8 @@ wm_set_window_config( CoreWindow             *window,
 
           window->config.rotation = config->rotation;
 
+          data->stack_data->visibility_valid = false;
+
           update_window( window, window_data, NULL, DSFLIP_NONE, false, false, false );
      }
 
@@ -4523,6 +4830,10 @@ wm_update_cursor( CoreWindowStack       *stack,
           return DFB_OK;
      }
 
+     /* Bring the back buffer up to date before restoring or saving the region under the cursor. */
+     if (data->active && back_buffer_tracked( stack, primary ))
+          sync_back_buffer( surface, wmdata, NULL, 0 );
+
      /* restore region under cursor */
      if (data->cursor_drawn) {
           D_ASSERT( stack->cursor.opacity || (flags & CCUF_OPACITY) );
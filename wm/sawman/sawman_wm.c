@@ -1565,6 +1565,8 @@ wm_init_stack( CoreWindowStack *stack,
      tier->size.w  = stack->width;
      tier->size.h  = stack->height;
 
+     sawman->index_valid = false;
+
      ret = dfb_layer_context_get_primary_region( context, true, &tier->region );
      if (ret) {
           sawman_unlock( sawman );
@@ -1627,6 +1629,8 @@ wm_close_stack( CoreWindowStack *stack,
 
      D_ASSERT( tier->context != NULL );
 
+     sawman_leave_bypass( sawman, tier );
+
      dfb_surface_detach( tier->surface, &tier->surface_reaction );
 
      tier->stack   = NULL;
@@ -1634,6 +1638,8 @@ wm_close_stack( CoreWindowStack *stack,
      tier->size.w  = 0;
      tier->size.h  = 0;
 
+     sawman->index_valid = false;
+
      dfb_layer_region_unlink( &tier->region );
 
      dfb_surface_unlink( &tier->surface );
@@ -1698,6 +1704,9 @@ wm_set_active( CoreWindowStack *stack,
 
      data->active = active;
 
+     if (!active)
+          sawman_leave_bypass( sawman, tier );
+
      sawman_unlock( sawman );
 
      if (active) {
@@ -2563,6 +2572,9 @@ wm_remove_window( CoreWindowStack *stack,
           }
      }
 
+     if (tier->bypass_window == sawwin)
+          sawman_leave_bypass( sawman, tier );
+
      if (tier->single_window == sawwin)
           tier->single_window = NULL;
 
@@ -3745,7 +3757,7 @@ wm_update_window( CoreWindow          *window,
           dfb_updates_add( &sawwin->right.updates, sawwin->parent ? NULL : right_region );     // FIXME: will crash with NULL
      }
      else {
-          if (tier->single_mode && tier->single_window != NULL) {
+          if (tier->single_mode && tier->single_window != NULL && !tier->bypass_window) {
                if (tier->single_window == sawwin) {
                     /* Save current buffers focus */
                     D_ASSERT( window->surface != NULL );
@@ -4143,6 +4155,13 @@ wm_update_cursor( CoreWindowStack       *stack,
      /*
       * SW Cursor mode
       */
+     if (tier->bypass_window && stack->cursor.enabled && stack->cursor.opacity) {
+          D_DEBUG_AT( SaWMan_Cursor, "  -> compositing again for software cursor\n" );
+
+          sawman_leave_bypass( sawman, tier );
+          sawman_process_updates( sawman, DSFLIP_NONE, wmdata );
+     }
+
      context = stack->context;
      D_ASSERT( context != NULL );
 